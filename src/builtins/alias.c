@@ -0,0 +1,84 @@
+#include "alias.h"
+#include "../utils/constants.h"
+#include "../utils/core.h"
+#include "../utils/functions.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void print_alias(const char *name, const char *value) {
+    printf("alias %s='%s'\n", name, value);
+}
+
+int alias(const command_without_substitution *cmd) {
+    if (cmd->argc == 1) {
+        const char **names;
+        size_t count = alias_names(&names);
+        for (size_t i = 0; i < count; i++) {
+            print_alias(names[i], get_alias(names[i], strlen(names[i])));
+        }
+        free(names);
+        return SUCCESS;
+    }
+
+    const char *equal = strchr(cmd->argv[1], '=');
+    if (equal != NULL) {
+        if (equal == cmd->argv[1]) {
+            fprintf(stderr, "jsh: alias: %s: invalid alias name\n", cmd->argv[1]);
+            return COMMAND_FAILURE;
+        }
+        size_t value_len = strlen(equal + 1);
+        for (size_t i = 2; i < cmd->argc; i++) {
+            value_len += strlen(cmd->argv[i]) + 1;
+        }
+        char *value = malloc(value_len + 1);
+        if (value == NULL) {
+            return COMMAND_FAILURE;
+        }
+        strcpy(value, equal + 1);
+        for (size_t i = 2; i < cmd->argc; i++) {
+            strcat(value, " ");
+            strcat(value, cmd->argv[i]);
+        }
+        char *name = strndup(cmd->argv[1], equal - cmd->argv[1]);
+        if (name == NULL) {
+            free(value);
+            return COMMAND_FAILURE;
+        }
+        set_alias(name, value);
+        free(name);
+        free(value);
+        return SUCCESS;
+    }
+
+    int return_value = SUCCESS;
+    for (size_t i = 1; i < cmd->argc; i++) {
+        const char *value = get_alias(cmd->argv[i], strlen(cmd->argv[i]));
+        if (value == NULL) {
+            fprintf(stderr, "jsh: alias: %s: not found\n", cmd->argv[i]);
+            return_value = COMMAND_FAILURE;
+        } else {
+            print_alias(cmd->argv[i], value);
+        }
+    }
+    return return_value;
+}
+
+int unalias(const command_without_substitution *cmd) {
+    if (cmd->argc == 1) {
+        print_error("unalias: usage: unalias [-a] name...");
+        return COMMAND_FAILURE;
+    }
+    if (strcmp(cmd->argv[1], "-a") == 0) {
+        unset_aliases();
+        return SUCCESS;
+    }
+    int return_value = SUCCESS;
+    for (size_t i = 1; i < cmd->argc; i++) {
+        if (!unset_alias(cmd->argv[i])) {
+            fprintf(stderr, "jsh: unalias: %s: not found\n", cmd->argv[i]);
+            return_value = COMMAND_FAILURE;
+        }
+    }
+    return return_value;
+}
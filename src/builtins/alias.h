@@ -0,0 +1,22 @@
+#ifndef ALIAS_H
+#define ALIAS_H
+
+#include "../parser/parser.h"
+
+int alias(const command_without_substitution *cmd);
+/**
+ * alias [name=value [word...]]
+ * alias name...
+ * Defines the alias name, whose value is the rest of the arguments joined by spaces, as a line has no quotes:
+ * `alias ll=ls -l`. Without argument, prints all the aliases, and with names, prints their values.
+ * Fails if a name has no alias.
+ */
+
+int unalias(const command_without_substitution *cmd);
+/**
+ * unalias name...
+ * unalias -a
+ * Removes the aliases, or all of them with -a. Fails if a name has no alias.
+ */
+
+#endif
@@ -0,0 +1,22 @@
+#include "assignment.h"
+#include "../utils/constants.h"
+#include "../utils/variables.h"
+#include <stdio.h>
+#include <string.h>
+
+int assign_variables(const command_without_substitution *cmd) {
+    for (size_t i = 0; i < cmd->argc; i++) {
+        if (!is_assignment(cmd->argv[i])) {
+            fprintf(stderr, "jsh: %s: not an assignment\n", cmd->argv[i]);
+            return COMMAND_FAILURE;
+        }
+    }
+    for (size_t i = 0; i < cmd->argc; i++) {
+        char *equal = strchr(cmd->argv[i], '=');
+        *equal = '\0';
+        set_variable(cmd->argv[i], equal + 1);
+        *equal = '=';
+    }
+    // A command made only of assignments has the status of its last command substitution
+    return substitution_exit_value == -1 ? SUCCESS : substitution_exit_value;
+}
@@ -0,0 +1,14 @@
+#ifndef ASSIGNMENT_H
+#define ASSIGNMENT_H
+
+#include "../parser/parser.h"
+
+int assign_variables(const command_without_substitution *cmd);
+/**
+ * name=value...
+ * Sets the variables of jsh, or of its environment if they are there, to the values, which are expanded.
+ * Fails if an argument is not an assignment, as commands run with assignments before them are not supported.
+ * Returns the status of the last command substitution of the values, if there is one.
+ */
+
+#endif
@@ -1,5 +1,6 @@
 #include "bg.h"
 #include "../utils/core.h"
+#include "../utils/flight_recorder.h"
 #include "../utils/jobs_core.h"
 #include "../utils/string_utils.h"
 #include <signal.h>
@@ -26,6 +27,7 @@ int bg(const command_without_substitution *cmd) {
         return COMMAND_FAILURE;
     }
     pid_t pgid = jobs[job_placement]->pgid;
+    record_flight_event(FLIGHT_SIGNAL_SENT, -pgid, SIGCONT, "bg");
     killpg(pgid, SIGCONT);
     return SUCCESS;
 }
@@ -0,0 +1,38 @@
+#include "builtins.h"
+#include <stdlib.h>
+#include <string.h>
+
+const builtin builtins[] = {
+    {":", jsh_true, false, false, true},
+    {"?", print_last_command_result, false, false, true},
+    {"alias", alias, false, false, false},
+    {"bg", bg, false, false, false},
+    {"cd", cd, false, true, false},
+    {"chunked", chunked, true, false, false},
+    {"debug", debug, false, false, false},
+    {"dirs", dirs, false, false, true},
+    {"exit", exit_jsh, false, false, false},
+    {"false", jsh_false, false, false, true},
+    {"fg", fg, false, false, false},
+    {"history", print_history, false, false, true},
+    {"j", jump, false, true, false},
+    {"jobs", print_jobs, false, false, true},
+    {"kill", jsh_kill, false, false, false},
+    {"popd", popd, false, true, false},
+    {"pushd", pushd, false, true, false},
+    {"pwd", pwd, false, false, true},
+    {"set", jsh_set, false, false, false},
+    {"true", jsh_true, false, false, true},
+    {"unalias", unalias, false, false, false},
+    {"wait", jsh_wait, false, false, false},
+};
+
+const size_t builtin_count = sizeof(builtins) / sizeof(builtins[0]);
+
+int compare_builtin_name(const void *name, const void *b) {
+    return strcmp(name, ((const builtin *)b)->name);
+}
+
+const builtin *find_builtin(const char *name) {
+    return bsearch(name, builtins, builtin_count, sizeof(builtin), compare_builtin_name);
+}
@@ -10,5 +10,35 @@
 #include "kill.h"
 #include "bg.h"
 #include "fg.h"
+#include "chunked.h"
+#include "history.h"
+#include "jump.h"
+#include "directory_stack.h"
+#include "true_false.h"
+#include "assignment.h"
+#include "alias.h"
+#include "wait.h"
+#include "set.h"
+#include "debug.h"
+
+typedef struct {
+    const char *name;
+    int (*run)(const command_without_substitution *);
+    bool is_forked;
+    bool updates_prompt;
+    bool is_contained;
+} builtin;
+/*
+ * A builtin of jsh with the function running it. A forked builtin is run in a child like an external command,
+ * rather than by jsh itself. The prompt is updated after the builtins which change the current directory, and a
+ * contained builtin only reads the state of jsh, so that a subshell made of them needs no fork.
+ */
+
+extern const builtin builtins[];
+extern const size_t builtin_count;
+/* The builtins, sorted by name, the one table used to run them and to complete their names */
+
+const builtin *find_builtin(const char *name);
+/* Returns the builtin of the name, or NULL if there is none */
 
 #endif
@@ -1,9 +1,9 @@
 #include <assert.h>
+#include <errno.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/stat.h>
 
 #include "../parser/parser.h"
 #include "../utils/constants.h"
@@ -39,19 +39,16 @@ int cd(const command_without_substitution *cmd) {
     char *correct_path = get_correct_path(cmd->argv[1]); // Corrects the path for ~
 
     assert(correct_path != NULL);
-    struct stat st;
 
-    if (stat(correct_path, &st) != 0) { // Checks if the directory exists
-        print_error("cd: no such file or directory");
-        free(correct_path);
-        return COMMAND_FAILURE;
-    }
-    if ((st.st_mode & S_IFMT) != S_IFDIR) { // Checks if its a directory
-        print_error("cd: not a directory");
-        free(correct_path);
-        return COMMAND_FAILURE;
-    }
+    // The directory is checked by the change itself, so that its path is resolved once
     if ((res_command = change_pwd(correct_path)) != SUCCESS) { // Updates pwd
+        if (errno == ENOENT) {
+            print_error("cd: no such file or directory");
+        } else if (errno == ENOTDIR) {
+            print_error("cd: not a directory");
+        } else {
+            fprintf(stderr, "cd: %s\n", strerror(errno));
+        }
         free(correct_path);
         return res_command;
     }
@@ -0,0 +1,180 @@
+#include "../parser/parser.h"
+#include "../utils/constants.h"
+#include "../utils/core.h"
+#include "../utils/string_utils.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "chunked.h"
+
+extern char **environ;
+
+typedef struct {
+    pid_t *pids;
+    size_t count;
+} running_batches;
+
+size_t argument_size(const char *arg) {
+    return strlen(arg) + 1 + sizeof(char *);
+}
+
+/*
+ * Returns the number of bytes the arguments of a batch may take
+ */
+size_t available_argument_space() {
+    long arg_max = sysconf(_SC_ARG_MAX);
+    if (arg_max <= 0) {
+        arg_max = 1 << 17;
+    }
+
+    size_t environment_size = sizeof(char *);
+    for (char **variable = environ; *variable != NULL; variable++) {
+        environment_size += argument_size(*variable);
+    }
+
+    if ((size_t)arg_max <= environment_size + CHUNKED_HEADROOM) {
+        return 0;
+    }
+    return arg_max - environment_size - CHUNKED_HEADROOM;
+}
+
+int combine_batch_status(int exit_code, int status) {
+    int batch_code = SUCCESS;
+    if (WIFSIGNALED(status)) {
+        batch_code = CHUNKED_BATCH_KILLED;
+    } else if (WEXITSTATUS(status) == COMMAND_NOT_FOUND || WEXITSTATUS(status) == CHUNKED_CANNOT_RUN) {
+        batch_code = WEXITSTATUS(status);
+    } else if (WEXITSTATUS(status) != SUCCESS) {
+        batch_code = CHUNKED_BATCH_FAILED;
+    }
+    return batch_code > exit_code ? batch_code : exit_code;
+}
+
+/*
+ * Waits for the end of one of the running batches, returns the combined exit code
+ */
+int wait_for_batch(running_batches *running, int exit_code) {
+    int status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, 0)) != -1 || errno == EINTR) {
+        for (size_t i = 0; pid != -1 && i < running->count; i++) {
+            if (running->pids[i] == pid) {
+                running->pids[i] = running->pids[running->count - 1];
+                running->count--;
+                return combine_batch_status(exit_code, status);
+            }
+        }
+    }
+    running->count = 0;
+    return exit_code;
+}
+
+size_t pack_batch(char **argv, size_t initial_count, size_t initial_size, char *const *arguments,
+                  size_t argument_count, size_t space) {
+    // A batch takes at least one argument, even if it is too large alone, so that execvp reports it
+    size_t count = 0;
+    size_t size = initial_size;
+    while (count < argument_count && (count == 0 || size + argument_size(arguments[count]) <= space)) {
+        size += argument_size(arguments[count]);
+        argv[initial_count + count] = arguments[count];
+        count++;
+    }
+    argv[initial_count + count] = NULL;
+    return count;
+}
+
+pid_t start_batch(char **argv) {
+    fflush(stdout);
+    fflush(stderr);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        execvp(argv[0], argv);
+        // errno is saved before the message, which may change it
+        int exec_errno = errno;
+        fprintf(stderr, "chunked: %s: %s\n", argv[0], strerror(exec_errno));
+        _exit(exec_errno == ENOENT ? COMMAND_NOT_FOUND : CHUNKED_CANNOT_RUN);
+    }
+    return pid;
+}
+
+int chunked(const command_without_substitution *cmd) {
+    size_t max_running = 1;
+    size_t command_index = 1;
+    if (cmd->argc > 1 && strcmp(cmd->argv[1], "-P") == 0) {
+        if (cmd->argc < 3 || !is_integer(cmd->argv[2]) || atoi(cmd->argv[2]) < 1) {
+            print_error("chunked: -P: invalid number of batches");
+            return COMMAND_FAILURE;
+        }
+        max_running = atoi(cmd->argv[2]);
+        command_index = 3;
+    }
+    if (command_index >= cmd->argc) {
+        print_error("chunked: usage: chunked [-P N] command [initial arguments --] arguments");
+        return COMMAND_FAILURE;
+    }
+
+    // The initial arguments are the ones before a `--`, if there is one
+    size_t initial_end = command_index + 1;
+    size_t first_argument = command_index + 1;
+    for (size_t i = command_index + 1; i < cmd->argc; i++) {
+        if (strcmp(cmd->argv[i], "--") == 0) {
+            initial_end = i;
+            first_argument = i + 1;
+            break;
+        }
+    }
+
+    size_t space = available_argument_space();
+    size_t initial_size = sizeof(char *);
+    for (size_t i = command_index; i < initial_end; i++) {
+        initial_size += argument_size(cmd->argv[i]);
+    }
+    if (initial_size >= space) {
+        print_error("chunked: the initial arguments do not leave room for any argument");
+        return COMMAND_FAILURE;
+    }
+
+    size_t initial_count = initial_end - command_index;
+    char **argv = malloc(sizeof(char *) * (cmd->argc + 1));
+    running_batches running = {malloc(sizeof(pid_t) * max_running), 0};
+    if (argv == NULL || running.pids == NULL) {
+        free(argv);
+        free(running.pids);
+        print_error("chunked: out of memory");
+        return COMMAND_FAILURE;
+    }
+    memcpy(argv, cmd->argv + command_index, sizeof(char *) * initial_count);
+
+    int exit_code = SUCCESS;
+    size_t next = first_argument;
+    do {
+        next += pack_batch(argv, initial_count, initial_size, cmd->argv + next, cmd->argc - next, space);
+
+        if (running.count == max_running) {
+            exit_code = wait_for_batch(&running, exit_code);
+        }
+        pid_t pid = start_batch(argv);
+        if (pid == -1) {
+            perror("chunked: fork");
+            if (exit_code < CHUNKED_CANNOT_RUN) {
+                exit_code = CHUNKED_CANNOT_RUN;
+            }
+            break;
+        }
+        running.pids[running.count++] = pid;
+    } while (next < cmd->argc);
+
+    while (running.count > 0) {
+        exit_code = wait_for_batch(&running, exit_code);
+    }
+
+    free(argv);
+    free(running.pids);
+    return exit_code;
+}
@@ -0,0 +1,42 @@
+#ifndef CHUNKED_H
+#define CHUNKED_H
+
+#include "../parser/parser.h"
+
+#define CHUNKED_HEADROOM 2048
+/* Bytes of the argument space left unused by each batch, as xargs does */
+
+#define CHUNKED_BATCH_FAILED 123
+#define CHUNKED_BATCH_KILLED 125
+#define CHUNKED_CANNOT_RUN 126
+/* Exit codes of chunked when a batch fails, is killed by a signal, or cannot be run */
+
+size_t argument_size(const char *arg);
+/* Returns the number of bytes an argument takes in the argument space of a program, its pointer included */
+
+size_t pack_batch(char **argv, size_t initial_count, size_t initial_size, char *const *arguments,
+                  size_t argument_count, size_t space);
+/*
+ * Puts after the initial_count arguments of argv, of initial_size bytes, as many of the arguments as fit in the
+ * space, followed by NULL, and returns how many of them it took: at least one if there is one, even if it does not
+ * fit alone, so that running the batch reports it
+ */
+
+int combine_batch_status(int exit_code, int status);
+/*
+ * Combines the status of a batch, as given by waitpid, with the exit code of the previous ones: the most severe
+ * of them is kept, a failed batch being CHUNKED_BATCH_FAILED whatever its own code unless it could not be run
+ */
+
+int chunked(const command_without_substitution *cmd);
+/**
+ * chunked [-P N] command [initial arguments --] arguments
+ * Runs the command with the arguments packed into batches which fit in the space the kernel allows
+ * for the arguments and the environment of a program (ARG_MAX), each batch starting with the initial
+ * arguments. The batches run one after another, or at most N at the same time with -P N.
+ * Returns 0 if every batch succeeds, CHUNKED_BATCH_FAILED if one fails, CHUNKED_BATCH_KILLED if one is
+ * killed, CHUNKED_CANNOT_RUN or COMMAND_NOT_FOUND if the command cannot be run.
+ * chunked runs in a child process like an external command, so that it is a job.
+ */
+
+#endif
@@ -0,0 +1,18 @@
+#include "debug.h"
+#include "../utils/constants.h"
+#include "../utils/core.h"
+#include "../utils/flight_recorder.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+int debug(const command_without_substitution *cmd) {
+    if (cmd->argc != 2 || strcmp(cmd->argv[1], "dump") != 0) {
+        print_error("debug: usage: debug dump");
+        return COMMAND_FAILURE;
+    }
+    // The events follow what was printed before
+    fflush(stdout);
+    dump_flight_recorder(STDOUT_FILENO);
+    return SUCCESS;
+}
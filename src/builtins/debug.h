@@ -0,0 +1,17 @@
+#ifndef DEBUG_H
+#define DEBUG_H
+
+#include "../parser/parser.h"
+
+int debug(const command_without_substitution *);
+/**
+ * Shows what happened inside jsh
+ * Usage :
+ * debug dump  : writes the last FLIGHT_RECORDER_SIZE events recorded by jsh, from the oldest one: the lines
+ *               parsed, the processes forked, the results of waitpid, the terminal given to the jobs with
+ *               tcsetpgrp, the signals sent and received and the changes of status of the jobs.
+ * The same events are written to the standard error on SIGUSR1, and before jsh is killed by a failed assertion
+ * or a crash.
+ */
+
+#endif
@@ -0,0 +1,99 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../parser/parser.h"
+#include "../utils/constants.h"
+#include "../utils/core.h"
+#include "../utils/directory_fds.h"
+
+#include "directory_stack.h"
+
+void push_directory(const char *directory) {
+    directory_stack = realloc(directory_stack, sizeof(char *) * (directory_stack_size + 1));
+    assert(directory_stack != NULL);
+    directory_stack[directory_stack_size] = strdup(directory);
+    assert(directory_stack[directory_stack_size] != NULL);
+    directory_stack_size++;
+    retain_directory_fd(directory);
+}
+
+/*
+ * Changes to the directory and updates current_folder, printing an error if it cannot be entered
+ */
+int enter_directory(const char *name, const char *directory) {
+    int res_command = change_pwd(directory);
+    if (res_command != SUCCESS) {
+        fprintf(stderr, "%s: %s: cannot enter the directory\n", name, directory);
+        return res_command;
+    }
+    update_current_folder();
+    return SUCCESS;
+}
+
+int pushd(const command_without_substitution *cmd) {
+    if (cmd->argc > 2) {
+        print_error("pushd: too many arguments");
+        return COMMAND_FAILURE;
+    }
+    if (cmd->argc == 1) {
+        if (directory_stack_size == 0) {
+            print_error("pushd: no other directory");
+            return COMMAND_FAILURE;
+        }
+        char *top = directory_stack[directory_stack_size - 1];
+        int res_command = enter_directory("pushd", top);
+        if (res_command != SUCCESS) {
+            return res_command;
+        }
+        // The previous directory takes the place of the top
+        release_directory_fd(top);
+        free(top);
+        directory_stack_size--;
+        push_directory(last_reference_position);
+        return SUCCESS;
+    }
+
+    char *previous = strdup(current_folder);
+    assert(previous != NULL);
+    int res_command = enter_directory("pushd", cmd->argv[1]);
+    if (res_command == SUCCESS) {
+        push_directory(previous);
+    }
+    free(previous);
+    return res_command;
+}
+
+int popd(const command_without_substitution *cmd) {
+    if (cmd->argc > 1) {
+        print_error("popd: too many arguments");
+        return COMMAND_FAILURE;
+    }
+    if (directory_stack_size == 0) {
+        print_error("popd: directory stack empty");
+        return COMMAND_FAILURE;
+    }
+    char *top = directory_stack[directory_stack_size - 1];
+    int res_command = enter_directory("popd", top);
+    if (res_command != SUCCESS) {
+        return res_command;
+    }
+    release_directory_fd(top);
+    free(top);
+    directory_stack_size--;
+    return SUCCESS;
+}
+
+int dirs(const command_without_substitution *cmd) {
+    if (cmd->argc > 1) {
+        print_error("dirs: too many arguments");
+        return COMMAND_FAILURE;
+    }
+    printf("%s", current_folder);
+    for (size_t i = directory_stack_size; i > 0; i--) {
+        printf(" %s", directory_stack[i - 1]);
+    }
+    printf("\n");
+    return SUCCESS;
+}
@@ -0,0 +1,28 @@
+#ifndef DIRECTORY_STACK_H
+#define DIRECTORY_STACK_H
+
+#include "../parser/parser.h"
+
+int pushd(const command_without_substitution *cmd);
+/**
+ * pushd [directory]
+ * Saves the current directory on top of the directory stack and changes to the directory, or without argument,
+ * exchanges the current directory with the top of the stack. The descriptors of the directories of the stack
+ * stay in the cache of the directories, so that going back to them does not resolve their path again.
+ * Returns SUCCESS on success, COMMAND_FAILURE on failure.
+ */
+
+int popd(const command_without_substitution *cmd);
+/**
+ * popd
+ * Removes the top of the directory stack and changes to it.
+ * Returns SUCCESS on success, COMMAND_FAILURE if the stack is empty or the directory cannot be entered.
+ */
+
+int dirs(const command_without_substitution *cmd);
+/**
+ * dirs
+ * Prints the current directory followed by the directory stack, from its top.
+ */
+
+#endif
@@ -3,7 +3,7 @@
 
 #include "../parser/parser.h"
 
-int exit_jsh(command_without_substitution *cmd);
+int exit_jsh(const command_without_substitution *cmd);
 /* Exit the jsh program with the specified value
  * If no value is specified, exit the program with 
  * the value of the last executed command*/
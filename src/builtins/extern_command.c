@@ -2,17 +2,31 @@
 #include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
 #include "../parser/parser.h"
 #include "../utils/constants.h"
 #include "../utils/core.h"
+#include "../utils/path_index.h"
 #include "extern_command.h"
 
 int extern_command(const command_without_substitution *cmd) {
-    int res_exec;
+    // The index of PATH refreshed by jsh before the fork spares execvp trying every directory,
+    // which still runs the command if the index is out of date or if the file is a script without `#!`
+    if (strchr(cmd->name, '/') == NULL) {
+        char *path = find_in_path_index(cmd->name);
+        if (path != NULL) {
+            execv(path, cmd->argv);
+            free(path);
+        }
+    }
 
-    res_exec = execvp(cmd->name, cmd->argv);
-    return res_exec;
+    execvp(cmd->name, cmd->argv);
+
+    // errno is saved before the message, which may change it
+    int exec_errno = errno;
+    fprintf(stderr, "jsh: %s: %s\n", cmd->name, strerror(exec_errno));
+    return exec_errno == ENOENT ? COMMAND_NOT_FOUND : COMMAND_NOT_EXECUTABLE;
 }
@@ -5,6 +5,8 @@
 
 int extern_command(const command_without_substitution *);
 /* Executes an external command, with or without
- * arguments, taking into account the PATH environment variable */
+ * arguments, taking into account the PATH environment variable.
+ * Returns only if it cannot be executed, after printing why, with COMMAND_NOT_FOUND if it does not exist
+ * and COMMAND_NOT_EXECUTABLE otherwise, such as for a file without the permission to execute it */
 
 #endif
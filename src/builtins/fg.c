@@ -1,7 +1,10 @@
 #include "fg.h"
 #include "../utils/core.h"
+#include "../utils/event_log.h"
+#include "../utils/flight_recorder.h"
 #include "../utils/jobs_core.h"
 #include "../utils/string_utils.h"
+#include <errno.h>
 #include <signal.h>
 #include <sys/types.h>
 #include <sys/wait.h>
@@ -32,19 +35,25 @@ int fg(const command_without_substitution *cmd) {
     int status;
     job *j = jobs[job_placement];
     pid_t pgid = j->pgid;
-    tcsetpgrp(STDERR_FILENO, pgid);
+    record_flight_event(FLIGHT_TCSETPGRP, pgid, tcsetpgrp(STDERR_FILENO, pgid), "fg");
+    record_flight_event(FLIGHT_SIGNAL_SENT, -pgid, SIGCONT, "fg");
     killpg(pgid, SIGCONT);
 
-    waitpid(j->job_process[j->process_number - 1]->pid, &status, WUNTRACED);
+    process *last = j->job_process[j->process_number - 1];
+    Status previous = last->status;
+    pid_t res = waitpid(last->pid, &status, WUNTRACED);
+    record_flight_event(FLIGHT_WAITPID, last->pid, res == -1 ? -errno : status, "fg");
+    set_status_of_process(last, status);
+    log_status_event(j, last, previous);
 
     if (WIFSTOPPED(status)) {
         j->status = STOPPED;
-        j->job_process[j->process_number - 1]->status = STOPPED;
+        record_flight_event(FLIGHT_JOB_STATUS, j->pgid, j->status, "fg");
         print_job(j, false);
     } else {
         remove_job_from_jobs(j->id);
     }
-    tcsetpgrp(STDERR_FILENO, getpgrp());
+    record_flight_event(FLIGHT_TCSETPGRP, getpgrp(), tcsetpgrp(STDERR_FILENO, getpgrp()), "fg");
 
     return SUCCESS;
 }
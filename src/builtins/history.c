@@ -0,0 +1,74 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../utils/core.h"
+#include "../utils/history_file.h"
+#include "../utils/string_utils.h"
+
+#include "history.h"
+
+void print_history_record(size_t index) {
+    size_t len;
+    const char *line = history_file_record(index, &len);
+    printf("%5zu  %.*s\n", index + 1, (int)len, line);
+}
+
+/*
+ * Prints the records containing the query from the oldest to the newest
+ */
+int print_matching_history(const char *query) {
+    size_t capacity = 64;
+    size_t count = 0;
+    long *matches = malloc(sizeof(long) * capacity);
+    assert(matches != NULL);
+
+    long match = search_history_file(query, history_file_record_count());
+    while (match != -1) {
+        if (count == capacity) {
+            capacity *= 2;
+            matches = realloc(matches, sizeof(long) * capacity);
+            assert(matches != NULL);
+        }
+        matches[count++] = match;
+        match = search_history_file(query, match);
+    }
+
+    for (size_t i = count; i > 0; i--) {
+        print_history_record(matches[i - 1]);
+    }
+    free(matches);
+    return count > 0 ? SUCCESS : COMMAND_FAILURE;
+}
+
+int print_history(const command_without_substitution *cmd) {
+    if (!is_history_file_open()) {
+        print_error("history: no history file");
+        return COMMAND_FAILURE;
+    }
+
+    if (cmd->argc == 1) {
+        size_t count = history_file_record_count();
+        for (size_t i = 0; i < count; i++) {
+            print_history_record(i);
+        }
+        return SUCCESS;
+    }
+
+    if (strcmp(cmd->argv[1], "search") != 0 || cmd->argc == 2) {
+        print_error("history: usage: history [search text]");
+        return COMMAND_FAILURE;
+    }
+
+    char *query = strdup(cmd->argv[2]);
+    assert(query != NULL);
+    for (size_t i = 3; i < cmd->argc; i++) {
+        char *joined = concat_with_delimiter(query, cmd->argv[i], ' ');
+        free(query);
+        query = joined;
+    }
+    int return_value = print_matching_history(query);
+    free(query);
+    return return_value;
+}
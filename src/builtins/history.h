@@ -0,0 +1,13 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "../parser/parser.h"
+
+int print_history(const command_without_substitution *cmd);
+/**
+ * history [search text]
+ * Prints the lines of the history file with their number, or only the ones containing the text
+ * (the arguments joined by spaces) with search, using the index of the history file.
+ */
+
+#endif
@@ -1,7 +1,19 @@
+#include <assert.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
+#include "jobs.h"
 #include "../utils/core.h"
 #include "../utils/int_utils.h"
+#include "../utils/job_output.h"
+#include "../utils/proc_stats.h"
+#include "../utils/process_tree.h"
+#include "../utils/signal_management.h"
 #include "../utils/string_utils.h"
 
 int print_given_jobs_from_argument_index(const command_without_substitution *cmd, size_t start_index) {
@@ -32,6 +44,247 @@ int print_given_jobs_from_argument_index(const command_without_substitution *cmd
     return SUCCESS;
 }
 
+/*
+ * Writes the output kept of the jobs `%n` given from the argument index, which were run with `&!`
+ */
+int replay_output_of_jobs_from_argument_index(const command_without_substitution *cmd, size_t start_index) {
+    if (start_index == cmd->argc) {
+        print_error("jobs: -o: job id required");
+        return COMMAND_FAILURE;
+    }
+    fflush(stdout);
+    for (size_t i = start_index; i < cmd->argc; ++i) {
+        if (cmd->argv[i][0] != '%' || !is_integer(cmd->argv[i] + 1)) {
+            print_error("jobs: %: invalid job id");
+            return COMMAND_FAILURE;
+        }
+        if (!replay_job_output(atoi(cmd->argv[i] + 1), STDOUT_FILENO)) {
+            fprintf(stderr, "jobs: %s: no captured output\n", cmd->argv[i]);
+            return COMMAND_FAILURE;
+        }
+    }
+    return SUCCESS;
+}
+
+/* Writes the number of bytes with the unit keeping it short, such as 1.5M */
+void format_bytes(double bytes, char *buffer, size_t size) {
+    const char *units = "BKMGT";
+    size_t unit = 0;
+    while (bytes >= 1024 && unit < strlen(units) - 1) {
+        bytes /= 1024;
+        unit++;
+    }
+    snprintf(buffer, size, unit == 0 ? "%.0f%c" : "%.1f%c", bytes, units[unit]);
+}
+
+typedef struct {
+    process_stats *stats;
+    size_t count;
+    size_t capacity;
+    double time;
+} job_stats_sample;
+/* The statistics of the processes of the jobs read at once, at the given time since the boot */
+
+process_stats *find_process_stats(const job_stats_sample *sample, pid_t pid) {
+    for (size_t i = 0; sample != NULL && i < sample->count; i++) {
+        if (sample->stats[i].pid == pid) {
+            return &sample->stats[i];
+        }
+    }
+    return NULL;
+}
+
+process_stats *add_process_stats(job_stats_sample *sample) {
+    if (sample->count == sample->capacity) {
+        sample->capacity = sample->capacity == 0 ? 16 : sample->capacity * 2;
+        sample->stats = realloc(sample->stats, sizeof(process_stats) * sample->capacity);
+        assert(sample->stats != NULL);
+    }
+    return &sample->stats[sample->count++];
+}
+
+/*
+ * Prints a process of a stage of a job: its CPU and read and write rates since the previous sample, or since it
+ * started, and the bytes waiting in the pipe of its output. A stage whose input pipe is almost full while its output
+ * is not is the bottleneck of the pipeline.
+ */
+void print_process_stats(const process_stats *stats, const process_stats *previous, double elapsed,
+                         long input_pipe_size, const char *name) {
+    if (previous == NULL) {
+        elapsed = stats->start_ticks / (double)sysconf(_SC_CLK_TCK);
+        elapsed = seconds_since_boot() - elapsed;
+    }
+    char read[16] = "-", written[16] = "-", read_rate[16] = "-", write_rate[16] = "-", pipe[32] = "-";
+    if (stats->has_io) {
+        format_bytes(stats->read_bytes, read, sizeof(read));
+        format_bytes(stats->written_bytes, written, sizeof(written));
+        if (elapsed > 0 && (previous == NULL || previous->has_io)) {
+            format_bytes((stats->read_bytes - (previous == NULL ? 0 : previous->read_bytes)) / elapsed, read_rate,
+                         sizeof(read_rate));
+            format_bytes((stats->written_bytes - (previous == NULL ? 0 : previous->written_bytes)) / elapsed,
+                         write_rate, sizeof(write_rate));
+        }
+    }
+    if (stats->output_pipe_fill != -1) {
+        char fill[16], size[16];
+        format_bytes(stats->output_pipe_fill, fill, sizeof(fill));
+        format_bytes(stats->output_pipe_size, size, sizeof(size));
+        snprintf(pipe, sizeof(pipe), "%s/%s", fill, size);
+    }
+    bool full_input = input_pipe_size > 0 && stats->input_pipe_fill * 4 >= input_pipe_size * 3;
+    bool full_output = stats->output_pipe_size > 0 && stats->output_pipe_fill * 4 >= stats->output_pipe_size * 3;
+
+    printf("    %-8d %c %6.1f%% %8s %8s %8s/s %8s/s %13s  %s%s\n", stats->pid, stats->state,
+           process_cpu_percent(previous, stats, elapsed), read, written, read_rate, write_rate, pipe, name,
+           full_input && !full_output ? "  <- bottleneck" : "");
+}
+
+/*
+ * Prints the descendants of the process of the index in the tree, indented by their depth under it
+ */
+void print_descendants_of_process(const process_tree *tree, size_t index, int depth) {
+    const size_t *children;
+    size_t count = process_tree_children(tree, index, &children);
+    for (size_t i = 0; i < count; i++) {
+        const tree_process *child = &tree->processes[children[i]];
+        printf("    %-8d %c %*s\\_ %s\n", child->pid, child->state, depth * 3, "", child->name);
+        print_descendants_of_process(tree, children[i], depth + 1);
+    }
+}
+
+/*
+ * Prints the job followed by the statistics of its processes, which are added to the sample, each one followed by
+ * the processes it started if the tree could be read
+ */
+void print_stages_of_job(job *j, const process_tree *tree, const job_stats_sample *previous,
+                         job_stats_sample *sample) {
+    char *strjb = simple_str_of_job(j, false);
+    printf("%s\n", strjb);
+    free(strjb);
+    printf("    %-8s %c %7s %8s %8s %10s %10s %13s  %s\n", "PID", 'S', "CPU", "READ", "WRITTEN", "READ/S",
+           "WRITTEN/S", "OUTPUT PIPE", "COMMAND");
+
+    long input_pipe_size = 0;
+    for (size_t i = 0; i < j->process_number; i++) {
+        process *p = j->job_process[i];
+        process_stats *stats = add_process_stats(sample);
+        if (p->status == DONE || p->status == KILLED || p->status == TIMED_OUT || !read_process_stats(p->pid, stats)) {
+            sample->count--;
+            char *state = state_to_string(p->status);
+            printf("    %-8d %s\n", p->pid, state);
+            free(state);
+            input_pipe_size = 0;
+            continue;
+        }
+        // A relay has no command of its own
+        const char *name = p->cmd_without_subst == NULL ? "(relay)" : p->cmd_without_subst->name;
+        print_process_stats(stats, find_process_stats(previous, p->pid),
+                            previous == NULL ? 0 : sample->time - previous->time, input_pipe_size,
+                            name != NULL ? name : "");
+        // The relay is among the stages, without being one of them
+        if (p->cmd_without_subst != NULL) {
+            input_pipe_size = stats->output_pipe_size;
+        }
+        if (tree != NULL) {
+            size_t index = process_tree_index(tree, p->pid);
+            if (index != tree->count) {
+                print_descendants_of_process(tree, index, 0);
+            }
+        }
+    }
+}
+
+/*
+ * Returns true if the job given by the argument index or, without argument, any job is still running. The processes
+ * of the system are read once for all the jobs into the tree, only the new ones and the ones of the jobs being read
+ * again if there is a previous tree.
+ */
+bool print_stages_of_jobs_once(const command_without_substitution *cmd, size_t start_index,
+                               const job_stats_sample *previous, job_stats_sample *sample,
+                               const process_tree *previous_tree, process_tree *tree) {
+    bool all = start_index == cmd->argc;
+    size_t count = all ? (size_t)job_number : cmd->argc - start_index;
+    int *placements = malloc(sizeof(int) * (count + 1));
+    assert(placements != NULL);
+    size_t root_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        placements[i] = all ? (int)i : get_jobs_placement_with_id(atoi(cmd->argv[start_index + i] + 1));
+        root_count += placements[i] == -1 ? 0 : jobs[placements[i]]->process_number;
+    }
+    pid_t *roots = malloc(sizeof(pid_t) * (root_count + 1));
+    assert(roots != NULL);
+    root_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        for (size_t k = 0; placements[i] != -1 && k < jobs[placements[i]]->process_number; k++) {
+            roots[root_count++] = jobs[placements[i]]->job_process[k]->pid;
+        }
+    }
+
+    bool has_tree = read_process_tree(tree, previous_tree, roots, root_count);
+    bool running = false;
+    sample->count = 0;
+    sample->time = seconds_since_boot();
+    for (size_t i = 0; i < count; i++) {
+        if (placements[i] != -1) {
+            print_stages_of_job(jobs[placements[i]], has_tree ? tree : NULL, previous, sample);
+            running = running || jobs[placements[i]]->status == RUNNING;
+        }
+    }
+    free(placements);
+    free(roots);
+    return running;
+}
+
+/*
+ * Prints the statistics of the processes of the jobs from the argument index, or of all of them, again every second
+ * with watch until they are over or an interruption
+ */
+int print_stages_of_jobs(const command_without_substitution *cmd, size_t start_index, bool watch) {
+    update_status_of_jobs();
+    for (size_t i = start_index; i < cmd->argc; ++i) {
+        if (cmd->argv[i][0] != '%' || !is_integer(cmd->argv[i] + 1) ||
+            get_jobs_placement_with_id(atoi(cmd->argv[i] + 1)) == -1) {
+            print_error("jobs: %: invalid job id");
+            return COMMAND_FAILURE;
+        }
+    }
+
+    job_stats_sample samples[2] = {{NULL, 0, 0, 0}, {NULL, 0, 0, 0}};
+    process_tree trees[2] = {{NULL, 0, NULL, NULL}, {NULL, 0, NULL, NULL}};
+    bool running = print_stages_of_jobs_once(cmd, start_index, NULL, &samples[0], NULL, &trees[0]);
+
+    if (watch) {
+        struct sigaction previous_interrupt_action;
+        sigaction(SIGINT, NULL, &previous_interrupt_action);
+        catch_interrupts();
+        bool is_terminal = isatty(STDOUT_FILENO);
+        for (size_t round = 1; running && !interrupted; round++) {
+            fflush(stdout);
+            struct timespec delay = {JOBS_WATCH_INTERVAL_MS / 1000, JOBS_WATCH_INTERVAL_MS % 1000 * 1000000};
+            if (nanosleep(&delay, NULL) == -1 && errno == EINTR) {
+                continue;
+            }
+            update_status_of_jobs();
+            // The screen shows only the last sample, without flickering
+            if (is_terminal) {
+                printf("\033[H\033[J");
+            } else {
+                printf("\n");
+            }
+            free_process_tree(&trees[round % 2]);
+            running = print_stages_of_jobs_once(cmd, start_index, &samples[(round - 1) % 2], &samples[round % 2],
+                                                &trees[(round - 1) % 2], &trees[round % 2]);
+        }
+        sigaction(SIGINT, &previous_interrupt_action, NULL);
+    }
+    free(samples[0].stats);
+    free(samples[1].stats);
+    free_process_tree(&trees[0]);
+    free_process_tree(&trees[1]);
+    remove_terminated_jobs(false);
+    return SUCCESS;
+}
+
 int print_jobs(const command_without_substitution *cmd) {
     if (cmd->argc == 1) {
         update_status_of_jobs();
@@ -44,12 +297,31 @@ int print_jobs(const command_without_substitution *cmd) {
         return SUCCESS;
     } else {
 
-        if (cmd->argv[1][0] == '-') {
-            // TODO : take into account the -t option
-            print_error("jobs: option -t not yet implemented");
+        if (strcmp(cmd->argv[1], "-o") == 0) {
+            return replay_output_of_jobs_from_argument_index(cmd, 2);
+        }
+        bool stages = false;
+        bool watch = false;
+        size_t index = 1;
+        for (; index < cmd->argc && cmd->argv[index][0] == '-'; index++) {
+            for (const char *option = cmd->argv[index] + 1; *option != '\0'; option++) {
+                if (*option == 't') {
+                    stages = true;
+                } else if (*option == 'w') {
+                    watch = true;
+                } else {
+                    print_error("jobs: invalid option");
+                    return COMMAND_FAILURE;
+                }
+            }
+        }
+        if (watch && !stages) {
+            print_error("jobs: -w requires -t");
             return COMMAND_FAILURE;
-        } else {
-            return print_given_jobs_from_argument_index(cmd, 1);
         }
+        if (stages) {
+            return print_stages_of_jobs(cmd, index, watch);
+        }
+        return print_given_jobs_from_argument_index(cmd, index);
     }
 }
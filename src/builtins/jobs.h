@@ -3,9 +3,22 @@
 
 #include "../utils/core.h"
 
+#define JOBS_WATCH_INTERVAL_MS 1000
+/* Time between two samples of the processes of the jobs with `jobs -t -w` */
+
 int print_jobs(const command_without_substitution *);
 /**
  * Prints the current jobs
+ * Usage :
+ * jobs [%n...]     : prints the jobs, or only the given ones
+ * jobs -o %n...    : writes the output kept of the jobs run with `&!`, or with `set -o capturejobs`, even once they
+ *                    are over, until a new captured job gets the same id
+ * jobs -t [%n...]  : prints each process of the jobs with its state, its CPU, the bytes it read and wrote and their
+ *                    rates since it started, read from /proc, and the bytes waiting in the pipe of its output, so
+ *                    that the slowest stage of a pipeline shows up, each one followed by the tree of the
+ *                    processes it started
+ * jobs -t -w       : prints them again every second, the CPU and the rates being the ones of the last second,
+ *                    until the jobs are over or an interruption
 */
 
 #endif
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../parser/parser.h"
+#include "../utils/constants.h"
+#include "../utils/core.h"
+#include "../utils/frecency.h"
+
+#include "jump.h"
+
+void print_frecent_directory(const char *directory, double score) {
+    printf("%-10.1f %s\n", score, directory);
+}
+
+int jump(const command_without_substitution *cmd) {
+    if (cmd->argc >= 2 && strcmp(cmd->argv[1], "-l") == 0) {
+        list_frecent_directories(cmd->argv + 2, cmd->argc - 2, print_frecent_directory);
+        return SUCCESS;
+    }
+    if (cmd->argc == 1) {
+        print_error("j: usage: j fragment... or j -l [fragment...]");
+        return COMMAND_FAILURE;
+    }
+
+    char *directory = find_frecent_directory(cmd->argv + 1, cmd->argc - 1, current_folder);
+    if (directory == NULL) {
+        print_error("j: no matching directory");
+        return COMMAND_FAILURE;
+    }
+    int res_command = change_pwd(directory);
+    free(directory);
+    if (res_command != SUCCESS) {
+        return res_command;
+    }
+    update_current_folder();
+    return SUCCESS;
+}
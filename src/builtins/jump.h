@@ -0,0 +1,15 @@
+#ifndef JUMP_H
+#define JUMP_H
+
+#include "../parser/parser.h"
+
+int jump(const command_without_substitution *cmd);
+/**
+ * j fragment...
+ * j -l [fragment...]
+ * Changes the current directory to the directory visited with cd with the best frecency (visited often and
+ * recently) whose path contains the fragments in order, the last one in its last component.
+ * With -l, prints the matching directories with their score instead, from the lowest to the best one.
+ */
+
+#endif
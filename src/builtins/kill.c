@@ -1,5 +1,6 @@
 #include "../parser/parser.h"
 #include "../utils/core.h"
+#include "../utils/flight_recorder.h"
 #include "../utils/string_utils.h"
 
 #include <signal.h>
@@ -10,6 +11,7 @@
 int kill_job(int job_id, int signal) {
     for (size_t i = 0; i < job_number; ++i) {
         if ((*(jobs + i))->id == job_id) {
+            record_flight_event(FLIGHT_SIGNAL_SENT, -(*(jobs + i))->pgid, signal, "kill");
             if (killpg((*(jobs + i))->pgid, signal) == -1) {
                 print_error("kill: an error occured");
                 return COMMAND_FAILURE;
@@ -57,7 +59,9 @@ int jsh_kill(const command_without_substitution *cmd) {
         return COMMAND_FAILURE;
     }
 
-    if (killpg(getpgid(atoi(target)), signal) == -1) {
+    pid_t pgid = getpgid(atoi(target));
+    record_flight_event(FLIGHT_SIGNAL_SENT, pgid == -1 ? 0 : -pgid, signal, "kill");
+    if (killpg(pgid, signal) == -1) {
         print_error("kill: an error occured");
         return COMMAND_FAILURE;
     }
@@ -1,4 +1,7 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "../parser/parser.h"
 #include "../utils/constants.h"
@@ -6,10 +9,20 @@
 #include "pwd.h"
 
 int pwd(const command_without_substitution *cmd) {
-    if (cmd->argc != 1) {
-        print_error("pwd: too many arguments\n");
+    if (cmd->argc > 2 || (cmd->argc == 2 && strcmp(cmd->argv[1], "-L") != 0 && strcmp(cmd->argv[1], "-P") != 0)) {
+        print_error("pwd: usage: pwd [-L | -P]");
         return COMMAND_FAILURE;
     }
+    if (cmd->argc == 2 && strcmp(cmd->argv[1], "-P") == 0) {
+        char *physical = getcwd(NULL, 0);
+        if (physical == NULL) {
+            perror("pwd");
+            return COMMAND_FAILURE;
+        }
+        printf("%s\n", physical);
+        free(physical);
+        return SUCCESS;
+    }
     printf("%s\n", current_folder);
 
     return SUCCESS;
@@ -4,7 +4,8 @@
 #include "../parser/parser.h"
 
 int pwd(const command_without_substitution *cmd);
-/* Displays the absolute physical reference of the current
- * directory. */
+/* Displays the absolute logical reference of the current
+ * directory, kept by cd without following the symbolic links,
+ * or its physical reference with -P. */
 
 #endif
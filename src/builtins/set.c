@@ -0,0 +1,60 @@
+#include "set.h"
+#include "../utils/constants.h"
+#include "../utils/core.h"
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    const char *name;
+    bool *value;
+} shell_option;
+
+const shell_option shell_options[] = {
+    {"capturejobs", &capture_jobs},
+    {NULL, NULL},
+};
+
+bool *shell_option_value(const char *name) {
+    for (size_t i = 0; shell_options[i].name != NULL; i++) {
+        if (strcmp(shell_options[i].name, name) == 0) {
+            return shell_options[i].value;
+        }
+    }
+    return NULL;
+}
+
+int jsh_set(const command_without_substitution *cmd) {
+    if (cmd->argc == 1 || (cmd->argc == 2 && strcmp(cmd->argv[1], "-o") == 0)) {
+        for (size_t i = 0; shell_options[i].name != NULL; i++) {
+            printf("%-15s %s\n", shell_options[i].name, *shell_options[i].value ? "on" : "off");
+        }
+        return SUCCESS;
+    }
+    if (cmd->argc == 2 && strcmp(cmd->argv[1], "+o") == 0) {
+        for (size_t i = 0; shell_options[i].name != NULL; i++) {
+            printf("set %co %s\n", *shell_options[i].value ? '-' : '+', shell_options[i].name);
+        }
+        return SUCCESS;
+    }
+
+    // Every option is checked before any of them is changed
+    for (size_t i = 1; i < cmd->argc; i++) {
+        if (strcmp(cmd->argv[i], "-o") != 0 && strcmp(cmd->argv[i], "+o") != 0) {
+            fprintf(stderr, "jsh: set: %s: invalid option\n", cmd->argv[i]);
+            return COMMAND_FAILURE;
+        }
+        if (i + 1 == cmd->argc) {
+            fprintf(stderr, "jsh: set: %s: option name required\n", cmd->argv[i]);
+            return COMMAND_FAILURE;
+        }
+        i++;
+        if (shell_option_value(cmd->argv[i]) == NULL) {
+            fprintf(stderr, "jsh: set: %s: invalid option name\n", cmd->argv[i]);
+            return COMMAND_FAILURE;
+        }
+    }
+    for (size_t i = 1; i + 1 < cmd->argc; i += 2) {
+        *shell_option_value(cmd->argv[i + 1]) = cmd->argv[i][0] == '-';
+    }
+    return SUCCESS;
+}
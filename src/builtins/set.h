@@ -0,0 +1,17 @@
+#ifndef SET_H
+#define SET_H
+
+#include "../parser/parser.h"
+
+int jsh_set(const command_without_substitution *);
+/**
+ * Turns the options of jsh on or off
+ * Usage :
+ * set [-o]             : prints the options and whether they are on
+ * set +o               : prints the options as the commands setting them again
+ * set -o|+o option...  : turns the options on with -o, off with +o
+ * The options are:
+ *  - capturejobs : the output of every job is captured as with `&!`
+ */
+
+#endif
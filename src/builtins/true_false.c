@@ -0,0 +1,10 @@
+#include "true_false.h"
+#include "../utils/constants.h"
+
+int jsh_true(const command_without_substitution *cmd) {
+    return SUCCESS;
+}
+
+int jsh_false(const command_without_substitution *cmd) {
+    return COMMAND_FAILURE;
+}
@@ -0,0 +1,19 @@
+#ifndef TRUE_FALSE_H
+#define TRUE_FALSE_H
+
+#include "../parser/parser.h"
+
+int jsh_true(const command_without_substitution *cmd);
+/**
+ * true [argument...]
+ * : [argument...]
+ * Does nothing and succeeds, such as for the condition of an endless loop.
+ */
+
+int jsh_false(const command_without_substitution *cmd);
+/**
+ * false [argument...]
+ * Does nothing and fails.
+ */
+
+#endif
@@ -0,0 +1,244 @@
+#define _GNU_SOURCE
+#include "wait.h"
+#include "../utils/core.h"
+#include "../utils/event_log.h"
+#include "../utils/flight_recorder.h"
+#include "../utils/jobs_core.h"
+#include "../utils/signal_management.h"
+#include "../utils/string_utils.h"
+#include <assert.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+int open_pidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return syscall(SYS_pidfd_open, pid, 0);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+/*
+ * Returns the job designated by `%n` or by the pid of its group or of one of its processes, or NULL if there is none
+ */
+job *job_of_wait_argument(const char *arg) {
+    if (arg[0] == '%') {
+        if (!is_integer(arg + 1)) {
+            return NULL;
+        }
+        int placement = get_jobs_placement_with_id(atoi(arg + 1));
+        return placement == -1 ? NULL : jobs[placement];
+    }
+    if (!is_integer(arg)) {
+        return NULL;
+    }
+    pid_t pid = atoi(arg);
+    for (size_t i = 0; i < job_number; i++) {
+        if (jobs[i]->pgid == pid) {
+            return jobs[i];
+        }
+        for (size_t k = 0; k < jobs[i]->process_number; k++) {
+            if (jobs[i]->job_process[k]->pid == pid) {
+                return jobs[i];
+            }
+        }
+    }
+    return NULL;
+}
+
+bool has_job_ended(const job *j) {
+    for (size_t i = 0; i < j->process_number; i++) {
+        if (j->job_process[i]->status == RUNNING || j->job_process[i]->status == STOPPED) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Reports the end of the job and removes it from the jobs, returning the exit status of its last process
+ */
+int end_waited_job(job *j) {
+    process *last = j->job_process[j->process_number - 1];
+    int status = last->exit_status;
+    if (has_job_timed_out(j)) {
+        j->status = TIMED_OUT;
+        status = COMMAND_TIMED_OUT;
+    } else {
+        j->status = last->status == KILLED ? KILLED : DONE;
+    }
+    print_job(j, false);
+    remove_job_from_jobs(j->id);
+    return status;
+}
+
+/* Collects the status of the process of the job which has ended */
+void reap_waited_process(const job *j, process *p) {
+    Status previous = p->status;
+    int status;
+    pid_t res = waitpid(p->pid, &status, WNOHANG);
+    record_flight_event(FLIGHT_WAITPID, p->pid, res == -1 ? -errno : (res == 0 ? 0 : status), "wait");
+    if (res > 0) {
+        set_status_of_process(p, status);
+    } else {
+        p->status = DETACHED;
+    }
+    log_status_event(j, p, previous);
+}
+
+/*
+ * Waits for the end of the jobs which are not NULL, or of the first one of them with next, setting their exit
+ * statuses and first_ended to the index of the first one which ended. Returns false if the wait was interrupted.
+ */
+bool wait_for_jobs(job **targets, int *statuses, size_t target_count, bool next, size_t *first_ended) {
+    size_t process_count = 0;
+    for (size_t i = 0; i < target_count; i++) {
+        process_count += targets[i] == NULL ? 0 : targets[i]->process_number;
+    }
+    struct pollfd *fds = malloc(sizeof(struct pollfd) * (process_count + 1));
+    process **processes = malloc(sizeof(process *) * (process_count + 1));
+    size_t *owners = malloc(sizeof(size_t) * (process_count + 1));
+    assert(fds != NULL && processes != NULL && owners != NULL);
+
+    size_t fd_count = 0;
+    for (size_t i = 0; i < target_count; i++) {
+        for (size_t k = 0; targets[i] != NULL && k < targets[i]->process_number; k++) {
+            process *p = targets[i]->job_process[k];
+            if (p->status != RUNNING) {
+                continue;
+            }
+            int fd = open_pidfd(p->pid);
+            if (fd == -1) {
+                // Without pidfds, before Linux 5.3, the processes are waited for one after the other
+                int status;
+                pid_t res = waitpid(p->pid, &status, 0);
+                record_flight_event(FLIGHT_WAITPID, p->pid, res == -1 ? -errno : status, "wait");
+                if (res == p->pid) {
+                    set_status_of_process(p, status);
+                } else {
+                    p->status = DETACHED;
+                }
+                log_status_event(targets[i], p, RUNNING);
+                continue;
+            }
+            fds[fd_count].fd = fd;
+            fds[fd_count].events = POLLIN;
+            processes[fd_count] = p;
+            owners[fd_count] = i;
+            fd_count++;
+        }
+    }
+
+    // The jobs which have already ended are reported at once, the stopped ones are not waited for
+    size_t remaining = 0;
+    *first_ended = target_count;
+    for (size_t i = 0; i < target_count; i++) {
+        if (targets[i] == NULL) {
+            continue;
+        }
+        if (has_job_ended(targets[i])) {
+            statuses[i] = end_waited_job(targets[i]);
+            targets[i] = NULL;
+            *first_ended = *first_ended == target_count ? i : *first_ended;
+        } else if (targets[i]->status != STOPPED) {
+            remaining++;
+        }
+    }
+
+    struct sigaction previous_interrupt_action;
+    sigaction(SIGINT, NULL, &previous_interrupt_action);
+    catch_interrupts();
+
+    while (remaining > 0 && !(next && *first_ended != target_count) && !interrupted) {
+        if (poll(fds, fd_count, -1) == -1) {
+            assert(errno == EINTR);
+            continue;
+        }
+        for (size_t i = 0; i < fd_count; i++) {
+            if (fds[i].fd == -1 || fds[i].revents == 0) {
+                continue;
+            }
+            reap_waited_process(targets[owners[i]], processes[i]);
+            close(fds[i].fd);
+            // A negative descriptor is ignored by poll
+            fds[i].fd = -1;
+
+            size_t owner = owners[i];
+            if (targets[owner] != NULL && has_job_ended(targets[owner])) {
+                statuses[owner] = end_waited_job(targets[owner]);
+                targets[owner] = NULL;
+                *first_ended = *first_ended == target_count ? owner : *first_ended;
+                remaining--;
+            }
+        }
+    }
+    bool was_interrupted = interrupted;
+    sigaction(SIGINT, &previous_interrupt_action, NULL);
+
+    for (size_t i = 0; i < fd_count; i++) {
+        if (fds[i].fd != -1) {
+            close(fds[i].fd);
+        }
+    }
+    free(fds);
+    free(processes);
+    free(owners);
+    return !was_interrupted;
+}
+
+int jsh_wait(const command_without_substitution *cmd) {
+    bool next = cmd->argc > 1 && strcmp(cmd->argv[1], "-n") == 0;
+    size_t first_arg = next ? 2 : 1;
+    size_t arg_count = cmd->argc - first_arg;
+
+    // Without arguments, all the jobs are waited for
+    size_t target_count = arg_count > 0 ? arg_count : job_number;
+    job **targets = malloc(sizeof(job *) * (target_count + 1));
+    int *statuses = malloc(sizeof(int) * (target_count + 1));
+    size_t *firsts = malloc(sizeof(size_t) * (target_count + 1));
+    assert(targets != NULL && statuses != NULL && firsts != NULL);
+
+    size_t job_count = 0;
+    for (size_t i = 0; i < target_count; i++) {
+        targets[i] = arg_count > 0 ? job_of_wait_argument(cmd->argv[first_arg + i]) : jobs[i];
+        statuses[i] = targets[i] == NULL ? WAIT_NOT_FOUND : SUCCESS;
+        if (targets[i] == NULL) {
+            fprintf(stderr, "jsh: wait: %s: no such job\n", cmd->argv[first_arg + i]);
+        }
+        // A job given twice is only waited for once, with the first of its arguments
+        firsts[i] = i;
+        for (size_t k = 0; k < i && targets[i] != NULL; k++) {
+            if (targets[k] == targets[i]) {
+                firsts[i] = k;
+                targets[i] = NULL;
+            }
+        }
+        job_count += targets[i] != NULL;
+    }
+
+    size_t first_ended;
+    int status = SUCCESS;
+    if (!wait_for_jobs(targets, statuses, target_count, next, &first_ended)) {
+        status = 128 + SIGINT;
+    } else if (next) {
+        status = first_ended == target_count ? WAIT_NOT_FOUND : statuses[first_ended];
+    } else if (arg_count > 0) {
+        status = statuses[firsts[target_count - 1]];
+    }
+
+    free(targets);
+    free(statuses);
+    free(firsts);
+    if (job_count > 0) {
+        update_prompt();
+    }
+    return status;
+}
@@ -0,0 +1,20 @@
+#ifndef WAIT_H
+#define WAIT_H
+
+#include "../parser/parser.h"
+
+#define WAIT_NOT_FOUND 127
+/* Exit status of wait for a job which does not exist, or with -n if there is no job to wait for */
+
+int jsh_wait(const command_without_substitution *);
+/**
+ * Waits for the end of jobs run in the background, reporting each of them as soon as it ends
+ * Usage :
+ * wait                 : waits for all the jobs and returns 0
+ * wait %n|pid...       : waits for the given jobs and returns the exit status of the last one
+ * wait -n [%n|pid...]  : waits for the first of the jobs to end and returns its exit status
+ * A descriptor is opened for each running process with pidfd_open, so that all of them are waited for at once
+ * with poll, which an interruption stops with the status 130. A stopped job is not waited for.
+ */
+
+#endif
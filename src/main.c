@@ -1,47 +1,351 @@
 #include <readline/history.h>
 #include <readline/readline.h>
+#include <assert.h>
+#include <ctype.h>
+#include <locale.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
 
 #include "parser/parser.h"
 #include "run/run.h"
 #include "utils/constants.h"
+#include "utils/command_completion.h"
 #include "utils/core.h"
+#include "utils/event_log.h"
+#include "utils/flight_recorder.h"
+#include "utils/event_loop.h"
+#include "utils/history_file.h"
 #include "utils/jobs_core.h"
+#include "utils/prompt_segments.h"
 #include "utils/signal_management.h"
 
-int main() {
-    init_core();
-    init_const();
-    use_jsh_signal_management();
+/*
+ * Reads a line continuing the input, of a here-document or of a compound command
+ */
+char *read_next_line() {
+    return readline("> ");
+}
 
-    rl_outstream = stderr;
-    while (1) {
-        last_line_read = readline(prompt);
-        if (last_line_read == NULL) {
+/*
+ * Runs a line read by readline, returns false at the end of the input
+ */
+bool run_line(char *line) {
+    last_line_read = line;
+    if (last_line_read == NULL) {
+        return false;
+    }
+    // A group or a compound command goes on over the next lines until it is closed
+    while (is_incomplete_input(last_line_read)) {
+        char *next_line = read_next_line();
+        if (next_line == NULL) {
             break;
         }
-        add_history(last_line_read);
+        last_line_read = join_continuation_line(last_line_read, next_line);
+        free(next_line);
+    }
+    add_history(last_line_read);
+    append_to_history_file(last_line_read);
+
+    unsigned long long parse_start_time = event_log_time();
+    current_pipeline_list = parse_pipeline_list(last_line_read);
+    log_parse_event(last_line_read, current_pipeline_list == NULL ? 0 : current_pipeline_list->pipeline_count,
+                    parse_start_time);
+    record_flight_event(FLIGHT_PARSE, getpid(),
+                        current_pipeline_list == NULL ? -1 : (int)current_pipeline_list->pipeline_count, last_line_read);
+
+    if (current_pipeline_list == NULL) {
+        last_command_exit_value = COMMAND_FAILURE;
+        free(last_line_read);
+        flush_event_log();
+        return true;
+    }
+    read_here_documents(current_pipeline_list, read_next_line);
+
+    int run_output = run_pipeline_list(current_pipeline_list);
+
+    last_command_exit_value = run_output;
+    update_status_of_jobs();
+    remove_terminated_jobs(true);
+
+    free(last_line_read);
+    free_pipeline_list(current_pipeline_list);
+    current_pipeline_list = NULL;
+    // The events of the line are written together, before the next one is waited for
+    flush_event_log();
+
+    // The commands may have changed what the segments of the prompt show, such as the state of a repository
+    invalidate_prompt_segments();
+    update_prompt();
+    return true;
+}
 
-        current_pipeline_list = parse_pipeline_list(last_line_read);
+const char *script_position = NULL;
+/* Position of the next line of the command string given with -c */
 
+/*
+ * Reads the next line of the command string given with -c
+ */
+char *read_script_line() {
+    if (script_position == NULL || *script_position == '\0') {
+        return NULL;
+    }
+    size_t len = strcspn(script_position, "\n");
+    char *line = strndup(script_position, len);
+    assert(line != NULL);
+    script_position += script_position[len] == '\n' ? len + 1 : len;
+    return line;
+}
+
+/*
+ * Runs the lines of the command string given with -c, without prompt nor history, and returns the last status
+ */
+int run_script(const char *script) {
+    script_position = script;
+    char *line;
+    while ((line = read_script_line()) != NULL) {
+        while (is_incomplete_input(line)) {
+            char *next_line = read_script_line();
+            if (next_line == NULL) {
+                break;
+            }
+            line = join_continuation_line(line, next_line);
+            free(next_line);
+        }
+        unsigned long long parse_start_time = event_log_time();
+        current_pipeline_list = parse_pipeline_list(line);
+        log_parse_event(line, current_pipeline_list == NULL ? 0 : current_pipeline_list->pipeline_count,
+                        parse_start_time);
+        record_flight_event(FLIGHT_PARSE, getpid(),
+                            current_pipeline_list == NULL ? -1 : (int)current_pipeline_list->pipeline_count, line);
+        free(line);
         if (current_pipeline_list == NULL) {
             last_command_exit_value = COMMAND_FAILURE;
             continue;
         }
+        read_here_documents(current_pipeline_list, read_script_line);
+        last_command_exit_value = run_pipeline_list(current_pipeline_list);
+        update_status_of_jobs();
+        remove_terminated_jobs(false);
+        free_pipeline_list(current_pipeline_list);
+        current_pipeline_list = NULL;
+        flush_event_log();
+    }
+    return last_command_exit_value;
+}
 
-        int run_output = run_pipeline_list(current_pipeline_list);
+void add_loaded_history_line(const char *line) {
+    add_history(line);
+}
 
-        last_command_exit_value = run_output;
-        update_status_of_jobs();
-        remove_terminated_jobs(true);
+/*
+ * Shows the newest line of the history file containing the query before the given record, returns its index or -1
+ */
+long show_history_match(const char *query, size_t before) {
+    long match = search_history_file(query, before);
+    // The same line is skipped, as it would not seem to move
+    while (match != -1) {
+        size_t len;
+        const char *line = history_file_record(match, &len);
+        if (strlen(rl_line_buffer) != len || strncmp(rl_line_buffer, line, len) != 0) {
+            char *copy = strndup(line, len);
+            rl_replace_line(copy, 0);
+            rl_point = strstr(copy, query) - copy;
+            free(copy);
+            return match;
+        }
+        match = search_history_file(query, match);
+    }
+    return -1;
+}
 
-        free(last_line_read);
-        free_pipeline_list_without_jobs(current_pipeline_list);
-        current_pipeline_list = NULL;
+/*
+ * Replaces the reverse search of readline (Ctrl-R) by a search in the index of the history file.
+ * As with readline, Ctrl-R looks for an older match, Ctrl-G restores the line, Enter runs the match,
+ * and any other key keeps it and is then handled as usual
+ */
+int search_history_backward(int count, int key) {
+    if (!is_history_file_open()) {
+        return rl_reverse_search_history(count, key);
+    }
+
+    static char last_query[HISTORY_SEARCH_QUERY_SIZE] = "";
+    char query[HISTORY_SEARCH_QUERY_SIZE] = "";
+    size_t query_len = 0;
+    char *original_line = strdup(rl_line_buffer);
+    int original_point = rl_point;
+    long match = -1;
+    bool failed = false;
+
+    while (1) {
+        rl_message("(history-search)%s`%s': ", failed ? " failed " : "", query);
+        int c = rl_read_key();
+
+        if (c == CTRL('G')) {
+            rl_replace_line(original_line, 0);
+            rl_point = original_point;
+            break;
+        }
+        if (c == '\r' || c == '\n') {
+            rl_clear_message();
+            free(original_line);
+            if (query_len > 0) {
+                strcpy(last_query, query);
+            }
+            return rl_newline(1, c);
+        }
+
+        if (c == CTRL('R')) {
+            if (query_len == 0) {
+                strcpy(query, last_query);
+                query_len = strlen(query);
+            }
+        } else if (c == RUBOUT || c == CTRL('H')) {
+            if (query_len > 0) {
+                query[--query_len] = '\0';
+            }
+            // A shorter query may match a newer line
+            match = -1;
+        } else if ((isprint(c) || c >= 0x80) && query_len + 1 < HISTORY_SEARCH_QUERY_SIZE) {
+            query[query_len++] = c;
+            query[query_len] = '\0';
+            // The current match is kept while it still contains the query
+            if (match != -1 && strstr(rl_line_buffer, query) != NULL) {
+                failed = false;
+                continue;
+            }
+        } else {
+            rl_execute_next(c);
+            break;
+        }
+
+        if (query_len == 0) {
+            failed = false;
+            continue;
+        }
+        long found = show_history_match(query, match == -1 ? history_file_record_count() : (size_t)match);
+        failed = found == -1;
+        match = failed ? match : found;
+    }
+
+    if (query_len > 0) {
+        strcpy(last_query, query);
+    }
+    rl_clear_message();
+    free(original_line);
+    return 0;
+}
+
+/*
+ * Called by readline once a line is complete
+ */
+void handle_line(char *line) {
+    // The commands may use the terminal, and the prompt may change with them
+    rl_callback_handler_remove();
+    if (!run_line(line)) {
+        stop_event_loop();
+        return;
+    }
+    rl_callback_handler_install(prompt, handle_line);
+}
+
+void handle_input(int fd, void *data) {
+    rl_callback_read_char();
+}
+
+/*
+ * Prints the changes of status of the jobs as soon as they happen, above the line being typed
+ */
+void handle_child_signal(int fd, void *data) {
+    struct signalfd_siginfo info;
+    while (read(fd, &info, sizeof(info)) == sizeof(info)) {
+        record_flight_event(FLIGHT_SIGNAL_RECEIVED, info.ssi_pid, info.ssi_signo, NULL);
+    }
+
+    if (!jobs_have_status_changes()) {
+        return;
+    }
+
+    rl_clear_visible_line();
+    update_status_of_jobs();
+    remove_terminated_jobs(true);
+    rl_set_prompt(prompt);
+    rl_forced_update_display();
+}
+
+/*
+ * Shows the segments of the prompt computed in the background as soon as they are ready
+ */
+void handle_prompt_segments(int fd, void *data) {
+    acknowledge_prompt_segments();
+    update_prompt();
+    if (rl_prompt == NULL || strcmp(rl_prompt, prompt) != 0) {
+        // The old prompt is erased, the new one being drawn from the start of the line
+        rl_clear_visible_line();
+        rl_set_prompt(prompt);
+        rl_forced_update_display();
+    }
+}
+
+/*
+ * Reads and runs the lines in an event loop, so that the jobs are notified while a line is typed.
+ * Returns false if the standard input cannot be watched, without reading anything
+ */
+bool run_event_loop_repl() {
+    if (!init_event_loop()) {
+        return false;
+    }
+    if (!watch_fd(STDIN_FILENO, handle_input, NULL)) {
+        free_event_loop();
+        return false;
+    }
+
+    int child_signal_fd = open_child_signal_fd();
+    if (child_signal_fd != -1) {
+        watch_fd(child_signal_fd, handle_child_signal, NULL);
+    }
+    if (prompt_segments_fd() != -1) {
+        watch_fd(prompt_segments_fd(), handle_prompt_segments, NULL);
+    }
+
+    rl_callback_handler_install(prompt, handle_line);
+    run_event_loop();
+
+    free_event_loop();
+    if (child_signal_fd != -1) {
+        close(child_signal_fd);
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    // Lets readline and the prompt display the multibyte characters of the user's locale
+    setlocale(LC_CTYPE, "");
+    init_core();
+    init_const();
+    use_jsh_signal_management();
+    install_flight_recorder_handlers();
+
+    if (argc == 3 && strcmp(argv[1], "-c") == 0) {
+        int status = run_script(argv[2]);
+        free_core();
+        return status;
+    }
+
+    rl_outstream = stderr;
+    if (open_history_file(NULL)) {
+        load_recent_history(add_loaded_history_line, HISTORY_LOADED_LINES);
+    }
+    rl_bind_key(CTRL('R'), search_history_backward);
+    rl_attempted_completion_function = complete_command;
+    if (!run_event_loop_repl()) {
+        while (run_line(readline(prompt))) {
+        }
     }
 
+    close_history_file();
     free_core();
     return last_command_exit_value;
 }
@@ -0,0 +1,181 @@
+#include "bytecode.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+typedef struct {
+    program *prog;
+    size_t instruction_capacity;
+    size_t pipeline_capacity;
+    size_t loop_capacity;
+} compiler;
+/* A program being compiled, with the capacities of its arrays, doubled as needed */
+
+void compile_list(compiler *c, pipeline_list *pips);
+void compile_compound(compiler *c, GroupType type, compound_command *compound);
+
+/*
+ * Appends an instruction to the program and returns its index
+ */
+size_t emit(compiler *c, Opcode op, size_t loop, size_t arg) {
+    program *prog = c->prog;
+    if (prog->instruction_count == c->instruction_capacity) {
+        c->instruction_capacity *= 2;
+        prog->instructions = realloc(prog->instructions, sizeof(instruction) * c->instruction_capacity);
+        assert(prog->instructions != NULL);
+    }
+    instruction *in = &prog->instructions[prog->instruction_count];
+    in->op = op;
+    in->loop = loop;
+    in->arg = arg;
+    return prog->instruction_count++;
+}
+
+/*
+ * Makes the jump at the given index go on at the next instruction emitted
+ */
+void patch_jump(compiler *c, size_t jump) {
+    c->prog->instructions[jump].arg = c->prog->instruction_count;
+}
+
+size_t add_pipeline_slot(compiler *c, pipeline_list *pips, size_t index) {
+    program *prog = c->prog;
+    if (prog->pipeline_count == c->pipeline_capacity) {
+        c->pipeline_capacity *= 2;
+        prog->pipelines = realloc(prog->pipelines, sizeof(pipeline_slot) * c->pipeline_capacity);
+        assert(prog->pipelines != NULL);
+    }
+    prog->pipelines[prog->pipeline_count].list = pips;
+    prog->pipelines[prog->pipeline_count].index = index;
+    return prog->pipeline_count++;
+}
+
+size_t add_loop(compiler *c, compound_command *compound) {
+    program *prog = c->prog;
+    if (prog->loop_count == c->loop_capacity) {
+        c->loop_capacity *= 2;
+        prog->loops = realloc(prog->loops, sizeof(compound_command *) * c->loop_capacity);
+        assert(prog->loops != NULL);
+    }
+    prog->loops[prog->loop_count] = compound;
+    return prog->loop_count++;
+}
+
+/*
+ * Returns true if the pipeline is a group `{ list; }` or a compound command which can be compiled into the
+ * program: alone in its pipeline, without redirection and not run as a job
+ */
+bool is_inlined_pipeline(const pipeline *pip) {
+    if (pip->to_job || pip->command_count != 1) {
+        return false;
+    }
+    const command *cmd = pip->commands[0];
+    return cmd->redirection_count == 0 && cmd->group_type != GROUP_NONE && cmd->group_type != GROUP_SUBSHELL &&
+           cmd->group_type != GROUP_FUNCTION;
+}
+
+void compile_list(compiler *c, pipeline_list *pips) {
+    for (size_t i = 0; i < pips->pipeline_count; i++) {
+        // A pipeline after `&&` or `||` is skipped according to the last status, kept for the next one
+        ListOperator op = i == 0 ? LIST_SEQUENCE : pips->operators[i - 1];
+        size_t skip = 0;
+        if (op == LIST_AND) {
+            skip = emit(c, OP_JUMP_IF_FAILURE, 0, 0);
+        } else if (op == LIST_OR) {
+            skip = emit(c, OP_JUMP_IF_SUCCESS, 0, 0);
+        }
+
+        pipeline *pip = pips->pipelines[i];
+        if (!is_inlined_pipeline(pip)) {
+            emit(c, OP_RUN, 0, add_pipeline_slot(c, pips, i));
+        } else if (pip->commands[0]->group_type == GROUP_BRACES) {
+            compile_list(c, pip->commands[0]->group);
+        } else {
+            compile_compound(c, pip->commands[0]->group_type, pip->commands[0]->compound);
+        }
+
+        if (op != LIST_SEQUENCE) {
+            patch_jump(c, skip);
+        }
+    }
+}
+
+void compile_if(compiler *c, compound_command *compound) {
+    size_t ends[compound->clause_count];
+    for (size_t i = 0; i < compound->clause_count; i++) {
+        compile_list(c, compound->conditions[i]);
+        size_t next_clause = emit(c, OP_JUMP_IF_FAILURE, 0, 0);
+        compile_list(c, compound->bodies[i]);
+        ends[i] = emit(c, OP_JUMP, 0, 0);
+        patch_jump(c, next_clause);
+    }
+    // Without a clause run, the status of `if` is SUCCESS
+    if (compound->else_body != NULL) {
+        compile_list(c, compound->else_body);
+    } else {
+        emit(c, OP_SET_STATUS, 0, 0);
+    }
+    for (size_t i = 0; i < compound->clause_count; i++) {
+        patch_jump(c, ends[i]);
+    }
+}
+
+void compile_while(compiler *c, compound_command *compound, bool until) {
+    size_t loop = add_loop(c, NULL);
+    emit(c, OP_LOOP_START, loop, 0);
+    size_t condition = c->prog->instruction_count;
+    compile_list(c, compound->conditions[0]);
+    size_t exit = emit(c, until ? OP_JUMP_IF_SUCCESS : OP_JUMP_IF_FAILURE, loop, 0);
+    compile_list(c, compound->bodies[0]);
+    emit(c, OP_LOOP_SAVE, loop, 0);
+    emit(c, OP_JUMP, loop, condition);
+    patch_jump(c, exit);
+    emit(c, OP_LOOP_END, loop, 0);
+}
+
+void compile_for(compiler *c, compound_command *compound) {
+    size_t loop = add_loop(c, compound);
+    emit(c, OP_FOR_WORDS, loop, 0);
+    size_t next = emit(c, OP_FOR_NEXT, loop, 0);
+    compile_list(c, compound->bodies[0]);
+    emit(c, OP_LOOP_SAVE, loop, 0);
+    emit(c, OP_JUMP, loop, next);
+    patch_jump(c, next);
+    emit(c, OP_LOOP_END, loop, 0);
+}
+
+void compile_compound(compiler *c, GroupType type, compound_command *compound) {
+    if (type == GROUP_IF) {
+        compile_if(c, compound);
+    } else if (type == GROUP_WHILE || type == GROUP_UNTIL) {
+        compile_while(c, compound, type == GROUP_UNTIL);
+    } else {
+        compile_for(c, compound);
+    }
+}
+
+program *compile_compound_command(GroupType type, compound_command *compound) {
+    program *prog = malloc(sizeof(program));
+    assert(prog != NULL);
+    compiler c = {prog, 16, 8, 2};
+    prog->instruction_count = 0;
+    prog->instructions = malloc(sizeof(instruction) * c.instruction_capacity);
+    prog->pipeline_count = 0;
+    prog->pipelines = malloc(sizeof(pipeline_slot) * c.pipeline_capacity);
+    prog->loop_count = 0;
+    prog->loops = malloc(sizeof(compound_command *) * c.loop_capacity);
+    assert(prog->instructions != NULL && prog->pipelines != NULL && prog->loops != NULL);
+
+    compile_compound(&c, type, compound);
+    return prog;
+}
+
+void free_program(program *prog) {
+    if (prog == NULL) {
+        return;
+    }
+    free(prog->instructions);
+    free(prog->pipelines);
+    free(prog->loops);
+    free(prog);
+}
@@ -0,0 +1,70 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "parser.h"
+
+typedef enum {
+    OP_RUN,
+    OP_JUMP,
+    OP_JUMP_IF_FAILURE,
+    OP_JUMP_IF_SUCCESS,
+    OP_SET_STATUS,
+    OP_LOOP_START,
+    OP_LOOP_SAVE,
+    OP_LOOP_END,
+    OP_FOR_WORDS,
+    OP_FOR_NEXT,
+} Opcode;
+/* Instructions of a program, which has a current status, the status of the last pipeline run:
+ *  - OP_RUN: runs the pipeline arg, its status becoming the current one
+ *  - OP_JUMP: goes on at the instruction arg
+ *  - OP_JUMP_IF_FAILURE: goes on at the instruction arg if the current status is not SUCCESS
+ *  - OP_JUMP_IF_SUCCESS: goes on at the instruction arg if the current status is SUCCESS
+ *  - OP_SET_STATUS: sets the current status to arg
+ *  - OP_LOOP_START: sets the status of the loop to SUCCESS, the status of a loop whose body never runs
+ *  - OP_LOOP_SAVE: sets the status of the loop to the current status, at the end of its body
+ *  - OP_LOOP_END: sets the current status to the status of the loop
+ *  - OP_FOR_WORDS: expands the words of the `for` loop and sets the status of the loop to SUCCESS
+ *  - OP_FOR_NEXT: assigns the next word of the `for` loop to its variable, or goes on at the instruction arg
+ *    once they have all been assigned
+ */
+
+typedef struct {
+    uint8_t op;
+    uint16_t loop;
+    uint32_t arg;
+} instruction;
+/* An instruction, loop being the index of the loop it is about */
+
+typedef struct {
+    pipeline_list *list;
+    size_t index;
+} pipeline_slot;
+/* A pipeline of a program, found in its list, where it is replaced by a copy once it has become a job */
+
+struct program {
+    size_t instruction_count;
+    instruction *instructions;
+    size_t pipeline_count;
+    pipeline_slot *pipelines;
+    size_t loop_count;
+    compound_command **loops;
+};
+/*
+ * A compound command compiled to instructions, run by a loop dispatching them. The lists of the compound command
+ * are flattened into jumps around the pipelines they run, as are the compound commands and the groups `{ list; }`
+ * nested in it which are neither redirected, piped nor run as a job, so that a loop does not go through the
+ * structure of its body at each iteration. loops has the compound command of each `for` loop, and NULL for the
+ * other loops. The pipelines and the compound commands are borrowed from the compound command compiled.
+ */
+
+program *compile_compound_command(GroupType type, compound_command *compound);
+/* Compiles the compound command of the given type, `if`, `while`, `until` or `for`, into a new program */
+
+void free_program(program *prog);
+/* Frees the program, without the pipelines and compound commands it borrows */
+
+#endif
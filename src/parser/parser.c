@@ -1,11 +1,18 @@
 #include "parser.h"
+#include "../utils/functions.h"
+#include "../utils/signal_management.h"
 #include "../utils/string_utils.h"
+#include "../utils/variables.h"
+#include "bytecode.h"
 #include <assert.h>
+#include <ctype.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+char *str_of_command(const command *cmd);
+
 /**
  * Returns the string corresponding to a redirection
  * Example :
@@ -16,6 +23,10 @@ char *str_of_redirection(redirection *redir) {
     char *s;
     if (redir->type == REDIRECT_STDIN && redir->mode == REDIRECT_NONE) {
         s = strdup("<");
+    } else if (redir->type == REDIRECT_STDIN && redir->mode == REDIRECT_HERE_DOCUMENT) {
+        s = strdup("<<");
+    } else if (redir->type == REDIRECT_STDIN && redir->mode == REDIRECT_HERE_STRING) {
+        s = strdup("<<<");
     } else if (redir->type == REDIRECT_STDOUT && redir->mode == REDIRECT_NO_OVERWRITE) {
         s = strdup(">");
     } else if (redir->type == REDIRECT_STDOUT && redir->mode == REDIRECT_OVERWRITE) {
@@ -37,19 +48,158 @@ char *str_of_redirection(redirection *redir) {
     return result;
 }
 
+/**
+ * Returns the characters opening a substitution argument
+ */
+const char *str_of_substitution_opening(const argument *arg) {
+    if (arg->type == ARG_SUBSTITUTION) {
+        return "<( ";
+    }
+    if (arg->type == ARG_OUTPUT_SUBSTITUTION) {
+        return ">( ";
+    }
+    return "$( ";
+}
+
+char *str_of_argument(const argument *arg) {
+    if (arg->type == ARG_SIMPLE) {
+        char *result = strdup(arg->value.simple);
+        assert(result != NULL);
+        return result;
+    }
+    if (arg->type == ARG_WORD) {
+        char *result = NULL;
+        size_t result_length = 0;
+        FILE *stream = open_memstream(&result, &result_length);
+        assert(stream != NULL);
+        for (size_t i = 0; i < arg->value.word.part_count; i++) {
+            char *part = str_of_argument(arg->value.word.parts[i]);
+            fputs(part, stream);
+            free(part);
+        }
+        fclose(stream);
+        return result;
+    }
+    char *substitution = str_of_pipeline(arg->value.substitution);
+    char *result = malloc(strlen(substitution) + 6); // For the `<( ` (or `>( `, `$( `) and ` )` characters
+    assert(result != NULL);
+    sprintf(result, "%s%s )", str_of_substitution_opening(arg), substitution);
+    free(substitution);
+    return result;
+}
+
+/**
+ * Prints a group, its list between its braces or parentheses, and its redirections
+ */
+char *str_of_group(const command *cmd) {
+    char *list = str_of_pipeline_list(cmd->group);
+    size_t list_len = strlen(list);
+    bool ends_with_job = list_len > 0 && list[list_len - 1] == TOKEN_PIPELINE_DELIM_C;
+    const char *opening = cmd->group_type == GROUP_BRACES ? "{ " : "( ";
+    const char *closing = cmd->group_type == GROUP_SUBSHELL ? " )" : ends_with_job ? " }" : "; }";
+
+    size_t result_length = strlen(opening) + list_len + strlen(closing) + 1;
+    char *redirections[cmd->redirection_count + 1];
+    for (size_t i = 0; i < cmd->redirection_count; ++i) {
+        redirections[i] = str_of_redirection(cmd->redirections + i);
+        result_length += strlen(redirections[i]);
+    }
+
+    char *result = malloc(result_length * sizeof(char));
+    assert(result != NULL);
+    int marker = snprintf(result, result_length, "%s%s%s", opening, list, closing);
+    for (size_t i = 0; i < cmd->redirection_count; ++i) {
+        marker += snprintf(result + marker, result_length - marker, "%s", redirections[i]);
+        free(redirections[i]);
+    }
+    free(list);
+    return result;
+}
+
+/**
+ * Prints a list of a compound command followed by the reserved word after it, such as "ls; then"
+ */
+void print_clause(FILE *stream, const pipeline_list *pips, const char *next_word) {
+    char *list = str_of_pipeline_list(pips);
+    size_t list_len = strlen(list);
+    bool ends_with_job = list_len > 0 && list[list_len - 1] == TOKEN_PIPELINE_DELIM_C;
+    fprintf(stream, "%s%s %s", list, ends_with_job ? "" : ";", next_word);
+    free(list);
+}
+
+/**
+ * Prints a compound command on a single line, and its redirections
+ */
+char *str_of_compound(const command *cmd) {
+    const compound_command *compound = cmd->compound;
+    char *result = NULL;
+    size_t result_length = 0;
+    FILE *stream = open_memstream(&result, &result_length);
+    assert(stream != NULL);
+
+    if (cmd->group_type == GROUP_IF) {
+        for (size_t i = 0; i < compound->clause_count; i++) {
+            bool is_last = i + 1 == compound->clause_count && compound->else_body == NULL;
+            fputs(i == 0 ? "if " : "elif ", stream);
+            print_clause(stream, compound->conditions[i], "then ");
+            print_clause(stream, compound->bodies[i], is_last ? "fi" : "");
+        }
+        if (compound->else_body != NULL) {
+            fputs("else ", stream);
+            print_clause(stream, compound->else_body, "fi");
+        }
+    } else {
+        if (cmd->group_type == GROUP_FOR) {
+            char *words = str_of_command(compound->words);
+            fprintf(stream, "for %s; do ", words);
+            free(words);
+        } else {
+            fputs(cmd->group_type == GROUP_WHILE ? "while " : "until ", stream);
+            print_clause(stream, compound->conditions[0], "do ");
+        }
+        print_clause(stream, compound->bodies[0], "done");
+    }
+
+    for (size_t i = 0; i < cmd->redirection_count; ++i) {
+        char *redirection = str_of_redirection(cmd->redirections + i);
+        fputs(redirection, stream);
+        free(redirection);
+    }
+    fclose(stream);
+    return result;
+}
+
+/**
+ * Prints the definition of a function, its name followed by its body
+ */
+char *str_of_function_definition(const command *cmd) {
+    char *body = str_of_command(cmd->group->pipelines[0]->commands[0]);
+    char *result = malloc(strlen(cmd->name) + strlen(body) + 4);
+    assert(result != NULL);
+    sprintf(result, "%s() %s", cmd->name, body);
+    free(body);
+    return result;
+}
+
 /**
  * Prints a command, its arguments and options
  */
 char *str_of_command(const command *cmd) {
+    if (cmd->group_type == GROUP_FUNCTION) {
+        return str_of_function_definition(cmd);
+    }
+    if (cmd->compound != NULL) {
+        return str_of_compound(cmd);
+    }
+    if (cmd->group != NULL) {
+        return str_of_group(cmd);
+    }
     size_t result_length = 1;
 
+    char *arguments[cmd->argc + 1];
     for (size_t i = 0; i < cmd->argc; ++i) {
-        if (cmd->argv[i]->type == ARG_SIMPLE) {
-            result_length += strlen(cmd->argv[i]->value.simple);
-        } else {
-            result_length += strlen(str_of_pipeline(cmd->argv[i]->value.substitution));
-            result_length += 5; // For the `<(` and `)` characters
-        }
+        arguments[i] = str_of_argument(cmd->argv[i]);
+        result_length += strlen(arguments[i]);
 
         if (i < cmd->argc - 1) {
             result_length += 1;
@@ -64,7 +214,8 @@ char *str_of_command(const command *cmd) {
             result_length += 4 + strlen((cmd->redirections + i)->filename);
         } else if (redir_type == REDIRECT_STDOUT && redir_mode == REDIRECT_NO_OVERWRITE) {
             result_length += 4 + strlen((cmd->redirections + i)->filename);
-        } else if (redir_type == REDIRECT_STDERR && redir_mode == REDIRECT_APPEND) {
+        } else if ((redir_type == REDIRECT_STDERR && redir_mode == REDIRECT_APPEND) ||
+                   redir_mode == REDIRECT_HERE_STRING) {
             result_length += 6 + strlen((cmd->redirections + i)->filename);
         } else {
             result_length += 5 + strlen((cmd->redirections + i)->filename);
@@ -75,17 +226,8 @@ char *str_of_command(const command *cmd) {
     int marker = 0;
 
     for (size_t i = 0; i < cmd->argc; ++i) {
-
-        if (cmd->argv[i]->type == ARG_SIMPLE) {
-            marker +=
-                snprintf(result + marker, strlen(cmd->argv[i]->value.simple) + 1, "%s", cmd->argv[i]->value.simple);
-        } else {
-            char *substitution = str_of_pipeline(cmd->argv[i]->value.substitution);
-            marker += snprintf(result + marker, 4, "%s", "<( ");
-            marker += snprintf(result + marker, strlen(substitution) + 1, "%s", substitution);
-            marker += snprintf(result + marker, 3, "%s", " )");
-            free(substitution);
-        }
+        marker += snprintf(result + marker, strlen(arguments[i]) + 1, "%s", arguments[i]);
+        free(arguments[i]);
 
         if (i < cmd->argc - 1) {
             result[marker] = ' ';
@@ -104,7 +246,16 @@ char *str_of_command(const command *cmd) {
 }
 
 char *str_of_pipeline(pipeline *p) {
-    int result_length = 1;
+    char prefix[64] = "";
+    if (p->timeout_ms > 0) {
+        int len = p->timeout_ms % 1000 == 0
+                      ? snprintf(prefix, sizeof(prefix), "timeout %lu ", p->timeout_ms / 1000)
+                      : snprintf(prefix, sizeof(prefix), "timeout %lu.%03lu ", p->timeout_ms / 1000, p->timeout_ms % 1000);
+        if (p->timeout_signal != SIGTERM) {
+            snprintf(prefix + len, sizeof(prefix) - len, "-s %d ", p->timeout_signal);
+        }
+    }
+    int result_length = 1 + strlen(prefix);
 
     for (size_t i = 0; i < p->command_count; ++i) {
         char *cmd = str_of_command(p->commands[i]);
@@ -116,7 +267,7 @@ char *str_of_pipeline(pipeline *p) {
     }
 
     char *result = malloc(result_length * sizeof(char));
-    int marker = 0;
+    int marker = sprintf(result, "%s", prefix);
 
     for (size_t i = 0; i < p->command_count; ++i) {
         char *cmd = str_of_command(p->commands[i]);
@@ -134,6 +285,52 @@ char *str_of_pipeline(pipeline *p) {
     return result;
 }
 
+/**
+ * Returns the characters following a pipeline of a list, according to its operator
+ */
+const char *str_of_list_operator(const pipeline *pip, ListOperator op, bool is_last) {
+    if (pip->to_job && pip->capture_output) {
+        return is_last ? " &!" : " &! ";
+    }
+    if (pip->to_job) {
+        return is_last ? " &" : " & ";
+    }
+    if (is_last) {
+        return "";
+    }
+    return op == LIST_AND ? " && " : op == LIST_OR ? " || " : "; ";
+}
+
+char *str_of_pipeline_list(const pipeline_list *pips) {
+    // The pipelines which became jobs are no longer in the list
+    size_t last = pips->pipeline_count;
+    while (last > 0 && pips->pipelines[last - 1] == NULL) {
+        last--;
+    }
+
+    size_t result_length = 1;
+    char *pipelines[pips->pipeline_count + 1];
+    for (size_t i = 0; i < last; ++i) {
+        pipelines[i] = pips->pipelines[i] == NULL ? NULL : str_of_pipeline(pips->pipelines[i]);
+        if (pipelines[i] != NULL) {
+            result_length += strlen(pipelines[i]) + 4;
+        }
+    }
+
+    char *result = malloc(result_length * sizeof(char));
+    assert(result != NULL);
+    int marker = 0;
+    for (size_t i = 0; i < last; ++i) {
+        if (pipelines[i] != NULL) {
+            marker += snprintf(result + marker, result_length - marker, "%s%s", pipelines[i],
+                               str_of_list_operator(pips->pipelines[i], pips->operators[i], i == last - 1));
+            free(pipelines[i]);
+        }
+    }
+    result[marker] = '\0';
+    return result;
+}
+
 /*
  * Frees the array of tokens.
  * The tokens must have been allocated with malloc.
@@ -168,6 +365,191 @@ char **tokenize(const char *input, size_t *token_count, const char *delimiter) {
     return tokens;
 }
 
+/*
+ * Returns true if the parenthesis at position i opens a substitution (`<(`, `>(`, `$(`),
+ * or is nested inside one.
+ */
+bool opens_substitution(const char *input, size_t i, size_t substitution_depth) {
+    if (input[i] != '(') {
+        return false;
+    }
+    return substitution_depth > 0 || (i > 0 && (input[i - 1] == '<' || input[i - 1] == '>' || input[i - 1] == '$'));
+}
+
+const char *const reserved_words_before_command[] = {"if", "then", "elif", "else", "while", "until", "do", NULL};
+/* Reserved words which a command follows */
+
+const char *const clause_words[] = {"then", "elif", "else", "do", NULL};
+/* Reserved words separating the clauses of a compound command */
+
+/*
+ * Returns true if the word starting at position i of the input is the reserved word, which is a whole word there
+ */
+bool is_reserved_word_at(const char *input, size_t i, const char *word) {
+    size_t len = strlen(word);
+    if (strncmp(input + i, word, len) != 0 || (i > 0 && strchr(" ;&|(", input[i - 1]) == NULL)) {
+        return false;
+    }
+    return input[i + len] == '\0' || strchr(" ;&|)", input[i + len]) != NULL;
+}
+
+/*
+ * Returns the reserved word of the list starting at position i of the input, or NULL if there is none
+ */
+const char *reserved_word_of_list_at(const char *input, size_t i, const char *const *words) {
+    for (size_t k = 0; words[k] != NULL; k++) {
+        if (is_reserved_word_at(input, i, words[k])) {
+            return words[k];
+        }
+    }
+    return NULL;
+}
+
+bool starts_command_at(const char *input, size_t i);
+
+bool is_function_name_character(char c) {
+    return isalnum((unsigned char)c) || c == '_' || c == '-';
+}
+
+/*
+ * Returns the length of the name of the function whose definition `name()` or `name ( )` starts at position i of the
+ * input, and sets body_start to the position after its parentheses, or returns 0 if no definition starts there
+ */
+size_t function_header_at(const char *input, size_t i, size_t *body_start) {
+    size_t name_len = 0;
+    while (is_function_name_character(input[i + name_len])) {
+        name_len++;
+    }
+    if (name_len == 0 || isdigit((unsigned char)input[i]) || input[i] == '-') {
+        return 0;
+    }
+    size_t k = i + name_len;
+    k += strspn(input + k, " ");
+    if (input[k] != '(') {
+        return 0;
+    }
+    k++;
+    k += strspn(input + k, " ");
+    if (input[k] != ')') {
+        return 0;
+    }
+    *body_start = k + 1;
+    return name_len;
+}
+
+/*
+ * Returns true if the input before position i ends with the header `name()` of a function definition, after which
+ * its body starts as a command
+ */
+bool ends_function_header_at(const char *input, size_t i) {
+    if (i < 3 || input[i - 1] != ')') {
+        return false;
+    }
+    size_t k = i - 1;
+    while (k > 0 && input[k - 1] == TOKEN_COMMAND_DELIM_C) {
+        k--;
+    }
+    if (k == 0 || input[k - 1] != '(') {
+        return false;
+    }
+    k--;
+    while (k > 0 && input[k - 1] == TOKEN_COMMAND_DELIM_C) {
+        k--;
+    }
+    size_t name_start = k;
+    while (name_start > 0 && is_function_name_character(input[name_start - 1])) {
+        name_start--;
+    }
+    size_t body_start;
+    return name_start < k && function_header_at(input, name_start, &body_start) == k - name_start &&
+           starts_command_at(input, name_start);
+}
+
+/*
+ * Returns true if position i of the input is where a command starts: after the start of the input,
+ * an operator, the opening of a group, a reserved word such as `then` or the header of a function definition,
+ * blanks aside
+ */
+bool starts_command_at(const char *input, size_t i) {
+    size_t start = i;
+    while (i > 0 && input[i - 1] == TOKEN_COMMAND_DELIM_C) {
+        i--;
+    }
+    if (i == 0 || strchr(";&|({", input[i - 1]) != NULL) {
+        return true;
+    }
+    if (ends_function_header_at(input, i)) {
+        return true;
+    }
+    // The command after a prefix `timeout DURATION` starts where the prefix ends
+    size_t command_start = i;
+    while (command_start > 0 && strchr(";&|({", input[command_start - 1]) == NULL) {
+        command_start--;
+    }
+    unsigned long timeout_ms;
+    int timeout_signal;
+    if (i != start && timeout_prefix_length(input + command_start, &timeout_ms, &timeout_signal) == start - command_start) {
+        return true;
+    }
+    if (i == start) {
+        return false;
+    }
+    size_t word_start = i;
+    while (word_start > 0 && strchr(" ;&|({", input[word_start - 1]) == NULL) {
+        word_start--;
+    }
+    return reserved_word_of_list_at(input, word_start, reserved_words_before_command) != NULL &&
+           starts_command_at(input, word_start);
+}
+
+/*
+ * Returns the type of the compound command whose reserved word starts at position i of the input, GROUP_NONE if none
+ * does. The position is expected to be where a command starts.
+ */
+GroupType compound_type_at(const char *input, size_t i) {
+    if (is_reserved_word_at(input, i, "if")) {
+        return GROUP_IF;
+    }
+    if (is_reserved_word_at(input, i, "while")) {
+        return GROUP_WHILE;
+    }
+    if (is_reserved_word_at(input, i, "until")) {
+        return GROUP_UNTIL;
+    }
+    if (is_reserved_word_at(input, i, "for")) {
+        return GROUP_FOR;
+    }
+    return GROUP_NONE;
+}
+
+/*
+ * Returns 1 if a parenthesis, a group or a compound command opens at position i of the input, -1 if one closes there,
+ * 0 otherwise. The braces and the reserved words open and close only as whole words where a command starts,
+ * as in `{ ls; }` or `if true; then ls; fi`.
+ */
+int nesting_change_at(const char *input, size_t i) {
+    if (input[i] == '(') {
+        return 1;
+    }
+    if (input[i] == ')') {
+        return -1;
+    }
+    if (strchr("{}iwufd", input[i]) == NULL || input[i] == '\0') {
+        return 0;
+    }
+    int change = 0;
+    if (input[i] == '{' || input[i] == '}') {
+        if (input[i + 1] == '\0' || strchr(" ;&|)", input[i + 1]) != NULL) {
+            change = input[i] == '{' ? 1 : -1;
+        }
+    } else if (compound_type_at(input, i) != GROUP_NONE) {
+        change = 1;
+    } else if (is_reserved_word_at(input, i, "fi") || is_reserved_word_at(input, i, "done")) {
+        change = -1;
+    }
+    return change != 0 && starts_command_at(input, i) ? change : 0;
+}
+
 char **tokenize_command_with_special_pipe(const char *input, size_t *token_count) {
     size_t len_input = strlen(input);
     char **tokens = malloc(MAX_TOKENS * sizeof(char *));
@@ -183,18 +565,17 @@ char **tokenize_command_with_special_pipe(const char *input, size_t *token_count
     size_t count = 0;
 
     while (end < len_input && count < MAX_TOKENS) {
-        if (input[end] == '(' && end > 0 && input[end - 1] == '<') {
+        if (opens_substitution(input, end, substitution_depth)) {
             substitution_depth++;
         } else if (input[end] == ')') {
+            if (substitution_depth == 0) {
+                fprintf(stderr, "jsh: parse error near `%c'\n", input[end]);
+                free_tokens(tokens, count);
+                return NULL;
+            }
             substitution_depth--;
         }
 
-        if (substitution_depth < 0) {
-            fprintf(stderr, "jsh: parse error near `%c'\n", TOKEN_PIPE_DELIM_C);
-            free_tokens(tokens, count);
-            return NULL;
-        }
-
         if (input[end] == ' ' && substitution_depth == 0) {
             if (end - start > 0) {
                 tokens[count] = malloc(sizeof(char) * (end - start + 1));
@@ -229,7 +610,7 @@ char **tokenize_command_with_special_pipe(const char *input, size_t *token_count
 
 /*
  * Tokenizes the input string into an array of tokens considering '|' as delimiter,
- * except when preceded by '>' or within substitutions marked by '<(' and ')'.
+ * except when preceded by '>' or within substitutions marked by '<(' and ')' and groups.
  */
 char **tokenize_pipeline_with_special_pipe(const char *input, size_t *token_count) {
     if (!input || !token_count) {
@@ -244,23 +625,17 @@ char **tokenize_pipeline_with_special_pipe(const char *input, size_t *token_coun
 
     size_t count = 0;
     size_t start = 0;
-    int substitution_depth = 0;
+    size_t substitution_depth = 0;
 
     for (size_t i = 0; i < len_input; i++) {
-        // Handle substitution depth
-        if (input[i] == '<' && (i + 1 < len_input) && input[i + 1] == '(') {
+        // Handle the depth of the substitutions and groups
+        int nesting = nesting_change_at(input, i);
+        if (nesting > 0) {
             substitution_depth++;
-            i++;
-        } else if (input[i] == ')' && substitution_depth > 0) {
+        } else if (nesting < 0 && substitution_depth > 0) {
             substitution_depth--;
         }
 
-        if (substitution_depth < 0) {
-            fprintf(stderr, "jsh: parse error near `%c'\n", input[i]);
-            free_tokens(tokens, count);
-            return NULL;
-        }
-
         // Check for " | " delimiter outside substitutions
         bool is_delimiter = false;
         if (substitution_depth == 0 && i + 2 < len_input) {
@@ -305,7 +680,8 @@ char **tokenize_pipeline_with_special_pipe(const char *input, size_t *token_coun
  * Returns 1 if the token is an redirection symbol, 0 otherwise.
  */
 int is_redirection(const char *token) {
-    return strcmp(token, "<") == 0 || strcmp(token, ">") == 0 || strcmp(token, ">|") == 0 || strcmp(token, ">>") == 0 ||
+    return strcmp(token, "<") == 0 || strcmp(token, "<<") == 0 || strcmp(token, "<<<") == 0 ||
+           strcmp(token, ">") == 0 || strcmp(token, ">|") == 0 || strcmp(token, ">>") == 0 ||
            strcmp(token, "2>") == 0 || strcmp(token, "2>|") == 0 || strcmp(token, "2>>") == 0;
 }
 
@@ -314,6 +690,191 @@ int is_substitution(const char *token) {
     return len > 3 && token[0] == '<' && token[1] == '(' && token[len - 1] == ')';
 }
 
+int is_output_substitution(const char *token) {
+    int len = strlen(token);
+    return len > 3 && token[0] == '>' && token[1] == '(' && token[len - 1] == ')';
+}
+
+/*
+ * Returns the position of the parenthesis closing the one at position open, or the length of the token if it is
+ * not closed
+ */
+size_t closing_parenthesis(const char *token, size_t open) {
+    size_t depth = 0;
+    size_t i = open;
+    for (; token[i] != '\0'; i++) {
+        if (token[i] == '(') {
+            depth++;
+        } else if (token[i] == ')' && --depth == 0) {
+            return i;
+        }
+    }
+    return i;
+}
+
+/*
+ * Returns the position of the first command substitution of the token from start, setting end to the position of
+ * its closing parenthesis, or the length of the token if there is none
+ */
+size_t command_substitution_at(const char *token, size_t start, size_t *end) {
+    size_t i = start;
+    while (token[i] != '\0') {
+        if (token[i] != '$' || token[i + 1] != '(') {
+            i++;
+            continue;
+        }
+        size_t closing = closing_parenthesis(token, i + 1);
+        if (token[closing] == '\0') {
+            break;
+        }
+        // `$((` starts an arithmetic expansion, expanded with the variables
+        if (token[i + 2] != '(') {
+            *end = closing;
+            return i;
+        }
+        i = closing + 1;
+    }
+    return strlen(token);
+}
+
+int is_command_substitution(const char *token) {
+    size_t end = 0;
+    return command_substitution_at(token, 0, &end) == 0 && token[end + 1] == '\0' && end > 2;
+}
+
+bool has_command_substitution(const char *token) {
+    size_t end = 0;
+    return token[command_substitution_at(token, 0, &end)] != '\0';
+}
+
+/*
+ * Returns the type of the argument of a substitution token
+ */
+int substitution_type_of_token(const char *token) {
+    if (is_substitution(token)) {
+        return ARG_SUBSTITUTION;
+    }
+    if (is_output_substitution(token)) {
+        return ARG_OUTPUT_SUBSTITUTION;
+    }
+    return ARG_COMMAND_SUBSTITUTION;
+}
+
+/*
+ * Returns the pipeline of the substitution between the given positions of the token, or NULL and prints an error if
+ * it is invalid or empty
+ */
+pipeline *parse_substitution_of_token(const char *token, size_t start, size_t end) {
+    char *substitution = strndup(token + start, end - start);
+    assert(substitution != NULL);
+    pipeline *substitution_pipeline = parse_pipeline(substitution, false);
+    free(substitution);
+    if (substitution_pipeline == NULL || substitution_pipeline->command_count == 0 ||
+        (substitution_pipeline->command_count == 1 && substitution_pipeline->commands[0]->name == NULL)) {
+        fprintf(stderr, "jsh: parse error near `%s'\n", token);
+        if (substitution_pipeline != NULL) {
+            free_pipeline(substitution_pipeline);
+        }
+        return NULL;
+    }
+    return substitution_pipeline;
+}
+
+/*
+ * Adds a part to the word, a string if pip is NULL and a command substitution otherwise
+ */
+void add_part_to_word(argument *word, char *simple, pipeline *pip) {
+    argument *part = malloc(sizeof(argument));
+    assert(part != NULL);
+    if (pip == NULL) {
+        part->type = ARG_SIMPLE;
+        part->value.simple = simple;
+    } else {
+        part->type = ARG_COMMAND_SUBSTITUTION;
+        part->value.substitution = pip;
+    }
+    word->value.word.parts[word->value.word.part_count++] = part;
+}
+
+/*
+ * Returns the word made of the text and the command substitutions of the token, or NULL if one of them is invalid
+ */
+argument *parse_word(const char *token) {
+    argument *word = malloc(sizeof(argument));
+    assert(word != NULL);
+    word->type = ARG_WORD;
+    word->value.word.part_count = 0;
+    // A part is never empty, so there are fewer of them than characters
+    word->value.word.parts = malloc(sizeof(argument *) * (strlen(token) + 1));
+    assert(word->value.word.parts != NULL);
+
+    size_t start = 0;
+    size_t end = 0;
+    for (size_t i = command_substitution_at(token, 0, &end); token[i] != '\0';
+         i = command_substitution_at(token, start, &end)) {
+        if (i > start) {
+            char *text = strndup(token + start, i - start);
+            assert(text != NULL);
+            add_part_to_word(word, text, NULL);
+        }
+        pipeline *substitution_pipeline = parse_substitution_of_token(token, i + 2, end);
+        if (substitution_pipeline == NULL) {
+            free_argument(word);
+            return NULL;
+        }
+        add_part_to_word(word, NULL, substitution_pipeline);
+        start = end + 1;
+    }
+    if (token[start] != '\0') {
+        char *text = strdup(token + start);
+        assert(text != NULL);
+        add_part_to_word(word, text, NULL);
+    }
+    return word;
+}
+
+argument *parse_argument(const char *token) {
+    if (is_substitution(token) || is_output_substitution(token) || is_command_substitution(token)) {
+        pipeline *substitution_pipeline = parse_substitution_of_token(token, 2, strlen(token) - 1);
+        if (substitution_pipeline == NULL) {
+            return NULL;
+        }
+        argument *arg = malloc(sizeof(argument));
+        assert(arg != NULL);
+        arg->type = substitution_type_of_token(token);
+        arg->value.substitution = substitution_pipeline;
+        return arg;
+    }
+    if (has_command_substitution(token)) {
+        return parse_word(token);
+    }
+    argument *arg = malloc(sizeof(argument));
+    assert(arg != NULL);
+    arg->type = ARG_SIMPLE;
+    arg->value.simple = strdup(token);
+    assert(arg->value.simple != NULL);
+    return arg;
+}
+
+void free_argument(argument *arg) {
+    if (arg == NULL) {
+        return;
+    }
+    if (arg->type == ARG_SIMPLE) {
+        if (arg->value.simple != NULL) {
+            free(arg->value.simple);
+        }
+    } else if (arg->type == ARG_WORD) {
+        for (size_t i = 0; i < arg->value.word.part_count; i++) {
+            free_argument(arg->value.word.parts[i]);
+        }
+        free(arg->value.word.parts);
+    } else if (arg->value.substitution != NULL) {
+        free_pipeline(arg->value.substitution);
+    }
+    free(arg);
+}
+
 void handle_parse_error(char **tokens, size_t token_count, command *cmd) {
     free_tokens(tokens, token_count);
     free_command(cmd);
@@ -350,6 +911,21 @@ command *finalize_command_reallocation(char **tokens, size_t token_count, comman
     return cmd;
 }
 
+/*
+ * Frees the first redirection_count redirections, their filename and content, and the array itself
+ */
+void free_redirections(redirection *redirections, size_t redirection_count) {
+    for (size_t i = 0; i < redirection_count; ++i) {
+        if (redirections[i].filename != NULL) {
+            free(redirections[i].filename);
+        }
+        if (redirections[i].content != NULL) {
+            free(redirections[i].content);
+        }
+    }
+    free(redirections);
+}
+
 void reinitialize_command(command *cmd) {
     if (cmd->name != NULL) {
         free(cmd->name);
@@ -357,32 +933,15 @@ void reinitialize_command(command *cmd) {
     cmd->name = NULL;
     if (cmd->argv != NULL) {
         for (size_t i = 0; i < cmd->argc; ++i) {
-            if (cmd->argv[i]->type == ARG_SIMPLE) {
-                if (cmd->argv[i]->value.simple != NULL) {
-                    free(cmd->argv[i]->value.simple);
-                }
-                cmd->argv[i]->value.simple = NULL;
-            } else {
-                if (cmd->argv[i]->value.substitution != NULL) {
-                    free_pipeline(cmd->argv[i]->value.substitution);
-                }
-                cmd->argv[i]->value.substitution = NULL;
-            }
-            free(cmd->argv[i]);
+            free_argument(cmd->argv[i]);
         }
         free(cmd->argv);
     }
     cmd->argv = NULL;
     cmd->argc = 0;
 
-    for (size_t i = 0; i < cmd->redirection_count; ++i) {
-        if (cmd->redirections[i].filename != NULL) {
-            free(cmd->redirections[i].filename);
-            cmd->redirections[i].filename = NULL;
-        }
-    }
     if (cmd->redirections != NULL) {
-        free(cmd->redirections);
+        free_redirections(cmd->redirections, cmd->redirection_count);
     }
     cmd->redirections = NULL;
     cmd->redirection_count = 0;
@@ -409,12 +968,7 @@ command *parse_redirections(char **tokens, size_t token_count, command *cmd) {
                 reinitialize_command(cmd);
                 fprintf(stderr, "jsh: parse error near `%s'\n", tokens[i]);
                 free_tokens(tokens, token_count);
-                for (size_t i = 0; i < redirection_count; ++i) {
-                    if (redirections[i].filename != NULL) {
-                        free(redirections[i].filename);
-                    }
-                }
-                free(redirections);
+                free_redirections(redirections, redirection_count);
                 free_command(cmd);
                 return NULL;
             }
@@ -422,6 +976,12 @@ command *parse_redirections(char **tokens, size_t token_count, command *cmd) {
             if (strcmp(tokens[i], "<") == 0) {
                 redirections[redirection_count].type = REDIRECT_STDIN;
                 redirections[redirection_count].mode = REDIRECT_NONE;
+            } else if (strcmp(tokens[i], "<<") == 0) {
+                redirections[redirection_count].type = REDIRECT_STDIN;
+                redirections[redirection_count].mode = REDIRECT_HERE_DOCUMENT;
+            } else if (strcmp(tokens[i], "<<<") == 0) {
+                redirections[redirection_count].type = REDIRECT_STDIN;
+                redirections[redirection_count].mode = REDIRECT_HERE_STRING;
             } else if (strcmp(tokens[i], ">") == 0) {
                 redirections[redirection_count].type = REDIRECT_STDOUT;
                 redirections[redirection_count].mode = REDIRECT_NO_OVERWRITE;
@@ -446,79 +1006,46 @@ command *parse_redirections(char **tokens, size_t token_count, command *cmd) {
                 reinitialize_command(cmd);
                 fprintf(stderr, "jsh: parse error near `%s'\n", tokens[i]);
                 free_tokens(tokens, token_count);
-                for (size_t i = 0; i < redirection_count; ++i) {
-                    if (redirections[i].filename != NULL) {
-                        free(redirections[i].filename);
-                    }
-                }
-                free(redirections);
+                free_redirections(redirections, redirection_count);
                 free_command(cmd);
                 return NULL;
             }
 
+            redirections[redirection_count].content = NULL;
             redirections[redirection_count].filename = strdup(tokens[i + 1]);
             if (redirections[redirection_count].filename == NULL) {
                 reinitialize_command(cmd);
                 fprintf(stderr, "jsh: parse error near `%s'\n", tokens[i]);
                 free_tokens(tokens, token_count);
-                for (size_t i = 0; i < redirection_count; ++i) {
-                    if (redirections[i].filename != NULL) {
-                        free(redirections[i].filename);
-                    }
-                }
-                free(redirections);
+                free_redirections(redirections, redirection_count);
                 free_command(cmd);
                 return NULL;
             }
 
+            if (redirections[redirection_count].mode == REDIRECT_HERE_STRING) {
+                // The body of a here-string is the word followed by a newline
+                redirections[redirection_count].content = concat_with_delimiter(tokens[i + 1], "", '\n');
+            }
+
             ++redirection_count;
             i += 2;
-        } else {
+        } else if (is_output_substitution(tokens[i])) {
+            // An output substitution among the redirections is one more target of the standard output
+            redirections[redirection_count].type = REDIRECT_STDOUT;
+            redirections[redirection_count].mode = REDIRECT_NO_OVERWRITE;
+            redirections[redirection_count].filename = strdup(tokens[i]);
+            redirections[redirection_count].content = NULL;
+            assert(redirections[redirection_count].filename != NULL);
 
-            cmd->argv[cmd->argc] = malloc(sizeof(argument));
-            if (is_substitution(tokens[i])) {
-                cmd->argv[cmd->argc]->type = ARG_SUBSTITUTION;
-
-                char *substitution = strdup(tokens[i] + 2);
-                substitution[strlen(substitution) - 1] = '\0';
-                pipeline *substitution_pipeline = parse_pipeline(substitution, false);
-                if (substitution_pipeline == NULL ||
-                    (cmd->argv[cmd->argc]->value.substitution->command_count == 1 &&
-                     cmd->argv[cmd->argc]->value.substitution->commands[0]->name == NULL)) {
-                    fprintf(stderr, "jsh: parse error near `%s'\n", tokens[i]);
-                    free(substitution);
-                    handle_parse_error(tokens, token_count, cmd);
-                    for (size_t i = 0; i < redirection_count; ++i) {
-                        if (redirections[i].filename != NULL) {
-                            free(redirections[i].filename);
-                        }
-                    }
-                    free(redirections);
-
-                    if (substitution_pipeline != NULL) {
-                        free_pipeline(substitution_pipeline);
-                    }
-                    return NULL;
-                }
-
-                cmd->argv[cmd->argc]->value.substitution = substitution_pipeline;
+            ++redirection_count;
+            ++i;
+        } else {
 
-                free(substitution);
-            } else {
-                cmd->argv[cmd->argc]->type = ARG_SIMPLE;
-                cmd->argv[cmd->argc]->value.simple = strdup(tokens[i]);
-
-                if (cmd->argv[cmd->argc]->value.simple == NULL) {
-                    fprintf(stderr, "jsh: parse error near `%s'\n", tokens[i]);
-                    handle_parse_error(tokens, token_count, cmd);
-                    for (size_t i = 0; i < redirection_count; ++i) {
-                        if (redirections[i].filename != NULL) {
-                            free(redirections[i].filename);
-                        }
-                    }
-                    free(redirections);
-                    return NULL;
-                }
+            cmd->argv[cmd->argc] = parse_argument(tokens[i]);
+            if (cmd->argv[cmd->argc] == NULL) {
+                handle_parse_error(tokens, token_count, cmd);
+                free_redirections(redirections, redirection_count);
+                return NULL;
             }
             ++cmd->argc;
             ++i;
@@ -528,18 +1055,348 @@ command *parse_redirections(char **tokens, size_t token_count, command *cmd) {
     }
 
     if (finalize_command_reallocation(tokens, token_count, cmd, redirection_count, redirections) == NULL) {
-        for (size_t i = 0; i < redirection_count; ++i) {
-            if (redirections[i].filename != NULL) {
-                free(redirections[i].filename);
+        free_redirections(redirections, redirection_count);
+        return NULL;
+    }
+    return cmd;
+}
+
+/*
+ * Returns true if all the pipelines of the list are empty
+ */
+bool is_empty_pipeline_list(const pipeline_list *pips) {
+    for (size_t i = 0; i < pips->pipeline_count; i++) {
+        const pipeline *pip = pips->pipelines[i];
+        if (pip->command_count > 1 || (pip->command_count == 1 && pip->commands[0]->name != NULL)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+pipeline_list *parse_list(const char *input);
+
+/*
+ * Parses the list between the given positions of the input, which cannot be empty. next_word is what follows it,
+ * for the error.
+ */
+pipeline_list *parse_clause(const char *input, size_t start, size_t end, const char *next_word) {
+    // The blanks ending the list are removed, so that `{ ls; }` is the single pipeline `ls`
+    while (end > start && input[end - 1] == TOKEN_COMMAND_DELIM_C) {
+        end--;
+    }
+    char *body = strndup(input + start, end - start);
+    assert(body != NULL);
+    pipeline_list *pips = parse_list(body);
+    free(body);
+    if (pips == NULL) {
+        return NULL;
+    }
+    if (is_empty_pipeline_list(pips)) {
+        fprintf(stderr, "jsh: parse error near `%s'\n", next_word);
+        free_pipeline_list(pips);
+        return NULL;
+    }
+    return pips;
+}
+
+/*
+ * Parses what follows a group or a compound command, which can only be redirections, into a command with
+ * the given name as its only argument
+ */
+command *parse_group_redirections(const char *name, const char *rest) {
+    char *input = concat_with_delimiter(name, rest, TOKEN_COMMAND_DELIM_C);
+    size_t token_count = 0;
+    char **tokens = tokenize_command_with_special_pipe(input, &token_count);
+    free(input);
+    if (tokens == NULL) {
+        return NULL;
+    }
+
+    command *cmd = malloc(sizeof(command));
+    assert(cmd != NULL);
+    cmd->name = strdup(name);
+    cmd->argv = malloc(sizeof(argument *) * (token_count + 1));
+    assert(cmd->name != NULL && cmd->argv != NULL);
+    cmd->argv[0] = malloc(sizeof(argument));
+    assert(cmd->argv[0] != NULL);
+    cmd->argv[0]->type = ARG_SIMPLE;
+    cmd->argv[0]->value.simple = strdup(name);
+    cmd->argv[1] = NULL;
+    cmd->argc = 1;
+    cmd->redirection_count = 0;
+    cmd->redirections = NULL;
+    cmd->group_type = GROUP_NONE;
+    cmd->group = NULL;
+    cmd->compound = NULL;
+
+    if (parse_redirections(tokens, token_count, cmd) == NULL) {
+        return NULL;
+    }
+    if (cmd->argc > 1) {
+        fprintf(stderr, "jsh: parse error near `%s'\n",
+                cmd->argv[1]->type == ARG_SIMPLE ? cmd->argv[1]->value.simple : name);
+        free_command(cmd);
+        return NULL;
+    }
+    return cmd;
+}
+
+/*
+ * Parses a group `{ list; }` or `( list )` starting at the first character of the input, followed by its
+ * redirections. The group is a command named after its opening character.
+ */
+command *parse_group(const char *input) {
+    GroupType group_type = input[0] == '{' ? GROUP_BRACES : GROUP_SUBSHELL;
+    char closing = group_type == GROUP_BRACES ? '}' : ')';
+
+    size_t depth = 0;
+    size_t end = 0;
+    for (; input[end] != '\0'; end++) {
+        int nesting = nesting_change_at(input, end);
+        if (nesting > 0) {
+            depth++;
+        } else if (nesting < 0 && --depth == 0) {
+            break;
+        }
+    }
+    if (input[end] != closing) {
+        const char *unexpected = input[end] == '\0' ? input : input + end;
+        fprintf(stderr, "jsh: parse error near `%.*s'\n", (int)strcspn(unexpected + 1, " ;&|") + 1, unexpected);
+        return NULL;
+    }
+
+    char closing_word[2] = {closing, '\0'};
+    pipeline_list *group = parse_clause(input, 1, end, closing_word);
+    if (group == NULL) {
+        return NULL;
+    }
+
+    char name[2] = {input[0], '\0'};
+    command *cmd = parse_group_redirections(name, input + end + 1);
+    if (cmd == NULL) {
+        free_pipeline_list(group);
+        return NULL;
+    }
+    cmd->group_type = group_type;
+    cmd->group = group;
+    return cmd;
+}
+
+/*
+ * Parses the header `name in words...` of a `for` loop, between the given positions of the input, into a command
+ * whose arguments from the third one are the words
+ */
+command *parse_for_words(const char *input, size_t start, size_t end) {
+    // The header ends with the `;` before `do`
+    while (end > start && input[end - 1] == TOKEN_COMMAND_DELIM_C) {
+        end--;
+    }
+    if (end > start && input[end - 1] == TOKEN_SEQUENCE_DELIM_C) {
+        end--;
+    }
+    char *header = strndup(input + start, end - start);
+    assert(header != NULL);
+    command *words = parse_command(header);
+    free(header);
+    if (words == NULL) {
+        return NULL;
+    }
+    if (words->argc < 2 || words->redirection_count > 0 || words->group_type != GROUP_NONE ||
+        words->argv[0]->type != ARG_SIMPLE || !is_variable_name(words->name, strlen(words->name)) ||
+        words->argv[1]->type != ARG_SIMPLE || strcmp(words->argv[1]->value.simple, "in") != 0) {
+        fprintf(stderr, "jsh: parse error near `for'\n");
+        free_command(words);
+        return NULL;
+    }
+    return words;
+}
+
+/*
+ * Returns true if the reserved words separating the clauses of the compound command follow its grammar:
+ * `then`, then `elif` and `then` or `else` for `if`, and a single `do` for the loops. Prints the error otherwise.
+ */
+bool has_valid_clause_words(GroupType type, const char **words, size_t word_count, const char *closing) {
+    const char *unexpected = word_count == 0 ? closing : NULL;
+    for (size_t k = 0; k < word_count && unexpected == NULL; k++) {
+        const char *previous = k == 0 ? NULL : words[k - 1];
+        bool valid;
+        if (type != GROUP_IF) {
+            valid = k == 0 && strcmp(words[k], "do") == 0;
+        } else if (strcmp(words[k], "then") == 0) {
+            valid = previous == NULL || strcmp(previous, "elif") == 0;
+        } else {
+            valid = previous != NULL && strcmp(previous, "then") == 0 && strcmp(words[k], "do") != 0;
+        }
+        if (!valid) {
+            unexpected = words[k];
+        }
+    }
+    // `if` ends after a body, not after a condition
+    if (unexpected == NULL && type == GROUP_IF && strcmp(words[word_count - 1], "elif") == 0) {
+        unexpected = closing;
+    }
+    if (unexpected != NULL) {
+        fprintf(stderr, "jsh: parse error near `%s'\n", unexpected);
+        return false;
+    }
+    return true;
+}
+
+compound_command *init_compound_command(size_t clause_count) {
+    compound_command *compound = malloc(sizeof(compound_command));
+    assert(compound != NULL);
+    compound->clause_count = clause_count;
+    compound->conditions = calloc(clause_count, sizeof(pipeline_list *));
+    compound->bodies = calloc(clause_count, sizeof(pipeline_list *));
+    assert(compound->conditions != NULL && compound->bodies != NULL);
+    compound->else_body = NULL;
+    compound->words = NULL;
+    compound->program = NULL;
+    return compound;
+}
+
+/*
+ * Parses the compound command of the given type starting at the first character of the input, followed by its
+ * redirections. The compound command is a command named after its first reserved word.
+ */
+command *parse_compound_command(const char *input, GroupType type) {
+    const char *opening = type == GROUP_IF ? "if" : type == GROUP_WHILE ? "while" : type == GROUP_UNTIL ? "until" : "for";
+    const char *closing = type == GROUP_IF ? "fi" : "done";
+
+    // The reserved words of the compound command itself are those at depth 1
+    const char *words[MAX_TOKENS];
+    size_t positions[MAX_TOKENS + 1];
+    size_t word_count = 0;
+    size_t depth = 0;
+    size_t end = 0;
+    for (; input[end] != '\0'; end++) {
+        int nesting = nesting_change_at(input, end);
+        if (nesting > 0) {
+            depth++;
+        } else if (nesting < 0 && --depth == 0) {
+            break;
+        } else if (depth == 1 && word_count < MAX_TOKENS) {
+            const char *word = reserved_word_of_list_at(input, end, clause_words);
+            if (word != NULL && starts_command_at(input, end)) {
+                words[word_count] = word;
+                positions[word_count++] = end;
             }
         }
-        free(redirections);
+    }
+    if (input[end] == '\0') {
+        fprintf(stderr, "jsh: parse error near `%s'\n", opening);
+        return NULL;
+    }
+    if (!is_reserved_word_at(input, end, closing)) {
+        fprintf(stderr, "jsh: parse error near `%.*s'\n", (int)strcspn(input + end + 1, " ;&|") + 1, input + end);
+        return NULL;
+    }
+    if (!has_valid_clause_words(type, words, word_count, closing)) {
         return NULL;
     }
+    positions[word_count] = end;
+
+    // Each clause goes from the end of the reserved word before it to the start of the one after it
+    size_t clause_count = type == GROUP_IF ? (word_count + 1) / 2 : 1;
+    compound_command *compound = init_compound_command(clause_count);
+    bool parsed = true;
+    size_t clause_start = strlen(opening);
+    for (size_t k = 0; k <= word_count && parsed; k++) {
+        const char *next_word = k < word_count ? words[k] : closing;
+        pipeline_list **list;
+        if (type == GROUP_FOR && k == 0) {
+            compound->words = parse_for_words(input, clause_start, positions[k]);
+            parsed = compound->words != NULL;
+            list = NULL;
+        } else if (type != GROUP_IF) {
+            list = k == 0 ? &compound->conditions[0] : &compound->bodies[0];
+        } else if (k > 0 && strcmp(words[k - 1], "else") == 0) {
+            list = &compound->else_body;
+        } else {
+            list = k % 2 == 0 ? &compound->conditions[k / 2] : &compound->bodies[k / 2];
+        }
+        if (list != NULL) {
+            *list = parse_clause(input, clause_start, positions[k], next_word);
+            parsed = *list != NULL;
+        }
+        if (k < word_count) {
+            clause_start = positions[k] + strlen(words[k]);
+        }
+    }
+
+    command *cmd = parsed ? parse_group_redirections(opening, input + end + strlen(closing)) : NULL;
+    if (cmd == NULL) {
+        free_compound_command(compound);
+        return NULL;
+    }
+    cmd->group_type = type;
+    cmd->compound = compound;
+    return cmd;
+}
+
+/*
+ * Parses the definition of a function whose name has the given length at the start of the input, its body being the
+ * compound command at body. The definition is a command named after the function.
+ */
+command *parse_function_definition(const char *input, size_t name_len, const char *body) {
+    command *body_command = parse_command(body);
+    if (body_command == NULL) {
+        return NULL;
+    }
+    if (body_command->group_type == GROUP_NONE || body_command->group_type == GROUP_FUNCTION) {
+        fprintf(stderr, "jsh: parse error near `%s'\n", body_command->name != NULL ? body_command->name : ")");
+        free_command(body_command);
+        return NULL;
+    }
+
+    pipeline *pip = malloc(sizeof(pipeline));
+    assert(pip != NULL);
+    pip->command_count = 1;
+    pip->commands = malloc(sizeof(command *));
+    assert(pip->commands != NULL);
+    pip->commands[0] = body_command;
+    pip->to_job = false;
+    pip->capture_output = false;
+    pip->timeout_ms = 0;
+    pip->timeout_signal = SIGTERM;
+
+    pipeline_list *list = malloc(sizeof(pipeline_list));
+    assert(list != NULL);
+    list->pipeline_count = 1;
+    list->pipelines = malloc(sizeof(pipeline *));
+    list->operators = malloc(sizeof(ListOperator));
+    assert(list->pipelines != NULL && list->operators != NULL);
+    list->pipelines[0] = pip;
+    list->operators[0] = LIST_SEQUENCE;
+
+    char *name = strndup(input, name_len);
+    assert(name != NULL);
+    command *cmd = parse_group_redirections(name, "");
+    free(name);
+    assert(cmd != NULL);
+    cmd->group_type = GROUP_FUNCTION;
+    cmd->group = list;
     return cmd;
 }
 
 command *parse_command(const char *input) {
+    size_t start = 0;
+    while (input[start] == TOKEN_COMMAND_DELIM_C) {
+        start++;
+    }
+    if (input[start] == '(' || (input[start] == '{' && (input[start + 1] == '\0' || input[start + 1] == ' '))) {
+        return parse_group(input + start);
+    }
+    GroupType compound_type = compound_type_at(input, start);
+    if (compound_type != GROUP_NONE) {
+        return parse_compound_command(input + start, compound_type);
+    }
+    size_t body_start;
+    size_t name_len = function_header_at(input, start, &body_start);
+    if (name_len > 0) {
+        return parse_function_definition(input + start, name_len, input + body_start);
+    }
 
     size_t token_count = 0;
     char **tokens = tokenize_command_with_special_pipe(input, &token_count);
@@ -552,6 +1409,10 @@ command *parse_command(const char *input) {
 
     assert(cmd != NULL);
 
+    cmd->group_type = GROUP_NONE;
+    cmd->group = NULL;
+    cmd->compound = NULL;
+
     if (token_count == 0) { // If Spaces only
         cmd->name = NULL;
         cmd->argc = 0;
@@ -569,7 +1430,10 @@ command *parse_command(const char *input) {
         return NULL;
     }
 
-    if (is_substitution(tokens[0])) {
+    // A group or a compound command cannot go on nor close where it was not opened
+    if (is_substitution(tokens[0]) || is_output_substitution(tokens[0]) || strcmp(tokens[0], "}") == 0 ||
+        strcmp(tokens[0], "fi") == 0 || strcmp(tokens[0], "done") == 0 ||
+        reserved_word_of_list_at(tokens[0], 0, clause_words) != NULL) {
         fprintf(stderr, "jsh: parse error near `%s'\n", tokens[0]);
         free_tokens(tokens, token_count);
         free(cmd);
@@ -590,19 +1454,12 @@ command *parse_command(const char *input) {
             break;
         }
 
-        // Error with a token being `<()`
-        if (strcmp(tokens[i], "<()") == 0) {
+        // Error with a token being `<()`, `>()` or `$()`
+        if (strcmp(tokens[i], "<()") == 0 || strcmp(tokens[i], ">()") == 0 || strcmp(tokens[i], "$()") == 0) {
             fprintf(stderr, "jsh: parse error near `%s'\n", tokens[i]);
             free(cmd->name);
             for (size_t j = 0; j < i; ++j) {
-                if (cmd->argv[j] != NULL) {
-                    if (cmd->argv[j]->type == ARG_SUBSTITUTION) {
-                        free_pipeline(cmd->argv[j]->value.substitution);
-                    } else {
-                        free(cmd->argv[j]->value.simple);
-                    }
-                    free(cmd->argv[j]);
-                }
+                free_argument(cmd->argv[j]);
             }
             free(cmd->argv);
             free(cmd);
@@ -610,65 +1467,16 @@ command *parse_command(const char *input) {
             return NULL;
         }
 
-        cmd->argv[i] = malloc(sizeof(argument));
-
-        assert(cmd->argv[i] != NULL);
-
-        if (is_substitution(tokens[i])) {
-            cmd->argv[i]->type = ARG_SUBSTITUTION;
-            char *substitution = strdup(tokens[i] + 2);
-            substitution[strlen(substitution) - 1] = '\0';
-            pipeline *substitution_pipeline = parse_pipeline(substitution, false);
-            if (substitution_pipeline == NULL ||
-                (substitution_pipeline->command_count == 1 && substitution_pipeline->commands[0]->name == NULL)) {
-                fprintf(stderr, "jsh: parse error near `%s'\n", tokens[i]);
-                free(substitution);
-                free(cmd->name);
-                for (size_t j = 0; j < i; ++j) {
-                    if (cmd->argv[j] != NULL) {
-                        if (cmd->argv[j]->type == ARG_SUBSTITUTION) {
-                            free_pipeline(cmd->argv[j]->value.substitution);
-                        } else {
-                            free(cmd->argv[j]->value.simple);
-                        }
-                        free(cmd->argv[j]);
-                    }
-                }
-
-                if (substitution_pipeline != NULL) {
-                    free_pipeline(substitution_pipeline);
-                }
-
-                free(cmd->argv[i]);
-                free(cmd->argv);
-                free(cmd);
-                free_tokens(tokens, token_count);
-                return NULL;
-            }
-            cmd->argv[i]->value.substitution = substitution_pipeline;
-            free(substitution);
-        } else {
-            cmd->argv[i]->type = ARG_SIMPLE;
-            cmd->argv[i]->value.simple = strdup(tokens[i]);
-            if (cmd->argv[i]->value.simple == NULL) {
-                fprintf(stderr, "jsh: parse error near `%s'\n", tokens[i]);
-                free(cmd->name);
-                for (size_t j = 0; j < i; ++j) {
-                    if (cmd->argv[j] != NULL) {
-                        if (cmd->argv[j]->type == ARG_SUBSTITUTION) {
-                            free_pipeline(cmd->argv[j]->value.substitution);
-                        } else {
-                            free(cmd->argv[j]->value.simple);
-                        }
-                        free(cmd->argv[j]);
-                    }
-                }
-                free(cmd->argv[i]);
-                free(cmd->argv);
-                free(cmd);
-                free_tokens(tokens, token_count);
-                return NULL;
+        cmd->argv[i] = parse_argument(tokens[i]);
+        if (cmd->argv[i] == NULL) {
+            free(cmd->name);
+            for (size_t j = 0; j < i; ++j) {
+                free_argument(cmd->argv[j]);
             }
+            free(cmd->argv);
+            free(cmd);
+            free_tokens(tokens, token_count);
+            return NULL;
         }
     }
 
@@ -683,15 +1491,120 @@ command *parse_command(const char *input) {
     return cmd;
 }
 
+/*
+ * Returns true if two pipes are only separated by blanks outside of the substitutions and groups
+ */
+bool has_empty_command_between_pipes(const char *input) {
+    size_t depth = 0;
+    for (size_t i = 0; input[i] != '\0'; i++) {
+        int nesting = nesting_change_at(input, i);
+        if (nesting > 0) {
+            depth++;
+        } else if (nesting < 0 && depth > 0) {
+            depth--;
+        }
+        if (depth > 0 || input[i] != TOKEN_PIPE_DELIM_C) {
+            continue;
+        }
+        size_t j = i + 1;
+        while (input[j] == TOKEN_COMMAND_DELIM_C) {
+            j++;
+        }
+        if (input[j] == TOKEN_PIPE_DELIM_C) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Sets ms to the duration of a timeout, in seconds or with a suffix, and returns false if it is not one
+ */
+bool parse_timeout_duration(const char *word, unsigned long *ms) {
+    if (!isdigit((unsigned char)word[0]) && word[0] != '.') {
+        return false;
+    }
+    char *end;
+    double value = strtod(word, &end);
+    double unit = strcmp(end, "") == 0 || strcmp(end, "s") == 0 ? 1
+                  : strcmp(end, "m") == 0                      ? 60
+                  : strcmp(end, "h") == 0                      ? 3600
+                  : strcmp(end, "d") == 0                      ? 86400
+                                                               : 0;
+    // Beyond thirty years, the command has no timeout worth the name
+    if (unit == 0 || end == word || value * unit > 1e9) {
+        return false;
+    }
+    *ms = (unsigned long)(value * unit * 1000 + 0.5);
+    return true;
+}
+
+size_t timeout_prefix_length(const char *input, unsigned long *timeout_ms, int *timeout_signal) {
+    size_t i = strspn(input, TOKEN_COMMAND_DELIM);
+    if (strncmp(input + i, "timeout ", 8) != 0) {
+        return 0;
+    }
+    i += 8;
+    *timeout_signal = SIGTERM;
+    bool has_duration = false;
+    char word[32];
+    while (true) {
+        i += strspn(input + i, TOKEN_COMMAND_DELIM);
+        size_t len = strcspn(input + i, " ;&|()");
+        if (len == 0 || len >= sizeof(word)) {
+            break;
+        }
+        memcpy(word, input + i, len);
+        word[len] = '\0';
+        if (strcmp(word, "-s") == 0) {
+            i += len;
+            i += strspn(input + i, TOKEN_COMMAND_DELIM);
+            len = strcspn(input + i, " ;&|()");
+            if (len == 0 || len >= sizeof(word)) {
+                return 0;
+            }
+            memcpy(word, input + i, len);
+            word[len] = '\0';
+            *timeout_signal = signal_of_name(word);
+            if (*timeout_signal == -1) {
+                return 0;
+            }
+        } else if (!has_duration) {
+            if (!parse_timeout_duration(word, timeout_ms)) {
+                return 0;
+            }
+            has_duration = true;
+        } else {
+            break;
+        }
+        i += len;
+    }
+    return has_duration ? i : 0;
+}
+
 pipeline *parse_pipeline(const char *input, bool to_job) {
+    // The prefix `timeout DURATION` applies to the whole pipeline, whose job gets a deadline
+    unsigned long timeout_ms = 0;
+    int timeout_signal = SIGTERM;
+    size_t prefix_len = timeout_prefix_length(input, &timeout_ms, &timeout_signal);
+    if (prefix_len > 0 && input[prefix_len] != '\0' && input[prefix_len] != TOKEN_PIPE_DELIM_C) {
+        input += prefix_len;
+    } else {
+        timeout_ms = 0;
+        timeout_signal = SIGTERM;
+    }
+
     if (start_with_exception(input, TOKEN_PIPE_DELIM_WITHOUT_SPACE, TOKEN_COMMAND_DELIM_C) ||
         end_with_exception(input, TOKEN_PIPE_DELIM_WITHOUT_SPACE, TOKEN_COMMAND_DELIM_C) ||
-        has_sequence_of_with_exception(input, TOKEN_PIPE_DELIM_C, TOKEN_COMMAND_DELIM_C)) {
+        has_empty_command_between_pipes(input)) {
         fprintf(stderr, "jsh: parse error near `%c'\n", TOKEN_PIPE_DELIM_C);
         return NULL;
     }
     pipeline *pip = malloc(sizeof(pipeline));
     assert(pip != NULL);
+    pip->timeout_ms = timeout_ms;
+    pip->timeout_signal = timeout_signal;
+    pip->capture_output = false;
 
     size_t token_count = 0;
     char **tokens = tokenize_pipeline_with_special_pipe(input, &token_count);
@@ -745,55 +1658,291 @@ pipeline *parse_pipeline(const char *input, bool to_job) {
     return pip;
 }
 
-pipeline_list *parse_pipeline_list(const char *input) {
-    if (has_sequence_of(input, TOKEN_PIPELINE_DELIM_C) ||
-        start_with_exception(input, TOKEN_PIPELINE_DELIM, TOKEN_COMMAND_DELIM_C)) {
-        fprintf(stderr, "jsh: parse error near `%c'\n", TOKEN_PIPELINE_DELIM_C);
+/*
+ * Returns the length of the list operator (`&&`, `||`, `;`, `&` or `&!`) at position i of the input, or 0 if there is
+ * none, and sets op to it, to_job to whether it puts the pipeline before it in the background and capture_output to
+ * whether the output of this job is captured
+ */
+size_t list_operator_at(const char *input, size_t i, ListOperator *op, bool *to_job, bool *capture_output) {
+    *to_job = false;
+    *capture_output = false;
+    if (input[i] == TOKEN_PIPELINE_DELIM_C && input[i + 1] == TOKEN_PIPELINE_DELIM_C) {
+        *op = LIST_AND;
+        return 2;
+    }
+    if (input[i] == TOKEN_PIPE_DELIM_C && input[i + 1] == TOKEN_PIPE_DELIM_C) {
+        *op = LIST_OR;
+        return 2;
+    }
+    if (input[i] == TOKEN_SEQUENCE_DELIM_C) {
+        *op = LIST_SEQUENCE;
+        return 1;
+    }
+    if (input[i] == TOKEN_PIPELINE_DELIM_C) {
+        *op = LIST_SEQUENCE;
+        *to_job = true;
+        *capture_output = input[i + 1] == TOKEN_CAPTURE_JOB_C;
+        return *capture_output ? 2 : 1;
+    }
+    return 0;
+}
+
+bool is_empty_pipeline(const char *input, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (input[i] != TOKEN_COMMAND_DELIM_C) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Parses the pipeline of the list between start and end, followed by the operator op
+ */
+bool add_pipeline_to_list(pipeline_list *pips, const char *start, size_t len, bool to_job, bool capture_output,
+                          ListOperator op) {
+    char *input = strndup(start, len);
+    assert(input != NULL);
+    pipeline *pip = parse_pipeline(input, to_job);
+    free(input);
+    if (pip == NULL) {
+        return false;
+    }
+    pip->capture_output = capture_output;
+    pips->pipelines[pips->pipeline_count] = pip;
+    pips->operators[pips->pipeline_count] = op;
+    pips->pipeline_count++;
+    return true;
+}
+
+/*
+ * Writes the input to the stream, the words which start a command and are aliases being replaced by their values.
+ * expanding has the depth aliases being expanded, which are not expanded again in their own values.
+ * Returns true if an alias was expanded.
+ */
+bool write_with_aliases(FILE *stream, const char *input, const char **expanding, size_t depth) {
+    bool expanded = false;
+    bool next_word_starts_command = false;
+    for (size_t i = 0; input[i] != '\0';) {
+        // The names of an arithmetic expansion are variables
+        if (strncmp(input + i, "$((", 3) == 0) {
+            int depth = 0;
+            do {
+                depth += input[i] == '(' ? 1 : input[i] == ')' ? -1 : 0;
+                fputc(input[i++], stream);
+            } while (input[i] != '\0' && depth > 0);
+            continue;
+        }
+        size_t len = strcspn(input + i, " ;&|()<>");
+        bool at_word_start = i == 0 || strchr(" ;&|()<>", input[i - 1]) != NULL;
+        if (len == 0 || !at_word_start) {
+            fputc(input[i], stream);
+            i++;
+            continue;
+        }
+
+        const char *value = get_alias(input + i, len);
+        bool starts_command = next_word_starts_command || starts_command_at(input, i);
+        next_word_starts_command = false;
+        for (size_t k = 0; value != NULL && k < depth; k++) {
+            if (strncmp(expanding[k], input + i, len) == 0 && expanding[k][len] == '\0') {
+                value = NULL;
+            }
+        }
+        if (value != NULL && starts_command && depth < MAX_TOKENS) {
+            char name[len + 1];
+            memcpy(name, input + i, len);
+            name[len] = '\0';
+            expanding[depth] = name;
+            write_with_aliases(stream, value, expanding, depth + 1);
+            size_t value_len = strlen(value);
+            next_word_starts_command = value_len > 0 && value[value_len - 1] == TOKEN_COMMAND_DELIM_C;
+            expanded = true;
+        } else {
+            fwrite(input + i, 1, len, stream);
+        }
+        i += len;
+    }
+    return expanded;
+}
+
+char *expand_aliases(const char *input) {
+    if (!has_aliases()) {
+        return NULL;
+    }
+    char *result = NULL;
+    size_t result_length = 0;
+    FILE *stream = open_memstream(&result, &result_length);
+    assert(stream != NULL);
+    const char *expanding[MAX_TOKENS];
+    bool expanded = write_with_aliases(stream, input, expanding, 0);
+    fclose(stream);
+    if (!expanded) {
+        free(result);
         return NULL;
     }
+    return result;
+}
 
-    size_t token_count = 0;
-    char **tokens = tokenize(input, &token_count, TOKEN_PIPELINE_DELIM);
-    assert(tokens != NULL);
+pipeline_list *parse_pipeline_list(const char *input) {
+    char *expanded = expand_aliases(input);
+    pipeline_list *pips = parse_list(expanded != NULL ? expanded : input);
+    free(expanded);
+    return pips;
+}
 
+/*
+ * Parses the list of pipelines of the input, whose aliases have been expanded
+ */
+pipeline_list *parse_list(const char *input) {
     pipeline_list *pips = malloc(sizeof(pipeline_list));
     assert(pips != NULL);
+    pips->pipeline_count = 0;
+    pips->pipelines = NULL;
+    pips->operators = NULL;
 
-    if (token_count == 0) {
-        pips->pipelines = NULL;
-        pips->pipeline_count = 0;
-        free_tokens(tokens, token_count);
-
+    size_t len_input = strlen(input);
+    if (len_input == 0) {
         return pips;
     }
-    pips->pipeline_count = 0;
-    pips->pipelines = malloc(sizeof(pipeline *) * token_count);
-    assert(pips->pipelines != NULL);
 
-    for (size_t i = 0; i < token_count - 1; i++) {
-        pips->pipelines[i] = parse_pipeline(tokens[i], true);
+    size_t capacity = 1;
+    for (size_t i = 0; i < len_input; i++) {
+        capacity += input[i] == TOKEN_PIPELINE_DELIM_C || input[i] == TOKEN_SEQUENCE_DELIM_C;
+    }
+    pips->pipelines = malloc(sizeof(pipeline *) * capacity);
+    pips->operators = malloc(sizeof(ListOperator) * capacity);
+    assert(pips->pipelines != NULL && pips->operators != NULL);
 
-        if (pips->pipelines[i] == NULL) {
-            free_tokens(tokens, token_count);
+    size_t start = 0;
+    size_t substitution_depth = 0;
+    ListOperator op = LIST_SEQUENCE;
+    for (size_t i = 0; i < len_input;) {
+        int nesting = nesting_change_at(input, i);
+        if (nesting > 0) {
+            substitution_depth++;
+        } else if (nesting < 0 && substitution_depth > 0) {
+            substitution_depth--;
+        }
+        bool to_job;
+        bool capture_output;
+        size_t op_len = substitution_depth == 0 ? list_operator_at(input, i, &op, &to_job, &capture_output) : 0;
+        if (op_len == 0) {
+            i++;
+            continue;
+        }
+        // Every operator follows a pipeline, which cannot be empty
+        if (is_empty_pipeline(input + start, i - start)) {
+            fprintf(stderr, "jsh: parse error near `%.*s'\n", (int)op_len, input + i);
             free_pipeline_list(pips);
             return NULL;
         }
-        pips->pipeline_count += 1;
+        if (!add_pipeline_to_list(pips, input + start, i - start, to_job, capture_output, op)) {
+            free_pipeline_list(pips);
+            return NULL;
+        }
+        i += op_len;
+        start = i;
     }
-    bool last_pipeline_to_job = input[strlen(input) - 1] == TOKEN_PIPELINE_DELIM_C;
-    pips->pipelines[token_count - 1] = parse_pipeline(tokens[token_count - 1], last_pipeline_to_job);
-    if (pips->pipelines[token_count - 1] == NULL) {
-        free_tokens(tokens, token_count);
+
+    // `&&` and `||` must be followed by a pipeline, whereas `;` and `&` may end the list
+    if ((op == LIST_AND || op == LIST_OR) && pips->pipeline_count > 0 &&
+        is_empty_pipeline(input + start, len_input - start)) {
+        fprintf(stderr, "jsh: parse error near `%s'\n", op == LIST_AND ? "&&" : "||");
+        free_pipeline_list(pips);
+        return NULL;
+    }
+    if (start < len_input && !add_pipeline_to_list(pips, input + start, len_input - start, false, false, LIST_SEQUENCE)) {
         free_pipeline_list(pips);
         return NULL;
     }
-    pips->pipeline_count += 1;
-
-    free_tokens(tokens, token_count);
 
     return pips;
 }
 
+/*
+ * Reads the lines of a here-document until its delimiter and returns them as a single string,
+ * each line followed by a newline
+ */
+char *read_here_document(const char *delimiter, char *(*read_line)(void)) {
+    size_t capacity = HERE_DOCUMENT_INITIAL_SIZE;
+    size_t len = 0;
+    char *body = malloc(capacity);
+    assert(body != NULL);
+    body[0] = '\0';
+
+    char *line;
+    while ((line = read_line()) != NULL && strcmp(line, delimiter) != 0) {
+        size_t line_len = strlen(line);
+        if (len + line_len + 2 > capacity) {
+            while (len + line_len + 2 > capacity) {
+                capacity *= 2;
+            }
+            body = realloc(body, capacity);
+            assert(body != NULL);
+        }
+        memcpy(body + len, line, line_len);
+        len += line_len;
+        body[len++] = '\n';
+        body[len] = '\0';
+        free(line);
+    }
+
+    if (line == NULL) {
+        fprintf(stderr, "jsh: warning: here-document delimited by end-of-file (wanted `%s')\n", delimiter);
+    } else {
+        free(line);
+    }
+    return body;
+}
+
+void read_here_documents_of_pipeline(pipeline *pip, char *(*read_line)(void)) {
+    for (size_t i = 0; i < pip->command_count; ++i) {
+        command *cmd = pip->commands[i];
+        if (cmd->group != NULL) {
+            read_here_documents(cmd->group, read_line);
+        }
+        if (cmd->compound != NULL) {
+            compound_command *compound = cmd->compound;
+            for (size_t k = 0; k < compound->clause_count; k++) {
+                if (compound->conditions[k] != NULL) {
+                    read_here_documents(compound->conditions[k], read_line);
+                }
+                read_here_documents(compound->bodies[k], read_line);
+            }
+            if (compound->else_body != NULL) {
+                read_here_documents(compound->else_body, read_line);
+            }
+        }
+        for (size_t j = 0; j < cmd->argc; ++j) {
+            const argument *arg = cmd->argv[j];
+            if (arg->type == ARG_WORD) {
+                for (size_t k = 0; k < arg->value.word.part_count; ++k) {
+                    if (arg->value.word.parts[k]->type != ARG_SIMPLE) {
+                        read_here_documents_of_pipeline(arg->value.word.parts[k]->value.substitution, read_line);
+                    }
+                }
+            } else if (arg->type != ARG_SIMPLE) {
+                read_here_documents_of_pipeline(arg->value.substitution, read_line);
+            }
+        }
+        for (size_t j = 0; j < cmd->redirection_count; ++j) {
+            redirection *redir = &cmd->redirections[j];
+            if (redir->mode == REDIRECT_HERE_DOCUMENT && redir->content == NULL) {
+                redir->content = read_here_document(redir->filename, read_line);
+            }
+        }
+    }
+}
+
+void read_here_documents(pipeline_list *pips, char *(*read_line)(void)) {
+    for (size_t i = 0; i < pips->pipeline_count; ++i) {
+        if (pips->pipelines[i] != NULL) {
+            read_here_documents_of_pipeline(pips->pipelines[i], read_line);
+        }
+    }
+}
+
 void free_command(command *cmd) {
     if (cmd == NULL) {
         return;
@@ -806,35 +1955,21 @@ void free_command(command *cmd) {
 
     size_t i = 0;
     for (i = 0; i < cmd->argc; ++i) {
-        if (cmd->argv[i] != NULL) {
-            if (cmd->argv[i]->type == ARG_SIMPLE) {
-                if (cmd->argv[i]->value.simple != NULL)
-                    free(cmd->argv[i]->value.simple);
-                cmd->argv[i]->value.simple = NULL;
-            } else {
-                if (cmd->argv[i]->value.substitution != NULL)
-                    free_pipeline(cmd->argv[i]->value.substitution);
-                cmd->argv[i]->value.substitution = NULL;
-            }
-            free(cmd->argv[i]);
-        }
+        free_argument(cmd->argv[i]);
     }
 
     if (cmd->argv != NULL)
         free(cmd->argv);
     cmd->argv = NULL;
 
-    for (i = 0; i < cmd->redirection_count; ++i) {
-        if (cmd->redirections[i].filename != NULL)
-            free(cmd->redirections[i].filename);
-        cmd->redirections[i].filename = NULL;
-    }
-
     if (cmd->redirections != NULL)
-        free(cmd->redirections);
+        free_redirections(cmd->redirections, cmd->redirection_count);
     cmd->redirections = NULL;
     cmd->redirection_count = 0;
 
+    free_pipeline_list(cmd->group);
+    free_compound_command(cmd->compound);
+
     free(cmd);
 }
 
@@ -876,6 +2011,12 @@ void free_command_without_substitution(command_without_substitution *cmd) {
     cmd->pids = NULL;
     cmd->pid_count = 0;
 
+    if (cmd->fds != NULL)
+        free(cmd->fds);
+
+    cmd->fds = NULL;
+    cmd->fd_count = 0;
+
     free(cmd);
 }
 
@@ -916,22 +2057,170 @@ void free_pipeline_list(pipeline_list *pips) {
     }
 
     free(pips->pipelines);
+    free(pips->operators);
     free(pips);
 }
 
-void free_pipeline_list_without_jobs(pipeline_list *pips) {
-    if (pips == NULL) {
+void free_compound_command(compound_command *compound) {
+    if (compound == NULL) {
         return;
     }
-    if (pips->pipelines == NULL) {
-        free(pips);
-        return;
+    for (size_t i = 0; i < compound->clause_count; i++) {
+        free_pipeline_list(compound->conditions[i]);
+        free_pipeline_list(compound->bodies[i]);
     }
-    for (size_t i = 0; i < pips->pipeline_count; i++) {
-        if (pips->pipelines[i] != NULL && !pips->pipelines[i]->to_job) {
-            free_pipeline(pips->pipelines[i]);
+    free(compound->conditions);
+    free(compound->bodies);
+    free_pipeline_list(compound->else_body);
+    free_command(compound->words);
+    free_program(compound->program);
+    free(compound);
+}
+
+pipeline_list *copy_pipeline_list(const pipeline_list *pips);
+command *copy_command(const command *cmd);
+
+argument *copy_argument(const argument *arg) {
+    argument *copy = malloc(sizeof(argument));
+    assert(copy != NULL);
+    copy->type = arg->type;
+    if (arg->type == ARG_SIMPLE) {
+        copy->value.simple = strdup(arg->value.simple);
+        assert(copy->value.simple != NULL);
+    } else if (arg->type == ARG_WORD) {
+        copy->value.word.part_count = arg->value.word.part_count;
+        copy->value.word.parts = malloc(sizeof(argument *) * arg->value.word.part_count);
+        assert(copy->value.word.parts != NULL);
+        for (size_t i = 0; i < arg->value.word.part_count; i++) {
+            copy->value.word.parts[i] = copy_argument(arg->value.word.parts[i]);
+        }
+    } else {
+        copy->value.substitution = copy_pipeline(arg->value.substitution);
+    }
+    return copy;
+}
+
+compound_command *copy_compound_command(const compound_command *compound) {
+    compound_command *copy = init_compound_command(compound->clause_count);
+    for (size_t i = 0; i < compound->clause_count; i++) {
+        copy->conditions[i] = compound->conditions[i] == NULL ? NULL : copy_pipeline_list(compound->conditions[i]);
+        copy->bodies[i] = copy_pipeline_list(compound->bodies[i]);
+    }
+    copy->else_body = compound->else_body == NULL ? NULL : copy_pipeline_list(compound->else_body);
+    copy->words = compound->words == NULL ? NULL : copy_command(compound->words);
+    return copy;
+}
+
+command *copy_command(const command *cmd) {
+    command *copy = malloc(sizeof(command));
+    assert(copy != NULL);
+    copy->name = cmd->name == NULL ? NULL : strdup(cmd->name);
+    copy->argc = cmd->argc;
+    copy->argv = NULL;
+    if (cmd->argv != NULL) {
+        copy->argv = malloc(sizeof(argument *) * (cmd->argc + 1));
+        assert(copy->argv != NULL);
+        for (size_t i = 0; i < cmd->argc; i++) {
+            copy->argv[i] = copy_argument(cmd->argv[i]);
         }
+        copy->argv[cmd->argc] = NULL;
     }
-    free(pips->pipelines);
-    free(pips);
+    copy->redirection_count = cmd->redirection_count;
+    copy->redirections = NULL;
+    if (cmd->redirection_count > 0) {
+        copy->redirections = malloc(sizeof(redirection) * cmd->redirection_count);
+        assert(copy->redirections != NULL);
+        for (size_t i = 0; i < cmd->redirection_count; i++) {
+            copy->redirections[i] = cmd->redirections[i];
+            copy->redirections[i].filename = strdup(cmd->redirections[i].filename);
+            if (cmd->redirections[i].content != NULL) {
+                copy->redirections[i].content = strdup(cmd->redirections[i].content);
+            }
+        }
+    }
+    copy->group_type = cmd->group_type;
+    copy->group = cmd->group == NULL ? NULL : copy_pipeline_list(cmd->group);
+    copy->compound = cmd->compound == NULL ? NULL : copy_compound_command(cmd->compound);
+    return copy;
+}
+
+pipeline *copy_pipeline(const pipeline *pip) {
+    pipeline *copy = malloc(sizeof(pipeline));
+    assert(copy != NULL);
+    copy->command_count = pip->command_count;
+    copy->to_job = pip->to_job;
+    copy->capture_output = pip->capture_output;
+    copy->timeout_ms = pip->timeout_ms;
+    copy->timeout_signal = pip->timeout_signal;
+    copy->commands = NULL;
+    if (pip->command_count > 0) {
+        copy->commands = malloc(sizeof(command *) * pip->command_count);
+        assert(copy->commands != NULL);
+        for (size_t i = 0; i < pip->command_count; i++) {
+            copy->commands[i] = copy_command(pip->commands[i]);
+        }
+    }
+    return copy;
+}
+
+pipeline_list *copy_pipeline_list(const pipeline_list *pips) {
+    pipeline_list *copy = malloc(sizeof(pipeline_list));
+    assert(copy != NULL);
+    copy->pipeline_count = pips->pipeline_count;
+    copy->pipelines = NULL;
+    copy->operators = NULL;
+    if (pips->pipelines != NULL) {
+        copy->pipelines = malloc(sizeof(pipeline *) * (pips->pipeline_count + 1));
+        copy->operators = malloc(sizeof(ListOperator) * (pips->pipeline_count + 1));
+        assert(copy->pipelines != NULL && copy->operators != NULL);
+        for (size_t i = 0; i < pips->pipeline_count; i++) {
+            copy->pipelines[i] = copy_pipeline(pips->pipelines[i]);
+            copy->operators[i] = pips->operators[i];
+        }
+    }
+    return copy;
+}
+
+bool is_incomplete_input(const char *input) {
+    size_t depth = 0;
+    for (size_t i = 0; input[i] != '\0'; i++) {
+        int nesting = nesting_change_at(input, i);
+        if (nesting > 0) {
+            depth++;
+        } else if (nesting < 0 && depth > 0) {
+            depth--;
+        }
+    }
+    // A function definition continues with its body on the next line
+    size_t len = strlen(input);
+    while (len > 0 && input[len - 1] == TOKEN_COMMAND_DELIM_C) {
+        len--;
+    }
+    return depth > 0 || ends_function_header_at(input, len);
+}
+
+char *join_continuation_line(char *input, const char *line) {
+    size_t line_start = strspn(line, " ");
+    if (line[line_start] == '\0') {
+        return input;
+    }
+    size_t len = strlen(input);
+    while (len > 0 && input[len - 1] == TOKEN_COMMAND_DELIM_C) {
+        len--;
+    }
+    size_t word_start = len;
+    while (word_start > 0 && strchr(" ;&|({", input[word_start - 1]) == NULL) {
+        word_start--;
+    }
+
+    // A command follows an operator or a reserved word such as `do` on the same line, other lines are separated
+    bool follows = len == 0 || strchr(";&|({", input[len - 1]) != NULL || ends_function_header_at(input, len) ||
+                   (word_start < len &&
+                    reserved_word_of_list_at(input, word_start, reserved_words_before_command) != NULL);
+    const char *separator = follows ? " " : "; ";
+    char *joined = malloc(len + strlen(separator) + strlen(line + line_start) + 1);
+    assert(joined != NULL);
+    sprintf(joined, "%.*s%s%s", (int)len, input, separator, line + line_start);
+    free(input);
+    return joined;
 }
@@ -14,9 +14,15 @@
 #define TOKEN_PIPE_DELIM " | "
 #define TOKEN_COMMAND_DELIM_C ' '
 #define TOKEN_PIPELINE_DELIM_C '&'
+#define TOKEN_CAPTURE_JOB_C '!'
+#define TOKEN_SEQUENCE_DELIM_C ';'
 #define TOKEN_PIPE_DELIM_C '|'
+#define HERE_DOCUMENT_INITIAL_SIZE 256
+/* Initial size of the buffer holding the body of a here-document, doubled as needed */
 
 typedef struct pipeline pipeline;
+typedef struct pipeline_list pipeline_list;
+typedef struct program program;
 
 typedef enum {
     REDIRECT_STDIN,
@@ -34,37 +40,95 @@ typedef enum {
     REDIRECT_OVERWRITE,
     REDIRECT_APPEND,
     REDIRECT_NO_OVERWRITE,
+    REDIRECT_HERE_DOCUMENT,
+    REDIRECT_HERE_STRING,
 } RedirectionMode;
 /* Modes of redirections supported:
  *  - No redirection mode (stdin)
  *  - Overwrite the file
  *  - Append to the file
  *  - Don't overwrite the file
+ *  - Here-document `<< DELIMITER` (stdin)
+ *  - Here-string `<<< word` (stdin)
  */
 
 typedef struct {
     RedirectionType type;
     RedirectionMode mode;
     char *filename;
+    char *content;
 } redirection;
+/* For a here-document, filename is the delimiter and content the body read by read_here_documents,
+ * for a here-string, filename is the word and content the word followed by a newline.
+ * content is NULL for the other redirections. The content of the redirections of a
+ * command_without_substitution is borrowed from its command. */
 
-typedef struct {
+typedef struct argument {
     // Enum to determine the type of argument
-    enum { ARG_SIMPLE, ARG_SUBSTITUTION } type;
+    enum { ARG_SIMPLE, ARG_SUBSTITUTION, ARG_OUTPUT_SUBSTITUTION, ARG_COMMAND_SUBSTITUTION, ARG_WORD } type;
 
     // Union to store the actual argument value
     union {
         char *simple;      // Pointer to a simple string argument
-        pipeline *substitution;  // Pointer to a pipeline for substitution
+        pipeline *substitution;  // Pointer to a pipeline for substitution (`<( )`, `>( )` or `$( )`)
+        struct {
+            size_t part_count;
+            struct argument **parts;
+        } word;  // Parts of a word mixing text and command substitutions, such as `x$( echo a )y`
     } value;
 } argument;
+/* An ARG_SUBSTITUTION (`<( pipeline )`) is replaced by the path of a pipe reading the output of the pipeline,
+ * an ARG_OUTPUT_SUBSTITUTION (`>( pipeline )`) by the path of a pipe writing to the input of the pipeline,
+ * whereas an ARG_COMMAND_SUBSTITUTION (`$( pipeline )`) is replaced by the output of the pipeline itself,
+ * without its trailing newlines and split into several arguments on blanks.
+ * The parts of an ARG_WORD are ARG_SIMPLE and ARG_COMMAND_SUBSTITUTION arguments: the first field of a
+ * substitution is joined to what comes before it and its last field to what comes after it. */
+
+typedef enum {
+    GROUP_NONE,
+    GROUP_BRACES,
+    GROUP_SUBSHELL,
+    GROUP_IF,
+    GROUP_WHILE,
+    GROUP_UNTIL,
+    GROUP_FOR,
+    GROUP_FUNCTION,
+    GROUP_CALL,
+} GroupType;
+/* Types of commands:
+ *  - A simple command
+ *  - A group `{ list; }` run by jsh itself
+ *  - A subshell `( list )` run by a child of jsh, or by jsh if it cannot change its state
+ *  - The compound commands `if list; then list; [elif list; then list;]... [else list;] fi`,
+ *    `while list; do list; done`, `until list; do list; done` and `for name in words; do list; done`,
+ *    run by jsh itself
+ *  - The definition of a function `name() compound-command`, whose group is a list made of the compound command
+ *  - A call of a function, the type of a command_without_substitution whose name is the one of a function
+ *    rather than of a builtin when it is prepared, its list being looked up when it runs
+ */
 
 typedef struct {
+    size_t clause_count;
+    pipeline_list **conditions;
+    pipeline_list **bodies;
+    pipeline_list *else_body;
+    struct command *words;
+    program *program;
+} compound_command;
+/* The clauses of a compound command: for `if`, the condition and the body of the `if` and of each `elif`, and the
+ * body of `else` or NULL, for `while` and `until`, a single clause, and for `for`, a single clause without
+ * condition and its words, parsed as the command `name in words...`.
+ * The program is the bytecode compiled from the compound command when it is first run. */
+
+typedef struct command {
     char *name;
     size_t argc;
     argument **argv;
     size_t redirection_count;
     redirection *redirections;
+    GroupType group_type;
+    pipeline_list *group;
+    compound_command *compound;
 } command;
 /*
     * A command is a single command with its arguments and redirections.
@@ -90,6 +154,13 @@ typedef struct {
     *   - type: REDIRECT_STDOUT
     *   - mode: REDIRECT_NO_OVERWRITE
     *   - filename: "file2.txt"
+    *
+    * A group "{ ls; pwd; } > out" has the name "{" as its only argument, the list "ls; pwd" as group
+    * and its redirections, which apply to the whole group.
+    * A compound command "for x in a b; do echo $x; done" likewise has the name "for" as its only argument,
+    * and its clauses as compound.
+    * A function definition "greet() { echo hello $1; }" has the name "greet" as its only argument, and as group
+    * the list whose single pipeline is the group "{ echo hello $1; }".
     */
 
 typedef struct {
@@ -100,31 +171,92 @@ typedef struct {
     redirection *redirections;
     pid_t *pids;
     size_t pid_count;
+    int *fds;
+    size_t fd_count;
+    GroupType group_type;
+    pipeline_list *group;
+    compound_command *compound;
 } command_without_substitution;
 /*
  * A command without substitution is a command with its arguments as strings and redirections.
+ * fds are the ends of the substitution pipes kept open by jsh until the command is launched.
+ * The group and the compound command are borrowed from its command.
  */
 
 struct pipeline{
     size_t command_count;
     command **commands;
     bool to_job;
+    bool capture_output;
+    unsigned long timeout_ms;
+    int timeout_signal;
 };
 /* A pipeline is a list of commands with a variable to determine whether
- * it should become a job. */
+ * it should become a job. A pipeline prefixed with `timeout DURATION [-s SIGNAL]` gets timeout_signal once its
+ * job has run for timeout_ms, 0 if it has no timeout. A job run with `&!` has its output captured, each of its
+ * lines being prefixed with its id. */
 
 
-typedef struct {
+typedef enum {
+    LIST_SEQUENCE,
+    LIST_AND,
+    LIST_OR,
+} ListOperator;
+/* Operators between the pipelines of a list:
+ *  - `;` or `&`: the next pipeline always runs
+ *  - `&&`: the next pipeline runs if the previous one succeeded
+ *  - `||`: the next pipeline runs if the previous one failed
+ */
+
+struct pipeline_list {
     size_t pipeline_count;
     pipeline **pipelines;
-} pipeline_list;
-/* pipelines is a list of pipeline */
+    ListOperator *operators;
+};
+/* pipelines is a list of pipeline, operators[i] is the operator between pipelines[i] and pipelines[i + 1].
+ * A pipeline which became a job belongs to it, and is replaced in the list by a copy once run, so that the
+ * list can be run again, as the body of a loop. */
 
 char *str_of_pipeline(pipeline *p);
 /**
  * Prints a pipeline on a single line
  */
 
+char *str_of_pipeline_list(const pipeline_list *pips);
+/**
+ * Prints a list of pipelines on a single line, with their operators
+ */
+
+size_t timeout_prefix_length(const char *input, unsigned long *timeout_ms, int *timeout_signal);
+/*
+ * Returns the length of the prefix `timeout DURATION [-s SIGNAL]` starting the input with its blanks, or 0 if
+ * there is none, and sets the duration in milliseconds and the signal, SIGTERM by default. As with timeout(1), the
+ * duration is a number of seconds, or of minutes, hours or days with the suffix `m`, `h` or `d`, and the signal
+ * may also come before it.
+ */
+
+pipeline *copy_pipeline(const pipeline *pip);
+/* Returns a copy of the pipeline, its commands and their groups, compound commands and here-documents */
+
+pipeline_list *copy_pipeline_list(const pipeline_list *pips);
+/* Returns a copy of the list and of its pipelines, such as the body of a function kept once its line is freed */
+
+char *expand_aliases(const char *input);
+/*
+ * Returns a copy of the input where each word starting a command is replaced by the value of its alias, as is the
+ * word after an alias whose value ends with a blank. The values are expanded in turn, but not an alias within its
+ * own value. Returns NULL if there is no alias to expand in the input. The copy must be freed by the caller.
+ */
+
+bool is_incomplete_input(const char *input);
+/* Returns true if a group or a compound command of the input is not closed yet, so that the next line continues it */
+
+char *join_continuation_line(char *input, const char *line);
+/*
+ * Appends a line continuing the input and returns it, reallocated. The lines are separated by `;`, unless the input
+ * ends with a reserved word or an operator which a command follows, such as `do` or `|`.
+ */
+
 void free_tokens(char **, size_t);
 /* Frees tokens */
 
@@ -149,9 +281,30 @@ char **tokenize_pipeline_with_special_pipe(const char *input, size_t *token_coun
 int is_substitution(const char *token);
 /* Checks if a token is a pipe substitution */
 
+int is_output_substitution(const char *token);
+/* Checks if a token is an output process substitution `>( ... )` */
+
+int is_command_substitution(const char *token);
+/* Checks if a token is a command substitution `$( ... )`, and only that */
+
+bool has_command_substitution(const char *token);
+/* Checks if a token contains a command substitution, such as `x$( ... )y`, an arithmetic expansion `$(( ))` not
+ * being one */
+
+argument *parse_argument(const char *token);
+/* Parses the token into an argument, a substitution, a word with command substitutions or a simple string,
+ * or returns NULL and prints an error if one of its substitutions is invalid */
+
+char *str_of_argument(const argument *arg);
+/* Prints an argument, a substitution being printed as `$( pipeline )` */
+
+void free_argument(argument *arg);
+/* Frees an argument and the string, the substitution pipeline or the parts it contains */
+
 command *parse_command(const char *input);
 /* parse_command takes a string and parses it into a command struct.
- * The string is expected to be a single command, with no pipes.
+ * The string is expected to be a single command, with no pipes, or a group `{ list; }` or `( list )`
+ * or a compound command followed by its redirections, or the definition of a function.
  * The command struct is allocated on the heap, so it must be freed with free_command.
  * If the string is invalid, parse_command returns NULL.
  */
@@ -166,11 +319,18 @@ pipeline *parse_pipeline(const char *input, bool to_job);
 
 pipeline_list *parse_pipeline_list(const char *input);
 /* parse_pipeline_list takes a string and parses it into a pipeline_list struct.
- * The string is expected to be few command, with no pipes, delimited by &.
+ * The string is expected to be few pipelines delimited by `&`, `;`, `&&` or `||`, the pipelines followed by `&`
+ * becoming jobs. Its aliases are expanded first, once for the whole string. An operator cannot follow an empty pipeline, nor `&&` and `||` end the string.
  * The pipeline_list struct is allocated on the heap, so it must be freed with free_pipeline_list.
  * If the string is invalid, parse_pipeline_list returns NULL.
  */
 
+void read_here_documents(pipeline_list *pips, char *(*read_line)(void));
+/* read_here_documents reads the body of each here-document of the pipelines, in the order they appear,
+ * line by line with read_line until the line equal to its delimiter.
+ * read_line returns a line allocated on the heap without its newline, or NULL at the end of the input,
+ * in which case the here-document ends there. */
+
 void free_command(command *cmd);
 /* free_command frees the memory allocated by parse_command,
  * the command struct and its fields.*/
@@ -181,12 +341,11 @@ void free_pipeline(pipeline *pip);
 /* free_pipeline frees the memory allocated by parse_pipeline,
  * the pipeline struct and its fields.*/
 
+void free_compound_command(compound_command *compound);
+/* free_compound_command frees the clauses of a compound command, its words and its program */
+
 void free_pipeline_list(pipeline_list *pips);
 /* free_pipeline_list frees the memory allocated by parse_pipeline_list,
  * the pipelines, pipelines struct, and their fields */
 
-void free_pipeline_list_without_jobs(pipeline_list *pips);
-/* free_pipeline_list_without_jobs frees the memory allocated by parse_pipeline_list,
- * the pipelines, pipelines struct with to_job false, and their commands */
-
 #endif
@@ -0,0 +1,169 @@
+#define _GNU_SOURCE
+#include "fanout.h"
+#include "../utils/fd_utils.h"
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/*
+ * Moves len bytes from the pipe from to the descriptor to, with splice when possible and with
+ * read and write otherwise. If to is negative or no longer writable, the bytes are discarded and
+ * false is returned.
+ */
+bool move_bytes(int from, int to, size_t len, char *buffer) {
+    bool writable = to >= 0;
+    bool can_splice = true;
+
+    while (len > 0) {
+        if (can_splice && writable) {
+            ssize_t moved = splice(from, NULL, to, NULL, len, SPLICE_F_MOVE);
+            if (moved > 0) {
+                len -= moved;
+                continue;
+            }
+            if (moved < 0 && errno == EINTR) {
+                continue;
+            }
+            if (moved < 0 && errno == EPIPE) {
+                writable = false;
+            }
+            can_splice = false;
+            continue;
+        }
+
+        size_t to_read = len < FANOUT_CHUNK_SIZE ? len : FANOUT_CHUNK_SIZE;
+        ssize_t nread = read(from, buffer, to_read);
+        if (nread < 0 && errno == EINTR) {
+            continue;
+        }
+        if (nread <= 0) {
+            break;
+        }
+        if (writable && !write_all(to, buffer, nread)) {
+            writable = false;
+        }
+        len -= nread;
+    }
+    return writable;
+}
+
+/*
+ * Relays the input to the targets by copying it in user space, used when tee(2) is not supported
+ */
+void relay_with_copies(int input, const int *targets, bool *alive, size_t target_count, char *buffer) {
+    while (1) {
+        ssize_t nread = read(input, buffer, FANOUT_CHUNK_SIZE);
+        if (nread < 0 && errno == EINTR) {
+            continue;
+        }
+        if (nread <= 0) {
+            return;
+        }
+        for (size_t i = 0; i < target_count; i++) {
+            if (alive[i] && !write_all(targets[i], buffer, nread)) {
+                alive[i] = false;
+            }
+        }
+    }
+}
+
+/*
+ * Relays the input to the targets: at each round, the content of the input pipe is duplicated with tee(2)
+ * into an intermediate pipe for every target but the last one, then moved from the intermediate pipes to
+ * their targets, and finally from the input to the last target, with splice(2).
+ */
+void relay(int input, const int *targets, size_t target_count) {
+    bool *alive = malloc(sizeof(bool) * target_count);
+    int(*intermediates)[2] = malloc(sizeof(int[2]) * (target_count - 1));
+    ssize_t *teed = malloc(sizeof(ssize_t) * (target_count - 1));
+    char *buffer = malloc(FANOUT_CHUNK_SIZE);
+    assert(alive != NULL && intermediates != NULL && teed != NULL && buffer != NULL);
+
+    int pipe_size = fcntl(input, F_GETPIPE_SZ);
+    for (size_t i = 0; i < target_count; i++) {
+        alive[i] = true;
+    }
+    for (size_t i = 0; i < target_count - 1; i++) {
+        assert(pipe(intermediates[i]) >= 0);
+        if (pipe_size > 0) {
+            fcntl(intermediates[i][1], F_SETPIPE_SZ, pipe_size);
+        }
+    }
+
+    while (1) {
+        teed[0] = tee(input, intermediates[0][1], FANOUT_CHUNK_SIZE, 0);
+        if (teed[0] < 0 && errno == EINTR) {
+            continue;
+        }
+        if (teed[0] < 0) {
+            relay_with_copies(input, targets, alive, target_count, buffer);
+            break;
+        }
+        if (teed[0] == 0) {
+            break;
+        }
+
+        // Every target receives the number of bytes all the intermediate pipes could take
+        size_t len = teed[0];
+        for (size_t i = 1; i < target_count - 1; i++) {
+            do {
+                teed[i] = tee(input, intermediates[i][1], len, 0);
+            } while (teed[i] < 0 && errno == EINTR);
+            assert(teed[i] > 0);
+            if ((size_t)teed[i] < len) {
+                len = teed[i];
+            }
+        }
+
+        for (size_t i = 0; i < target_count - 1; i++) {
+            alive[i] = move_bytes(intermediates[i][0], alive[i] ? targets[i] : -1, len, buffer);
+            // Bytes teed beyond len are duplicated again at the next round
+            move_bytes(intermediates[i][0], -1, teed[i] - len, buffer);
+        }
+        size_t last = target_count - 1;
+        alive[last] = move_bytes(input, alive[last] ? targets[last] : -1, len, buffer);
+
+        bool one_alive = false;
+        for (size_t i = 0; i < target_count; i++) {
+            one_alive = one_alive || alive[i];
+        }
+        if (!one_alive) {
+            break;
+        }
+    }
+
+    free(alive);
+    free(intermediates);
+    free(teed);
+    free(buffer);
+}
+
+pid_t start_fanout_relay(const int *targets, size_t target_count, int *input_fd) {
+    assert(targets != NULL);
+    assert(target_count > 1);
+
+    int tube[2];
+    assert(pipe(tube) >= 0);
+
+    pid_t pid = fork();
+    assert(pid != -1);
+
+    if (pid == 0) {
+        close(tube[1]);
+        // A target closed early (a substitution which stopped reading for instance) must not kill the relay
+        signal(SIGPIPE, SIG_IGN);
+
+        relay(tube[0], targets, target_count);
+
+        close(tube[0]);
+        exit(EXIT_SUCCESS);
+    }
+
+    close(tube[0]);
+    *input_fd = tube[1];
+    return pid;
+}
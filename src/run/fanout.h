@@ -0,0 +1,21 @@
+#ifndef FANOUT_H
+#define FANOUT_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#define FANOUT_CHUNK_SIZE (1 << 16)
+/* Maximal number of bytes moved by the relay at each round */
+
+pid_t start_fanout_relay(const int *targets, size_t target_count, int *input_fd);
+/*
+ * Forks a relay process copying everything written to a new pipe to each of the (at least two) target descriptors,
+ * and sets input_fd to the write end of this pipe.
+ * The data is duplicated with tee(2) and moved with splice(2), so that it is never copied in user space,
+ * with a fallback on read and write for the targets which do not support it (a terminal for instance).
+ * The relay ends when every writer of the pipe is closed. The targets are closed by the caller
+ * once the relay is started.
+ * Returns the pid of the relay.
+ */
+
+#endif
@@ -0,0 +1,59 @@
+#define _GNU_SOURCE
+#include "here_document.h"
+#include "../utils/fd_utils.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/*
+ * Returns the read end of a pipe filled with the content, or -1 if the content does not fit in the pipe,
+ * so that writing it never blocks
+ */
+int here_document_in_pipe(const char *content, size_t len) {
+    int tube[2];
+    if (pipe(tube) == -1) {
+        return -1;
+    }
+
+    int capacity = fcntl(tube[1], F_GETPIPE_SZ);
+    if (capacity < 0 || len > (size_t)capacity || !write_all(tube[1], content, len)) {
+        close(tube[0]);
+        close(tube[1]);
+        return -1;
+    }
+
+    close(tube[1]);
+    return tube[0];
+}
+
+/*
+ * Returns a sealed memfd holding the content, or -1 on failure
+ */
+int here_document_in_memfd(const char *content, size_t len) {
+    int fd = memfd_create("jsh-here-document", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd == -1) {
+        perror("memfd_create");
+        return -1;
+    }
+
+    if (!write_all(fd, content, len) ||
+        fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == -1 ||
+        lseek(fd, 0, SEEK_SET) == -1) {
+        perror("here-document");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int fd_of_here_document(const char *content) {
+    size_t len = strlen(content);
+
+    int fd = here_document_in_pipe(content, len);
+    if (fd == -1) {
+        fd = here_document_in_memfd(content, len);
+    }
+    return fd;
+}
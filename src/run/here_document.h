@@ -0,0 +1,12 @@
+#ifndef HERE_DOCUMENT_H
+#define HERE_DOCUMENT_H
+
+int fd_of_here_document(const char *content);
+/*
+ * Returns a descriptor from which the content of a here-document or a here-string can be read,
+ * without writing it to the filesystem: a pipe already filled with the content when it fits in
+ * the capacity of a pipe, otherwise a memfd sealed against any modification, positioned at its start.
+ * Returns -1 if the descriptor could not be created.
+ */
+
+#endif
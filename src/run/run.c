@@ -1,5 +1,19 @@
+#define _GNU_SOURCE
 #include "run.h"
+#include "../utils/brace_expansion.h"
+#include "../utils/event_log.h"
+#include "../utils/flight_recorder.h"
+#include "../utils/functions.h"
+#include "../utils/glob_expansion.h"
+#include "../utils/job_output.h"
 #include "../utils/signal_management.h"
+#include "../utils/string_utils.h"
+#include "../utils/timer_wheel.h"
+#include "fanout.h"
+#include "here_document.h"
+#include "../utils/path_index.h"
+#include "../utils/variables.h"
+#include "../parser/bytecode.h"
 #include <assert.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -11,6 +25,9 @@
 #include <unistd.h>
 
 command_without_substitution *prepare_command(command *, job *);
+bool is_intern_command(const char *);
+bool is_forked_builtin(const char *);
+int run_pipeline(pipeline *, job *, bool);
 int **init_tubes(size_t);
 void close_fd_of_tubes_except(int **, size_t, int, int);
 void free_tubes(int **, size_t);
@@ -21,192 +38,513 @@ char *fd_to_proc_path(int fd) {
     return proc_path;
 }
 
-process_substitution_output fd_from_subtitution_arg_with_pipe(argument *sub_arg, job *j) {
+char *capture_output_of_substitution(argument *sub_arg, size_t *len) {
     assert(sub_arg != NULL);
-    assert(sub_arg->type == ARG_SUBSTITUTION);
+    assert(sub_arg->type == ARG_COMMAND_SUBSTITUTION);
     pipeline *pip = sub_arg->value.substitution;
     assert(pip != NULL);
-    assert(pip->command_count > 0);
-    assert(pip->commands[0] != NULL);
 
-    if (pip->command_count == 1) {
-        command_without_substitution *cmd_without_subst = prepare_command(pip->commands[0], j);
-        int tube[2];
-        assert(pipe(tube) >= 0);
+    int tube[2];
+    assert(pipe(tube) >= 0);
+#ifdef F_SETPIPE_SZ
+    // A larger pipe means fewer wake-ups for big outputs, it is not an error if it is refused
+    fcntl(tube[1], F_SETPIPE_SZ, CAPTURE_PIPE_SIZE);
+#endif
 
-        pid_t pid = fork();
-        assert(pid != -1);
+    // Nothing buffered by jsh must be written twice by the child
+    fflush(stdout);
+    fflush(stderr);
 
-        switch (pid) {
-        case 0:
-            close(tube[0]);
-            dup2(tube[1], STDOUT_FILENO);
-            close(tube[1]);
+    pid_t pid = fork();
+    assert(pid != -1);
 
-            run_command(cmd_without_subst, true, pip, j, false);
+    if (pid == 0) {
+        close(tube[0]);
+        dup2(tube[1], STDOUT_FILENO);
+        close(tube[1]);
 
-            exit(SUCCESS);
-            break;
-        default:
-            close(tube[1]);
-            process_substitution_output output = {pid, tube[0]};
-            if (j->pgid == -1) {
-                setpgid(pid, pid);
-                pid_t pgid = getpgid(pid);
-
-                j->pid_leader = pid;
-                j->pgid = pgid;
-                j->status = RUNNING;
-            } else {
-                setpgid(pid, j->pgid);
-            }
-            add_process_to_job(j, pid, pip->commands[0], cmd_without_subst, RUNNING);
+        job *sub_job = init_job_to_add(-1, -1, pip, RUNNING);
+        int run_output = run_pipeline(pip, sub_job, true);
 
-            return output;
+        fflush(stdout);
+        exit(run_output);
+    }
+    close(tube[1]);
+
+    // The output is read straight into a single buffer growing geometrically, so that each byte
+    // is copied a bounded number of times whatever the size of the output
+    size_t capacity = CAPTURE_READ_SIZE;
+    size_t size = 0;
+    char *buffer = malloc(capacity);
+    assert(buffer != NULL);
+
+    while (1) {
+        if (capacity - size < CAPTURE_READ_SIZE) {
+            capacity *= 2;
+            buffer = realloc(buffer, capacity);
+            assert(buffer != NULL);
+        }
+        ssize_t nread = read(tube[0], buffer + size, capacity - size - 1);
+        if (nread < 0 && errno == EINTR) {
+            continue;
+        }
+        if (nread <= 0) {
+            break;
         }
+        size += nread;
     }
+    close(tube[0]);
+    buffer[size] = '\0';
 
-    pid_t pids[pip->command_count - 1];
-    int **tubes = init_tubes(pip->command_count - 1);
+    // The status of the last substitution is the one of a command made only of assignments
+    int status = 0;
+    while (waitpid(pid, &status, 0) == -1 && errno == EINTR) {
+    }
+    substitution_exit_value = WIFSIGNALED(status) ? 128 + WTERMSIG(status) : WEXITSTATUS(status);
 
-    command_without_substitution **cmds_without_subst =
-        malloc(sizeof(command_without_substitution *) * pip->command_count);
-    assert(cmds_without_subst != NULL);
+    *len = size;
+    return buffer;
+}
 
-    for (int i = 0; i < pip->command_count - 1; i++) {
-        cmds_without_subst[i] = prepare_command(pip->commands[i], j);
+void join_job_process_group(job *j, pid_t pid) {
+    bool is_first = j->pgid == -1;
+    if (is_first) {
+        j->pid_leader = pid;
+        j->pgid = pid;
+        j->status = RUNNING;
+    }
+    // Without job control, in a subshell, the processes stay in its process group
+    if (job_control) {
+        setpgid(pid, j->pgid);
+    } else {
+        j->pgid = getpgrp();
+    }
 
-        pids[i] = fork();
-        if (pids[i] == 0) {
-            close_fd_of_tubes_except(tubes, pip->command_count - 1, i - 1, i);
-            dup2(tubes[i][1], STDOUT_FILENO);
-            close(tubes[i][1]);
-            if (i != 0) {
-                dup2(tubes[i - 1][0], STDIN_FILENO);
-                close(tubes[i - 1][0]);
+    // The deadline of a pipeline with a timeout runs from the start of its first process, once it has its group
+    if (is_first && j->pipeline != NULL && j->pipeline->timeout_ms > 0) {
+        j->deadline = add_deadline(j->pipeline->timeout_ms, pid, job_control, j->pipeline->timeout_signal);
+    }
+}
+
+void add_substitution_process_to_job(job *j, pid_t pid, command *cmd, command_without_substitution *cmd_without_subst) {
+    join_job_process_group(j, pid);
+    add_process_to_job(j, pid, cmd, cmd_without_subst, RUNNING);
+}
+
+pid_t launch_substitution_pipeline(pipeline *pip, job *j, int fd_in, int fd_out, int fd_kept) {
+    assert(pip != NULL);
+    assert(pip->command_count > 0);
+    assert(pip->commands[0] != NULL);
+
+    pid_t pid = -1;
+    int previous_read_end = fd_in;
+
+    for (size_t i = 0; i < pip->command_count; i++) {
+        bool is_last = i == pip->command_count - 1;
+        int tube[2] = {-1, -1};
+        if (!is_last) {
+            assert(pipe(tube) >= 0);
+        }
+
+        command_without_substitution *cmd_without_subst = prepare_command(pip->commands[i], j);
+
+        fflush(stdout);
+        fflush(stderr);
+        pid = fork();
+        assert(pid != -1);
+
+        if (pid == 0) {
+            close(fd_kept);
+            if (tube[0] != -1) {
+                close(tube[0]);
+            }
+            if (previous_read_end != -1) {
+                dup2(previous_read_end, STDIN_FILENO);
+                close(previous_read_end);
+            }
+            int write_end = is_last ? fd_out : tube[1];
+            if (write_end != -1) {
+                dup2(write_end, STDOUT_FILENO);
+                close(write_end);
             }
-            run_command(cmds_without_subst[i], true, pip, j, false);
 
-            close(tubes[i][0]);
-            exit(SUCCESS);
-        } else {
-            if (j->pgid == -1) {
-                setpgid(pids[i], pids[i]);
-                pid_t pgid = getpgid(pids[i]);
+            exit(run_command(cmd_without_subst, true, pip, j, false));
+        }
 
-                j->pid_leader = pids[i];
-                j->pgid = pgid;
-                j->status = RUNNING;
-            } else {
-                setpgid(pids[i], j->pgid);
+        add_substitution_process_to_job(j, pid, pip->commands[i], cmd_without_subst);
+        close_substitution_fds(cmd_without_subst);
+
+        if (previous_read_end != -1) {
+            close(previous_read_end);
+        }
+        if (is_last) {
+            if (fd_out != -1) {
+                close(fd_out);
             }
-            add_process_to_job(j, pids[i], pip->commands[i], cmds_without_subst[i], RUNNING);
+        } else {
+            close(tube[1]);
         }
+        previous_read_end = tube[0];
     }
 
-    close_fd_of_tubes_except(tubes, pip->command_count - 1, pip->command_count - 2, pip->command_count);
+    return pid;
+}
 
-    int stdin_copy = dup(STDIN_FILENO);
-    dup2(tubes[pip->command_count - 2][0], STDIN_FILENO);
-    close(tubes[pip->command_count - 2][0]);
+process_substitution_output fd_from_subtitution_arg_with_pipe(argument *sub_arg, job *j) {
+    assert(sub_arg != NULL);
+    assert(sub_arg->type == ARG_SUBSTITUTION);
 
-    free_tubes(tubes, pip->command_count - 1);
+    int tube[2];
+    assert(pipe(tube) >= 0);
 
-    cmds_without_subst[pip->command_count - 1] = prepare_command(pip->commands[pip->command_count - 1], j);
+    pid_t pid = launch_substitution_pipeline(sub_arg->value.substitution, j, -1, tube[1], tube[0]);
+
+    process_substitution_output output = {pid, tube[0]};
+    return output;
+}
+
+process_substitution_output fd_from_output_subtitution_arg_with_pipe(argument *sub_arg, job *j) {
+    assert(sub_arg != NULL);
+    assert(sub_arg->type == ARG_OUTPUT_SUBSTITUTION);
 
     int tube[2];
     assert(pipe(tube) >= 0);
 
-    pid_t pid = fork();
-    assert(pid != -1);
+    pid_t pid = launch_substitution_pipeline(sub_arg->value.substitution, j, tube[0], -1, tube[1]);
 
-    switch (pid) {
-    case 0:
-        close(tube[0]);
-        dup2(tube[1], STDOUT_FILENO);
-        close(tube[1]);
+    process_substitution_output output = {pid, tube[1]};
+    return output;
+}
 
-        run_command(cmds_without_subst[pip->command_count - 1], false, pip, j, true);
+process_substitution_output fd_from_substitution_filename(const char *filename, job *j) {
+    process_substitution_output output = {-1, -1};
+
+    char *substitution = strdup(filename + 2);
+    assert(substitution != NULL);
+    substitution[strlen(substitution) - 1] = '\0';
+    pipeline *pip = parse_pipeline(substitution, false);
+    if (pip == NULL || pip->command_count == 0) {
+        fprintf(stderr, "jsh: %s: invalid substitution\n", substitution);
+        free_pipeline(pip);
+        free(substitution);
+        return output;
+    }
 
-        exit(SUCCESS);
-        break;
-    default:
-        close(tube[1]);
-        process_substitution_output output = {pid, tube[0]};
+    argument sub_arg;
+    sub_arg.type = is_substitution(filename) ? ARG_SUBSTITUTION : ARG_OUTPUT_SUBSTITUTION;
+    sub_arg.value.substitution = pip;
+    if (sub_arg.type == ARG_SUBSTITUTION) {
+        output = fd_from_subtitution_arg_with_pipe(&sub_arg, j);
+    } else {
+        output = fd_from_output_subtitution_arg_with_pipe(&sub_arg, j);
+    }
+    free_pipeline(pip);
+    free(substitution);
+    return output;
+}
 
-        if (j->pgid == -1) {
-            setpgid(pid, pid);
-            pid_t pgid = getpgid(pid);
+void add_substitution_fd_to_command(command_without_substitution *cmd_without_subst, process_substitution_output output) {
+    cmd_without_subst->pids[cmd_without_subst->pid_count] = output.pid;
+    cmd_without_subst->pid_count++;
+    cmd_without_subst->fds[cmd_without_subst->fd_count] = output.fd;
+    cmd_without_subst->fd_count++;
+}
 
-            j->pid_leader = pid;
-            j->pgid = pgid;
-            j->status = RUNNING;
-        } else {
-            setpgid(pid, j->pgid);
+void close_substitution_fds(command_without_substitution *cmd_without_subst) {
+    for (size_t i = 0; i < cmd_without_subst->fd_count; i++) {
+        close(cmd_without_subst->fds[i]);
+    }
+    cmd_without_subst->fd_count = 0;
+}
+
+void add_argument_to_command(command_without_substitution *cmd_without_subst, size_t *argv_capacity, char *arg) {
+    if (cmd_without_subst->argc + 1 >= *argv_capacity) {
+        *argv_capacity *= 2;
+        cmd_without_subst->argv = realloc(cmd_without_subst->argv, sizeof(char *) * (*argv_capacity));
+        assert(cmd_without_subst->argv != NULL);
+    }
+    cmd_without_subst->argv[cmd_without_subst->argc] = arg;
+    cmd_without_subst->argc++;
+}
+
+void add_expanded_word_to_command(command_without_substitution *cmd_without_subst, size_t *argv_capacity,
+                                  const char *word) {
+    // The arguments of a function call stay one argument each
+    if (strcmp(word, "$@") == 0) {
+        for (size_t i = 1; i <= positional_parameter_count(); i++) {
+            char *arg = strdup(positional_parameter(i));
+            assert(arg != NULL);
+            add_argument_to_command(cmd_without_subst, argv_capacity, arg);
+        }
+        return;
+    }
+
+    // The variables are expanded before the patterns, their values being a single argument
+    char *expanded = strchr(word, '$') == NULL ? NULL : expand_variables(word);
+    if (expanded != NULL) {
+        word = expanded;
+    }
+
+    // The name of the command is never a pattern, so that a builtin such as `?` keeps its meaning
+    if (cmd_without_subst->argc > 0 && has_glob_characters(word)) {
+        size_t match_count = 0;
+        char **matches = expand_glob(word, &match_count);
+        if (matches != NULL) {
+            for (size_t k = 0; k < match_count; k++) {
+                add_argument_to_command(cmd_without_subst, argv_capacity, matches[k]);
+            }
+            free(matches);
+            free(expanded);
+            return;
+        }
+    }
+
+    // A pattern matching nothing is kept as is
+    char *arg = expanded != NULL ? expanded : strdup(word);
+    assert(arg != NULL);
+    add_argument_to_command(cmd_without_subst, argv_capacity, arg);
+}
+
+/*
+ * Adds the words of the brace expansion of the word, each one expanded like a word of its own. The arguments are
+ * first given room for exactly these words and the remaining_argc arguments after them, so that a range such as
+ * `{1..100000}` is generated straight into them.
+ */
+void add_brace_expanded_word_to_command(command_without_substitution *cmd_without_subst, size_t *argv_capacity,
+                                        const char *word, size_t remaining_argc) {
+    brace_expansion expansion;
+    if (!start_brace_expansion(word, &expansion)) {
+        add_expanded_word_to_command(cmd_without_subst, argv_capacity, word);
+        return;
+    }
+    if (expansion.count == 0) {
+        expansion_failed = true;
+    }
+
+    size_t needed_capacity = cmd_without_subst->argc + expansion.count + remaining_argc + 1;
+    if (needed_capacity > *argv_capacity) {
+        *argv_capacity = needed_capacity;
+        cmd_without_subst->argv = realloc(cmd_without_subst->argv, sizeof(char *) * (*argv_capacity));
+        assert(cmd_without_subst->argv != NULL);
+    }
+    for (size_t k = 0; k < expansion.count; k++) {
+        add_expanded_word_to_command(cmd_without_subst, argv_capacity, brace_expansion_word(&expansion, k));
+    }
+    end_brace_expansion(&expansion);
+}
+
+void add_captured_fields_to_command(command_without_substitution *cmd_without_subst, size_t *argv_capacity,
+                                    argument *arg) {
+    size_t len = 0;
+    char *output = capture_output_of_substitution(arg, &len);
+    len = strip_trailing_newlines(output, len);
+
+    size_t field_count = count_fields(output, len);
+    char **fields = malloc(sizeof(char *) * (field_count + 1));
+    assert(fields != NULL);
+    field_count = split_fields(output, len, fields, field_count);
+
+    for (size_t k = 0; k < field_count; k++) {
+        add_expanded_word_to_command(cmd_without_subst, argv_capacity, fields[k]);
+    }
+
+    free(fields);
+    free(output);
+}
+
+/*
+ * Adds the words of a word mixing text and command substitutions. The fields of each substitution are joined to the
+ * text around them, so that only its first and last fields are joined to what comes before and after it, and each
+ * word obtained is then expanded like a word of its own. The variables of the text are expanded before the joining,
+ * so that a name is never followed by the output of a substitution.
+ */
+void add_word_with_substitutions_to_command(command_without_substitution *cmd_without_subst, size_t *argv_capacity,
+                                            argument *arg, size_t remaining_argc) {
+    char *word = NULL;
+    size_t word_len = 0;
+    FILE *stream = open_memstream(&word, &word_len);
+    assert(stream != NULL);
+    // A word made only of substitutions without output is no word at all
+    bool has_word = false;
+
+    for (size_t k = 0; k < arg->value.word.part_count; k++) {
+        argument *part = arg->value.word.parts[k];
+        if (part->type == ARG_SIMPLE) {
+            char *expanded = strchr(part->value.simple, '$') == NULL ? NULL : expand_variables(part->value.simple);
+            fputs(expanded != NULL ? expanded : part->value.simple, stream);
+            free(expanded);
+            has_word = true;
+            continue;
         }
-        add_process_to_job(j, pid, pip->commands[pip->command_count - 1], cmds_without_subst[pip->command_count - 1],
-                           RUNNING);
 
-        for (size_t i = 0; i < pip->command_count; i++) {
-            cmds_without_subst[i] = NULL;
+        size_t len = 0;
+        char *output = capture_output_of_substitution(part, &len);
+        len = strip_trailing_newlines(output, len);
+        size_t field_count = count_fields(output, len);
+        char **fields = malloc(sizeof(char *) * (field_count + 1));
+        assert(fields != NULL);
+        field_count = split_fields(output, len, fields, field_count);
+
+        for (size_t f = 0; f < field_count; f++) {
+            // Each field but the first one starts a new word
+            if (f > 0) {
+                fclose(stream);
+                add_brace_expanded_word_to_command(cmd_without_subst, argv_capacity, word, remaining_argc);
+                free(word);
+                stream = open_memstream(&word, &word_len);
+                assert(stream != NULL);
+            }
+            fputs(fields[f], stream);
+            has_word = true;
         }
+        free(fields);
+        free(output);
+    }
 
-        free(cmds_without_subst);
+    fclose(stream);
+    if (has_word) {
+        add_brace_expanded_word_to_command(cmd_without_subst, argv_capacity, word, remaining_argc);
+    }
+    free(word);
+}
 
-        dup2(stdin_copy, STDIN_FILENO);
-        close(stdin_copy);
+/*
+ * Returns true if the word is an assignment whose value has command substitutions, and only assignments come before
+ * it in the command
+ */
+bool is_assignment_with_substitutions(const command_without_substitution *cmd_without_subst, const argument *arg) {
+    if (arg->type != ARG_WORD || arg->value.word.parts[0]->type != ARG_SIMPLE ||
+        !is_assignment(arg->value.word.parts[0]->value.simple)) {
+        return false;
+    }
+    for (size_t i = 0; i < cmd_without_subst->argc; i++) {
+        if (!is_assignment(cmd_without_subst->argv[i])) {
+            return false;
+        }
+    }
+    return true;
+}
 
-        return output;
+/*
+ * Adds an assignment whose value has command substitutions as a single argument: the output of each substitution,
+ * without its trailing newlines, is part of the value as is, neither split into fields nor expanded again
+ */
+void add_assignment_with_substitutions_to_command(command_without_substitution *cmd_without_subst,
+                                                  size_t *argv_capacity, argument *arg) {
+    char *assignment = NULL;
+    size_t assignment_len = 0;
+    FILE *stream = open_memstream(&assignment, &assignment_len);
+    assert(stream != NULL);
+
+    for (size_t k = 0; k < arg->value.word.part_count; k++) {
+        argument *part = arg->value.word.parts[k];
+        if (part->type == ARG_SIMPLE) {
+            char *expanded = strchr(part->value.simple, '$') == NULL ? NULL : expand_variables(part->value.simple);
+            fputs(expanded != NULL ? expanded : part->value.simple, stream);
+            free(expanded);
+            continue;
+        }
+        size_t len = 0;
+        char *output = capture_output_of_substitution(part, &len);
+        fwrite(output, 1, strip_trailing_newlines(output, len), stream);
+        free(output);
     }
+
+    fclose(stream);
+    add_argument_to_command(cmd_without_subst, argv_capacity, assignment);
+}
+
+/*
+ * Returns a command without name, which does nothing when it is run
+ */
+command_without_substitution *empty_command_without_substitution() {
+    command_without_substitution *cmd_without_substitution = malloc(sizeof(command_without_substitution));
+    assert(cmd_without_substitution != NULL);
+
+    cmd_without_substitution->name = NULL;
+    cmd_without_substitution->argc = 0;
+    cmd_without_substitution->argv = NULL;
+    cmd_without_substitution->redirection_count = 0;
+    cmd_without_substitution->redirections = NULL;
+    cmd_without_substitution->pids = NULL;
+    cmd_without_substitution->pid_count = 0;
+    cmd_without_substitution->fds = NULL;
+    cmd_without_substitution->fd_count = 0;
+    cmd_without_substitution->group_type = GROUP_NONE;
+    cmd_without_substitution->group = NULL;
+    cmd_without_substitution->compound = NULL;
+
+    return cmd_without_substitution;
 }
 
 command_without_substitution *prepare_command(command *cmd, job *j) {
     assert(cmd != NULL);
 
     if (cmd->name == NULL) {
-        command_without_substitution *cmd_without_substitution = malloc(sizeof(command_without_substitution));
-        assert(cmd_without_substitution != NULL);
-
-        cmd_without_substitution->name = NULL;
-        cmd_without_substitution->argc = 0;
-        cmd_without_substitution->argv = NULL;
-        cmd_without_substitution->redirection_count = 0;
-        cmd_without_substitution->redirections = NULL;
-
-        return cmd_without_substitution;
+        return empty_command_without_substitution();
     }
 
     assert(cmd->argv != NULL);
     assert(cmd->argv[0] != NULL);
-    assert(cmd->argv[0]->type == ARG_SIMPLE);
 
     command_without_substitution *cmd_without_substitution = malloc(sizeof(command_without_substitution));
     assert(cmd_without_substitution != NULL);
 
-    cmd_without_substitution->name = strdup(cmd->name);
-    assert(cmd_without_substitution->name != NULL);
-
-    cmd_without_substitution->argc = cmd->argc;
-    cmd_without_substitution->argv = malloc(sizeof(char *) * (cmd->argc + 1));
+    // Command substitutions may expand to any number of arguments, so argv grows as needed
+    size_t argv_capacity = cmd->argc + 1;
+    cmd_without_substitution->argc = 0;
+    cmd_without_substitution->argv = malloc(sizeof(char *) * argv_capacity);
     assert(cmd_without_substitution->argv != NULL);
 
     cmd_without_substitution->pids = malloc(sizeof(pid_t) * MAX_TOKENS);
     assert(cmd_without_substitution->pids != NULL);
     cmd_without_substitution->pid_count = 0;
+    cmd_without_substitution->fds = malloc(sizeof(int) * MAX_TOKENS);
+    assert(cmd_without_substitution->fds != NULL);
+    cmd_without_substitution->fd_count = 0;
 
+    expansion_failed = false;
+    substitution_exit_value = -1;
     for (size_t i = 0; i < cmd->argc; ++i) {
         if (cmd->argv[i]->type == ARG_SIMPLE) {
-            cmd_without_substitution->argv[i] = strdup(cmd->argv[i]->value.simple);
-            assert(cmd_without_substitution->argv[i] != NULL);
-        } else if (cmd->argv[i]->type == ARG_SUBSTITUTION) {
-            process_substitution_output output = fd_from_subtitution_arg_with_pipe(cmd->argv[i], j);
-            cmd_without_substitution->argv[i] = strdup(fd_to_proc_path(output.fd));
-            assert(cmd_without_substitution->argv[i] != NULL);
-            cmd_without_substitution->pids[cmd_without_substitution->pid_count] = output.pid;
-            cmd_without_substitution->pid_count++;
+            add_brace_expanded_word_to_command(cmd_without_substitution, &argv_capacity, cmd->argv[i]->value.simple,
+                                               cmd->argc - i - 1);
+        } else if (cmd->argv[i]->type == ARG_SUBSTITUTION || cmd->argv[i]->type == ARG_OUTPUT_SUBSTITUTION) {
+            process_substitution_output output = cmd->argv[i]->type == ARG_SUBSTITUTION
+                                                     ? fd_from_subtitution_arg_with_pipe(cmd->argv[i], j)
+                                                     : fd_from_output_subtitution_arg_with_pipe(cmd->argv[i], j);
+            char *arg = strdup(fd_to_proc_path(output.fd));
+            assert(arg != NULL);
+            add_argument_to_command(cmd_without_substitution, &argv_capacity, arg);
+            add_substitution_fd_to_command(cmd_without_substitution, output);
+        } else if (cmd->argv[i]->type == ARG_COMMAND_SUBSTITUTION) {
+            add_captured_fields_to_command(cmd_without_substitution, &argv_capacity, cmd->argv[i]);
+        } else if (is_assignment_with_substitutions(cmd_without_substitution, cmd->argv[i])) {
+            add_assignment_with_substitutions_to_command(cmd_without_substitution, &argv_capacity, cmd->argv[i]);
+        } else if (cmd->argv[i]->type == ARG_WORD) {
+            add_word_with_substitutions_to_command(cmd_without_substitution, &argv_capacity, cmd->argv[i],
+                                                   cmd->argc - i - 1);
         }
     }
-    cmd_without_substitution->argv[cmd->argc] = NULL;
+    cmd_without_substitution->argv[cmd_without_substitution->argc] = NULL;
+
+    // A command with an invalid expansion is not run, and fails
+    if (expansion_failed) {
+        close_substitution_fds(cmd_without_substitution);
+        cmd_without_substitution->name = NULL;
+        cmd_without_substitution->redirection_count = 0;
+        cmd_without_substitution->redirections = NULL;
+        free_command_without_substitution(cmd_without_substitution);
+        last_command_exit_value = COMMAND_FAILURE;
+        return empty_command_without_substitution();
+    }
+
+    // The name may come from a command substitution, so it is the first argument once expanded
+    cmd_without_substitution->name = NULL;
+    if (cmd_without_substitution->argc > 0) {
+        cmd_without_substitution->name = strdup(cmd_without_substitution->argv[0]);
+        assert(cmd_without_substitution->name != NULL);
+    }
 
     cmd_without_substitution->redirection_count = cmd->redirection_count;
     cmd_without_substitution->redirections = malloc(sizeof(redirection) * cmd->redirection_count);
@@ -216,41 +554,216 @@ command_without_substitution *prepare_command(command *cmd, job *j) {
         cmd_without_substitution->redirections[i].type = cmd->redirections[i].type;
         cmd_without_substitution->redirections[i].mode = cmd->redirections[i].mode;
         cmd_without_substitution->redirections[i].filename = strdup(cmd->redirections[i].filename);
+        // Here-document bodies may be large, they are borrowed from the command rather than copied
+        cmd_without_substitution->redirections[i].content = cmd->redirections[i].content;
+    }
+
+    // The list of a group and the clauses of a compound command are borrowed like the here-documents
+    cmd_without_substitution->group_type = cmd->group_type;
+    cmd_without_substitution->group = cmd->group;
+    cmd_without_substitution->compound = cmd->compound;
+
+    // A command is a builtin, then a function, then a program of PATH
+    if (cmd->group_type == GROUP_NONE && cmd_without_substitution->name != NULL &&
+        !is_intern_command(cmd_without_substitution->name) && !is_forked_builtin(cmd_without_substitution->name) &&
+        find_function(cmd_without_substitution->name) != NULL) {
+        cmd_without_substitution->group_type = GROUP_CALL;
     }
 
     return cmd_without_substitution;
 }
 
 bool is_intern_command(const char *cmd_name) {
-    return strcmp(cmd_name, "pwd") == 0 || strcmp(cmd_name, "cd") == 0 || strcmp(cmd_name, "exit") == 0 ||
-           strcmp(cmd_name, "?") == 0 || strcmp(cmd_name, "jobs") == 0 || strcmp(cmd_name, "kill") == 0 ||
-           strcmp(cmd_name, "bg") == 0 || strcmp(cmd_name, "fg") == 0;
+    const builtin *b = find_builtin(cmd_name);
+    return (b != NULL && !b->is_forked) || is_assignment(cmd_name);
+}
+
+bool is_forked_builtin(const char *cmd_name) {
+    const builtin *b = find_builtin(cmd_name);
+    return b != NULL && b->is_forked;
 }
 
 int run_intern_command(command_without_substitution *cmd_without_subst) {
+    unsigned long long start_time = event_log_time();
     int return_value;
-    if (strcmp(cmd_without_subst->argv[0], "pwd") == 0) {
-        return_value = pwd(cmd_without_subst);
-    } else if (strcmp(cmd_without_subst->argv[0], "cd") == 0) {
-        int cd_output = cd(cmd_without_subst);
-        update_prompt();
-        return_value = cd_output;
-    } else if (strcmp(cmd_without_subst->argv[0], "exit") == 0) {
-        return_value = exit_jsh(cmd_without_subst);
-    } else if (strcmp(cmd_without_subst->argv[0], "?") == 0) {
-        return_value = print_last_command_result(cmd_without_subst);
-    } else if (strcmp(cmd_without_subst->argv[0], "jobs") == 0) {
-        return_value = print_jobs(cmd_without_subst);
-    } else if (strcmp(cmd_without_subst->argv[0], "kill") == 0) {
-        return_value = jsh_kill(cmd_without_subst);
-    } else if (strcmp(cmd_without_subst->argv[0], "bg") == 0) {
-        return_value = bg(cmd_without_subst);
-    } else if (strcmp(cmd_without_subst->argv[0], "fg") == 0) {
-        return_value = fg(cmd_without_subst);
+    const builtin *b = find_builtin(cmd_without_subst->argv[0]);
+    if (b != NULL) {
+        return_value = b->run(cmd_without_subst);
+        if (b->updates_prompt) {
+            update_prompt();
+        }
+    } else if (is_assignment(cmd_without_subst->argv[0])) {
+        return_value = assign_variables(cmd_without_subst);
     }
+    log_builtin_event(cmd_without_subst, return_value, start_time);
     return return_value;
 }
 
+bool is_contained_builtin(const char *cmd_name) {
+    const builtin *b = find_builtin(cmd_name);
+    return b != NULL && b->is_contained;
+}
+
+/*
+ * Returns true if the list only reads the state of jsh, with builtins which change nothing and groups of them,
+ * so that a subshell running it can be run by jsh itself without a fork
+ */
+bool is_contained_list(const pipeline_list *pips) {
+    for (size_t i = 0; i < pips->pipeline_count; i++) {
+        const pipeline *pip = pips->pipelines[i];
+        if (pip == NULL || pip->to_job || pip->command_count != 1) {
+            return false;
+        }
+        const command *cmd = pip->commands[0];
+        if (cmd->group_type == GROUP_FUNCTION) {
+            return false;
+        } else if (cmd->group != NULL) {
+            if (!is_contained_list(cmd->group)) {
+                return false;
+            }
+        } else if (cmd->compound != NULL) {
+            return false;
+        } else if (cmd->name != NULL && !is_contained_builtin(cmd->name)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+typedef struct {
+    command_without_substitution *words;
+    size_t next_word;
+    int status;
+} loop_state;
+/* A loop of a program being run: the status of its body and, for a `for` loop, its words expanded,
+ * the first two being its variable and `in` */
+
+size_t running_programs = 0;
+
+int run_program(program *prog) {
+    // The loops run by jsh itself can be interrupted, whereas a command run in the foreground gets SIGINT itself
+    if (running_programs++ == 0) {
+        catch_interrupts();
+    }
+    loop_state *loops = calloc(prog->loop_count, sizeof(loop_state));
+    assert(prog->loop_count == 0 || loops != NULL);
+
+    int status = last_command_exit_value;
+    size_t pc = 0;
+    while (pc < prog->instruction_count && !interrupted) {
+        const instruction *in = &prog->instructions[pc++];
+        loop_state *loop = &loops[in->loop];
+        switch (in->op) {
+        case OP_RUN:
+            status = run_pipeline_of_list(prog->pipelines[in->arg].list, prog->pipelines[in->arg].index);
+            break;
+        case OP_JUMP:
+            pc = in->arg;
+            break;
+        case OP_JUMP_IF_FAILURE:
+            pc = status != SUCCESS ? in->arg : pc;
+            break;
+        case OP_JUMP_IF_SUCCESS:
+            pc = status == SUCCESS ? in->arg : pc;
+            break;
+        case OP_SET_STATUS:
+            status = in->arg;
+            break;
+        case OP_LOOP_START:
+            loop->status = SUCCESS;
+            break;
+        case OP_LOOP_SAVE:
+            loop->status = status;
+            break;
+        case OP_LOOP_END:
+            status = loop->status;
+            break;
+        case OP_FOR_WORDS: {
+            free_command_without_substitution(loop->words);
+            job *j = init_job_to_add(-1, -1, NULL, RUNNING);
+            loop->words = prepare_command(prog->loops[in->loop]->words, j);
+            close_substitution_fds(loop->words);
+            free_job(j);
+            loop->next_word = 2;
+            loop->status = SUCCESS;
+            break;
+        }
+        case OP_FOR_NEXT:
+            if (loop->next_word < loop->words->argc) {
+                set_variable(prog->loops[in->loop]->words->name, loop->words->argv[loop->next_word++]);
+            } else {
+                free_command_without_substitution(loop->words);
+                loop->words = NULL;
+                pc = in->arg;
+            }
+            break;
+        }
+        last_command_exit_value = status;
+    }
+    if (interrupted) {
+        status = 128 + SIGINT;
+        last_command_exit_value = status;
+    }
+
+    for (size_t i = 0; i < prog->loop_count; i++) {
+        free_command_without_substitution(loops[i].words);
+    }
+    free(loops);
+    if (--running_programs == 0) {
+        ignore_interrupts();
+    }
+    return status;
+}
+
+/*
+ * Runs the body of the function called with the arguments of the command as its positional parameters
+ */
+int call_function(command_without_substitution *cmd_without_subst) {
+    function_definition *function = find_function(cmd_without_subst->name);
+    assert(function != NULL);
+    retain_function(function);
+    push_positional_parameters(cmd_without_subst->argc - 1, cmd_without_subst->argv + 1);
+    // The braces of a body without redirection only delimit it, its list is run directly
+    const command *body = function->body->pipelines[0]->commands[0];
+    bool is_plain_group = body->group_type == GROUP_BRACES && body->redirection_count == 0;
+    int status = run_pipeline_list(is_plain_group ? body->group : function->body);
+    pop_positional_parameters();
+    release_function(function);
+    return status;
+}
+
+/*
+ * Runs the list of a group or the compound command, compiled the first time it runs, calls a function or defines
+ * one with a copy of its body, so that it is never parsed again
+ */
+int run_group(command_without_substitution *cmd_without_subst) {
+    if (cmd_without_subst->group_type == GROUP_FUNCTION) {
+        define_function(cmd_without_subst->name, copy_pipeline_list(cmd_without_subst->group));
+        return SUCCESS;
+    }
+    if (cmd_without_subst->group_type == GROUP_CALL) {
+        return call_function(cmd_without_subst);
+    }
+    if (cmd_without_subst->group != NULL) {
+        return run_pipeline_list(cmd_without_subst->group);
+    }
+    compound_command *compound = cmd_without_subst->compound;
+    if (compound->program == NULL) {
+        compound->program = compile_compound_command(cmd_without_subst->group_type, compound);
+    }
+    return run_program(compound->program);
+}
+
+/*
+ * Runs a group or a compound command in a process forked for it, where the jobs are not managed: its processes
+ * stay in its process group and get the signals sent to it
+ */
+int run_group_in_child(command_without_substitution *cmd_without_subst) {
+    job_control = false;
+    reset_signal_management();
+    return run_group(cmd_without_subst);
+}
+
 int run_command_without_redirections(command_without_substitution *cmd_without_subst, bool already_forked,
                                      pipeline *pip, job *j, bool is_leader) {
     int return_value = 0;
@@ -266,23 +779,43 @@ int run_command_without_redirections(command_without_substitution *cmd_without_s
         return return_value;
     }
     if (already_forked) {
-        if (is_intern_command(cmd_without_subst->argv[0])) {
+        if (cmd_without_subst->group_type != GROUP_NONE) {
+            return_value = run_group_in_child(cmd_without_subst);
+        } else if (is_intern_command(cmd_without_subst->argv[0])) {
             return_value = run_intern_command(cmd_without_subst);
+        } else if (is_forked_builtin(cmd_without_subst->argv[0])) {
+            return_value = find_builtin(cmd_without_subst->argv[0])->run(cmd_without_subst);
         } else {
             return_value = extern_command(cmd_without_subst);
         }
         return return_value;
     }
 
-    if (!pip->to_job && is_intern_command(cmd_without_subst->argv[0]) && is_leader) {
+    // A command with a timeout runs in a child, which can be killed
+    if (!pip->to_job && pip->timeout_ms == 0 && is_intern_command(cmd_without_subst->argv[0]) && is_leader) {
         j->pipeline = NULL;
         free_job(j);
         return_value = run_intern_command(cmd_without_subst);
+        close_substitution_fds(cmd_without_subst);
+        free_command_without_substitution(cmd_without_subst);
+        return return_value;
+    }
+
+    // A group or a compound command alone in its pipeline runs in jsh, as does a subshell which cannot change its state
+    if (!pip->to_job && pip->timeout_ms == 0 && is_leader && j->pgid == -1 && cmd_without_subst->group_type != GROUP_NONE &&
+        (cmd_without_subst->group_type != GROUP_SUBSHELL || is_contained_list(cmd_without_subst->group))) {
+        j->pipeline = NULL;
+        free_job(j);
+        return_value = run_group(cmd_without_subst);
+        close_substitution_fds(cmd_without_subst);
         free_command_without_substitution(cmd_without_subst);
         return return_value;
     }
 
     int status; // status of the created process
+    // The output of the builtins run before must neither follow the one of the child nor be written by it again
+    fflush(stdout);
+    fflush(stderr);
     pid_t pid = fork();
 
     assert(pid != -1);
@@ -292,71 +825,81 @@ int run_command_without_redirections(command_without_substitution *cmd_without_s
         for (size_t i = 0; i < cmd_without_subst->pid_count; i++) {
             waitpid(cmd_without_subst->pids[i], NULL, 0);
         }
+        if (cmd_without_subst->group_type != GROUP_NONE) {
+            exit(run_group_in_child(cmd_without_subst));
+        }
         if (is_intern_command(cmd_without_subst->argv[0])) {
             return_value = run_intern_command(cmd_without_subst);
             exit(return_value);
         }
         reset_signal_management();
+        if (is_forked_builtin(cmd_without_subst->argv[0])) {
+            exit(find_builtin(cmd_without_subst->argv[0])->run(cmd_without_subst));
+        }
         return_value = extern_command(cmd_without_subst);
         use_jsh_signal_management();
-        if (return_value < 0) {
-            perror("execvp");
-            exit(errno);
-        }
-        exit(SUCCESS);
+        exit(return_value);
         break;
     default:
-        if (j->pgid == -1) {
-            setpgid(pid, pid);
-            pid_t pgid = getpgid(pid);
-
-            j->pid_leader = pid;
-            j->pgid = pgid;
-            j->status = RUNNING;
-        } else {
-            setpgid(pid, j->pgid);
-        }
+        close_substitution_fds(cmd_without_subst);
+        join_job_process_group(j, pid);
 
         add_process_to_job(j, pid, pip->commands[0], cmd_without_subst, RUNNING);
 
         if (is_leader) {
             if (pip->to_job) {
                 add_job_to_jobs(j);
-                print_job(j, true);
+                // A job whose output is captured is printed once jsh has its own output back
+                if (!pip->capture_output) {
+                    print_job(j, true);
+                }
                 return SUCCESS;
             } else {
 
-                tcsetpgrp(STDERR_FILENO, getpgid(pid));
+                if (job_control) {
+                    record_flight_event(FLIGHT_TCSETPGRP, j->pgid, tcsetpgrp(STDERR_FILENO, getpgid(pid)), NULL);
+                }
 
-                waitpid(pid, &status, WUNTRACED);
+                pid_t res = waitpid(pid, &status, job_control ? WUNTRACED : 0);
+                record_flight_event(FLIGHT_WAITPID, pid, res == -1 ? -errno : status, NULL);
+                process *p = j->job_process[j->process_number - 1];
+                set_status_of_process(p, status);
+                log_status_event(j, p, RUNNING);
+                // Whatever the command did with the signal, it ended because of its timeout
+                bool timed_out = has_job_timed_out(j);
+                // A command killed by a signal fails with 128 plus the signal, as one stopped does
+                int exit_status = WIFSTOPPED(status) ? 128 + WSTOPSIG(status) : p->exit_status;
                 if (WIFSTOPPED(status)) {
                     pip->to_job = true;
                     j->status = STOPPED;
+                    record_flight_event(FLIGHT_JOB_STATUS, j->pgid, j->status, NULL);
                     add_job_to_jobs(j);
                     print_job(j, true);
                     j->pipeline->to_job = true;
-                    j->job_process[j->process_number - 1]->status = STOPPED;
                 } else if (WIFSIGNALED(status)) {
-                    j->job_process[j->process_number - 1]->status = KILLED;
+                    // Interrupting a command of a loop interrupts the loop
+                    if (WTERMSIG(status) == SIGINT) {
+                        interrupted = 1;
+                    }
 
                     j->pipeline->to_job = false;
                     j->pipeline = NULL;
 
                     free_job(j);
                 } else if (WIFEXITED(status)) {
-                    j->job_process[j->process_number - 1]->status = DONE;
-
                     j->pipeline->to_job = false;
                     j->pipeline = NULL;
 
                     free_job(j);
                 }
 
-                tcsetpgrp(STDERR_FILENO, getpgrp());
+                if (job_control) {
+                    record_flight_event(FLIGHT_TCSETPGRP, getpgrp(), tcsetpgrp(STDERR_FILENO, getpgrp()), NULL);
+                }
 
                 fflush(stderr);
                 fflush(stdout);
-                return WEXITSTATUS(status);
+                return timed_out ? COMMAND_TIMED_OUT : exit_status;
             }
         }
     }
@@ -384,102 +927,135 @@ int get_flags(const redirection *redirection) {
     return flags;
 }
 
+int open_output_redirection(command_without_substitution *cmd_without_subst, const redirection *redir, job *j) {
+    if (is_output_substitution(redir->filename)) {
+        process_substitution_output output = fd_from_substitution_filename(redir->filename, j);
+        if (output.fd != -1) {
+            cmd_without_subst->pids[cmd_without_subst->pid_count] = output.pid;
+            cmd_without_subst->pid_count++;
+        }
+        return output.fd;
+    }
+
+    int fd = open(redir->filename, get_flags(redir), 0666);
+    if (fd == -1) {
+        if (errno == EEXIST) {
+            fprintf(stderr, "jsh: %s: cannot overwrite existing file\n", redir->filename);
+        } else {
+            perror("open");
+        }
+    }
+    return fd;
+}
+
+void add_relay_to_job(job *j, pid_t relay_pid, command *cmd) {
+    add_process_to_job(j, relay_pid, cmd, NULL, RUNNING);
+
+    // The last process of a job is the one fg waits for, so it must stay the command itself
+    if (j->process_number > 1) {
+        process *relay_process = j->job_process[j->process_number - 1];
+        j->job_process[j->process_number - 1] = j->job_process[j->process_number - 2];
+        j->job_process[j->process_number - 2] = relay_process;
+    }
+}
+
 int run_command(command_without_substitution *cmd_without_subst, bool already_forked, pipeline *pip, job *j,
                 bool is_leader) {
 
     int return_value = 0;
 
+    // Without redirections, there are no descriptors to restore, which matters for the builtins run in loops
+    if (cmd_without_subst->redirection_count == 0) {
+        return run_command_without_redirections(cmd_without_subst, already_forked, pip, j, is_leader);
+    }
+
     int stdin_copy = dup(STDIN_FILENO);
     int stdout_copy = dup(STDOUT_FILENO);
     int stderr_copy = dup(STDERR_FILENO);
 
-    int fd_in, fd_out, fd_err;
-    for (size_t i = 0; i < cmd_without_subst->redirection_count; ++i) {
-        if (cmd_without_subst->redirections[i].type == REDIRECT_STDIN) {
-            char *filename = cmd_without_subst->redirections[i].filename;
-
-            if (is_substitution(filename)) {
-                char *substitution = strdup(filename + 2);
-                substitution[strlen(substitution) - 1] = '\0';
-                pipeline *pip = parse_pipeline(substitution, false);
-                if (pip == NULL) {
-                    fprintf(stderr, "jsh: %s: invalid substitution\n", substitution);
-                    return COMMAND_FAILURE;
+    // Every target of the standard output receives the whole output, through a relay when there are several
+    int stdout_targets[cmd_without_subst->redirection_count + 1];
+    size_t stdout_target_count = 0;
+    pid_t relay_pid = -1;
+    bool redirection_failed = false;
+
+    int fd_in, fd_err;
+    for (size_t i = 0; i < cmd_without_subst->redirection_count && !redirection_failed; ++i) {
+        redirection *redir = &cmd_without_subst->redirections[i];
+
+        if (redir->type == REDIRECT_STDIN) {
+            if (redir->content != NULL) {
+                fd_in = fd_of_here_document(redir->content);
+                if (fd_in == -1) {
+                    redirection_failed = true;
+                    break;
+                }
+            } else if (is_substitution(redir->filename)) {
+                process_substitution_output output = fd_from_substitution_filename(redir->filename, j);
+                if (output.fd == -1) {
+                    redirection_failed = true;
+                    break;
                 }
-                argument *sub_arg = malloc(sizeof(argument));
-                assert(sub_arg != NULL);
-                sub_arg->type = ARG_SUBSTITUTION;
-                sub_arg->value.substitution = pip;
-                process_substitution_output output = fd_from_subtitution_arg_with_pipe(sub_arg, j);
                 fd_in = output.fd;
                 cmd_without_subst->pids[cmd_without_subst->pid_count] = output.pid;
                 cmd_without_subst->pid_count++;
-                free(substitution);
-                free(sub_arg);
             } else {
-                fd_in = open(cmd_without_subst->redirections[i].filename, O_RDONLY);
+                fd_in = open(redir->filename, O_RDONLY);
             }
 
             if (fd_in == -1) {
-                if (errno == ENOENT) {
-                    perror("open");
-                    return COMMAND_FAILURE;
-                }
+                perror("open");
+                redirection_failed = true;
+                break;
             }
             if (dup2(fd_in, STDIN_FILENO) == -1) {
                 perror("dup2");
-                return EXIT_FAILURE;
-            }
-            if (close(fd_in) == -1) {
-                perror("close");
-                return EXIT_FAILURE;
+                redirection_failed = true;
             }
-        } else if (cmd_without_subst->redirections[i].type == REDIRECT_STDOUT) {
-            fd_out =
-                open(cmd_without_subst->redirections[i].filename, get_flags(&cmd_without_subst->redirections[i]), 0666);
+            close(fd_in);
+        } else if (redir->type == REDIRECT_STDOUT) {
+            int fd_out = open_output_redirection(cmd_without_subst, redir, j);
             if (fd_out == -1) {
-                if (errno == EEXIST) {
-                    fprintf(stderr, "jsh: %s: cannot overwrite existing file\n",
-                            cmd_without_subst->redirections[i].filename);
-                    return 1;
-                } else {
-                    perror("open");
-                    return EXIT_FAILURE;
-                }
+                redirection_failed = true;
+                break;
             }
-            if (dup2(fd_out, STDOUT_FILENO) == -1) {
-                perror("dup2");
-                return EXIT_FAILURE;
-            }
-            if (close(fd_out) == -1) {
-                perror("close");
-                return EXIT_FAILURE;
-            }
-        } else if (cmd_without_subst->redirections[i].type == REDIRECT_STDERR) {
-            fd_err =
-                open(cmd_without_subst->redirections[i].filename, get_flags(&cmd_without_subst->redirections[i]), 0666);
+            stdout_targets[stdout_target_count] = fd_out;
+            stdout_target_count++;
+        } else if (redir->type == REDIRECT_STDERR) {
+            fd_err = open_output_redirection(cmd_without_subst, redir, j);
             if (fd_err == -1) {
-                if (errno == EEXIST) {
-                    fprintf(stderr, "jsh: %s: cannot overwrite existing file\n",
-                            cmd_without_subst->redirections[i].filename);
-                    return 1;
-                } else {
-                    perror("open");
-                    return EXIT_FAILURE;
-                }
+                redirection_failed = true;
+                break;
             }
             if (dup2(fd_err, STDERR_FILENO) == -1) {
                 perror("dup2");
-                return EXIT_FAILURE;
-            }
-            if (close(fd_err) == -1) {
-                perror("close");
-                return EXIT_FAILURE;
+                redirection_failed = true;
             }
+            close(fd_err);
         }
     }
 
-    return_value = run_command_without_redirections(cmd_without_subst, already_forked, pip, j, is_leader);
+    if (!redirection_failed && stdout_target_count > 1) {
+        int relay_input;
+        relay_pid = start_fanout_relay(stdout_targets, stdout_target_count, &relay_input);
+        dup2(relay_input, STDOUT_FILENO);
+        close(relay_input);
+    } else if (!redirection_failed && stdout_target_count == 1) {
+        dup2(stdout_targets[0], STDOUT_FILENO);
+    }
+    for (size_t i = 0; i < stdout_target_count; i++) {
+        close(stdout_targets[i]);
+    }
+
+    if (redirection_failed) {
+        return_value = COMMAND_FAILURE;
+    } else {
+        return_value = run_command_without_redirections(cmd_without_subst, already_forked, pip, j, is_leader);
+    }
+
+    // The output of a builtin run by jsh itself must reach its redirections before they are undone
+    fflush(stdout);
+    fflush(stderr);
 
     dup2(stdin_copy, STDIN_FILENO);
     dup2(stdout_copy, STDOUT_FILENO);
@@ -489,6 +1065,16 @@ int run_command(command_without_substitution *cmd_without_subst, bool already_fo
     close(stdout_copy);
     close(stderr_copy);
 
+    if (relay_pid != -1) {
+        if (!already_forked && pip->to_job) {
+            // The job is still running, the relay ends with it
+            add_relay_to_job(j, relay_pid, pip->commands[0]);
+        } else {
+            // The command is over, the relay ends once it has written everything
+            waitpid(relay_pid, NULL, 0);
+        }
+    }
+
     return return_value;
 }
 
@@ -536,6 +1122,8 @@ int run_commands_of_pipeline(pipeline *pip, job *j) {
     for (int i = 0; i < pip->command_count - 1; i++) {
         cmds_without_subst[i] = prepare_command(pip->commands[i], j);
 
+        fflush(stdout);
+        fflush(stderr);
         pids[i] = fork();
         if (pids[i] == 0) {
             close_fd_of_tubes_except(tubes, pip->command_count - 1, i - 1, i);
@@ -550,17 +1138,9 @@ int run_commands_of_pipeline(pipeline *pip, job *j) {
             close(tubes[i][0]);
             exit(run_output);
         } else {
-            if (j->pgid == -1) {
-                setpgid(pids[i], pids[i]);
-                pid_t pgid = getpgid(pids[i]);
-
-                j->pid_leader = pids[i];
-                j->pgid = pgid;
-                j->status = RUNNING;
-            } else {
-                setpgid(pids[i], j->pgid);
-            }
+            join_job_process_group(j, pids[i]);
             add_process_to_job(j, pids[i], pip->commands[i], cmds_without_subst[i], RUNNING);
+            close_substitution_fds(cmds_without_subst[i]);
         }
     }
 
@@ -597,7 +1177,7 @@ int run_pipeline(pipeline *pip, job *j, bool is_leader) {
     unsigned njob = job_number;
 
     if (pip->command_count > 1) {
-        run_commands_of_pipeline(pip, j);
+        run_output = run_commands_of_pipeline(pip, j);
     } else {
         command_without_substitution *cmd_without_subst = prepare_command(pip->commands[0], j);
 
@@ -615,10 +1195,81 @@ int run_pipeline_list(pipeline_list *pips) {
     if (pips->pipeline_count == 0) {
         return last_command_exit_value;
     }
-    int run_output = 0;
+    // The children look the commands up in the index of PATH, which only jsh can bring up to date
+    refresh_path_index();
+    int run_output = last_command_exit_value;
     for (size_t i = 0; i < pips->pipeline_count; i++) {
-        job *j = init_job_to_add(-1, -1, pips->pipelines[i], RUNNING);
-        run_output = run_pipeline(pips->pipelines[i], j, true);
+        // A pipeline after `&&` or `||` is skipped according to the status of the last one run, kept for the next
+        ListOperator op = i == 0 ? LIST_SEQUENCE : pips->operators[i - 1];
+        if ((op == LIST_AND && run_output != SUCCESS) || (op == LIST_OR && run_output == SUCCESS)) {
+            continue;
+        }
+        bool background = pips->pipelines[i]->to_job;
+        unsigned long long start_time = event_log_time();
+        run_output = run_pipeline_of_list(pips, i);
+        log_pipeline_event(pips->pipeline_count, i, background, run_output, start_time);
+    }
+    return run_output;
+}
+
+/*
+ * Runs the pipeline of a job whose output is captured: while its processes start, the standard output and error of
+ * jsh are the pipes of the relay of its output, which becomes one of its processes
+ */
+int run_captured_pipeline(pipeline *pip, job *j) {
+    int stdout_fd, stderr_fd;
+    pid_t relay_pid = start_job_output(j->id, &stdout_fd, &stderr_fd);
+    if (relay_pid == -1) {
+        pip->capture_output = false;
+        return run_pipeline(pip, j, true);
+    }
+
+    int stdout_copy = dup(STDOUT_FILENO);
+    int stderr_copy = dup(STDERR_FILENO);
+    dup2(stdout_fd, STDOUT_FILENO);
+    dup2(stderr_fd, STDERR_FILENO);
+    close(stdout_fd);
+    close(stderr_fd);
+
+    int run_output = run_pipeline(pip, j, true);
+
+    fflush(stdout);
+    fflush(stderr);
+    dup2(stdout_copy, STDOUT_FILENO);
+    dup2(stderr_copy, STDERR_FILENO);
+    close(stdout_copy);
+    close(stderr_copy);
+
+    // A job which could not start has no writer of the pipes left, its relay is over
+    if (get_jobs_placement_with_id(j->id) == -1) {
+        waitpid(relay_pid, NULL, 0);
+        return run_output;
+    }
+    // The job is announced on the terminal, not among its own output
+    add_relay_to_job(j, relay_pid, pip->commands[0]);
+    print_job(j, true);
+    return run_output;
+}
+
+int run_pipeline_of_list(pipeline_list *pips, size_t i) {
+    pipeline *pip = pips->pipelines[i];
+    bool to_job = pip->to_job;
+    bool capture_output = pip->capture_output;
+    job *j = init_job_to_add(-1, -1, pip, RUNNING);
+    int run_output;
+    if (pip->to_job && pip->command_count > 0 && (capture_output || capture_jobs)) {
+        pip->capture_output = true;
+        run_output = run_captured_pipeline(pip, j);
+    } else {
+        run_output = run_pipeline(pip, j, true);
+    }
+    last_command_exit_value = run_output;
+
+    // A pipeline run as a job, or stopped, belongs to it from now on, the list keeps a copy to run it again
+    if (pip->to_job) {
+        pips->pipelines[i] = copy_pipeline(pip);
+        pips->pipelines[i]->to_job = to_job;
+        pips->pipelines[i]->capture_output = capture_output;
     }
     return run_output;
 }
@@ -22,16 +22,58 @@ typedef struct {
  * Structure to store the pid and the fd of the process substitution
  */
 
+pid_t launch_substitution_pipeline(pipeline *pip, job *j, int fd_in, int fd_out, int fd_kept);
+/*
+ * Forks the processes of the pipeline of a substitution as processes of the job, reading from fd_in and
+ * writing to fd_out (-1 to keep the standard input or output of jsh), and closes these descriptors in jsh.
+ * fd_kept, the other end of the substitution pipe, is closed in the processes.
+ * Returns the pid of the last process of the pipeline.
+ */
+
 char *fd_to_proc_path(int fd);
 /*
  * Returns the path of the descriptor in the proc repertory
  */
 
+#define CAPTURE_READ_SIZE (1 << 16)
+/* Minimal free space given to each read of a command substitution output */
+
+#define CAPTURE_PIPE_SIZE (1 << 20)
+/* Capacity requested for the pipe of a command substitution */
+
+char *capture_output_of_substitution(argument *sub_arg, size_t *len);
+/*
+ * Runs the pipeline of a command substitution in a child process and returns its whole output,
+ * read from a pipe into an allocated buffer terminated by '\0', and its length in len.
+ * The status of the pipeline is kept in substitution_exit_value.
+ */
+
 process_substitution_output fd_from_subtitution_arg_with_pipe(argument *sub_arg, job *j);
 /*
  * Returns the descriptor from the substitution created
  */
 
+process_substitution_output fd_from_output_subtitution_arg_with_pipe(argument *sub_arg, job *j);
+/*
+ * Returns the write end of a pipe read by the pipeline of an output substitution `>( ... )`
+ */
+
+process_substitution_output fd_from_substitution_filename(const char *filename, job *j);
+/*
+ * Parses the substitution `<( ... )` or `>( ... )` given as a redirection target and returns its descriptor,
+ * or -1 as descriptor if the substitution is invalid
+ */
+
+void add_substitution_fd_to_command(command_without_substitution *cmd_without_subst, process_substitution_output);
+/*
+ * Records the pid and the descriptor of a substitution used as an argument of the command
+ */
+
+void close_substitution_fds(command_without_substitution *cmd_without_subst);
+/*
+ * Closes the substitution descriptors kept by jsh for the command, once it has been launched
+ */
+
 int run_command_without_redirections(command_without_substitution *cmd_without_subst, bool is_job, pipeline *pip,
                                      job *j, bool is_leader);
 /* Run a command, without redirection.
@@ -80,6 +122,18 @@ int run_pipeline(pipeline *, job *, bool);
  *  - Exit value from extern_command if the pipeline was an external command.
  */
 
+int run_pipeline_of_list(pipeline_list *pips, size_t i);
+/*
+ * Runs the pipeline at index i of the list and returns its status. If it becomes a job, the list gets a copy of it
+ * in its place, so that a list can be run several times.
+ */
+
+int run_program(program *prog);
+/*
+ * Runs the instructions of a compiled compound command and returns the status of the last pipeline run.
+ * SIGINT interrupts the program, whose status is then 130, as does a command of the program killed by SIGINT.
+ */
+
 int run_pipeline_list(pipeline_list *pips);
 /* Run a list of pipelines.
  *
@@ -0,0 +1,587 @@
+#include "arithmetic.h"
+#include "variables.h"
+#include <ctype.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum {
+    TOKEN_END,
+    TOKEN_NUMBER,
+    TOKEN_NAME,
+    TOKEN_OPEN,
+    TOKEN_CLOSE,
+    TOKEN_COMMA,
+    TOKEN_ASSIGN,
+    TOKEN_ADD_ASSIGN,
+    TOKEN_SUBTRACT_ASSIGN,
+    TOKEN_MULTIPLY_ASSIGN,
+    TOKEN_DIVIDE_ASSIGN,
+    TOKEN_REMAINDER_ASSIGN,
+    TOKEN_SHIFT_LEFT_ASSIGN,
+    TOKEN_SHIFT_RIGHT_ASSIGN,
+    TOKEN_AND_ASSIGN,
+    TOKEN_XOR_ASSIGN,
+    TOKEN_OR_ASSIGN,
+    TOKEN_QUESTION,
+    TOKEN_COLON,
+    TOKEN_LOGICAL_OR,
+    TOKEN_LOGICAL_AND,
+    TOKEN_OR,
+    TOKEN_XOR,
+    TOKEN_AND,
+    TOKEN_EQUAL,
+    TOKEN_NOT_EQUAL,
+    TOKEN_LESS,
+    TOKEN_LESS_EQUAL,
+    TOKEN_GREATER,
+    TOKEN_GREATER_EQUAL,
+    TOKEN_SHIFT_LEFT,
+    TOKEN_SHIFT_RIGHT,
+    TOKEN_ADD,
+    TOKEN_SUBTRACT,
+    TOKEN_MULTIPLY,
+    TOKEN_DIVIDE,
+    TOKEN_REMAINDER,
+    TOKEN_POWER,
+    TOKEN_NOT,
+    TOKEN_COMPLEMENT,
+    TOKEN_INCREMENT,
+    TOKEN_DECREMENT,
+    TOKEN_INVALID,
+} ArithmeticToken;
+
+typedef enum {
+    PRECEDENCE_NONE,
+    PRECEDENCE_COMMA,
+    PRECEDENCE_ASSIGNMENT,
+    PRECEDENCE_CONDITIONAL,
+    PRECEDENCE_LOGICAL_OR,
+    PRECEDENCE_LOGICAL_AND,
+    PRECEDENCE_OR,
+    PRECEDENCE_XOR,
+    PRECEDENCE_AND,
+    PRECEDENCE_EQUALITY,
+    PRECEDENCE_RELATIONAL,
+    PRECEDENCE_SHIFT,
+    PRECEDENCE_ADDITIVE,
+    PRECEDENCE_MULTIPLICATIVE,
+    PRECEDENCE_POWER,
+    PRECEDENCE_UNARY,
+} Precedence;
+/* Binding powers of the operators, from the loosest to the tightest as in C, `**` binding tighter than the binary
+ * operators but looser than the unary ones */
+
+typedef struct {
+    const char *input;
+    size_t len;
+    size_t position;
+    ArithmeticToken token;
+    long long number;
+    const char *name;
+    size_t name_len;
+    const char *error;
+    int depth;
+} arithmetic_parser;
+/* The state of an evaluation: the current token, read up to position, with the value of a number or the name of a
+ * variable, and the first error met */
+
+long long parse_arithmetic(arithmetic_parser *p, Precedence min_precedence, bool evaluate);
+
+void fail(arithmetic_parser *p, const char *error) {
+    if (p->error == NULL) {
+        p->error = error;
+    }
+}
+
+/*
+ * Returns the token of the operator at start, preferring its longest spelling such as `<<=` to `<`, and sets token
+ * to TOKEN_INVALID if there is no operator there
+ */
+size_t operator_length_at(const arithmetic_parser *p, const char *start, ArithmeticToken *token) {
+    size_t left = p->len - p->position;
+    char second = left > 1 ? start[1] : '\0';
+    char third = left > 2 ? start[2] : '\0';
+    *token = TOKEN_INVALID;
+    switch (start[0]) {
+    case '(':
+        *token = TOKEN_OPEN;
+        return 1;
+    case ')':
+        *token = TOKEN_CLOSE;
+        return 1;
+    case ',':
+        *token = TOKEN_COMMA;
+        return 1;
+    case '?':
+        *token = TOKEN_QUESTION;
+        return 1;
+    case ':':
+        *token = TOKEN_COLON;
+        return 1;
+    case '~':
+        *token = TOKEN_COMPLEMENT;
+        return 1;
+    case '=':
+        *token = second == '=' ? TOKEN_EQUAL : TOKEN_ASSIGN;
+        return second == '=' ? 2 : 1;
+    case '!':
+        *token = second == '=' ? TOKEN_NOT_EQUAL : TOKEN_NOT;
+        return second == '=' ? 2 : 1;
+    case '+':
+    case '-': {
+        bool plus = start[0] == '+';
+        *token = second == start[0] ? (plus ? TOKEN_INCREMENT : TOKEN_DECREMENT)
+                 : second == '='    ? (plus ? TOKEN_ADD_ASSIGN : TOKEN_SUBTRACT_ASSIGN)
+                                    : (plus ? TOKEN_ADD : TOKEN_SUBTRACT);
+        return second == start[0] || second == '=' ? 2 : 1;
+    }
+    case '*':
+        *token = second == '*' ? TOKEN_POWER : second == '=' ? TOKEN_MULTIPLY_ASSIGN : TOKEN_MULTIPLY;
+        return second == '*' || second == '=' ? 2 : 1;
+    case '/':
+        *token = second == '=' ? TOKEN_DIVIDE_ASSIGN : TOKEN_DIVIDE;
+        return second == '=' ? 2 : 1;
+    case '%':
+        *token = second == '=' ? TOKEN_REMAINDER_ASSIGN : TOKEN_REMAINDER;
+        return second == '=' ? 2 : 1;
+    case '^':
+        *token = second == '=' ? TOKEN_XOR_ASSIGN : TOKEN_XOR;
+        return second == '=' ? 2 : 1;
+    case '&':
+    case '|': {
+        bool and = start[0] == '&';
+        *token = second == start[0] ? (and ? TOKEN_LOGICAL_AND : TOKEN_LOGICAL_OR)
+                 : second == '='    ? (and ? TOKEN_AND_ASSIGN : TOKEN_OR_ASSIGN)
+                                    : (and ? TOKEN_AND : TOKEN_OR);
+        return second == start[0] || second == '=' ? 2 : 1;
+    }
+    case '<':
+    case '>': {
+        bool less = start[0] == '<';
+        if (second == start[0]) {
+            *token = third == '=' ? (less ? TOKEN_SHIFT_LEFT_ASSIGN : TOKEN_SHIFT_RIGHT_ASSIGN)
+                                  : (less ? TOKEN_SHIFT_LEFT : TOKEN_SHIFT_RIGHT);
+            return third == '=' ? 3 : 2;
+        }
+        *token = second == '=' ? (less ? TOKEN_LESS_EQUAL : TOKEN_GREATER_EQUAL) : (less ? TOKEN_LESS : TOKEN_GREATER);
+        return second == '=' ? 2 : 1;
+    }
+    default:
+        return 0;
+    }
+}
+
+bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool is_name_start(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+/* The characters are compared directly rather than with ctype.h, which looks up the locale, as the expressions
+ * are read once for each evaluation */
+
+/*
+ * Reads the number of the given length in base 10, or in base 16 after `0x` or 8 after `0` like C, and returns
+ * false if a digit is not one of its base
+ */
+bool read_number(const char *digits, size_t len, long long *number) {
+    unsigned long long value = 0;
+    unsigned int base = 10;
+    size_t i = 0;
+    if (digits[0] != '0') {
+        for (; i < len && is_digit(digits[i]); i++) {
+            value = value * 10 + (digits[i] - '0');
+        }
+        *number = (long long)value;
+        return i == len;
+    }
+    if (len > 2 && digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X')) {
+        base = 16;
+        i = 2;
+    } else if (len > 1 && digits[0] == '0') {
+        base = 8;
+        i = 1;
+    }
+    for (; i < len; i++) {
+        unsigned char c = digits[i];
+        unsigned int digit = isdigit(c) ? c - '0' : isxdigit(c) ? (tolower(c) - 'a' + 10) : base;
+        if (digit >= base) {
+            return false;
+        }
+        value = value * base + digit;
+    }
+    *number = (long long)value;
+    return true;
+}
+
+void next_token(arithmetic_parser *p) {
+    while (p->position < p->len && (p->input[p->position] == ' ' || p->input[p->position] == '\t' ||
+                                     p->input[p->position] == '\n')) {
+        p->position++;
+    }
+    if (p->position >= p->len) {
+        p->token = TOKEN_END;
+        return;
+    }
+
+    const char *start = p->input + p->position;
+    if (is_digit(*start)) {
+        size_t number_len = 1;
+        while (p->position + number_len < p->len && (is_name_start(start[number_len]) || is_digit(start[number_len]))) {
+            number_len++;
+        }
+        p->position += number_len;
+        if (!read_number(start, number_len, &p->number)) {
+            fail(p, "invalid number");
+            p->token = TOKEN_INVALID;
+            return;
+        }
+        p->token = TOKEN_NUMBER;
+        return;
+    }
+    if (is_name_start(*start)) {
+        size_t name_len = 1;
+        while (p->position + name_len < p->len && (is_name_start(start[name_len]) || is_digit(start[name_len]))) {
+            name_len++;
+        }
+        p->name = start;
+        p->name_len = name_len;
+        p->position += name_len;
+        p->token = TOKEN_NAME;
+        return;
+    }
+    p->position += operator_length_at(p, start, &p->token);
+    if (p->token != TOKEN_INVALID) {
+        return;
+    }
+    fail(p, "syntax error: invalid arithmetic operator");
+    p->token = TOKEN_INVALID;
+}
+
+Precedence infix_precedence(ArithmeticToken token) {
+    switch (token) {
+    case TOKEN_COMMA:
+        return PRECEDENCE_COMMA;
+    case TOKEN_QUESTION:
+        return PRECEDENCE_CONDITIONAL;
+    case TOKEN_LOGICAL_OR:
+        return PRECEDENCE_LOGICAL_OR;
+    case TOKEN_LOGICAL_AND:
+        return PRECEDENCE_LOGICAL_AND;
+    case TOKEN_OR:
+        return PRECEDENCE_OR;
+    case TOKEN_XOR:
+        return PRECEDENCE_XOR;
+    case TOKEN_AND:
+        return PRECEDENCE_AND;
+    case TOKEN_EQUAL:
+    case TOKEN_NOT_EQUAL:
+        return PRECEDENCE_EQUALITY;
+    case TOKEN_LESS:
+    case TOKEN_LESS_EQUAL:
+    case TOKEN_GREATER:
+    case TOKEN_GREATER_EQUAL:
+        return PRECEDENCE_RELATIONAL;
+    case TOKEN_SHIFT_LEFT:
+    case TOKEN_SHIFT_RIGHT:
+        return PRECEDENCE_SHIFT;
+    case TOKEN_ADD:
+    case TOKEN_SUBTRACT:
+        return PRECEDENCE_ADDITIVE;
+    case TOKEN_MULTIPLY:
+    case TOKEN_DIVIDE:
+    case TOKEN_REMAINDER:
+        return PRECEDENCE_MULTIPLICATIVE;
+    case TOKEN_POWER:
+        return PRECEDENCE_POWER;
+    default:
+        return PRECEDENCE_NONE;
+    }
+}
+
+/*
+ * Returns the binary operator of a compound assignment such as `+=`, TOKEN_ASSIGN for `=`, or TOKEN_INVALID if the
+ * token assigns nothing
+ */
+ArithmeticToken operator_of_assignment(ArithmeticToken token) {
+    switch (token) {
+    case TOKEN_ASSIGN:
+        return TOKEN_ASSIGN;
+    case TOKEN_ADD_ASSIGN:
+        return TOKEN_ADD;
+    case TOKEN_SUBTRACT_ASSIGN:
+        return TOKEN_SUBTRACT;
+    case TOKEN_MULTIPLY_ASSIGN:
+        return TOKEN_MULTIPLY;
+    case TOKEN_DIVIDE_ASSIGN:
+        return TOKEN_DIVIDE;
+    case TOKEN_REMAINDER_ASSIGN:
+        return TOKEN_REMAINDER;
+    case TOKEN_SHIFT_LEFT_ASSIGN:
+        return TOKEN_SHIFT_LEFT;
+    case TOKEN_SHIFT_RIGHT_ASSIGN:
+        return TOKEN_SHIFT_RIGHT;
+    case TOKEN_AND_ASSIGN:
+        return TOKEN_AND;
+    case TOKEN_XOR_ASSIGN:
+        return TOKEN_XOR;
+    case TOKEN_OR_ASSIGN:
+        return TOKEN_OR;
+    default:
+        return TOKEN_INVALID;
+    }
+}
+
+/*
+ * Applies the binary operator, the arithmetic wrapping around like the one of the processor rather than being
+ * undefined. A division by zero is only an error if the operation is evaluated.
+ */
+long long apply_binary_operator(arithmetic_parser *p, ArithmeticToken op, long long left, long long right,
+                                bool evaluate) {
+    unsigned long long l = (unsigned long long)left;
+    unsigned long long r = (unsigned long long)right;
+    switch (op) {
+    case TOKEN_OR:
+        return left | right;
+    case TOKEN_XOR:
+        return left ^ right;
+    case TOKEN_AND:
+        return left & right;
+    case TOKEN_EQUAL:
+        return left == right;
+    case TOKEN_NOT_EQUAL:
+        return left != right;
+    case TOKEN_LESS:
+        return left < right;
+    case TOKEN_LESS_EQUAL:
+        return left <= right;
+    case TOKEN_GREATER:
+        return left > right;
+    case TOKEN_GREATER_EQUAL:
+        return left >= right;
+    case TOKEN_SHIFT_LEFT:
+        return (long long)(l << (r & 63));
+    case TOKEN_SHIFT_RIGHT:
+        return left >> (r & 63);
+    case TOKEN_ADD:
+        return (long long)(l + r);
+    case TOKEN_SUBTRACT:
+        return (long long)(l - r);
+    case TOKEN_MULTIPLY:
+        return (long long)(l * r);
+    case TOKEN_DIVIDE:
+    case TOKEN_REMAINDER:
+        if (right == 0) {
+            if (evaluate) {
+                fail(p, "division by zero");
+            }
+            return 0;
+        }
+        if (left == LLONG_MIN && right == -1) {
+            return op == TOKEN_DIVIDE ? left : 0;
+        }
+        return op == TOKEN_DIVIDE ? left / right : left % right;
+    case TOKEN_POWER: {
+        if (right < 0) {
+            if (evaluate) {
+                fail(p, "exponent less than 0");
+            }
+            return 0;
+        }
+        unsigned long long result = 1;
+        for (; r > 0; r >>= 1, l *= l) {
+            if (r & 1) {
+                result *= l;
+            }
+        }
+        return (long long)result;
+    }
+    default:
+        return right;
+    }
+}
+
+/*
+ * Returns the value of the variable as a number, its value being evaluated as an expression if it is not one
+ */
+long long value_of_variable(arithmetic_parser *p, const char *name, size_t len) {
+    const char *value = get_variable(name, len);
+    if (value == NULL) {
+        return 0;
+    }
+    // Most values are numbers, the others are evaluated as expressions
+    long long number;
+    size_t value_len = strlen(value);
+    size_t sign = value[0] == '-';
+    if (value_len > sign && read_number(value + sign, value_len - sign, &number)) {
+        return sign ? (long long)(0ULL - (unsigned long long)number) : number;
+    }
+    if (p->depth + 1 >= ARITHMETIC_MAX_DEPTH) {
+        fail(p, "expression recursion level exceeded");
+        return 0;
+    }
+
+    arithmetic_parser inner = {value, strlen(value), 0, TOKEN_END, 0, NULL, 0, NULL, p->depth + 1};
+    next_token(&inner);
+    number = parse_arithmetic(&inner, PRECEDENCE_COMMA, true);
+    if (inner.error == NULL && inner.token != TOKEN_END) {
+        fail(&inner, "syntax error in expression");
+    }
+    if (inner.error != NULL) {
+        fail(p, inner.error);
+    }
+    return number;
+}
+
+void assign_variable(arithmetic_parser *p, const char *name, size_t len, long long value) {
+    char name_buffer[VARIABLE_NAME_SIZE];
+    char value_buffer[ARITHMETIC_RESULT_SIZE];
+    if (len >= VARIABLE_NAME_SIZE) {
+        fail(p, "variable name too long");
+        return;
+    }
+    memcpy(name_buffer, name, len);
+    name_buffer[len] = '\0';
+    snprintf(value_buffer, sizeof(value_buffer), "%lld", value);
+    set_variable(name_buffer, value_buffer);
+}
+
+/*
+ * Parses and evaluates what starts with a variable: its value, an assignment to it or its postfix increment
+ */
+long long parse_variable(arithmetic_parser *p, bool evaluate) {
+    const char *name = p->name;
+    size_t len = p->name_len;
+    next_token(p);
+
+    ArithmeticToken op = operator_of_assignment(p->token);
+    if (op != TOKEN_INVALID) {
+        next_token(p);
+        long long right = parse_arithmetic(p, PRECEDENCE_ASSIGNMENT, evaluate);
+        long long value = op == TOKEN_ASSIGN ? right
+                                             : apply_binary_operator(p, op, evaluate ? value_of_variable(p, name, len) : 0,
+                                                                     right, evaluate);
+        if (evaluate && p->error == NULL) {
+            assign_variable(p, name, len, value);
+        }
+        return value;
+    }
+
+    long long value = evaluate ? value_of_variable(p, name, len) : 0;
+    if (p->token == TOKEN_INCREMENT || p->token == TOKEN_DECREMENT) {
+        if (evaluate) {
+            assign_variable(p, name, len, (long long)((unsigned long long)value + (p->token == TOKEN_INCREMENT ? 1 : -1)));
+        }
+        next_token(p);
+    }
+    return value;
+}
+
+/*
+ * Parses and evaluates an operand, with its unary operators
+ */
+long long parse_operand(arithmetic_parser *p, bool evaluate) {
+    ArithmeticToken token = p->token;
+    switch (token) {
+    case TOKEN_NUMBER: {
+        long long value = p->number;
+        next_token(p);
+        return value;
+    }
+    case TOKEN_NAME:
+        return parse_variable(p, evaluate);
+    case TOKEN_OPEN: {
+        next_token(p);
+        long long value = parse_arithmetic(p, PRECEDENCE_COMMA, evaluate);
+        if (p->token != TOKEN_CLOSE) {
+            fail(p, "syntax error: missing `)'");
+            return 0;
+        }
+        next_token(p);
+        return value;
+    }
+    case TOKEN_ADD:
+    case TOKEN_SUBTRACT:
+    case TOKEN_NOT:
+    case TOKEN_COMPLEMENT: {
+        next_token(p);
+        long long value = parse_arithmetic(p, PRECEDENCE_UNARY, evaluate);
+        return token == TOKEN_ADD        ? value
+               : token == TOKEN_SUBTRACT ? (long long)(0ULL - (unsigned long long)value)
+               : token == TOKEN_NOT      ? !value
+                                         : ~value;
+    }
+    case TOKEN_INCREMENT:
+    case TOKEN_DECREMENT: {
+        next_token(p);
+        if (p->token != TOKEN_NAME) {
+            fail(p, "syntax error: variable expected");
+            return 0;
+        }
+        const char *name = p->name;
+        size_t len = p->name_len;
+        next_token(p);
+        long long value = 0;
+        if (evaluate) {
+            value = (long long)((unsigned long long)value_of_variable(p, name, len) +
+                                (token == TOKEN_INCREMENT ? 1 : -1));
+            assign_variable(p, name, len, value);
+        }
+        return value;
+    }
+    default:
+        fail(p, "syntax error: operand expected");
+        return 0;
+    }
+}
+
+/*
+ * Parses and evaluates the expression from the current token as long as its operators bind at least as tightly as
+ * min_precedence. If evaluate is false, such as for the branch of `?:` not taken, nothing is assigned.
+ */
+long long parse_arithmetic(arithmetic_parser *p, Precedence min_precedence, bool evaluate) {
+    long long left = parse_operand(p, evaluate);
+    Precedence precedence;
+    while (p->error == NULL && (precedence = infix_precedence(p->token)) != PRECEDENCE_NONE &&
+           precedence >= min_precedence) {
+        ArithmeticToken op = p->token;
+        next_token(p);
+        if (op == TOKEN_QUESTION) {
+            long long if_true = parse_arithmetic(p, PRECEDENCE_COMMA, evaluate && left != 0);
+            if (p->token != TOKEN_COLON) {
+                fail(p, "syntax error: `:' expected for conditional expression");
+                return 0;
+            }
+            next_token(p);
+            long long if_false = parse_arithmetic(p, PRECEDENCE_CONDITIONAL, evaluate && left == 0);
+            left = left != 0 ? if_true : if_false;
+        } else if (op == TOKEN_LOGICAL_AND || op == TOKEN_LOGICAL_OR) {
+            bool skipped = op == TOKEN_LOGICAL_AND ? left == 0 : left != 0;
+            long long right = parse_arithmetic(p, precedence + 1, evaluate && !skipped);
+            left = skipped ? op == TOKEN_LOGICAL_OR : right != 0;
+        } else {
+            // `**` is right associative, the other binary operators left associative
+            long long right = parse_arithmetic(p, op == TOKEN_POWER ? precedence : precedence + 1, evaluate);
+            left = apply_binary_operator(p, op, left, right, evaluate);
+        }
+    }
+    return left;
+}
+
+bool evaluate_arithmetic(const char *expression, size_t len, long long *result) {
+    arithmetic_parser p = {expression, len, 0, TOKEN_END, 0, NULL, 0, NULL, 0};
+    next_token(&p);
+    // An empty expression is 0
+    *result = p.token == TOKEN_END && p.error == NULL ? 0 : parse_arithmetic(&p, PRECEDENCE_COMMA, true);
+    if (p.error == NULL && p.token != TOKEN_END) {
+        fail(&p, "syntax error in expression");
+    }
+    if (p.error != NULL) {
+        fprintf(stderr, "jsh: %.*s: %s\n", (int)len, expression, p.error);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,21 @@
+#ifndef ARITHMETIC_H
+#define ARITHMETIC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define ARITHMETIC_MAX_DEPTH 16
+/* Number of variables whose values are expressions which may be evaluated within one another, such as `a=b+1` */
+
+#define ARITHMETIC_RESULT_SIZE 24
+/* Size of a buffer holding the decimal digits of any result with its sign */
+
+bool evaluate_arithmetic(const char *expression, size_t len, long long *result);
+/*
+ * Evaluates the first len characters of the expression of an arithmetic expansion `$(( ))`, with the integer
+ * operators of C, `**` and the variables of jsh by their names, which may be assigned such as with `i += 1`.
+ * Returns false and prints the error if the expression is invalid or divides by zero.
+ * The expression is evaluated while it is parsed, without building a tree nor allocating memory.
+ */
+
+#endif
@@ -0,0 +1,385 @@
+#include "brace_expansion.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NO_BRACE_NODE SIZE_MAX
+#define BRACE_COUNT_LIMIT ((size_t)BRACE_EXPANSION_MAX_WORDS + 1)
+#define BRACE_RANGE_MAX_LEN 64
+
+typedef enum { BRACE_TEXT, BRACE_SEQUENCE, BRACE_ALTERNATION, BRACE_RANGE } BraceNodeType;
+
+struct brace_node {
+    BraceNodeType type;
+    size_t count;
+    size_t max_len;
+    size_t stride;
+    size_t first_child;
+    size_t next_sibling;
+    const char *text;
+    size_t len;
+    long long first;
+    long long step;
+    int width;
+    bool is_character;
+    size_t cached_child;
+    size_t cached_offset;
+};
+/*
+ * A part of a word with braces, generating count words of at most max_len bytes:
+ *  - BRACE_TEXT: the len characters at text
+ *  - BRACE_SEQUENCE: the words of its children concatenated, the child of a sequence changing every stride words
+ *  - BRACE_ALTERNATION: the words of each of its children, sequences, one after the other; the child of the last
+ *    word generated and the index of its first word are kept so that the next word is found at once
+ *  - BRACE_RANGE: first, first + step, ..., as integers padded to width digits or as characters
+ */
+
+/* Products and sums are saturated above the limit, so that they cannot overflow */
+size_t brace_count_product(size_t a, size_t b) {
+    if (a != 0 && b > BRACE_COUNT_LIMIT / a) {
+        return BRACE_COUNT_LIMIT;
+    }
+    return a * b > BRACE_COUNT_LIMIT ? BRACE_COUNT_LIMIT : a * b;
+}
+
+size_t brace_count_sum(size_t a, size_t b) {
+    return a + b > BRACE_COUNT_LIMIT ? BRACE_COUNT_LIMIT : a + b;
+}
+
+size_t new_brace_node(brace_expansion *expansion, BraceNodeType type) {
+    brace_node *node = &expansion->nodes[expansion->node_count];
+    node->type = type;
+    node->count = 1;
+    node->max_len = 0;
+    node->stride = 1;
+    node->first_child = NO_BRACE_NODE;
+    node->next_sibling = NO_BRACE_NODE;
+    node->cached_child = NO_BRACE_NODE;
+    node->cached_offset = 0;
+    return expansion->node_count++;
+}
+
+/*
+ * Returns the position of the `}` closing the `{` at start, before end, or end if it is not closed,
+ * and sets has_comma if a comma separates its content
+ */
+size_t closing_brace(const char *word, size_t start, size_t end, bool *has_comma) {
+    size_t depth = 0;
+    *has_comma = false;
+    for (size_t i = start; i < end; i++) {
+        if (word[i] == '{') {
+            depth++;
+        } else if (word[i] == '}') {
+            if (--depth == 0) {
+                return i;
+            }
+        } else if (word[i] == ',' && depth == 1) {
+            *has_comma = true;
+        }
+    }
+    return end;
+}
+
+bool is_brace_letter(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+bool parse_brace_integer(const char *text, long long *value) {
+    const char *digits = text[0] == '-' || text[0] == '+' ? text + 1 : text;
+    if (*digits < '0' || *digits > '9') {
+        return false;
+    }
+    char *end;
+    errno = 0;
+    *value = strtoll(text, &end, 10);
+    return *end == '\0' && errno == 0;
+}
+
+/* Returns true if the bound is written with leading zeros, such as `01` or `-05` */
+bool is_padded_bound(const char *text) {
+    const char *digits = text[0] == '-' || text[0] == '+' ? text + 1 : text;
+    return digits[0] == '0' && digits[1] != '\0';
+}
+
+/* Returns the value of the given index of the range, computed without overflowing */
+long long brace_range_value(const brace_node *node, size_t index) {
+    return (long long)((unsigned long long)node->first + (unsigned long long)node->step * index);
+}
+
+/* Returns true if the content of the braces from start to end is a range, setting the node to it */
+bool parse_brace_range(const char *word, size_t start, size_t end, brace_node *node) {
+    char content[BRACE_RANGE_MAX_LEN];
+    if (end - start >= BRACE_RANGE_MAX_LEN) {
+        return false;
+    }
+    memcpy(content, word + start, end - start);
+    content[end - start] = '\0';
+
+    char *separator = strstr(content, "..");
+    if (separator == NULL) {
+        return false;
+    }
+    *separator = '\0';
+    char *from = content;
+    char *to = separator + 2;
+    char *by = strstr(to, "..");
+    long long step = 1;
+    if (by != NULL) {
+        *by = '\0';
+        by += 2;
+        if (!parse_brace_integer(by, &step)) {
+            return false;
+        }
+    }
+
+    long long first, last;
+    node->width = 0;
+    if (is_brace_letter(from[0]) && from[1] == '\0' && is_brace_letter(to[0]) && to[1] == '\0') {
+        node->is_character = true;
+        first = from[0];
+        last = to[0];
+    } else if (parse_brace_integer(from, &first) && parse_brace_integer(to, &last)) {
+        node->is_character = false;
+        if (is_padded_bound(from) || is_padded_bound(to)) {
+            node->width = strlen(from) > strlen(to) ? strlen(from) : strlen(to);
+        }
+    } else {
+        return false;
+    }
+
+    // The sign of the step is ignored, the range going from its first bound to its last one
+    unsigned long long distance = first <= last ? (unsigned long long)last - (unsigned long long)first
+                                                : (unsigned long long)first - (unsigned long long)last;
+    unsigned long long magnitude = step < 0 ? -(unsigned long long)step : (unsigned long long)step;
+    if (magnitude == 0) {
+        magnitude = 1;
+    }
+    unsigned long long count = distance / magnitude + 1;
+
+    node->type = BRACE_RANGE;
+    node->count = count > BRACE_COUNT_LIMIT ? BRACE_COUNT_LIMIT : count;
+    node->first = first;
+    node->step = first <= last ? (long long)magnitude : -(long long)magnitude;
+    if (node->is_character) {
+        node->max_len = 1;
+    } else {
+        // The longest integer of the range is one of its bounds
+        char bound[BRACE_RANGE_MAX_LEN];
+        long long end_value = brace_range_value(node, node->count - 1);
+        int first_len = snprintf(bound, sizeof(bound), "%lld", first);
+        int last_len = snprintf(bound, sizeof(bound), "%lld", end_value);
+        int len = first_len > last_len ? first_len : last_len;
+        node->max_len = len > node->width ? len : node->width;
+    }
+    return true;
+}
+
+size_t parse_brace_sequence(const char *word, size_t start, size_t end, brace_expansion *expansion, bool *expanded);
+
+/*
+ * Sets the strides of the child of a sequence and of the children after it, the last child changing at each word,
+ * the one before it once the last one has generated all of its words, and so on. Returns the number of words
+ * they generate.
+ */
+size_t set_brace_strides(brace_expansion *expansion, size_t child) {
+    if (child == NO_BRACE_NODE) {
+        return 1;
+    }
+    size_t stride = set_brace_strides(expansion, expansion->nodes[child].next_sibling);
+    expansion->nodes[child].stride = stride;
+    return brace_count_product(stride, expansion->nodes[child].count);
+}
+
+/* Adds a child to the sequence, after its last child */
+void append_brace_child(brace_expansion *expansion, size_t sequence, size_t *last_child, size_t child) {
+    brace_node *node = &expansion->nodes[sequence];
+    if (*last_child == NO_BRACE_NODE) {
+        node->first_child = child;
+    } else {
+        expansion->nodes[*last_child].next_sibling = child;
+    }
+    *last_child = child;
+    node->count = brace_count_product(node->count, expansion->nodes[child].count);
+    node->max_len += expansion->nodes[child].max_len;
+}
+
+/*
+ * Returns the alternation or the range of the braces at start, closed at close, or NO_BRACE_NODE if they are
+ * neither of them
+ */
+size_t parse_brace_group(const char *word, size_t start, size_t close, bool has_comma, brace_expansion *expansion,
+                         bool *expanded) {
+    if (!has_comma) {
+        size_t range = new_brace_node(expansion, BRACE_RANGE);
+        if (parse_brace_range(word, start + 1, close, &expansion->nodes[range])) {
+            return range;
+        }
+        expansion->node_count--;
+        return NO_BRACE_NODE;
+    }
+
+    size_t alternation = new_brace_node(expansion, BRACE_ALTERNATION);
+    expansion->nodes[alternation].count = 0;
+    size_t last_child = NO_BRACE_NODE;
+    size_t alternative_start = start + 1;
+    size_t depth = 0;
+    for (size_t i = start + 1; i <= close; i++) {
+        if (i < close && word[i] == '{') {
+            depth++;
+        } else if (i < close && word[i] == '}') {
+            depth--;
+        } else if (i == close || (word[i] == ',' && depth == 0)) {
+            size_t child = parse_brace_sequence(word, alternative_start, i, expansion, expanded);
+            brace_node *node = &expansion->nodes[alternation];
+            if (last_child == NO_BRACE_NODE) {
+                node->first_child = child;
+            } else {
+                expansion->nodes[last_child].next_sibling = child;
+            }
+            last_child = child;
+            node->count = brace_count_sum(node->count, expansion->nodes[child].count);
+            if (expansion->nodes[child].max_len > node->max_len) {
+                node->max_len = expansion->nodes[child].max_len;
+            }
+            alternative_start = i + 1;
+        }
+    }
+    return alternation;
+}
+
+/* Returns the sequence of the text and the braces of the word from start to end */
+size_t parse_brace_sequence(const char *word, size_t start, size_t end, brace_expansion *expansion, bool *expanded) {
+    size_t sequence = new_brace_node(expansion, BRACE_SEQUENCE);
+    size_t last_child = NO_BRACE_NODE;
+    size_t text_start = start;
+    size_t i = start;
+    while (i < end) {
+        bool has_comma;
+        // The braces of a `${name}` are not expanded
+        if (word[i] == '$' && i + 1 < end && word[i + 1] == '{') {
+            size_t close = closing_brace(word, i + 1, end, &has_comma);
+            i = close == end ? end : close + 1;
+            continue;
+        }
+        if (word[i] != '{') {
+            i++;
+            continue;
+        }
+
+        size_t close = closing_brace(word, i, end, &has_comma);
+        size_t group = close == end ? NO_BRACE_NODE : parse_brace_group(word, i, close, has_comma, expansion, expanded);
+        if (group == NO_BRACE_NODE) {
+            // The `{` is kept, and the braces it contains may still be expanded
+            i++;
+            continue;
+        }
+        if (text_start < i) {
+            size_t text = new_brace_node(expansion, BRACE_TEXT);
+            expansion->nodes[text].text = word + text_start;
+            expansion->nodes[text].len = i - text_start;
+            expansion->nodes[text].max_len = i - text_start;
+            append_brace_child(expansion, sequence, &last_child, text);
+        }
+        append_brace_child(expansion, sequence, &last_child, group);
+        *expanded = true;
+        i = close + 1;
+        text_start = i;
+    }
+    if (text_start < end) {
+        size_t text = new_brace_node(expansion, BRACE_TEXT);
+        expansion->nodes[text].text = word + text_start;
+        expansion->nodes[text].len = end - text_start;
+        expansion->nodes[text].max_len = end - text_start;
+        append_brace_child(expansion, sequence, &last_child, text);
+    }
+
+    set_brace_strides(expansion, expansion->nodes[sequence].first_child);
+    return sequence;
+}
+
+bool start_brace_expansion(const char *word, brace_expansion *expansion) {
+    if (strchr(word, '{') == NULL) {
+        return false;
+    }
+
+    // A node takes at least one character of the word, except the sequence of an empty alternative
+    size_t len = strlen(word);
+    expansion->nodes = malloc(sizeof(brace_node) * (2 * len + 2));
+    assert(expansion->nodes != NULL);
+    expansion->node_count = 0;
+    expansion->buffer = NULL;
+
+    bool expanded = false;
+    size_t root = parse_brace_sequence(word, 0, len, expansion, &expanded);
+    assert(root == 0);
+    if (!expanded) {
+        free(expansion->nodes);
+        return false;
+    }
+
+    expansion->count = expansion->nodes[root].count;
+    expansion->max_len = expansion->nodes[root].max_len;
+    if (expansion->count > BRACE_EXPANSION_MAX_WORDS) {
+        fprintf(stderr, "jsh: %s: brace expansion of more than %d words\n", word, BRACE_EXPANSION_MAX_WORDS);
+        expansion->count = 0;
+        return true;
+    }
+    expansion->buffer = malloc(expansion->max_len + 1);
+    assert(expansion->buffer != NULL);
+    return true;
+}
+
+/* Writes the word of the given index of the node at out, and returns the end of what was written */
+char *write_brace_word(brace_expansion *expansion, size_t node_index, size_t index, char *out) {
+    brace_node *node = &expansion->nodes[node_index];
+    switch (node->type) {
+    case BRACE_TEXT:
+        memcpy(out, node->text, node->len);
+        return out + node->len;
+    case BRACE_SEQUENCE:
+        for (size_t child = node->first_child; child != NO_BRACE_NODE; child = expansion->nodes[child].next_sibling) {
+            brace_node *child_node = &expansion->nodes[child];
+            out = write_brace_word(expansion, child, index / child_node->stride % child_node->count, out);
+        }
+        return out;
+    case BRACE_ALTERNATION: {
+        size_t child = node->cached_child;
+        size_t offset = node->cached_offset;
+        if (child == NO_BRACE_NODE || index < offset) {
+            child = node->first_child;
+            offset = 0;
+        }
+        while (index >= offset + expansion->nodes[child].count) {
+            offset += expansion->nodes[child].count;
+            child = expansion->nodes[child].next_sibling;
+        }
+        node->cached_child = child;
+        node->cached_offset = offset;
+        return write_brace_word(expansion, child, index - offset, out);
+    }
+    case BRACE_RANGE: {
+        long long value = brace_range_value(node, index);
+        if (node->is_character) {
+            *out = (char)value;
+            return out + 1;
+        }
+        return out + snprintf(out, node->max_len + 1, "%0*lld", node->width, value);
+    }
+    }
+    return out;
+}
+
+const char *brace_expansion_word(brace_expansion *expansion, size_t index) {
+    assert(index < expansion->count);
+    char *end = write_brace_word(expansion, 0, index, expansion->buffer);
+    *end = '\0';
+    return expansion->buffer;
+}
+
+void end_brace_expansion(brace_expansion *expansion) {
+    free(expansion->nodes);
+    free(expansion->buffer);
+}
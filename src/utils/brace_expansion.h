@@ -0,0 +1,46 @@
+#ifndef BRACE_EXPANSION_H
+#define BRACE_EXPANSION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define BRACE_EXPANSION_MAX_WORDS (1 << 24)
+/* Maximal number of words a brace expansion may generate */
+
+typedef struct brace_node brace_node;
+
+typedef struct {
+    brace_node *nodes;
+    size_t node_count;
+    size_t count;
+    size_t max_len;
+    char *buffer;
+} brace_expansion;
+/*
+ * The expansion of a word with braces, such as `a{b,c{1..3}}`: its parts are kept as nodes giving the number of
+ * words they generate, so that the count words of the expansion are generated one after the other in a buffer of
+ * max_len + 1 bytes, without any list of them being built.
+ */
+
+bool start_brace_expansion(const char *word, brace_expansion *expansion);
+/*
+ * Returns false if the word has no brace expansion, it is then left as is. Otherwise prepares the expansion of:
+ *  - the comma lists `{a,b,c}`, which may be nested and have a preamble and a postscript, as in `x{a,b{1,2}}y`
+ *  - the ranges of integers `{1..10}` or of letters `{a..z}`, with an optional step `{0..100..5}`, the integers
+ *    being padded with zeros if one of the bounds starts with `0`, as in `{01..10}`
+ * A `{` with neither a comma nor a range, or without its closing `}`, and `${` are kept as they are.
+ * The expansion has a count of 0 if it would generate more than BRACE_EXPANSION_MAX_WORDS words, an error being
+ * printed. The word must stay valid until end_brace_expansion is called.
+ */
+
+const char *brace_expansion_word(brace_expansion *expansion, size_t index);
+/*
+ * Returns the word of the given index, below count, in the buffer of the expansion, which is overwritten by the
+ * next call. The words are generated in order, the last braces changing first, as in `a1 a2 b1 b2` for
+ * `{a,b}{1,2}`; generating them in increasing order takes a constant time per brace.
+ */
+
+void end_brace_expansion(brace_expansion *expansion);
+/* Frees the nodes and the buffer of the expansion */
+
+#endif
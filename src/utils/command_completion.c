@@ -0,0 +1,58 @@
+#include <readline/readline.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../builtins/builtins.h"
+#include "command_completion.h"
+#include "path_index.h"
+
+bool is_command_position(int start) {
+    int i = start - 1;
+    while (i >= 0 && rl_line_buffer[i] == ' ') {
+        i--;
+    }
+    return i < 0 || strchr("|&;({", rl_line_buffer[i]) != NULL;
+}
+
+/*
+ * Generator of readline returning the builtins then the executables starting with the text, one at each call
+ */
+char *generate_command_name(const char *text, int state) {
+    static size_t builtin_index;
+    static size_t path_index;
+    static size_t path_last;
+    static bool in_path;
+    size_t text_len = strlen(text);
+
+    if (state == 0) {
+        builtin_index = 0;
+        in_path = path_index_prefix_range(text, &path_index, &path_last);
+    }
+
+    while (builtin_index < builtin_count) {
+        const char *name = builtins[builtin_index++].name;
+        if (strncmp(name, text, text_len) == 0) {
+            return strdup(name);
+        }
+    }
+    while (in_path && path_index < path_last) {
+        const char *name = path_index_name(path_index++);
+        // The builtins were already given
+        if (find_builtin(name) == NULL) {
+            return strdup(name);
+        }
+    }
+    return NULL;
+}
+
+char **complete_command(const char *text, int start, int end) {
+    if (!is_command_position(start) || strchr(text, '/') != NULL) {
+        return NULL;
+    }
+    refresh_path_index();
+    // Without falling back to the file names of the current directory if nothing matches
+    rl_attempted_completion_over = 1;
+    return rl_completion_matches(text, generate_command_name);
+}
@@ -0,0 +1,11 @@
+#ifndef COMMAND_COMPLETION_H
+#define COMMAND_COMPLETION_H
+
+char **complete_command(const char *text, int start, int end);
+/*
+ * Completion function of readline: completes the names of the builtins and of the executables of PATH,
+ * looked up in the index of PATH, when the word is a command name, i.e. at the start of the line or after
+ * `|`, `&`, `;` or `(`, and does not contain a `/`. Otherwise, lets readline complete the file names.
+ */
+
+#endif
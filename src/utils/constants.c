@@ -17,6 +17,8 @@ const char *HOME;
 const int SUCCESS = 0;
 const int COMMAND_FAILURE = 1;
 const int COMMAND_NOT_FOUND = 127;
+const int COMMAND_NOT_EXECUTABLE = 126;
+const int COMMAND_TIMED_OUT = 124;
 
 const size_t PROMPT_MAX_VISIBLE_LEN = 30;
 const size_t LITTERAL_CHARS_COUNT = 4;
@@ -21,6 +21,8 @@ extern const char *RED_COLOR;
 extern const int SUCCESS;
 extern const int COMMAND_FAILURE;
 extern const int COMMAND_NOT_FOUND;
+extern const int COMMAND_NOT_EXECUTABLE; // The status of a command found but which cannot be executed
+extern const int COMMAND_TIMED_OUT; // The status of a command killed by its `timeout`, as with timeout(1)
 
 /* PROMPT DATA */
 
@@ -5,11 +5,21 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include "core.h"
-#include "int_utils.h"
+#include "directory_fds.h"
+#include "event_log.h"
+#include "frecency.h"
+#include "functions.h"
+#include "job_output.h"
 #include "jobs_core.h"
+#include "path_index.h"
+#include "prompt_segments.h"
+#include "string_utils.h"
+#include "timer_wheel.h"
+#include "variables.h"
 
 char *current_folder;
 char *prompt;
@@ -17,43 +27,125 @@ int last_command_exit_value = 0;
 char *last_reference_position;
 char *last_line_read;
 pipeline_list *current_pipeline_list = NULL;
+char **directory_stack = NULL;
+size_t directory_stack_size = 0;
+bool job_control = true;
+bool capture_jobs = false;
+
+// The logical path of the directory changed to by change_pwd, used by the next update_current_folder
+char *changed_folder = NULL;
 
 void print_error(const char *error) {
     fprintf(stderr, "%s\n", error);
 }
 
+/*
+ * Segments of the prompt kept from one update to the next, so that only the ones which changed are rendered again
+ */
+size_t prompt_capacity = 0;
+size_t prompt_color_codes_len = 0;
+int prompt_job_number = -1;
+char prompt_job_segment[PROMPT_JOB_SEGMENT_SIZE];
+size_t prompt_job_segment_len = 0;
+unsigned long current_folder_generation = 0;
+unsigned long prompt_folder_generation = 0;
+size_t prompt_folder_width = 0;
+const char *prompt_folder_segment = NULL;
+bool prompt_folder_truncated = false;
+unsigned long prompt_segments_rendered_generation = 0;
+
+/*
+ * Renders the visible part of the current folder within the given number of columns,
+ * keeping its end after three dots if it is too wide
+ */
+void render_folder_segment(size_t max_width) {
+    size_t len = strlen(current_folder);
+    prompt_folder_segment = suffix_of_display_width(current_folder, len, max_width);
+    prompt_folder_truncated = prompt_folder_segment != current_folder;
+    if (prompt_folder_truncated) {
+        prompt_folder_segment = suffix_of_display_width(current_folder, len, max_width - 3); // -3 for the three dots
+    }
+    prompt_folder_width = max_width;
+    prompt_folder_generation = current_folder_generation;
+}
+
+void append_to_prompt(size_t *len, const char *str, size_t str_len) {
+    memcpy(prompt + *len, str, str_len);
+    *len += str_len;
+}
+
 void update_prompt() {
-    // Defining the size of the prompt
-    size_t nb_color_codes_char = strlen(DEFAULT_COLOR) + strlen(YELLOW_COLOR) + strlen(GREEN_COLOR);
-    int job_number_len = get_nb_of_digits(job_number);
-    size_t prompt_max_len = PROMPT_MAX_VISIBLE_LEN + nb_color_codes_char;
-    size_t full_prompt_len = strlen(current_folder) + job_number_len + LITTERAL_CHARS_COUNT + nb_color_codes_char;
-    size_t final_prompt_len = (full_prompt_len > prompt_max_len ? prompt_max_len : full_prompt_len) + 1;
-
-    // Allocating memory for the prompt
-    if (prompt != NULL) {
-        free(prompt);
+    if (prompt_color_codes_len == 0) {
+        prompt_color_codes_len =
+            strlen(DEFAULT_COLOR) + strlen(YELLOW_COLOR) + strlen(GREEN_COLOR) + strlen(CYAN_COLOR);
     }
-    prompt = malloc((final_prompt_len + 1) * sizeof(char));
-    assert(prompt != NULL);
-
-    // Constructing the prompt
-    if (full_prompt_len > prompt_max_len) {
-        // Handling the case where the length of the path makes the prompt longer than the max length
-        size_t shortened_path_len =
-            prompt_max_len - LITTERAL_CHARS_COUNT - job_number_len - nb_color_codes_char - 3; // -3 for the three dots
-        size_t start_of_path = strlen(current_folder) - shortened_path_len;
-        snprintf(prompt, final_prompt_len + 1, "%s[%d]%s...%s%s$ ", YELLOW_COLOR, job_number, GREEN_COLOR,
-                 current_folder + start_of_path, DEFAULT_COLOR);
+
+    bool job_changed = job_number != prompt_job_number;
+    if (job_changed) {
+        prompt_job_segment_len =
+            snprintf(prompt_job_segment, PROMPT_JOB_SEGMENT_SIZE, "[%d]", job_number);
+        prompt_job_number = job_number;
+    }
+
+    // The segments computed in the background keep the value of the last update until their fresh one arrives
+    refresh_prompt_segments(current_folder);
+    unsigned long segments_generation = prompt_segments_generation();
+    bool segments_changed = segments_generation != prompt_segments_rendered_generation;
+    prompt_segments_rendered_generation = segments_generation;
+    const char *segments = prompt_segments_text();
+    size_t segments_len = strlen(segments);
+    size_t segments_width = utf8_display_width(segments);
+
+    // The folder takes the columns left by the job number, the segments and the literal characters,
+    // the segments being dropped rather than leaving less than PROMPT_MIN_FOLDER_WIDTH columns to the folder
+    size_t folder_width = PROMPT_MAX_VISIBLE_LEN - LITTERAL_CHARS_COUNT - (prompt_job_segment_len - 2);
+    if (folder_width < segments_width + PROMPT_MIN_FOLDER_WIDTH) {
+        segments_len = 0;
     } else {
-        // Regular case
-        snprintf(prompt, final_prompt_len + 1, "%s[%d]%s%s%s$ ", YELLOW_COLOR, job_number, GREEN_COLOR, current_folder,
-                 DEFAULT_COLOR);
+        folder_width -= segments_width;
     }
+    bool folder_changed =
+        prompt_folder_generation != current_folder_generation || prompt_folder_width != folder_width;
+    if (folder_changed) {
+        render_folder_segment(folder_width);
+    }
+
+    if (!job_changed && !folder_changed && !segments_changed && prompt != NULL) {
+        return;
+    }
+
+    size_t folder_segment_len = strlen(prompt_folder_segment);
+    // The three dots, then `$ ` and the final '\0'
+    size_t needed = prompt_color_codes_len + prompt_job_segment_len + folder_segment_len + segments_len + 3 + 3;
+    if (needed > prompt_capacity) {
+        // Wide enough for any folder of ASCII characters, only grown for the folders with many multibyte ones
+        prompt_capacity = needed > PROMPT_BUFFER_SIZE ? needed : PROMPT_BUFFER_SIZE;
+        free(prompt);
+        prompt = malloc(prompt_capacity * sizeof(char));
+        assert(prompt != NULL);
+    }
+
+    size_t len = 0;
+    append_to_prompt(&len, YELLOW_COLOR, strlen(YELLOW_COLOR));
+    append_to_prompt(&len, prompt_job_segment, prompt_job_segment_len);
+    append_to_prompt(&len, GREEN_COLOR, strlen(GREEN_COLOR));
+    if (prompt_folder_truncated) {
+        append_to_prompt(&len, "...", 3);
+    }
+    append_to_prompt(&len, prompt_folder_segment, folder_segment_len);
+    if (segments_len > 0) {
+        append_to_prompt(&len, CYAN_COLOR, strlen(CYAN_COLOR));
+        append_to_prompt(&len, segments, segments_len);
+    }
+    append_to_prompt(&len, DEFAULT_COLOR, strlen(DEFAULT_COLOR));
+    append_to_prompt(&len, "$ ", 3); // With the final '\0'
 }
 
 void init_core() {
     update_current_folder();
+    open_frecency_database(NULL);
+    open_event_log(NULL);
+    init_prompt_segments();
     update_prompt();
 
     size_t len_current_folder = strlen(current_folder);
@@ -78,17 +170,65 @@ void free_core() {
     }
     free_pipeline_list(current_pipeline_list);
     free_jobs_core();
+    free_timer_wheel();
+    free_job_outputs();
+    free_prompt_segments();
+    for (size_t i = 0; i < directory_stack_size; i++) {
+        free(directory_stack[i]);
+    }
+    free(directory_stack);
+    directory_stack = NULL;
+    directory_stack_size = 0;
+    free(changed_folder);
+    changed_folder = NULL;
+    free_path_index();
+    close_frecency_database();
+    close_event_log();
+    close_directory_fds();
+    free_functions();
+    free_variables();
 }
 
 int change_pwd(const char *path) {
+    free(changed_folder);
+    changed_folder = NULL;
+
+    char *logical = logical_path(current_folder == NULL ? "/" : current_folder, path);
+    int fd = directory_fd(logical);
+    if (fd != -1 && fchdir(fd) == 0) {
+        changed_folder = logical;
+        return SUCCESS;
+    }
+    free(logical);
+
+    // The logical path may not exist, such as `..` after a symbolic link to a directory removed since
     if (chdir(path) != 0) {
         return COMMAND_FAILURE;
     }
     return SUCCESS;
 }
 
+/*
+ * Returns the logical path of the current directory: the one of the last change_pwd, or PWD if it is the
+ * current directory, or its physical path otherwise
+ */
+char *get_logical_current_folder() {
+    if (changed_folder != NULL) {
+        char *folder = changed_folder;
+        changed_folder = NULL;
+        return folder;
+    }
+    const char *pwd = getenv("PWD");
+    struct stat pwd_st, current_st;
+    if (current_folder == NULL && pwd != NULL && pwd[0] == '/' && stat(pwd, &pwd_st) == 0 &&
+        stat(".", &current_st) == 0 && pwd_st.st_dev == current_st.st_dev && pwd_st.st_ino == current_st.st_ino) {
+        return logical_path("/", pwd);
+    }
+    return getcwd(NULL, 0);
+}
+
 void update_current_folder() {
-    char *new_current_folder = getcwd(NULL, 0);
+    char *new_current_folder = get_logical_current_folder();
     assert(new_current_folder != NULL);
 
     if (last_reference_position != NULL) {
@@ -97,4 +237,10 @@ void update_current_folder() {
 
     last_reference_position = current_folder;
     current_folder = new_current_folder;
+    current_folder_generation++;
+
+    // Every change of directory but the first one, which is where jsh starts
+    if (last_reference_position != NULL) {
+        record_directory_visit(current_folder);
+    }
 }
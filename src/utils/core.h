@@ -5,6 +5,15 @@
 #include "constants.h"
 #include "jobs_core.h"
 
+#define PROMPT_BUFFER_SIZE 128
+/* Initial size of the buffer of the prompt */
+
+#define PROMPT_JOB_SEGMENT_SIZE 16
+/* Size of the buffer of the job count of the prompt, with its brackets */
+
+#define PROMPT_MIN_FOLDER_WIDTH 8
+/* Minimal number of columns of the folder, the segments computed in the background being hidden otherwise */
+
 /* VARIABLES */
 
 extern char *current_folder; // current user position, initialized with PWD from constant
@@ -13,6 +22,10 @@ extern int last_command_exit_value;          // last user command exit value
 extern char *last_reference_position;        // last user location, initialized with PWD from constant
 extern char *last_line_read;                 // last line typed by the user
 extern pipeline_list *current_pipeline_list; // current_pipeline run
+extern char **directory_stack;               // directories saved by pushd, the last one being the top
+extern size_t directory_stack_size;          // number of directories of directory_stack
+extern bool job_control;                     // false in a subshell, whose processes stay in its process group
+extern bool capture_jobs;                     // set -o capturejobs: every job has its output captured as with &!
 
 /* FUNCTIONS */
 
@@ -20,7 +33,9 @@ void print_error(const char *);
 // print the error message on error output
 
 void update_prompt();
-// update the prompt according to the current position
+// update the prompt according to the current position and the number of jobs, rendering only the segments
+// which changed since the last update in a buffer kept between updates, the folder being truncated
+// according to its display width, and followed by the segments computed in the background which are ready
 
 void init_core();
 // initialize constants and then initialize the variables that need them: current_folder, prompt and
@@ -31,10 +46,11 @@ void free_core();
 NULL */
 
 int change_pwd(const char *);
-/* updates the pwd environment variable by changing it to the string passed as argument, and returns an error otherwise
- */
+/* changes the current directory to the path passed as argument, resolved logically from current_folder and entered
+ * with fchdir through the cache of the descriptors of directories, and returns an error otherwise (errno is set) */
 
 void update_current_folder();
-/* Changes the folder variable current_folder to the reference of the current directory */
+/* Changes the folder variable current_folder to the logical path of the current directory: the one given to the
+ * last change_pwd, or PWD at startup if it names the current directory, without calling getcwd */
 
 #endif
@@ -0,0 +1,229 @@
+#define _GNU_SOURCE
+#include "directory_cache.h"
+#include <assert.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+struct linux_dirent64 {
+    ino64_t d_ino;
+    off64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+directory_listing *directory_cache[DIRECTORY_CACHE_BUCKETS];
+size_t directory_cache_entry_count = 0;
+pthread_mutex_t directory_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+size_t directory_cache_bucket(dev_t dev, ino_t ino) {
+    uint64_t hash = (uint64_t)ino * 0x9E3779B97F4A7C15ULL ^ (uint64_t)dev;
+    return (hash >> 20) % DIRECTORY_CACHE_BUCKETS;
+}
+
+void free_directory_listing(directory_listing *listing) {
+    free(listing->entries);
+    free(listing->names);
+    free(listing);
+}
+
+/*
+ * Drops a reference to the listing, the lock must be held
+ */
+void unreference_directory_listing(directory_listing *listing) {
+    listing->reference_count--;
+    if (listing->reference_count == 0) {
+        free_directory_listing(listing);
+    }
+}
+
+/*
+ * Removes the listing of the directory from the cache, the lock must be held
+ */
+void uncache_directory_listing(dev_t dev, ino_t ino) {
+    directory_listing **previous = &directory_cache[directory_cache_bucket(dev, ino)];
+    while (*previous != NULL) {
+        directory_listing *listing = *previous;
+        if (listing->dev == dev && listing->ino == ino) {
+            *previous = listing->next;
+            directory_cache_entry_count -= listing->entry_count;
+            unreference_directory_listing(listing);
+            return;
+        }
+        previous = &listing->next;
+    }
+}
+
+void clear_directory_cache_locked() {
+    for (size_t i = 0; i < DIRECTORY_CACHE_BUCKETS; i++) {
+        while (directory_cache[i] != NULL) {
+            directory_listing *listing = directory_cache[i];
+            directory_cache[i] = listing->next;
+            unreference_directory_listing(listing);
+        }
+    }
+    directory_cache_entry_count = 0;
+}
+
+void clear_directory_cache() {
+    pthread_mutex_lock(&directory_cache_lock);
+    clear_directory_cache_locked();
+    pthread_mutex_unlock(&directory_cache_lock);
+}
+
+/*
+ * Returns the cached listing of the directory with a new reference if it is still valid, NULL otherwise
+ */
+directory_listing *find_cached_directory_listing(const struct stat *st) {
+    pthread_mutex_lock(&directory_cache_lock);
+    directory_listing *listing = directory_cache[directory_cache_bucket(st->st_dev, st->st_ino)];
+    while (listing != NULL && (listing->dev != st->st_dev || listing->ino != st->st_ino)) {
+        listing = listing->next;
+    }
+    if (listing != NULL && (listing->mtime.tv_sec != st->st_mtim.tv_sec ||
+                            listing->mtime.tv_nsec != st->st_mtim.tv_nsec)) {
+        uncache_directory_listing(st->st_dev, st->st_ino);
+        listing = NULL;
+    }
+    if (listing != NULL) {
+        listing->reference_count++;
+    }
+    pthread_mutex_unlock(&directory_cache_lock);
+    return listing;
+}
+
+void cache_directory_listing(directory_listing *listing) {
+    pthread_mutex_lock(&directory_cache_lock);
+    uncache_directory_listing(listing->dev, listing->ino);
+    if (directory_cache_entry_count + listing->entry_count > DIRECTORY_CACHE_MAX_ENTRIES) {
+        clear_directory_cache_locked();
+    }
+
+    size_t bucket = directory_cache_bucket(listing->dev, listing->ino);
+    listing->next = directory_cache[bucket];
+    directory_cache[bucket] = listing;
+    listing->reference_count++;
+    directory_cache_entry_count += listing->entry_count;
+    pthread_mutex_unlock(&directory_cache_lock);
+}
+
+/*
+ * Reads the entries of the open directory with getdents64(2), returns false on failure
+ */
+bool read_directory_entries(int fd, directory_listing *listing) {
+    char *buffer = malloc(DIRECTORY_READ_SIZE);
+    size_t names_capacity = DIRECTORY_READ_SIZE;
+    size_t names_len = 0;
+    size_t entries_capacity = 64;
+    listing->names = malloc(names_capacity);
+    listing->entries = malloc(sizeof(directory_entry) * entries_capacity);
+    assert(buffer != NULL && listing->names != NULL && listing->entries != NULL);
+
+    // The names may move while they are read, so the entries first hold their offsets
+    size_t *offsets = malloc(sizeof(size_t) * entries_capacity);
+    assert(offsets != NULL);
+
+    long nread;
+    while ((nread = syscall(SYS_getdents64, fd, buffer, DIRECTORY_READ_SIZE)) > 0) {
+        for (long position = 0; position < nread;) {
+            struct linux_dirent64 *dirent = (struct linux_dirent64 *)(buffer + position);
+            position += dirent->d_reclen;
+
+            const char *name = dirent->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+                continue;
+            }
+
+            size_t name_len = strlen(name) + 1;
+            if (names_len + name_len > names_capacity) {
+                while (names_len + name_len > names_capacity) {
+                    names_capacity *= 2;
+                }
+                listing->names = realloc(listing->names, names_capacity);
+                assert(listing->names != NULL);
+            }
+            if (listing->entry_count == entries_capacity) {
+                entries_capacity *= 2;
+                listing->entries = realloc(listing->entries, sizeof(directory_entry) * entries_capacity);
+                offsets = realloc(offsets, sizeof(size_t) * entries_capacity);
+                assert(listing->entries != NULL && offsets != NULL);
+            }
+
+            memcpy(listing->names + names_len, name, name_len);
+            offsets[listing->entry_count] = names_len;
+            listing->entries[listing->entry_count].type = dirent->d_type;
+            listing->entry_count++;
+            names_len += name_len;
+        }
+    }
+
+    for (size_t i = 0; i < listing->entry_count; i++) {
+        listing->entries[i].name = listing->names + offsets[i];
+    }
+    free(offsets);
+    free(buffer);
+    return nread == 0;
+}
+
+/*
+ * Returns true if the directory may still be modified without changing its modification time,
+ * the timestamps of the filesystem being coarser than the time between two modifications
+ */
+bool is_racily_modified(const struct stat *st) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return st->st_mtim.tv_sec >= now.tv_sec - 1;
+}
+
+directory_listing *get_directory_listing(int dirfd, const char *path) {
+    int fd = openat(dirfd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return NULL;
+    }
+
+    directory_listing *listing = find_cached_directory_listing(&st);
+    if (listing != NULL) {
+        close(fd);
+        return listing;
+    }
+
+    listing = malloc(sizeof(directory_listing));
+    assert(listing != NULL);
+    listing->dev = st.st_dev;
+    listing->ino = st.st_ino;
+    listing->mtime = st.st_mtim;
+    listing->entry_count = 0;
+    listing->reference_count = 1;
+    listing->next = NULL;
+
+    bool read = read_directory_entries(fd, listing);
+    close(fd);
+    if (!read) {
+        free_directory_listing(listing);
+        return NULL;
+    }
+
+    if (!is_racily_modified(&st)) {
+        cache_directory_listing(listing);
+    }
+    return listing;
+}
+
+void release_directory_listing(directory_listing *listing) {
+    pthread_mutex_lock(&directory_cache_lock);
+    unreference_directory_listing(listing);
+    pthread_mutex_unlock(&directory_cache_lock);
+}
@@ -0,0 +1,55 @@
+#ifndef DIRECTORY_CACHE_H
+#define DIRECTORY_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <time.h>
+
+#define DIRECTORY_CACHE_BUCKETS 4096
+/* Number of buckets of the hash table of the cached listings */
+
+#define DIRECTORY_CACHE_MAX_ENTRIES (1 << 20)
+/* Maximal number of entries of all the cached listings, the cache is emptied beyond */
+
+#define DIRECTORY_READ_SIZE (1 << 15)
+/* Size of the buffer given to getdents64 */
+
+typedef struct {
+    char *name;
+    unsigned char type;
+} directory_entry;
+/* An entry of a directory, with its d_type (DT_UNKNOWN if the filesystem does not provide it) */
+
+typedef struct directory_listing {
+    dev_t dev;
+    ino_t ino;
+    struct timespec mtime;
+    size_t entry_count;
+    directory_entry *entries;
+    char *names;
+    size_t reference_count;
+    struct directory_listing *next;
+} directory_listing;
+/*
+ * The entries of a directory, without `.` and `..`, identified by the device and inode of the directory
+ * and valid as long as its modification time is unchanged. names holds the names of the entries.
+ * A listing is shared between the cache and its users, and freed once no one references it.
+ */
+
+directory_listing *get_directory_listing(int dirfd, const char *path);
+/*
+ * Returns the listing of the directory path, relative to dirfd like openat(2).
+ * The listing comes from the cache if the directory has not been modified since it was read,
+ * otherwise it is read with getdents64(2) and cached.
+ * Returns NULL if the directory cannot be opened.
+ * The listing must be released with release_directory_listing. Safe to call from several threads.
+ */
+
+void release_directory_listing(directory_listing *listing);
+/* Releases a listing returned by get_directory_listing */
+
+void clear_directory_cache();
+/* Empties the cache of the listings */
+
+#endif
@@ -0,0 +1,146 @@
+#define _GNU_SOURCE
+#include "directory_fds.h"
+#include <assert.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct {
+    char *path;
+    int fd;
+    unsigned long last_use;
+    unsigned int retain_count;
+} directory_fd_entry;
+/* A directory of the cache with its descriptor, kept while retain_count is not 0 */
+
+directory_fd_entry directory_fd_entries[DIRECTORY_FDS_SIZE];
+size_t directory_fd_count = 0;
+unsigned long directory_fd_clock = 0;
+
+char *logical_path(const char *current, const char *path) {
+    size_t current_len = path[0] == '/' ? 0 : strlen(current);
+    while (current_len > 0 && current[current_len - 1] == '/') {
+        current_len--;
+    }
+    char *result = malloc(current_len + strlen(path) + 2);
+    assert(result != NULL);
+    memcpy(result, current, current_len);
+    size_t len = current_len;
+
+    const char *component = path;
+    while (*component != '\0') {
+        const char *end = strchrnul(component, '/');
+        size_t component_len = end - component;
+        if (component_len == 2 && component[0] == '.' && component[1] == '.') {
+            while (len > 0 && result[len - 1] != '/') {
+                len--;
+            }
+            if (len > 0) {
+                len--;
+            }
+        } else if (component_len > 0 && !(component_len == 1 && component[0] == '.')) {
+            result[len++] = '/';
+            memcpy(result + len, component, component_len);
+            len += component_len;
+        }
+        component = *end == '\0' ? end : end + 1;
+    }
+
+    if (len == 0) {
+        result[len++] = '/';
+    }
+    result[len] = '\0';
+    return result;
+}
+
+directory_fd_entry *find_directory_fd_entry(const char *path) {
+    for (size_t i = 0; i < directory_fd_count; i++) {
+        if (strcmp(directory_fd_entries[i].path, path) == 0) {
+            return &directory_fd_entries[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Returns a free entry of the cache, closing the least recently used descriptor which is not retained if it is full,
+ * or NULL if all of them are retained
+ */
+directory_fd_entry *free_directory_fd_entry() {
+    if (directory_fd_count < DIRECTORY_FDS_SIZE) {
+        return &directory_fd_entries[directory_fd_count++];
+    }
+    directory_fd_entry *oldest = NULL;
+    for (size_t i = 0; i < directory_fd_count; i++) {
+        directory_fd_entry *entry = &directory_fd_entries[i];
+        if (entry->retain_count == 0 && (oldest == NULL || entry->last_use < oldest->last_use)) {
+            oldest = entry;
+        }
+    }
+    if (oldest != NULL) {
+        close(oldest->fd);
+        free(oldest->path);
+    }
+    return oldest;
+}
+
+int directory_fd(const char *path) {
+    directory_fd_entry *entry = find_directory_fd_entry(path);
+    if (entry != NULL) {
+        // The path may name another directory since, if it was moved, removed, or is a symbolic link retargeted
+        struct stat fd_st, path_st;
+        if (fstat(entry->fd, &fd_st) == 0 && fstatat(AT_FDCWD, path, &path_st, 0) == 0 &&
+            fd_st.st_dev == path_st.st_dev && fd_st.st_ino == path_st.st_ino) {
+            entry->last_use = ++directory_fd_clock;
+            return entry->fd;
+        }
+        int fd = open(path, O_PATH | O_DIRECTORY | O_CLOEXEC);
+        if (fd == -1) {
+            return -1;
+        }
+        close(entry->fd);
+        entry->fd = fd;
+        entry->last_use = ++directory_fd_clock;
+        return fd;
+    }
+
+    int fd = open(path, O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1) {
+        return -1;
+    }
+    entry = free_directory_fd_entry();
+    if (entry == NULL) {
+        // Every descriptor is retained, this one is not cached
+        close(fd);
+        return -1;
+    }
+    entry->path = strdup(path);
+    assert(entry->path != NULL);
+    entry->fd = fd;
+    entry->last_use = ++directory_fd_clock;
+    entry->retain_count = 0;
+    return fd;
+}
+
+void retain_directory_fd(const char *path) {
+    if (directory_fd(path) != -1) {
+        find_directory_fd_entry(path)->retain_count++;
+    }
+}
+
+void release_directory_fd(const char *path) {
+    directory_fd_entry *entry = find_directory_fd_entry(path);
+    if (entry != NULL && entry->retain_count > 0) {
+        entry->retain_count--;
+    }
+}
+
+void close_directory_fds() {
+    for (size_t i = 0; i < directory_fd_count; i++) {
+        close(directory_fd_entries[i].fd);
+        free(directory_fd_entries[i].path);
+    }
+    directory_fd_count = 0;
+}
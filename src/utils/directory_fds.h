@@ -0,0 +1,32 @@
+#ifndef DIRECTORY_FDS_H
+#define DIRECTORY_FDS_H
+
+#include <stdbool.h>
+
+#define DIRECTORY_FDS_SIZE 16
+/* Number of descriptors of directories kept open, the least recently used one being closed beyond */
+
+char *logical_path(const char *current, const char *path);
+/*
+ * Returns the absolute path of path from the absolute directory current, the components `.` and `..` being
+ * removed without following the symbolic links, like `cd -L`. The path must be freed by the caller.
+ */
+
+int directory_fd(const char *path);
+/*
+ * Returns a descriptor of the directory at the absolute path, opened with O_PATH and kept in a cache of the
+ * DIRECTORY_FDS_SIZE most recently used ones, or -1 if it cannot be opened. A cached descriptor is only used again
+ * if the path still leads to its directory, same device and inode, and is opened again otherwise.
+ * The descriptor belongs to the cache and stays valid until the next call.
+ */
+
+void retain_directory_fd(const char *path);
+/* Keeps the descriptor of the directory in the cache until it is released, such as for the directory stack */
+
+void release_directory_fd(const char *path);
+/* Allows the descriptor of the directory to be evicted again */
+
+void close_directory_fds();
+/* Closes all the descriptors of the cache */
+
+#endif
@@ -0,0 +1,280 @@
+#define _GNU_SOURCE
+#include "event_log.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+int event_log_fd = -1;
+pid_t event_log_owner = -1;
+
+char event_log_lines[EVENT_LOG_BATCH_SIZE][EVENT_LOG_LINE_SIZE];
+struct iovec event_log_iovecs[EVENT_LOG_BATCH_SIZE];
+size_t event_log_count = 0;
+/* The events waiting to be written, each one in its own line whose length is the one of its iovec */
+
+bool open_event_log(const char *path) {
+    close_event_log();
+    if (path == NULL) {
+        path = getenv("JSH_EVENT_LOG");
+    }
+    if (path == NULL || *path == '\0') {
+        return false;
+    }
+    event_log_fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (event_log_fd == -1) {
+        return false;
+    }
+    event_log_owner = getpid();
+    return true;
+}
+
+bool is_event_log_open() {
+    return event_log_fd != -1;
+}
+
+unsigned long long event_log_time() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/*
+ * Appends the formatted fields to the event being written, as much of them as fits
+ */
+void append_event_fields(const char *format, ...) {
+    struct iovec *iov = &event_log_iovecs[event_log_count];
+    size_t room = EVENT_LOG_LINE_SIZE - iov->iov_len;
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf((char *)iov->iov_base + iov->iov_len, room, format, args);
+    va_end(args);
+    iov->iov_len += len < 0 ? 0 : ((size_t)len < room ? (size_t)len : room - 1);
+}
+
+/*
+ * Starts an event of the given kind in the next line of the batch
+ */
+void begin_event(const char *event) {
+    event_log_iovecs[event_log_count].iov_base = event_log_lines[event_log_count];
+    event_log_iovecs[event_log_count].iov_len = 0;
+    append_event_fields("{\"time_ns\":%llu,\"event\":\"%s\"", event_log_time(), event);
+}
+
+/*
+ * Appends the characters of the string to the event, escaped for JSON. What does not fit in the line is cut at the
+ * beginning of a character, leaving room for the end of the line.
+ */
+void append_event_chars(const char *str) {
+    struct iovec *iov = &event_log_iovecs[event_log_count];
+    char *line = iov->iov_base;
+    // The closing quote and brace and the newline always fit
+    size_t limit = EVENT_LOG_LINE_SIZE - 4;
+    for (const unsigned char *c = (const unsigned char *)str; *c != '\0'; c++) {
+        char escaped[8];
+        size_t len;
+        if (*c == '"' || *c == '\\') {
+            escaped[0] = '\\';
+            escaped[1] = *c;
+            len = 2;
+        } else if (*c == '\n' || *c == '\t') {
+            escaped[0] = '\\';
+            escaped[1] = *c == '\n' ? 'n' : 't';
+            len = 2;
+        } else if (*c < 0x20) {
+            len = snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+        } else {
+            escaped[0] = *c;
+            len = 1;
+        }
+        if (iov->iov_len + len > limit) {
+            // The continuation bytes of a character cut are removed with it
+            if ((*c & 0xC0) == 0x80) {
+                while (iov->iov_len > 0 && (line[iov->iov_len - 1] & 0xC0) == 0x80) {
+                    iov->iov_len--;
+                }
+                if (iov->iov_len > 0 && (line[iov->iov_len - 1] & 0x80) != 0) {
+                    iov->iov_len--;
+                }
+            }
+            return;
+        }
+        memcpy(line + iov->iov_len, escaped, len);
+        iov->iov_len += len;
+    }
+}
+
+void append_event_string(const char *key, const char *value) {
+    append_event_fields(",\"%s\":\"", key);
+    append_event_chars(value);
+    append_event_fields("\"");
+}
+
+/*
+ * Appends the arguments of the command, separated by spaces, as the string of the key
+ */
+void append_event_command(const char *key, const command_without_substitution *cmd) {
+    append_event_fields(",\"%s\":\"", key);
+    for (size_t i = 0; i < cmd->argc; i++) {
+        if (i > 0) {
+            append_event_chars(" ");
+        }
+        append_event_chars(cmd->argv[i]);
+    }
+    append_event_fields("\"");
+}
+
+/*
+ * Ends the event, which is written with the others once the batch is full
+ */
+void end_event() {
+    struct iovec *iov = &event_log_iovecs[event_log_count];
+    memcpy((char *)iov->iov_base + iov->iov_len, "}\n", 2);
+    iov->iov_len += 2;
+    if (++event_log_count == EVENT_LOG_BATCH_SIZE) {
+        flush_event_log();
+    }
+}
+
+void append_job_fields(const job *j, pid_t pid) {
+    append_event_fields(",\"job\":%u,\"pid\":%d,\"pgid\":%d", j->id, pid, j->pgid);
+}
+
+void log_parse_event(const char *line, size_t pipeline_count, unsigned long long start_time) {
+    if (event_log_fd == -1) {
+        return;
+    }
+    begin_event("parse");
+    append_event_fields(",\"pipelines\":%zu,\"duration_ns\":%llu", pipeline_count, event_log_time() - start_time);
+    append_event_string("line", line);
+    end_event();
+}
+
+void log_pipeline_event(size_t pipeline_count, size_t index, bool background, int status,
+                        unsigned long long start_time) {
+    if (event_log_fd == -1) {
+        return;
+    }
+    begin_event("pipeline");
+    append_event_fields(",\"pipelines\":%zu,\"index\":%zu,\"background\":%s,\"status\":%d,\"duration_ns\":%llu",
+                        pipeline_count, index, background ? "true" : "false", status, event_log_time() - start_time);
+    end_event();
+}
+
+void log_spawn_event(const job *j, const process *p) {
+    if (event_log_fd == -1) {
+        return;
+    }
+    begin_event("spawn");
+    append_job_fields(j, p->pid);
+    // A relay has no command of its own
+    if (p->cmd_without_subst == NULL) {
+        append_event_string("command", "(relay)");
+    } else {
+        append_event_command("command", p->cmd_without_subst);
+    }
+    end_event();
+}
+
+/* Returns the name of the status in the events */
+const char *event_status_name(Status status) {
+    switch (status) {
+    case RUNNING:
+        return "running";
+    case STOPPED:
+        return "stopped";
+    case DETACHED:
+        return "detached";
+    case KILLED:
+        return "killed";
+    case DONE:
+        return "done";
+    case TIMED_OUT:
+        return "timed_out";
+    }
+    return "unknown";
+}
+
+void log_job_event(const job *j) {
+    if (event_log_fd == -1) {
+        return;
+    }
+    begin_event("job");
+    append_job_fields(j, j->pid_leader);
+    append_event_fields(",\"processes\":%zu,\"status\":\"%s\"", j->process_number, event_status_name(j->status));
+    end_event();
+}
+
+void log_status_event(const job *j, const process *p, Status previous) {
+    if (event_log_fd == -1 || p->status == previous) {
+        return;
+    }
+    if (p->status == STOPPED || p->status == RUNNING) {
+        begin_event(p->status == STOPPED ? "stop" : "continue");
+        append_job_fields(j, p->pid);
+    } else {
+        begin_event("reap");
+        append_job_fields(j, p->pid);
+        append_event_fields(",\"status\":\"%s\",\"exit_status\":%d,\"duration_ns\":%llu", event_status_name(p->status),
+                            p->exit_status, event_log_time() - p->start_time);
+    }
+    end_event();
+}
+
+void log_builtin_event(const command_without_substitution *cmd, int status, unsigned long long start_time) {
+    if (event_log_fd == -1) {
+        return;
+    }
+    begin_event("builtin");
+    append_event_fields(",\"status\":%d,\"duration_ns\":%llu", status, event_log_time() - start_time);
+    append_event_command("command", cmd);
+    end_event();
+}
+
+void flush_event_log() {
+    if (event_log_count == 0) {
+        return;
+    }
+    // A child forked while events were waiting has them too, they are the ones of its parent
+    if (event_log_fd == -1 || getpid() != event_log_owner) {
+        event_log_count = 0;
+        return;
+    }
+    struct iovec *iov = event_log_iovecs;
+    size_t count = event_log_count;
+    while (count > 0) {
+        ssize_t written = writev(event_log_fd, iov, count);
+        if (written == -1 && errno == EINTR) {
+            continue;
+        }
+        if (written == -1) {
+            break;
+        }
+        // What a short write left is written again
+        while (count > 0 && (size_t)written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char *)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+    event_log_count = 0;
+}
+
+void close_event_log() {
+    if (event_log_fd == -1) {
+        return;
+    }
+    flush_event_log();
+    close(event_log_fd);
+    event_log_fd = -1;
+    event_log_owner = -1;
+}
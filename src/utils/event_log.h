@@ -0,0 +1,63 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include "jobs_core.h"
+#include <stdbool.h>
+
+#define EVENT_LOG_BATCH_SIZE 64
+#define EVENT_LOG_LINE_SIZE 1024
+/* Number of events kept before they are written at once, and size of each of them, a longer string being cut */
+
+bool open_event_log(const char *path);
+/*
+ * Appends the events of jsh to the file at the given path, or at JSH_EVENT_LOG if path is NULL, one JSON object per
+ * line. Returns false if there is no path or the file cannot be opened, nothing being recorded then.
+ * Each event has the time it happened at in nanoseconds of CLOCK_MONOTONIC and its kind:
+ * {"time_ns":..,"event":"parse","pipelines":..,"duration_ns":..,"line":".."}
+ * {"time_ns":..,"event":"pipeline","pipelines":..,"index":..,"background":..,"status":..,"duration_ns":..}
+ * {"time_ns":..,"event":"spawn","job":..,"pid":..,"pgid":..,"command":".."}
+ * {"time_ns":..,"event":"job","job":..,"pid":..,"pgid":..,"processes":..,"status":".."}
+ * {"time_ns":..,"event":"stop" or "continue","job":..,"pid":..,"pgid":..}
+ * {"time_ns":..,"event":"reap","job":..,"pid":..,"pgid":..,"status":"done" or "killed" or "detached",
+ *  "exit_status":..,"duration_ns":..}
+ * {"time_ns":..,"event":"builtin","status":..,"duration_ns":..,"command":".."}
+ */
+
+bool is_event_log_open();
+/* Returns true if the events are recorded */
+
+unsigned long long event_log_time();
+/* Returns the time of CLOCK_MONOTONIC in nanoseconds, the one of the events */
+
+void log_parse_event(const char *line, size_t pipeline_count, unsigned long long start_time);
+/* Records the parsing of the line, started at the given time, into the given number of pipelines */
+
+void log_pipeline_event(size_t pipeline_count, size_t index, bool background, int status,
+                        unsigned long long start_time);
+/* Records the end of the run of a pipeline of a list, started at the given time, with its status */
+
+void log_spawn_event(const job *j, const process *p);
+/* Records the start of the process of the job */
+
+void log_job_event(const job *j);
+/* Records the addition of the job to the jobs */
+
+void log_status_event(const job *j, const process *p, Status previous);
+/*
+ * Records the change of status of the process of the job from the previous one, if it has changed: it has stopped,
+ * continued, or been reaped, with its exit status and the time it ran for
+ */
+
+void log_builtin_event(const command_without_substitution *cmd, int status, unsigned long long start_time);
+/* Records the run of the builtin by jsh, started at the given time, with its status */
+
+void flush_event_log();
+/*
+ * Writes the events recorded with a single writev. It is done when EVENT_LOG_BATCH_SIZE of them are waiting, and
+ * once a line has been run, only by the jsh which opened the log, so that a child never writes them twice.
+ */
+
+void close_event_log();
+/* Writes the events waiting and closes the log */
+
+#endif
@@ -0,0 +1,77 @@
+#include "event_loop.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+typedef struct watcher {
+    int fd;
+    event_handler handler;
+    void *data;
+    struct watcher *next;
+} watcher;
+/* A watched descriptor, which its events refer to */
+
+int epoll_fd = -1;
+bool event_loop_running = false;
+watcher *watchers = NULL;
+
+bool init_event_loop() {
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    return epoll_fd != -1;
+}
+
+bool watch_fd(int fd, event_handler handler, void *data) {
+    watcher *w = malloc(sizeof(watcher));
+    assert(w != NULL);
+    w->fd = fd;
+    w->handler = handler;
+    w->data = data;
+
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = w;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1) {
+        free(w);
+        return false;
+    }
+
+    w->next = watchers;
+    watchers = w;
+    return true;
+}
+
+void run_event_loop() {
+    struct epoll_event events[EVENT_LOOP_MAX_EVENTS];
+    event_loop_running = true;
+
+    while (event_loop_running) {
+        int event_count = epoll_wait(epoll_fd, events, EVENT_LOOP_MAX_EVENTS, -1);
+        if (event_count == -1) {
+            assert(errno == EINTR);
+            continue;
+        }
+
+        for (int i = 0; i < event_count && event_loop_running; i++) {
+            watcher *w = events[i].data.ptr;
+            w->handler(w->fd, w->data);
+        }
+    }
+}
+
+void stop_event_loop() {
+    event_loop_running = false;
+}
+
+void free_event_loop() {
+    while (watchers != NULL) {
+        watcher *next = watchers->next;
+        free(watchers);
+        watchers = next;
+    }
+    if (epoll_fd != -1) {
+        close(epoll_fd);
+        epoll_fd = -1;
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stdbool.h>
+
+#define EVENT_LOOP_MAX_EVENTS 16
+/* Maximal number of events handled by each wait of the loop */
+
+typedef void (*event_handler)(int fd, void *data);
+/* Function called when a watched descriptor is readable */
+
+bool init_event_loop();
+/* Creates the epoll instance of the loop, returns false on failure */
+
+bool watch_fd(int fd, event_handler handler, void *data);
+/* Calls the handler each time the descriptor is readable.
+ * Returns false if the descriptor cannot be watched (a regular file for instance) */
+
+void run_event_loop();
+/* Waits for the events and calls their handlers until stop_event_loop is called */
+
+void stop_event_loop();
+/* Makes run_event_loop return once the current handler returns */
+
+void free_event_loop();
+/* Closes the epoll instance and frees the watchers */
+
+#endif
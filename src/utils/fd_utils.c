@@ -0,0 +1,18 @@
+#include "fd_utils.h"
+#include <errno.h>
+#include <unistd.h>
+
+bool write_all(int fd, const char *buffer, size_t len) {
+    while (len > 0) {
+        ssize_t written = write(fd, buffer, len);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        buffer += written;
+        len -= written;
+    }
+    return true;
+}
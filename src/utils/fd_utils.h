@@ -0,0 +1,11 @@
+#ifndef FD_UTILS_H
+#define FD_UTILS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+bool write_all(int fd, const char *buffer, size_t len);
+/* Writes the whole buffer to the descriptor, retrying on interruptions and partial writes.
+ * Returns false if the descriptor is no longer writable */
+
+#endif
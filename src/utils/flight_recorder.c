@@ -0,0 +1,261 @@
+#define _GNU_SOURCE
+#include "flight_recorder.h"
+#include "fd_utils.h"
+#include "jobs_core.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct {
+    unsigned long sequence;
+    unsigned long long time;
+    flight_event_kind kind;
+    pid_t pid;
+    int value;
+    char text[FLIGHT_RECORDER_TEXT_SIZE];
+} flight_event;
+/*
+ * An event of the ring, whose sequence is its number plus one once it is completely written, and 0 while it is
+ * being written
+ */
+
+flight_event flight_events[FLIGHT_RECORDER_SIZE];
+unsigned long flight_event_count = 0;
+/* Number of events ever recorded, the next one going to the slot of this number modulo the size of the ring */
+
+unsigned long long flight_recorder_time() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+void record_flight_event(flight_event_kind kind, pid_t pid, int value, const char *text) {
+    unsigned long number = __atomic_fetch_add(&flight_event_count, 1, __ATOMIC_RELAXED);
+    flight_event *event = &flight_events[number % FLIGHT_RECORDER_SIZE];
+    __atomic_store_n(&event->sequence, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    event->time = flight_recorder_time();
+    event->kind = kind;
+    event->pid = pid;
+    event->value = value;
+    size_t len = 0;
+    if (text != NULL) {
+        for (; len < FLIGHT_RECORDER_TEXT_SIZE - 1 && text[len] != '\0'; len++) {
+            event->text[len] = text[len];
+        }
+    }
+    event->text[len] = '\0';
+    __atomic_store_n(&event->sequence, number + 1, __ATOMIC_RELEASE);
+}
+
+typedef struct {
+    char data[192];
+    size_t len;
+} dump_line;
+/* A line of the dump, formatted without stdio so that it can be done in a signal handler */
+
+void append_to_dump_line(dump_line *line, const char *str) {
+    for (; *str != '\0' && line->len < sizeof(line->data) - 1; str++) {
+        // The text of an event is shown on its line, whatever it holds
+        line->data[line->len++] = *str == '\n' || *str == '\t' ? ' ' : *str;
+    }
+}
+
+/* Appends the number, padded with spaces to the width, or with zeros if zeros is true */
+void append_number_to_dump_line(dump_line *line, long long number, size_t width, bool zeros) {
+    char digits[24];
+    size_t count = 0;
+    bool negative = number < 0;
+    unsigned long long value = negative ? -(unsigned long long)number : (unsigned long long)number;
+    do {
+        digits[count++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+    if (negative) {
+        digits[count++] = '-';
+    }
+    for (; width > count && line->len < sizeof(line->data) - 1; width--) {
+        line->data[line->len++] = zeros ? '0' : ' ';
+    }
+    while (count > 0 && line->len < sizeof(line->data) - 1) {
+        line->data[line->len++] = digits[--count];
+    }
+}
+
+const char *flight_event_name(flight_event_kind kind) {
+    switch (kind) {
+    case FLIGHT_PARSE:
+        return "parse";
+    case FLIGHT_FORK:
+        return "fork";
+    case FLIGHT_WAITPID:
+        return "waitpid";
+    case FLIGHT_TCSETPGRP:
+        return "tcsetpgrp";
+    case FLIGHT_SIGNAL_SENT:
+        return "signal sent";
+    case FLIGHT_SIGNAL_RECEIVED:
+        return "signal received";
+    case FLIGHT_JOB_STATUS:
+        return "job status";
+    }
+    return "unknown";
+}
+
+const char *flight_status_name(int status) {
+    switch (status) {
+    case RUNNING:
+        return "Running";
+    case STOPPED:
+        return "Stopped";
+    case DETACHED:
+        return "Detached";
+    case KILLED:
+        return "Killed";
+    case DONE:
+        return "Done";
+    case TIMED_OUT:
+        return "Timed out";
+    }
+    return "unknown";
+}
+
+/*
+ * Appends the value of the event, in the way its kind gives it
+ */
+void append_flight_event_value(dump_line *line, const flight_event *event) {
+    switch (event->kind) {
+    case FLIGHT_PARSE:
+        append_to_dump_line(line, "pipelines ");
+        append_number_to_dump_line(line, event->value, 0, false);
+        break;
+    case FLIGHT_FORK:
+        append_to_dump_line(line, "pgid ");
+        append_number_to_dump_line(line, event->value, 0, false);
+        break;
+    case FLIGHT_WAITPID:
+        if (event->value < 0) {
+            append_to_dump_line(line, "errno ");
+            append_number_to_dump_line(line, -event->value, 0, false);
+        } else if (WIFEXITED(event->value)) {
+            append_to_dump_line(line, "exited ");
+            append_number_to_dump_line(line, WEXITSTATUS(event->value), 0, false);
+        } else if (WIFSIGNALED(event->value)) {
+            append_to_dump_line(line, "killed by ");
+            append_number_to_dump_line(line, WTERMSIG(event->value), 0, false);
+        } else if (WIFSTOPPED(event->value)) {
+            append_to_dump_line(line, "stopped by ");
+            append_number_to_dump_line(line, WSTOPSIG(event->value), 0, false);
+        } else {
+            append_to_dump_line(line, "continued");
+        }
+        break;
+    case FLIGHT_TCSETPGRP:
+        append_to_dump_line(line, "result ");
+        append_number_to_dump_line(line, event->value, 0, false);
+        break;
+    case FLIGHT_SIGNAL_SENT:
+    case FLIGHT_SIGNAL_RECEIVED:
+        append_to_dump_line(line, "signal ");
+        append_number_to_dump_line(line, event->value, 0, false);
+        break;
+    case FLIGHT_JOB_STATUS:
+        append_to_dump_line(line, flight_status_name(event->value));
+        break;
+    }
+}
+
+/*
+ * Writes the event, with its age at the time of the dump in seconds
+ */
+void dump_flight_event(int fd, const flight_event *event, unsigned long long now) {
+    dump_line line = {.len = 0};
+    unsigned long long age = now > event->time ? now - event->time : 0;
+    append_number_to_dump_line(&line, age / 1000000000ULL, 6, false);
+    append_to_dump_line(&line, ".");
+    append_number_to_dump_line(&line, age % 1000000000ULL / 1000, 6, true);
+    append_to_dump_line(&line, "s ago  ");
+
+    const char *name = flight_event_name(event->kind);
+    append_to_dump_line(&line, name);
+    for (size_t len = strlen(name); len < 16; len++) {
+        append_to_dump_line(&line, " ");
+    }
+    append_to_dump_line(&line, "pid ");
+    append_number_to_dump_line(&line, event->pid, 7, false);
+    append_to_dump_line(&line, "  ");
+    append_flight_event_value(&line, event);
+    if (event->text[0] != '\0') {
+        append_to_dump_line(&line, "  ");
+        append_to_dump_line(&line, event->text);
+    }
+    line.data[line.len++] = '\n';
+    write_all(fd, line.data, line.len);
+}
+
+void dump_flight_recorder(int fd) {
+    unsigned long count = __atomic_load_n(&flight_event_count, __ATOMIC_ACQUIRE);
+    unsigned long first = count > FLIGHT_RECORDER_SIZE ? count - FLIGHT_RECORDER_SIZE : 0;
+    unsigned long long now = flight_recorder_time();
+
+    dump_line header = {.len = 0};
+    append_to_dump_line(&header, "jsh ");
+    append_number_to_dump_line(&header, getpid(), 0, false);
+    append_to_dump_line(&header, ": last ");
+    append_number_to_dump_line(&header, count - first, 0, false);
+    append_to_dump_line(&header, " of ");
+    append_number_to_dump_line(&header, count, 0, false);
+    append_to_dump_line(&header, " events");
+    header.data[header.len++] = '\n';
+    write_all(fd, header.data, header.len);
+
+    for (unsigned long number = first; number < count; number++) {
+        const flight_event *slot = &flight_events[number % FLIGHT_RECORDER_SIZE];
+        // An event being written, or already overwritten by a newer one, is skipped
+        if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != number + 1) {
+            continue;
+        }
+        flight_event event = *slot;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) != number + 1) {
+            continue;
+        }
+        dump_flight_event(fd, &event, now);
+    }
+}
+
+void dump_flight_recorder_on_request(int signal) {
+    int saved_errno = errno;
+    dump_flight_recorder(STDERR_FILENO);
+    errno = saved_errno;
+}
+
+/*
+ * Dumps the ring before the signal kills jsh: the handler was reset on entry, so the signal raised again is the
+ * default one once the handler returns
+ */
+void dump_flight_recorder_on_crash(int signal) {
+    dump_flight_recorder(STDERR_FILENO);
+    raise(signal);
+}
+
+void install_flight_recorder_handlers() {
+    struct sigaction sigac_dump;
+    sigac_dump.sa_handler = dump_flight_recorder_on_request;
+    sigac_dump.sa_flags = SA_RESTART;
+    sigemptyset(&sigac_dump.sa_mask);
+    sigaction(SIGUSR1, &sigac_dump, NULL);
+
+    struct sigaction sigac_crash;
+    sigac_crash.sa_handler = dump_flight_recorder_on_crash;
+    sigac_crash.sa_flags = SA_RESETHAND;
+    sigemptyset(&sigac_crash.sa_mask);
+    sigaction(SIGABRT, &sigac_crash, NULL);
+    sigaction(SIGSEGV, &sigac_crash, NULL);
+    sigaction(SIGBUS, &sigac_crash, NULL);
+    sigaction(SIGFPE, &sigac_crash, NULL);
+}
@@ -0,0 +1,52 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <sys/types.h>
+
+#define FLIGHT_RECORDER_SIZE 1024
+/* Number of the last events kept, a power of two */
+
+#define FLIGHT_RECORDER_TEXT_SIZE 32
+/* Size of the text kept with an event, with its null byte, a longer one being cut */
+
+typedef enum {
+    FLIGHT_PARSE,
+    FLIGHT_FORK,
+    FLIGHT_WAITPID,
+    FLIGHT_TCSETPGRP,
+    FLIGHT_SIGNAL_SENT,
+    FLIGHT_SIGNAL_RECEIVED,
+    FLIGHT_JOB_STATUS
+} flight_event_kind;
+/*
+ * What an event records, its pid and value being:
+ * - FLIGHT_PARSE: the pid of jsh and the number of pipelines of the line, -1 if it could not be parsed, whose
+ *   beginning is its text
+ * - FLIGHT_FORK: the pid of the process added to a job and its process group, its command being its text
+ * - FLIGHT_WAITPID: the pid waited for and the status returned by waitpid, or -errno if it failed
+ * - FLIGHT_TCSETPGRP: the process group given the terminal and the result of tcsetpgrp
+ * - FLIGHT_SIGNAL_SENT: the process, or the process group as a negative pid, and the signal sent to it
+ * - FLIGHT_SIGNAL_RECEIVED: the pid of the sender if known and the signal received by jsh
+ * - FLIGHT_JOB_STATUS: the process group of a job and its new status
+ */
+
+void record_flight_event(flight_event_kind kind, pid_t pid, int value, const char *text);
+/*
+ * Records the event in the ring, overwriting the oldest one, with its time of CLOCK_MONOTONIC. Nothing is formatted
+ * nor allocated: the slot is taken with an atomic increment and the event copied into it, so that it can be called
+ * from any thread or signal handler, and always.
+ */
+
+void dump_flight_recorder(int fd);
+/*
+ * Writes the events of the ring to the descriptor, from the oldest one, each one on a line with its age. Only
+ * async-signal-safe functions are used, so that it can be called from a signal handler.
+ */
+
+void install_flight_recorder_handlers();
+/*
+ * Dumps the ring to the standard error on SIGUSR1, and on SIGABRT, SIGSEGV, SIGBUS and SIGFPE before the signal
+ * kills jsh as it would have, so that a failed assertion shows what led to it
+ */
+
+#endif
@@ -0,0 +1,588 @@
+#define _GNU_SOURCE
+#include "frecency.h"
+#include "fd_utils.h"
+#include "string_utils.h"
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct {
+    char *path;
+    double rank;
+    int64_t last_visit;
+} frecency_visit;
+/* The visits of a directory not written to the database yet */
+
+typedef struct {
+    const char *path;
+    uint32_t path_len;
+    double rank;
+    int64_t last_visit;
+} frecency_record;
+/* A directory of the database being rewritten */
+
+char *frecency_path = NULL;
+pid_t frecency_owner = -1;
+
+const unsigned char *frecency_map = NULL;
+size_t frecency_map_size = 0;
+dev_t frecency_map_dev = 0;
+ino_t frecency_map_ino = 0;
+struct timespec frecency_map_mtime = {0, 0};
+
+frecency_visit frecency_visits[FRECENCY_FLUSH_VISITS];
+size_t frecency_visit_count = 0;
+
+bool open_frecency_database(const char *path) {
+    close_frecency_database();
+    if (path == NULL) {
+        path = getenv("JSH_JUMP_DATABASE");
+    }
+    if (path != NULL) {
+        frecency_path = strdup(path);
+    } else {
+        const char *home = getenv("HOME");
+        if (home == NULL) {
+            return false;
+        }
+        frecency_path = concat_with_delimiter(home, FRECENCY_FILE_NAME, '/');
+    }
+    assert(frecency_path != NULL);
+    frecency_owner = getpid();
+    return true;
+}
+
+void unmap_frecency_database() {
+    if (frecency_map != NULL) {
+        munmap((void *)frecency_map, frecency_map_size);
+    }
+    frecency_map = NULL;
+    frecency_map_size = 0;
+}
+
+const frecency_header *frecency_database_header() {
+    return (const frecency_header *)frecency_map;
+}
+
+const frecency_entry *frecency_database_entries() {
+    return (const frecency_entry *)(frecency_map + sizeof(frecency_header));
+}
+
+const char *frecency_entry_path(const frecency_entry *entry) {
+    return (const char *)frecency_map + frecency_database_header()->strings_offset + entry->path_offset;
+}
+
+/*
+ * Returns true if the mapped file is a database whose parts all lie within it
+ */
+bool is_valid_frecency_database() {
+    if (frecency_map_size < sizeof(frecency_header)) {
+        return false;
+    }
+    const frecency_header *header = frecency_database_header();
+    if (memcmp(header->magic, FRECENCY_MAGIC, 4) != 0 || header->version != FRECENCY_VERSION ||
+        header->size != frecency_map_size || header->bucket_count != FRECENCY_INDEX_BUCKETS) {
+        return false;
+    }
+    uint64_t entries_end = sizeof(frecency_header) + (uint64_t)header->entry_count * sizeof(frecency_entry);
+    if (header->index_offset < entries_end || header->strings_offset > header->size ||
+        header->index_offset + sizeof(uint32_t) * (FRECENCY_INDEX_BUCKETS + 1) > header->strings_offset) {
+        return false;
+    }
+    const uint32_t *starts = (const uint32_t *)(frecency_map + header->index_offset);
+    if (header->index_offset + sizeof(uint32_t) * (FRECENCY_INDEX_BUCKETS + 1 + (uint64_t)starts[FRECENCY_INDEX_BUCKETS]) >
+        header->strings_offset) {
+        return false;
+    }
+    const uint32_t *ids = starts + FRECENCY_INDEX_BUCKETS + 1;
+    for (size_t b = 0; b < FRECENCY_INDEX_BUCKETS; b++) {
+        if (starts[b] > starts[b + 1]) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < starts[FRECENCY_INDEX_BUCKETS]; i++) {
+        if (ids[i] >= header->entry_count) {
+            return false;
+        }
+    }
+    const frecency_entry *entries = frecency_database_entries();
+    const char *strings = (const char *)frecency_map + header->strings_offset;
+    uint64_t strings_size = header->size - header->strings_offset;
+    for (uint32_t i = 0; i < header->entry_count; i++) {
+        if ((uint64_t)entries[i].path_offset + entries[i].path_len >= strings_size ||
+            strings[entries[i].path_offset + entries[i].path_len] != '\0') {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Maps the database again if it was rewritten since it was mapped, by this session or another one
+ */
+void map_frecency_database() {
+    struct stat st;
+    if (frecency_path == NULL || stat(frecency_path, &st) == -1) {
+        unmap_frecency_database();
+        return;
+    }
+    if (frecency_map != NULL && st.st_dev == frecency_map_dev && st.st_ino == frecency_map_ino &&
+        st.st_mtim.tv_sec == frecency_map_mtime.tv_sec && st.st_mtim.tv_nsec == frecency_map_mtime.tv_nsec) {
+        return;
+    }
+
+    unmap_frecency_database();
+    int fd = open(frecency_path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return;
+    }
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (map != MAP_FAILED) {
+            frecency_map = map;
+            frecency_map_size = st.st_size;
+            frecency_map_dev = st.st_dev;
+            frecency_map_ino = st.st_ino;
+            frecency_map_mtime = st.st_mtim;
+        }
+    }
+    close(fd);
+
+    if (frecency_map != NULL && !is_valid_frecency_database()) {
+        unmap_frecency_database();
+    }
+}
+
+void record_directory_visit(const char *directory) {
+    if (frecency_path == NULL || frecency_owner != getpid()) {
+        return;
+    }
+    // The visits are dropped while the database cannot be written
+    if (frecency_visit_count == FRECENCY_FLUSH_VISITS && !flush_frecency_database()) {
+        return;
+    }
+    time_t now = time(NULL);
+    for (size_t i = 0; i < frecency_visit_count; i++) {
+        if (strcmp(frecency_visits[i].path, directory) == 0) {
+            frecency_visits[i].rank++;
+            frecency_visits[i].last_visit = now;
+            return;
+        }
+    }
+
+    frecency_visits[frecency_visit_count].path = strdup(directory);
+    assert(frecency_visits[frecency_visit_count].path != NULL);
+    frecency_visits[frecency_visit_count].rank = 1;
+    frecency_visits[frecency_visit_count].last_visit = now;
+    frecency_visit_count++;
+    if (frecency_visit_count == FRECENCY_FLUSH_VISITS) {
+        flush_frecency_database();
+    }
+}
+
+double frecency_score(double rank, int64_t last_visit, time_t now) {
+    int64_t age = now - last_visit;
+    if (age < 3600) {
+        return rank * 4;
+    }
+    if (age < 86400) {
+        return rank * 2;
+    }
+    if (age < 604800) {
+        return rank / 2;
+    }
+    return rank / 4;
+}
+
+/*
+ * Returns true if the path contains the fragments in order, and the last one after its last `/`
+ */
+bool matches_fragments(const char *path, char *const *fragments, size_t fragment_count) {
+    const char *position = path;
+    for (size_t i = 0; i < fragment_count; i++) {
+        position = strstr(position, fragments[i]);
+        if (position == NULL) {
+            return false;
+        }
+        position += strlen(fragments[i]);
+    }
+    if (fragment_count == 0) {
+        return true;
+    }
+    const char *last_component = strrchr(path, '/');
+    last_component = last_component == NULL ? path : last_component + 1;
+    return strstr(last_component, fragments[fragment_count - 1]) != NULL;
+}
+
+size_t frecency_trigram_bucket(const unsigned char *trigram) {
+    uint32_t key = (uint32_t)trigram[0] << 16 | (uint32_t)trigram[1] << 8 | trigram[2];
+    return (key * 2654435761u) >> 20 & (FRECENCY_INDEX_BUCKETS - 1);
+}
+
+/*
+ * Returns the entries of the database whose last component may contain the last fragment: the ones of the
+ * smallest bucket of its trigrams, or all of them if it is shorter than three characters. Sets count to their
+ * number, and all to true if they are all the entries, in which case NULL is returned
+ */
+const uint32_t *frecency_candidates(char *const *fragments, size_t fragment_count, size_t *count, bool *all) {
+    const frecency_header *header = frecency_database_header();
+    const uint32_t *starts = (const uint32_t *)(frecency_map + header->index_offset);
+    const uint32_t *ids = starts + FRECENCY_INDEX_BUCKETS + 1;
+
+    *all = true;
+    *count = header->entry_count;
+    size_t best_bucket = 0;
+    const char *last = fragment_count == 0 ? "" : fragments[fragment_count - 1];
+    size_t len = strlen(last);
+    for (size_t k = 0; k + 3 <= len; k++) {
+        size_t bucket = frecency_trigram_bucket((const unsigned char *)last + k);
+        if (*all || starts[bucket + 1] - starts[bucket] < starts[best_bucket + 1] - starts[best_bucket]) {
+            best_bucket = bucket;
+            *all = false;
+        }
+    }
+    if (*all) {
+        return NULL;
+    }
+    *count = starts[best_bucket + 1] - starts[best_bucket];
+    return ids + starts[best_bucket];
+}
+
+/*
+ * Calls visit on each directory matching the fragments, with its rank and last visit including the visits
+ * not written yet
+ */
+void for_each_matching_directory(char *const *fragments, size_t fragment_count,
+                                 void (*visit)(const char *directory, double rank, int64_t last_visit, void *data),
+                                 void *data) {
+    map_frecency_database();
+    bool *visit_written = calloc(frecency_visit_count + 1, sizeof(bool));
+    assert(visit_written != NULL);
+
+    if (frecency_map != NULL) {
+        const frecency_entry *entries = frecency_database_entries();
+        size_t count;
+        bool all;
+        const uint32_t *candidates = frecency_candidates(fragments, fragment_count, &count, &all);
+        for (size_t i = 0; i < count; i++) {
+            const frecency_entry *entry = &entries[all ? i : candidates[i]];
+            const char *path = frecency_entry_path(entry);
+            if (!matches_fragments(path, fragments, fragment_count)) {
+                continue;
+            }
+            double rank = entry->rank;
+            int64_t last_visit = entry->last_visit;
+            for (size_t k = 0; k < frecency_visit_count; k++) {
+                if (strcmp(frecency_visits[k].path, path) == 0) {
+                    rank += frecency_visits[k].rank;
+                    last_visit = frecency_visits[k].last_visit;
+                    visit_written[k] = true;
+                }
+            }
+            visit(path, rank, last_visit, data);
+        }
+    }
+
+    for (size_t k = 0; k < frecency_visit_count; k++) {
+        if (!visit_written[k] && matches_fragments(frecency_visits[k].path, fragments, fragment_count)) {
+            visit(frecency_visits[k].path, frecency_visits[k].rank, frecency_visits[k].last_visit, data);
+        }
+    }
+    free(visit_written);
+}
+
+typedef struct {
+    const char *directory;
+    double score;
+} scored_directory;
+
+typedef struct {
+    scored_directory *items;
+    size_t count;
+    size_t capacity;
+    time_t now;
+} scored_directories;
+
+void add_scored_directory(const char *directory, double rank, int64_t last_visit, void *data) {
+    scored_directories *list = data;
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity == 0 ? 16 : list->capacity * 2;
+        list->items = realloc(list->items, sizeof(scored_directory) * list->capacity);
+        assert(list->items != NULL);
+    }
+    list->items[list->count++] = (scored_directory){directory, frecency_score(rank, last_visit, list->now)};
+}
+
+int compare_scored_directories(const void *a, const void *b) {
+    const scored_directory *directory_a = a;
+    const scored_directory *directory_b = b;
+    if (directory_a->score != directory_b->score) {
+        return directory_a->score < directory_b->score ? -1 : 1;
+    }
+    // The shorter path first on a tie, as the parent of a directory is more likely to be meant
+    return (int)(strlen(directory_b->directory) - strlen(directory_a->directory));
+}
+
+typedef struct {
+    scored_directory best;
+    time_t now;
+    const char *excluded;
+} best_directory;
+
+void keep_best_directory(const char *directory, double rank, int64_t last_visit, void *data) {
+    best_directory *search = data;
+    scored_directory candidate = {directory, frecency_score(rank, last_visit, search->now)};
+    if (search->best.directory != NULL && compare_scored_directories(&candidate, &search->best) <= 0) {
+        return;
+    }
+    if (search->excluded == NULL || strcmp(search->excluded, directory) != 0) {
+        search->best = candidate;
+    }
+}
+
+bool is_existing_directory(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+char *find_frecent_directory(char *const *fragments, size_t fragment_count, const char *excluded) {
+    best_directory search = {{NULL, 0}, time(NULL), excluded};
+    for_each_matching_directory(fragments, fragment_count, keep_best_directory, &search);
+    if (search.best.directory == NULL) {
+        return NULL;
+    }
+    if (is_existing_directory(search.best.directory)) {
+        return strdup(search.best.directory);
+    }
+
+    // The removed directories stay in the database, the matches are then tried from the best one
+    scored_directories list = {NULL, 0, 0, search.now};
+    for_each_matching_directory(fragments, fragment_count, add_scored_directory, &list);
+    qsort(list.items, list.count, sizeof(scored_directory), compare_scored_directories);
+    char *found = NULL;
+    for (size_t i = list.count; i > 0 && found == NULL; i--) {
+        const char *directory = list.items[i - 1].directory;
+        if ((excluded == NULL || strcmp(excluded, directory) != 0) && is_existing_directory(directory)) {
+            found = strdup(directory);
+        }
+    }
+    free(list.items);
+    return found;
+}
+
+void list_frecent_directories(char *const *fragments, size_t fragment_count,
+                              void (*print)(const char *directory, double score)) {
+    scored_directories list = {NULL, 0, 0, time(NULL)};
+    for_each_matching_directory(fragments, fragment_count, add_scored_directory, &list);
+    qsort(list.items, list.count, sizeof(scored_directory), compare_scored_directories);
+    for (size_t i = 0; i < list.count; i++) {
+        print(list.items[i].directory, list.items[i].score);
+    }
+    free(list.items);
+}
+
+int compare_frecency_visits(const void *a, const void *b) {
+    return strcmp(((const frecency_visit *)a)->path, ((const frecency_visit *)b)->path);
+}
+
+/*
+ * Merges the entries of the database, sorted by path, with the visits sorted by path, and ages the ranks if
+ * they grew too much. Returns the records, sorted by path, and sets count to their number
+ */
+frecency_record *merge_frecency_visits(size_t *count) {
+    size_t entry_count = frecency_map == NULL ? 0 : frecency_database_header()->entry_count;
+    const frecency_entry *entries = frecency_map == NULL ? NULL : frecency_database_entries();
+    qsort(frecency_visits, frecency_visit_count, sizeof(frecency_visit), compare_frecency_visits);
+
+    frecency_record *records = malloc(sizeof(frecency_record) * (entry_count + frecency_visit_count + 1));
+    assert(records != NULL);
+    size_t i = 0;
+    size_t k = 0;
+    double total_rank = 0;
+    *count = 0;
+    while (i < entry_count || k < frecency_visit_count) {
+        int comparison = i == entry_count           ? 1
+                         : k == frecency_visit_count ? -1
+                                                     : strcmp(frecency_entry_path(&entries[i]), frecency_visits[k].path);
+        frecency_record record;
+        if (comparison <= 0) {
+            record = (frecency_record){frecency_entry_path(&entries[i]), entries[i].path_len, entries[i].rank,
+                                       entries[i].last_visit};
+            i++;
+        }
+        if (comparison >= 0) {
+            if (comparison > 0) {
+                record = (frecency_record){frecency_visits[k].path, strlen(frecency_visits[k].path), 0, 0};
+            }
+            record.rank += frecency_visits[k].rank;
+            record.last_visit = frecency_visits[k].last_visit;
+            k++;
+        }
+        total_rank += record.rank;
+        records[(*count)++] = record;
+    }
+
+    if (total_rank > FRECENCY_MAX_TOTAL_RANK) {
+        size_t kept = 0;
+        for (size_t r = 0; r < *count; r++) {
+            records[r].rank *= FRECENCY_AGING_FACTOR;
+            if (records[r].rank >= 1) {
+                records[kept++] = records[r];
+            }
+        }
+        *count = kept;
+    }
+    return records;
+}
+
+/*
+ * Adds the record to each distinct bucket of the trigrams of the last component of its path, using the stamps of the buckets to skip
+ * the ones it was already added to: counts it in the bucket if positions is NULL, writes it at the position
+ * of the bucket otherwise
+ */
+void index_frecency_record(const frecency_record *record, uint32_t id, uint32_t *stamps, uint32_t *starts,
+                           uint32_t *positions, uint32_t *ids) {
+    const char *last_slash = memrchr(record->path, '/', record->path_len);
+    uint32_t first = last_slash == NULL ? 0 : last_slash - record->path + 1;
+    for (uint32_t k = first; k + 3 <= record->path_len; k++) {
+        size_t bucket = frecency_trigram_bucket((const unsigned char *)record->path + k);
+        if (stamps[bucket] == id + 1) {
+            continue;
+        }
+        stamps[bucket] = id + 1;
+        if (positions == NULL) {
+            starts[bucket + 1]++;
+        } else {
+            ids[positions[bucket]++] = id;
+        }
+    }
+}
+
+/*
+ * Lays the records out as a database in a single buffer, returns it and sets size to its size
+ */
+unsigned char *serialize_frecency_records(const frecency_record *records, size_t count, size_t *size) {
+    uint32_t *stamps = calloc(FRECENCY_INDEX_BUCKETS, sizeof(uint32_t));
+    uint32_t *starts = calloc(FRECENCY_INDEX_BUCKETS + 1, sizeof(uint32_t));
+    assert(stamps != NULL && starts != NULL);
+    size_t strings_size = 0;
+    for (size_t i = 0; i < count; i++) {
+        index_frecency_record(&records[i], i, stamps, starts, NULL, NULL);
+        strings_size += records[i].path_len + 1;
+    }
+    for (size_t b = 0; b < FRECENCY_INDEX_BUCKETS; b++) {
+        starts[b + 1] += starts[b];
+    }
+
+    frecency_header header;
+    memcpy(header.magic, FRECENCY_MAGIC, 4);
+    header.version = FRECENCY_VERSION;
+    header.entry_count = count;
+    header.bucket_count = FRECENCY_INDEX_BUCKETS;
+    header.index_offset = sizeof(frecency_header) + sizeof(frecency_entry) * count;
+    header.strings_offset =
+        header.index_offset + sizeof(uint32_t) * (FRECENCY_INDEX_BUCKETS + 1 + (size_t)starts[FRECENCY_INDEX_BUCKETS]);
+    header.size = header.strings_offset + strings_size;
+
+    unsigned char *buffer = malloc(header.size);
+    assert(buffer != NULL);
+    memcpy(buffer, &header, sizeof(frecency_header));
+
+    frecency_entry *entries = (frecency_entry *)(buffer + sizeof(frecency_header));
+    char *strings = (char *)buffer + header.strings_offset;
+    size_t strings_len = 0;
+    for (size_t i = 0; i < count; i++) {
+        entries[i] = (frecency_entry){strings_len, records[i].path_len, records[i].rank, records[i].last_visit};
+        memcpy(strings + strings_len, records[i].path, records[i].path_len);
+        strings[strings_len + records[i].path_len] = '\0';
+        strings_len += records[i].path_len + 1;
+    }
+
+    uint32_t *index = (uint32_t *)(buffer + header.index_offset);
+    memcpy(index, starts, sizeof(uint32_t) * (FRECENCY_INDEX_BUCKETS + 1));
+    uint32_t *positions = starts;
+    memset(stamps, 0, sizeof(uint32_t) * FRECENCY_INDEX_BUCKETS);
+    for (size_t i = 0; i < count; i++) {
+        index_frecency_record(&records[i], i, stamps, NULL, positions, index + FRECENCY_INDEX_BUCKETS + 1);
+    }
+
+    free(stamps);
+    free(starts);
+    *size = header.size;
+    return buffer;
+}
+
+/*
+ * Writes the buffer to a temporary file next to the database and renames it over the database
+ */
+bool replace_frecency_database(const unsigned char *buffer, size_t size) {
+    char *temporary_path = concat_with_delimiter(frecency_path, "XXXXXX", '.');
+    int fd = mkostemp(temporary_path, O_CLOEXEC);
+    if (fd == -1) {
+        free(temporary_path);
+        return false;
+    }
+    bool written = write_all(fd, (const char *)buffer, size) && fsync(fd) == 0;
+    close(fd);
+    if (!written || rename(temporary_path, frecency_path) == -1) {
+        unlink(temporary_path);
+        written = false;
+    }
+    free(temporary_path);
+    return written;
+}
+
+bool flush_frecency_database() {
+    if (frecency_path == NULL || frecency_owner != getpid() || frecency_visit_count == 0) {
+        return true;
+    }
+
+    // The database may have been rewritten by another session since it was mapped, it is read again under the lock
+    char *lock_path = concat_with_delimiter(frecency_path, "lock", '.');
+    int lock_fd = open(lock_path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    free(lock_path);
+    if (lock_fd == -1 || flock(lock_fd, LOCK_EX) == -1) {
+        if (lock_fd != -1) {
+            close(lock_fd);
+        }
+        return false;
+    }
+    map_frecency_database();
+
+    size_t count;
+    frecency_record *records = merge_frecency_visits(&count);
+    size_t size;
+    unsigned char *buffer = serialize_frecency_records(records, count, &size);
+    free(records);
+    bool replaced = replace_frecency_database(buffer, size);
+    free(buffer);
+    close(lock_fd);
+
+    if (replaced) {
+        for (size_t i = 0; i < frecency_visit_count; i++) {
+            free(frecency_visits[i].path);
+        }
+        frecency_visit_count = 0;
+    }
+    return replaced;
+}
+
+void close_frecency_database() {
+    if (frecency_owner == getpid()) {
+        flush_frecency_database();
+    }
+    for (size_t i = 0; i < frecency_visit_count; i++) {
+        free(frecency_visits[i].path);
+    }
+    frecency_visit_count = 0;
+    unmap_frecency_database();
+    free(frecency_path);
+    frecency_path = NULL;
+    frecency_owner = -1;
+}
@@ -0,0 +1,84 @@
+#ifndef FRECENCY_H
+#define FRECENCY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#define FRECENCY_FILE_NAME ".jsh_jumps"
+/* Name of the database in the home directory, used if JSH_JUMP_DATABASE is not set */
+
+#define FRECENCY_MAGIC "JSHJ"
+#define FRECENCY_VERSION 1
+/* First bytes of the database and version of its layout */
+
+#define FRECENCY_INDEX_BUCKETS 4096
+/* Number of buckets of the trigrams of the index of the database */
+
+#define FRECENCY_FLUSH_VISITS 8
+/* Number of visits kept in memory before the database is rewritten */
+
+#define FRECENCY_MAX_TOTAL_RANK 100000.0
+/* Total rank of the directories above which all the ranks are aged */
+
+#define FRECENCY_AGING_FACTOR 0.99
+/* Factor applied to the ranks when they are aged, the directories whose rank falls below 1 being forgotten */
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t bucket_count;
+    uint64_t index_offset;
+    uint64_t strings_offset;
+    uint64_t size;
+} frecency_header;
+/*
+ * Header of the database, followed by the entries sorted by path, then the index of the trigrams of the last
+ * components of the paths:
+ * bucket_count + 1 starts followed by the positions of the entries of each bucket, and then the paths
+ * terminated by '\0'. The offsets are from the start of the file.
+ */
+
+typedef struct {
+    uint32_t path_offset;
+    uint32_t path_len;
+    double rank;
+    int64_t last_visit;
+} frecency_entry;
+/* A directory of the database: the offset of its path from strings_offset, its rank, incremented at each
+ * visit, and the time of its last visit */
+
+bool open_frecency_database(const char *path);
+/* Uses the database at the given path, or at JSH_JUMP_DATABASE, or at ~/.jsh_jumps if path is NULL.
+ * Nothing is read until the database is queried. Returns false if there is no path for it */
+
+void record_directory_visit(const char *directory);
+/* Records a visit of the directory, written to the database with the others every FRECENCY_FLUSH_VISITS visits */
+
+double frecency_score(double rank, int64_t last_visit, time_t now);
+/* Returns the score of a directory: its rank weighted by how recent its last visit is */
+
+char *find_frecent_directory(char *const *fragments, size_t fragment_count, const char *excluded);
+/*
+ * Returns the existing directory with the best score whose path contains the fragments in order, the last one
+ * after the last `/`, or NULL if none does. The excluded directory, such as the current one, is not returned.
+ * If the last fragment has at least three characters, it is looked up in the index of the trigrams of the database.
+ * The path must be freed by the caller.
+ */
+
+void list_frecent_directories(char *const *fragments, size_t fragment_count,
+                              void (*print)(const char *directory, double score));
+/* Calls print on the directories matching the fragments, from the lowest score to the best one */
+
+bool flush_frecency_database();
+/*
+ * Merges the visits kept in memory into the database and writes it to a temporary file renamed over it,
+ * under a lock, so that the sessions sharing it cannot lose each other's visits nor read a partial file.
+ */
+
+void close_frecency_database();
+/* Flushes and unmaps the database */
+
+#endif
@@ -0,0 +1,172 @@
+#include "functions.h"
+#include "variables.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    char *name;
+    void *value;
+} named_entry;
+
+typedef struct {
+    named_entry *entries;
+    size_t capacity;
+    size_t count;
+} name_table;
+/* Open addressing table with linear probing. A removed entry keeps its name with a NULL value, so that the probing
+ * goes on past it, and is reused if the name is defined again */
+
+name_table functions = {NULL, 0, 0};
+name_table aliases = {NULL, 0, 0};
+
+/*
+ * Returns the slot of the name in the table, or the empty slot where it would be inserted
+ */
+named_entry *slot_of_name(const name_table *table, const char *name, size_t len) {
+    size_t i = hash_of_name(name, len) & (table->capacity - 1);
+    while (table->entries[i].name != NULL &&
+           (strncmp(table->entries[i].name, name, len) != 0 || table->entries[i].name[len] != '\0')) {
+        i = (i + 1) & (table->capacity - 1);
+    }
+    return &table->entries[i];
+}
+
+void grow_name_table(name_table *table) {
+    named_entry *old = table->entries;
+    size_t old_capacity = table->capacity;
+    table->capacity = old_capacity == 0 ? NAME_TABLE_INITIAL_CAPACITY : old_capacity * 2;
+    table->entries = calloc(table->capacity, sizeof(named_entry));
+    assert(table->entries != NULL);
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old[i].name != NULL) {
+            *slot_of_name(table, old[i].name, strlen(old[i].name)) = old[i];
+        }
+    }
+    free(old);
+}
+
+/*
+ * Returns the value of the name in the table, or NULL if it has none
+ */
+void *find_in_name_table(const name_table *table, const char *name, size_t len) {
+    if (table->count == 0) {
+        return NULL;
+    }
+    return slot_of_name(table, name, len)->value;
+}
+
+/*
+ * Sets the value of the name in the table and returns its previous one, or NULL if it had none
+ */
+void *put_in_name_table(name_table *table, const char *name, void *value) {
+    if (table->capacity == 0) {
+        grow_name_table(table);
+    }
+    named_entry *slot = slot_of_name(table, name, strlen(name));
+    void *previous = slot->value;
+    slot->value = value;
+    if (slot->name == NULL) {
+        slot->name = strdup(name);
+        assert(slot->name != NULL);
+        if (++table->count * 2 > table->capacity) {
+            grow_name_table(table);
+        }
+    }
+    return previous;
+}
+
+void define_function(const char *name, pipeline_list *body) {
+    function_definition *function = malloc(sizeof(function_definition));
+    assert(function != NULL);
+    function->body = body;
+    function->references = 1;
+    function_definition *previous = put_in_name_table(&functions, name, function);
+    if (previous != NULL) {
+        release_function(previous);
+    }
+}
+
+function_definition *find_function(const char *name) {
+    return find_in_name_table(&functions, name, strlen(name));
+}
+
+void retain_function(function_definition *function) {
+    function->references++;
+}
+
+void release_function(function_definition *function) {
+    if (--function->references == 0) {
+        free_pipeline_list(function->body);
+        free(function);
+    }
+}
+
+void set_alias(const char *name, const char *value) {
+    char *copy = strdup(value);
+    assert(copy != NULL);
+    free(put_in_name_table(&aliases, name, copy));
+}
+
+const char *get_alias(const char *name, size_t len) {
+    return find_in_name_table(&aliases, name, len);
+}
+
+bool has_aliases() {
+    return aliases.count > 0;
+}
+
+bool unset_alias(const char *name) {
+    if (aliases.count == 0) {
+        return false;
+    }
+    named_entry *slot = slot_of_name(&aliases, name, strlen(name));
+    if (slot->value == NULL) {
+        return false;
+    }
+    free(slot->value);
+    slot->value = NULL;
+    return true;
+}
+
+void unset_aliases() {
+    for (size_t i = 0; i < aliases.capacity; i++) {
+        free(aliases.entries[i].value);
+        aliases.entries[i].value = NULL;
+    }
+}
+
+int compare_names(const void *a, const void *b) {
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+size_t alias_names(const char ***names) {
+    *names = malloc(sizeof(char *) * (aliases.count + 1));
+    assert(*names != NULL);
+    size_t count = 0;
+    for (size_t i = 0; i < aliases.capacity; i++) {
+        if (aliases.entries[i].value != NULL) {
+            (*names)[count++] = aliases.entries[i].name;
+        }
+    }
+    qsort(*names, count, sizeof(char *), compare_names);
+    return count;
+}
+
+void free_functions() {
+    for (size_t i = 0; i < functions.capacity; i++) {
+        free(functions.entries[i].name);
+        if (functions.entries[i].value != NULL) {
+            release_function(functions.entries[i].value);
+        }
+    }
+    free(functions.entries);
+    functions = (name_table){NULL, 0, 0};
+
+    for (size_t i = 0; i < aliases.capacity; i++) {
+        free(aliases.entries[i].name);
+        free(aliases.entries[i].value);
+    }
+    free(aliases.entries);
+    aliases = (name_table){NULL, 0, 0};
+}
@@ -0,0 +1,55 @@
+#ifndef FUNCTIONS_H
+#define FUNCTIONS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../parser/parser.h"
+
+#define NAME_TABLE_INITIAL_CAPACITY 32
+/* Number of slots of the tables of the functions and of the aliases at first, doubled once they are half full */
+
+typedef struct {
+    pipeline_list *body;
+    size_t references;
+} function_definition;
+/*
+ * The body of a function, parsed once when it is defined: a list made of the single compound command after `name()`.
+ * It is referenced by the table while it is the definition of its name, and by each call running it, so that a
+ * function defining itself again keeps its body until it returns.
+ */
+
+void define_function(const char *name, pipeline_list *body);
+/* Defines the function, the body belonging to it from then on. A previous definition of the name is replaced */
+
+function_definition *find_function(const char *name);
+/* Returns the definition of the function, or NULL if none has the name */
+
+void retain_function(function_definition *function);
+/* Keeps the definition alive while a call runs it */
+
+void release_function(function_definition *function);
+/* Frees the definition once neither the table nor a call references it */
+
+void set_alias(const char *name, const char *value);
+/* Defines the alias, replacing the value of a previous one */
+
+const char *get_alias(const char *name, size_t len);
+/* Returns the value of the alias named by the first len characters of name, or NULL if there is none */
+
+bool has_aliases();
+/* Returns true if an alias may be defined, so that the words of a line must be looked up */
+
+bool unset_alias(const char *name);
+/* Removes the alias, returns false if there was none */
+
+void unset_aliases();
+/* Removes all the aliases */
+
+size_t alias_names(const char ***names);
+/* Sets names to a new array of the names of the aliases, sorted, and returns their number. The array must be freed */
+
+void free_functions();
+/* Frees the functions and the aliases */
+
+#endif
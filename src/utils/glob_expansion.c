@@ -0,0 +1,387 @@
+#define _GNU_SOURCE
+#include "glob_expansion.h"
+#include "directory_cache.h"
+#include "string_utils.h"
+#include <assert.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct {
+    char **items;
+    size_t count;
+    size_t capacity;
+} path_list;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    path_list pending;
+    size_t busy;
+    bool with_files;
+} directory_walk;
+/* The state shared by the threads of a recursive walk: the directories left to read,
+ * and the number of threads reading one, which may still find new directories */
+
+typedef struct {
+    directory_walk *walk;
+    path_list found;
+} directory_walker;
+
+void add_path(path_list *list, char *path) {
+    assert(path != NULL);
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity == 0 ? 16 : list->capacity * 2;
+        list->items = realloc(list->items, sizeof(char *) * list->capacity);
+        assert(list->items != NULL);
+    }
+    list->items[list->count] = path;
+    list->count++;
+}
+
+void free_path_list(path_list *list) {
+    for (size_t i = 0; i < list->count; i++) {
+        free(list->items[i]);
+    }
+    free(list->items);
+    list->items = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+/*
+ * Returns the position following the bracket expression starting at pattern and sets matched
+ * to whether the character belongs to it, or returns NULL if the bracket is not closed
+ */
+const char *match_bracket(const char *pattern, char c, bool *matched) {
+    const char *p = pattern + 1;
+    bool negated = *p == '!' || *p == '^';
+    if (negated) {
+        p++;
+    }
+
+    // A `]` right after the opening is a character of the set
+    bool found = false;
+    bool first = true;
+    while (*p != '\0' && (first || *p != ']')) {
+        first = false;
+        if (p[1] == '-' && p[2] != '\0' && p[2] != ']') {
+            found = found || ((unsigned char)p[0] <= (unsigned char)c && (unsigned char)c <= (unsigned char)p[2]);
+            p += 3;
+        } else {
+            found = found || *p == c;
+            p++;
+        }
+    }
+
+    if (*p != ']') {
+        return NULL;
+    }
+    *matched = found != negated;
+    return p + 1;
+}
+
+bool has_glob_characters(const char *word) {
+    bool matched;
+    for (const char *p = word; *p != '\0'; p++) {
+        if (*p == '*' || *p == '?' || (*p == '[' && match_bracket(p, '\0', &matched) != NULL)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool match_glob(const char *pattern, const char *name) {
+    // Position after the last `*` met, and the position in the name it currently stands for the end of
+    const char *star_pattern = NULL;
+    const char *star_name = NULL;
+
+    while (*name != '\0') {
+        if (*pattern == '*') {
+            star_pattern = ++pattern;
+            star_name = name;
+            continue;
+        }
+
+        bool matched = false;
+        const char *next = NULL;
+        if (*pattern == '?') {
+            matched = true;
+            next = pattern + 1;
+        } else if (*pattern == '[' && (next = match_bracket(pattern, *name, &matched)) != NULL) {
+        } else if (*pattern != '\0') {
+            matched = *pattern == *name;
+            next = pattern + 1;
+        }
+
+        if (matched) {
+            pattern = next;
+            name++;
+        } else if (star_pattern != NULL) {
+            // The last `*` takes one more character
+            pattern = star_pattern;
+            name = ++star_name;
+        } else {
+            return false;
+        }
+    }
+
+    while (*pattern == '*') {
+        pattern++;
+    }
+    return *pattern == '\0';
+}
+
+char *join_path(const char *prefix, const char *name) {
+    size_t prefix_len = strlen(prefix);
+    if (prefix_len == 0) {
+        return strdup(name);
+    }
+    if (prefix[prefix_len - 1] != '/') {
+        return concat_with_delimiter(prefix, name, '/');
+    }
+
+    size_t name_len = strlen(name);
+    char *path = malloc(prefix_len + name_len + 1);
+    assert(path != NULL);
+    memcpy(path, prefix, prefix_len);
+    memcpy(path + prefix_len, name, name_len + 1);
+    return path;
+}
+
+const char *directory_of_prefix(const char *prefix) {
+    return prefix[0] == '\0' ? "." : prefix;
+}
+
+bool is_directory_entry(const directory_entry *entry, const char *path, bool follow_links) {
+    if (entry->type == DT_DIR) {
+        return true;
+    }
+    if (entry->type != DT_UNKNOWN && (entry->type != DT_LNK || !follow_links)) {
+        return false;
+    }
+
+    struct stat st;
+    int result = follow_links ? stat(path, &st) : lstat(path, &st);
+    return result == 0 && S_ISDIR(st.st_mode);
+}
+
+/*
+ * Adds the path of the entries of the directory prefix matching the component, only the directories
+ * if other components follow
+ */
+void expand_component(const char *prefix, const char *component, bool only_directories, path_list *result) {
+    directory_listing *listing = get_directory_listing(AT_FDCWD, directory_of_prefix(prefix));
+    if (listing == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < listing->entry_count; i++) {
+        directory_entry *entry = &listing->entries[i];
+        if ((entry->name[0] == '.' && component[0] != '.') || !match_glob(component, entry->name)) {
+            continue;
+        }
+
+        char *path = join_path(prefix, entry->name);
+        if (only_directories && !is_directory_entry(entry, path, true)) {
+            free(path);
+            continue;
+        }
+        add_path(result, path);
+    }
+    release_directory_listing(listing);
+}
+
+/*
+ * Adds the path of the component without pattern, checking it exists if it is the last one
+ */
+void expand_literal_component(const char *prefix, const char *component, bool last, bool only_directories,
+                              path_list *result) {
+    char *path = join_path(prefix, component);
+    struct stat st;
+    if (last && (only_directories ? stat(path, &st) != 0 || !S_ISDIR(st.st_mode) : lstat(path, &st) != 0)) {
+        free(path);
+        return;
+    }
+    add_path(result, path);
+}
+
+/*
+ * Reads the directories of the walk until none is left and no other thread may find new ones,
+ * keeping the subdirectories, and every entry if the walk is with files
+ */
+void *walk_directories(void *arg) {
+    directory_walker *walker = arg;
+    directory_walk *walk = walker->walk;
+    path_list subdirectories = {NULL, 0, 0};
+
+    pthread_mutex_lock(&walk->lock);
+    while (1) {
+        while (walk->pending.count == 0 && walk->busy > 0) {
+            pthread_cond_wait(&walk->changed, &walk->lock);
+        }
+        if (walk->pending.count == 0) {
+            break;
+        }
+        walk->pending.count--;
+        char *directory = walk->pending.items[walk->pending.count];
+        walk->busy++;
+        pthread_mutex_unlock(&walk->lock);
+
+        directory_listing *listing = get_directory_listing(AT_FDCWD, directory_of_prefix(directory));
+        if (listing != NULL) {
+            for (size_t i = 0; i < listing->entry_count; i++) {
+                directory_entry *entry = &listing->entries[i];
+                if (entry->name[0] == '.') {
+                    continue;
+                }
+
+                // Symbolic links are not followed, so that the walk cannot loop
+                char *path = join_path(directory, entry->name);
+                bool is_directory = is_directory_entry(entry, path, false);
+                if (is_directory) {
+                    add_path(&subdirectories, strdup(path));
+                }
+                if (is_directory || walk->with_files) {
+                    add_path(&walker->found, path);
+                } else {
+                    free(path);
+                }
+            }
+            release_directory_listing(listing);
+        }
+        free(directory);
+
+        pthread_mutex_lock(&walk->lock);
+        for (size_t i = 0; i < subdirectories.count; i++) {
+            add_path(&walk->pending, subdirectories.items[i]);
+        }
+        walk->busy--;
+        if (subdirectories.count > 0 || walk->busy == 0) {
+            pthread_cond_broadcast(&walk->changed);
+        }
+        subdirectories.count = 0;
+    }
+    pthread_mutex_unlock(&walk->lock);
+
+    free(subdirectories.items);
+    return NULL;
+}
+
+size_t glob_thread_count() {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) {
+        return 1;
+    }
+    return cpus < GLOB_MAX_THREADS ? (size_t)cpus : GLOB_MAX_THREADS;
+}
+
+/*
+ * Adds the paths matching a `**` component in the directory prefix: the prefix itself and all its
+ * subdirectories if other components follow, every entry below the prefix otherwise
+ */
+void expand_recursively(const char *prefix, bool with_files, bool with_prefix, path_list *result) {
+    directory_walk walk;
+    pthread_mutex_init(&walk.lock, NULL);
+    pthread_cond_init(&walk.changed, NULL);
+    walk.pending = (path_list){NULL, 0, 0};
+    walk.busy = 0;
+    walk.with_files = with_files;
+    add_path(&walk.pending, strdup(prefix));
+
+    if (with_prefix) {
+        add_path(result, strdup(prefix));
+    }
+
+    // The current thread is one of the walkers
+    directory_walker walkers[GLOB_MAX_THREADS];
+    pthread_t threads[GLOB_MAX_THREADS];
+    size_t thread_count = glob_thread_count();
+    for (size_t i = 0; i < thread_count; i++) {
+        walkers[i].walk = &walk;
+        walkers[i].found = (path_list){NULL, 0, 0};
+    }
+    for (size_t i = 1; i < thread_count; i++) {
+        if (pthread_create(&threads[i], NULL, walk_directories, &walkers[i]) != 0) {
+            thread_count = i;
+            break;
+        }
+    }
+    walk_directories(&walkers[0]);
+    for (size_t i = 1; i < thread_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (size_t i = 0; i < thread_count; i++) {
+        for (size_t k = 0; k < walkers[i].found.count; k++) {
+            add_path(result, walkers[i].found.items[k]);
+        }
+        free(walkers[i].found.items);
+    }
+    free(walk.pending.items);
+    pthread_mutex_destroy(&walk.lock);
+    pthread_cond_destroy(&walk.changed);
+}
+
+char **expand_glob(const char *pattern, size_t *count) {
+    *count = 0;
+
+    char *copy = strdup(pattern);
+    assert(copy != NULL);
+    size_t len = strlen(copy);
+    bool only_directories = len > 0 && copy[len - 1] == '/';
+
+    char **components = malloc(sizeof(char *) * (len / 2 + 1));
+    assert(components != NULL);
+    size_t component_count = 0;
+    char *saveptr;
+    for (char *component = strtok_r(copy, "/", &saveptr); component != NULL;
+         component = strtok_r(NULL, "/", &saveptr)) {
+        components[component_count++] = component;
+    }
+
+    path_list paths = {NULL, 0, 0};
+    add_path(&paths, strdup(pattern[0] == '/' ? "/" : ""));
+
+    for (size_t k = 0; k < component_count && paths.count > 0; k++) {
+        bool last = k == component_count - 1;
+        const char *component = components[k];
+        path_list next = {NULL, 0, 0};
+
+        for (size_t i = 0; i < paths.count; i++) {
+            if (strcmp(component, "**") == 0) {
+                expand_recursively(paths.items[i], last && !only_directories, !last, &next);
+            } else if (!has_glob_characters(component)) {
+                expand_literal_component(paths.items[i], component, last, only_directories, &next);
+            } else {
+                expand_component(paths.items[i], component, !last || only_directories, &next);
+            }
+        }
+
+        free_path_list(&paths);
+        paths = next;
+    }
+    free(components);
+    free(copy);
+
+    if (paths.count == 0) {
+        free(paths.items);
+        return NULL;
+    }
+
+    if (only_directories) {
+        for (size_t i = 0; i < paths.count; i++) {
+            char *path = concat_with_delimiter(paths.items[i], "", '/');
+            free(paths.items[i]);
+            paths.items[i] = path;
+        }
+    }
+
+    radix_sort_strings(paths.items, paths.count);
+    *count = paths.count;
+    return paths.items;
+}
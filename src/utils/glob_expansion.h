@@ -0,0 +1,32 @@
+#ifndef GLOB_EXPANSION_H
+#define GLOB_EXPANSION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define GLOB_MAX_THREADS 8
+/* Maximal number of threads walking the directories of a recursive `**` */
+
+bool has_glob_characters(const char *word);
+/* Returns true if the word is a pattern, i.e. contains a `*`, a `?` or a closed `[...]` */
+
+bool match_glob(const char *pattern, const char *name);
+/*
+ * Returns true if the name matches the pattern, where
+ *  - `*` matches any sequence of characters
+ *  - `?` matches any character
+ *  - `[...]` matches any character of the set, which may contain ranges (`a-z`),
+ *    and any character not in the set if it starts with `!` or `^`
+ * A `[` without its closing `]` matches itself.
+ */
+
+char **expand_glob(const char *pattern, size_t *count);
+/*
+ * Returns the paths matching the pattern, sorted in byte order, and sets count to their number.
+ * The pattern is matched component by component, a `**` component matching any number of
+ * directories, which are then walked by several threads. Names starting with a `.` are only
+ * matched by a component starting with a `.`.
+ * Returns NULL if no path matches. The paths and the array must be freed by the caller.
+ */
+
+#endif
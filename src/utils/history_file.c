@@ -0,0 +1,527 @@
+#define _GNU_SOURCE
+#include "history_file.h"
+#include <assert.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+int history_fd = -1;
+const unsigned char *history_map = NULL;
+size_t history_map_size = 0;
+
+// Records parsed from the start of the file, up to history_parsed_size
+size_t *history_record_offsets = NULL;
+uint32_t *history_record_lengths = NULL;
+size_t history_record_count = 0;
+size_t history_record_capacity = 0;
+size_t history_parsed_size = 0;
+
+// Index of the trigrams of the first history_indexed_count records: the records of the bucket i are
+// history_index_records[history_index_starts[i]] to history_index_records[history_index_starts[i + 1] - 1]
+uint32_t *history_index_starts = NULL;
+uint32_t *history_index_records = NULL;
+size_t history_indexed_count = 0;
+
+typedef struct {
+    const unsigned char *map;
+    size_t map_size;
+    size_t *offsets;
+    uint32_t *lengths;
+    size_t count;
+    uint32_t *starts;
+    uint32_t *records;
+    bool done;
+    bool cancelled;
+} history_index_build;
+/* An index being built in the background, from its own mapping of the file and a copy of the positions of
+ * the records, so that the main thread can go on parsing and mapping the file */
+
+pthread_mutex_t history_index_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_t history_index_thread;
+history_index_build *history_index_building = NULL;
+
+void collect_history_index_build(bool wait, bool cancel);
+
+void reset_history_records() {
+    collect_history_index_build(true, true);
+    free(history_record_offsets);
+    free(history_record_lengths);
+    free(history_index_starts);
+    free(history_index_records);
+    history_record_offsets = NULL;
+    history_record_lengths = NULL;
+    history_index_starts = NULL;
+    history_index_records = NULL;
+    history_record_count = 0;
+    history_record_capacity = 0;
+    history_parsed_size = 0;
+    history_indexed_count = 0;
+}
+
+void unmap_history_file() {
+    if (history_map != NULL) {
+        munmap((void *)history_map, history_map_size);
+    }
+    history_map = NULL;
+    history_map_size = 0;
+}
+
+/*
+ * Maps the whole file again if it grew, and forgets its records if it shrank
+ */
+void remap_history_file() {
+    struct stat st;
+    if (fstat(history_fd, &st) == -1 || (size_t)st.st_size == history_map_size) {
+        return;
+    }
+    if ((size_t)st.st_size < history_map_size) {
+        reset_history_records();
+    }
+
+    unmap_history_file();
+    if (st.st_size == 0) {
+        return;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, history_fd, 0);
+    if (map == MAP_FAILED) {
+        reset_history_records();
+        return;
+    }
+    history_map = map;
+    history_map_size = st.st_size;
+}
+
+bool open_history_file(const char *path) {
+    char *default_path = NULL;
+    if (path == NULL) {
+        path = getenv("JSH_HISTFILE");
+    }
+    if (path == NULL) {
+        const char *home = getenv("HOME");
+        if (home == NULL) {
+            return false;
+        }
+        default_path = malloc(strlen(home) + strlen(HISTORY_FILE_NAME) + 2);
+        assert(default_path != NULL);
+        strcpy(default_path, home);
+        strcat(default_path, "/");
+        strcat(default_path, HISTORY_FILE_NAME);
+        path = default_path;
+    }
+
+    close_history_file();
+    history_fd = open(path, O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+    free(default_path);
+    if (history_fd == -1) {
+        return false;
+    }
+    remap_history_file();
+    return true;
+}
+
+bool is_history_file_open() {
+    return history_fd != -1;
+}
+
+uint32_t read_record_length(const unsigned char *header) {
+    return (uint32_t)header[1] | (uint32_t)header[2] << 8 | (uint32_t)header[3] << 16 | (uint32_t)header[4] << 24;
+}
+
+/*
+ * Returns true if a whole record starts at the position and ends before the limit, setting len to its length
+ */
+bool is_record_at(size_t position, size_t limit, uint32_t *len) {
+    if (position + HISTORY_RECORD_HEADER_SIZE + 1 > limit || history_map[position] != HISTORY_RECORD_MARK) {
+        return false;
+    }
+    *len = read_record_length(history_map + position);
+    size_t end = position + HISTORY_RECORD_HEADER_SIZE + *len;
+    return *len <= HISTORY_LINE_MAX && end < limit && history_map[end] == '\n';
+}
+
+/*
+ * Finds the record ending right before the position end, returns false if there is none
+ */
+bool find_previous_record(size_t end, size_t *start, uint32_t *len) {
+    if (end < HISTORY_RECORD_HEADER_SIZE + 1 || history_map[end - 1] != '\n') {
+        return false;
+    }
+    // The mark is the last one before the line whose length fits, the line itself may contain the byte
+    size_t position = end - HISTORY_RECORD_HEADER_SIZE - 1;
+    while (1) {
+        const unsigned char *mark = memrchr(history_map, HISTORY_RECORD_MARK, position + 1);
+        if (mark == NULL) {
+            return false;
+        }
+        position = mark - history_map;
+        if (is_record_at(position, end, len) && position + HISTORY_RECORD_HEADER_SIZE + *len + 1 == end) {
+            *start = position;
+            return true;
+        }
+        if (position == 0 || end - position > HISTORY_LINE_MAX + HISTORY_RECORD_HEADER_SIZE + 1) {
+            return false;
+        }
+        position--;
+    }
+}
+
+void load_recent_history(void (*add_line)(const char *line), size_t count) {
+    if (history_fd == -1) {
+        return;
+    }
+    remap_history_file();
+
+    size_t *starts = malloc(sizeof(size_t) * count);
+    assert(starts != NULL);
+    size_t found = 0;
+    size_t end = history_map_size;
+    // A record being written by another session may not have its end yet
+    while (end > 0 && history_map[end - 1] != '\n') {
+        end--;
+    }
+    size_t start;
+    uint32_t len;
+    while (found < count && find_previous_record(end, &start, &len)) {
+        starts[found++] = start;
+        end = start;
+    }
+
+    for (size_t i = found; i > 0; i--) {
+        start = starts[i - 1];
+        len = read_record_length(history_map + start);
+        char *line = strndup((const char *)history_map + start + HISTORY_RECORD_HEADER_SIZE, len);
+        assert(line != NULL);
+        add_line(line);
+        free(line);
+    }
+    free(starts);
+}
+
+bool append_to_history_file(const char *line) {
+    size_t len = strlen(line);
+    if (history_fd == -1 || len == 0 || len > HISTORY_LINE_MAX) {
+        return false;
+    }
+
+    size_t record_size = HISTORY_RECORD_HEADER_SIZE + len + 1;
+    unsigned char *record = malloc(record_size);
+    assert(record != NULL);
+    record[0] = HISTORY_RECORD_MARK;
+    for (int i = 0; i < 4; i++) {
+        record[1 + i] = (len >> (8 * i)) & 0xFF;
+    }
+    memcpy(record + HISTORY_RECORD_HEADER_SIZE, line, len);
+    record[record_size - 1] = '\n';
+
+    // With O_APPEND, a single write(2) is appended at once even if other sessions write at the same time
+    ssize_t written = write(history_fd, record, record_size);
+    free(record);
+    return written == (ssize_t)record_size;
+}
+
+void add_history_record(size_t offset, uint32_t len) {
+    if (history_record_count == history_record_capacity) {
+        history_record_capacity = history_record_capacity == 0 ? 1024 : history_record_capacity * 2;
+        history_record_offsets = realloc(history_record_offsets, sizeof(size_t) * history_record_capacity);
+        history_record_lengths = realloc(history_record_lengths, sizeof(uint32_t) * history_record_capacity);
+        assert(history_record_offsets != NULL && history_record_lengths != NULL);
+    }
+    history_record_offsets[history_record_count] = offset;
+    history_record_lengths[history_record_count] = len;
+    history_record_count++;
+}
+
+/*
+ * Parses the records appended since the last call, skipping the bytes which are not a whole record,
+ * such as a record cut by a crash
+ */
+void parse_history_records() {
+    remap_history_file();
+    size_t position = history_parsed_size;
+    while (position < history_map_size) {
+        uint32_t len;
+        if (is_record_at(position, history_map_size, &len)) {
+            add_history_record(position + HISTORY_RECORD_HEADER_SIZE, len);
+            position += HISTORY_RECORD_HEADER_SIZE + len + 1;
+            continue;
+        }
+        if (history_map[position] == HISTORY_RECORD_MARK && position + HISTORY_RECORD_HEADER_SIZE <= history_map_size &&
+            read_record_length(history_map + position) <= HISTORY_LINE_MAX &&
+            position + HISTORY_RECORD_HEADER_SIZE + read_record_length(history_map + position) >= history_map_size) {
+            break; // Still being written
+        }
+        const unsigned char *mark =
+            memchr(history_map + position + 1, HISTORY_RECORD_MARK, history_map_size - position - 1);
+        position = mark == NULL ? history_map_size : (size_t)(mark - history_map);
+    }
+    history_parsed_size = position;
+}
+
+size_t history_file_record_count() {
+    if (history_fd == -1) {
+        return 0;
+    }
+    parse_history_records();
+    return history_record_count;
+}
+
+const char *history_file_record(size_t index, size_t *len) {
+    assert(index < history_record_count);
+    *len = history_record_lengths[index];
+    return (const char *)history_map + history_record_offsets[index];
+}
+
+size_t trigram_bucket(const unsigned char *trigram) {
+    uint32_t key = (uint32_t)trigram[0] << 16 | (uint32_t)trigram[1] << 8 | trigram[2];
+    return (key * 2654435761u) >> 16 & (HISTORY_INDEX_BUCKETS - 1);
+}
+
+/*
+ * Adds the record to each distinct bucket of its trigrams, using the stamps of the buckets to skip the ones
+ * it was already added to: counts it in the bucket if positions is NULL, writes it at the position of the bucket
+ * otherwise
+ */
+void index_history_record(history_index_build *build, size_t record, uint32_t *stamps, uint32_t *positions) {
+    const unsigned char *line = build->map + build->offsets[record];
+    uint32_t line_len = build->lengths[record];
+    for (uint32_t k = 0; k + 3 <= line_len; k++) {
+        size_t bucket = trigram_bucket(line + k);
+        if (stamps[bucket] == record + 1) {
+            continue;
+        }
+        stamps[bucket] = record + 1;
+        if (positions == NULL) {
+            build->starts[bucket + 1]++;
+        } else {
+            build->records[positions[bucket]++] = record;
+        }
+    }
+}
+
+bool is_history_index_build_cancelled(history_index_build *build) {
+    pthread_mutex_lock(&history_index_lock);
+    bool cancelled = build->cancelled;
+    pthread_mutex_unlock(&history_index_lock);
+    return cancelled;
+}
+
+/*
+ * Builds the index of the trigrams of the records of the build, in two passes: the first one counts
+ * the records of each bucket, the second one fills them, in the order of the records
+ */
+void *build_history_index(void *arg) {
+    history_index_build *build = arg;
+    uint32_t *stamps = calloc(HISTORY_INDEX_BUCKETS, sizeof(uint32_t));
+    uint32_t *positions = malloc(sizeof(uint32_t) * HISTORY_INDEX_BUCKETS);
+    build->starts = calloc(HISTORY_INDEX_BUCKETS + 1, sizeof(uint32_t));
+    assert(stamps != NULL && positions != NULL && build->starts != NULL);
+
+    bool cancelled = false;
+    for (size_t i = 0; i < build->count && !cancelled; i++) {
+        index_history_record(build, i, stamps, NULL);
+        cancelled = i % HISTORY_INDEX_CHECK_INTERVAL == 0 && is_history_index_build_cancelled(build);
+    }
+    for (size_t i = 0; i < HISTORY_INDEX_BUCKETS; i++) {
+        build->starts[i + 1] += build->starts[i];
+    }
+
+    if (!cancelled) {
+        build->records = malloc(sizeof(uint32_t) * (build->starts[HISTORY_INDEX_BUCKETS] + 1));
+        assert(build->records != NULL);
+        memcpy(positions, build->starts, sizeof(uint32_t) * HISTORY_INDEX_BUCKETS);
+        memset(stamps, 0, sizeof(uint32_t) * HISTORY_INDEX_BUCKETS);
+    }
+    for (size_t i = 0; i < build->count && !cancelled; i++) {
+        index_history_record(build, i, stamps, positions);
+        cancelled = i % HISTORY_INDEX_CHECK_INTERVAL == 0 && is_history_index_build_cancelled(build);
+    }
+    free(positions);
+    free(stamps);
+
+    pthread_mutex_lock(&history_index_lock);
+    build->done = true;
+    pthread_mutex_unlock(&history_index_lock);
+    return NULL;
+}
+
+void free_history_index_build(history_index_build *build) {
+    munmap((void *)build->map, build->map_size);
+    free(build->offsets);
+    free(build->lengths);
+    free(build->starts);
+    free(build->records);
+    free(build);
+}
+
+/*
+ * Forgets the build in the children of jsh, since the thread building it is not there
+ */
+void forget_history_index_build_in_child() {
+    pthread_mutex_init(&history_index_lock, NULL);
+    history_index_building = NULL;
+}
+
+/*
+ * Starts building the index of the records parsed in a thread, from a copy of their positions
+ * and with its own mapping of the file, so that the file can be mapped again in the meantime
+ */
+void start_history_index_build() {
+    static bool fork_handler_registered = false;
+    if (history_record_count == 0) {
+        return;
+    }
+
+    history_index_build *build = calloc(1, sizeof(history_index_build));
+    assert(build != NULL);
+    build->count = history_record_count;
+    build->map_size = history_record_offsets[build->count - 1] + history_record_lengths[build->count - 1] + 1;
+    void *map = mmap(NULL, build->map_size, PROT_READ, MAP_SHARED, history_fd, 0);
+    if (map == MAP_FAILED) {
+        free(build);
+        return;
+    }
+    build->map = map;
+    build->offsets = malloc(sizeof(size_t) * build->count);
+    build->lengths = malloc(sizeof(uint32_t) * build->count);
+    assert(build->offsets != NULL && build->lengths != NULL);
+    memcpy(build->offsets, history_record_offsets, sizeof(size_t) * build->count);
+    memcpy(build->lengths, history_record_lengths, sizeof(uint32_t) * build->count);
+
+    if (!fork_handler_registered) {
+        pthread_atfork(NULL, NULL, forget_history_index_build_in_child);
+        fork_handler_registered = true;
+    }
+
+    // The thread must not take the signals meant for the main thread, such as SIGCHLD
+    sigset_t all, previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &previous);
+    bool started = pthread_create(&history_index_thread, NULL, build_history_index, build) == 0;
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+    if (!started) {
+        free_history_index_build(build);
+        return;
+    }
+    history_index_building = build;
+}
+
+/*
+ * Replaces the index by the one built in the background if it is ready, or as soon as it is if wait is true,
+ * in which case the build is cancelled first if cancel is true
+ */
+void collect_history_index_build(bool wait, bool cancel) {
+    history_index_build *build = history_index_building;
+    if (build == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&history_index_lock);
+    build->cancelled = cancel;
+    bool done = build->done;
+    pthread_mutex_unlock(&history_index_lock);
+    if (!done && !wait) {
+        return;
+    }
+
+    pthread_join(history_index_thread, NULL);
+    history_index_building = NULL;
+    if (!cancel) {
+        free(history_index_starts);
+        free(history_index_records);
+        history_index_starts = build->starts;
+        history_index_records = build->records;
+        history_indexed_count = build->count;
+        build->starts = NULL;
+        build->records = NULL;
+    }
+    free_history_index_build(build);
+}
+
+bool record_contains(size_t index, const char *query, size_t query_len) {
+    return memmem(history_map + history_record_offsets[index], history_record_lengths[index], query, query_len) !=
+           NULL;
+}
+
+/*
+ * Returns the newest of the records from first to before - 1 whose line contains the query, or -1 if none does
+ */
+long scan_history_records(const char *query, size_t query_len, size_t first, size_t before) {
+    for (size_t i = before; i > first; i--) {
+        if (record_contains(i - 1, query, query_len)) {
+            return i - 1;
+        }
+    }
+    return -1;
+}
+
+long search_history_file(const char *query, size_t before) {
+    size_t count = history_file_record_count();
+    size_t query_len = strlen(query);
+    if (before > count) {
+        before = count;
+    }
+    if (query_len == 0) {
+        return before > 0 ? (long)before - 1 : -1;
+    }
+
+    // Too short for the trigrams, the records are scanned
+    if (query_len < 3) {
+        return scan_history_records(query, query_len, 0, before);
+    }
+
+    // Until the index is built, the records it does not cover are scanned, which mostly finds the recent lines at once
+    collect_history_index_build(false, false);
+    if (history_index_building == NULL && count - history_indexed_count > HISTORY_UNINDEXED_MAX) {
+        start_history_index_build();
+    }
+    long match = scan_history_records(query, query_len, history_indexed_count < before ? history_indexed_count : before,
+                                      before);
+    if (match != -1 || history_indexed_count == 0) {
+        return match;
+    }
+
+    // Every matching record contains all the trigrams of the query, the records of the smallest bucket are checked
+    size_t best_bucket = trigram_bucket((const unsigned char *)query);
+    for (size_t k = 1; k + 3 <= query_len; k++) {
+        size_t bucket = trigram_bucket((const unsigned char *)query + k);
+        if (history_index_starts[bucket + 1] - history_index_starts[bucket] <
+            history_index_starts[best_bucket + 1] - history_index_starts[best_bucket]) {
+            best_bucket = bucket;
+        }
+    }
+
+    // The records of a bucket are sorted, the ones before the limit are found by binary search
+    size_t limit = before < history_indexed_count ? before : history_indexed_count;
+    size_t low = history_index_starts[best_bucket];
+    size_t high = history_index_starts[best_bucket + 1];
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (history_index_records[middle] < limit) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    for (size_t i = low; i > history_index_starts[best_bucket]; i--) {
+        uint32_t record = history_index_records[i - 1];
+        if (record_contains(record, query, query_len)) {
+            return record;
+        }
+    }
+    return -1;
+}
+
+void close_history_file() {
+    reset_history_records();
+    unmap_history_file();
+    if (history_fd != -1) {
+        close(history_fd);
+        history_fd = -1;
+    }
+}
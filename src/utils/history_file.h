@@ -0,0 +1,73 @@
+#ifndef HISTORY_FILE_H
+#define HISTORY_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define HISTORY_FILE_NAME ".jsh_history"
+/* Name of the history file in the home directory, used if JSH_HISTFILE is not set */
+
+#define HISTORY_RECORD_MARK 0xFE
+/* First byte of each record, which cannot appear in UTF-8 text */
+
+#define HISTORY_RECORD_HEADER_SIZE 5
+/* Size of the header of a record: its mark and the length of its line on four bytes, little endian */
+
+#define HISTORY_LINE_MAX (1 << 20)
+/* Maximal length of a line of the history file, longer ones are neither saved nor read */
+
+#define HISTORY_LOADED_LINES 1000
+/* Number of lines of the history file loaded in the history of readline at startup */
+
+#define HISTORY_SEARCH_QUERY_SIZE 256
+/* Size of the buffer of the query of the interactive search of the history (Ctrl-R) */
+
+#define HISTORY_INDEX_BUCKETS (1 << 16)
+/* Number of buckets of the trigrams of the search index */
+
+#define HISTORY_UNINDEXED_MAX 4096
+/* Number of records not covered by the index above which it is built again in the background */
+
+#define HISTORY_INDEX_CHECK_INTERVAL 65536
+/* Number of records indexed between two checks that the build of the index was not cancelled */
+
+bool open_history_file(const char *path);
+/*
+ * Opens the history file at the given path, or at JSH_HISTFILE, or at ~/.jsh_history if path is NULL,
+ * creating it if needed. Nothing is read until the records are needed.
+ * Returns false if the file cannot be opened, the history then not being saved.
+ */
+
+bool is_history_file_open();
+/* Returns true if a history file is open */
+
+void load_recent_history(void (*add_line)(const char *line), size_t count);
+/* Calls add_line on the last count lines of the history file, from the oldest to the newest,
+ * reading the file backwards so that only these records are read */
+
+bool append_to_history_file(const char *line);
+/*
+ * Appends the line to the history file in a single write(2) of a record framed by its mark and its length,
+ * so that the lines of several sessions appending to the same file cannot be interleaved.
+ * Empty lines are not saved. Returns false if the line cannot be saved.
+ */
+
+size_t history_file_record_count();
+/* Returns the number of records of the history file, including those appended by other sessions */
+
+const char *history_file_record(size_t index, size_t *len);
+/* Returns the line of the record at the given index and sets len to its length. The line is not null terminated,
+ * and is only valid until the next call to a function of the history file */
+
+long search_history_file(const char *query, size_t before);
+/*
+ * Returns the index of the newest record before the given index whose line contains the query, or -1 if none does.
+ * The records are looked up in an index of their trigrams, built by a thread started at the first search and
+ * built again once more than HISTORY_UNINDEXED_MAX records are not covered by it. The records it does not cover
+ * yet are scanned from the newest one.
+ */
+
+void close_history_file();
+/* Unmaps and closes the history file, and frees its index */
+
+#endif
@@ -0,0 +1,308 @@
+#define _GNU_SOURCE
+#include "job_output.h"
+#include "fd_utils.h"
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+typedef struct {
+    uint64_t written;
+} job_output_header;
+/* Number of bytes ever written to a ring, only increased by the relay */
+
+typedef struct {
+    unsigned id;
+    char *mapping;
+    size_t page_size;
+} job_output_ring;
+/*
+ * The output kept for a job: a page holding its header, followed by the ring mapped twice in a row from the same
+ * file, so that any JOB_OUTPUT_RING_SIZE bytes of it are contiguous and copied at once, wherever they start.
+ */
+
+typedef struct {
+    int fd;
+    int target;
+    char line[JOB_OUTPUT_LINE_SIZE];
+    size_t line_len;
+    char out[JOB_OUTPUT_CHUNK_SIZE];
+    size_t out_len;
+} job_output_stream;
+/* A pipe read by the relay, with the beginning of its line without end and the lines to write to its target */
+
+job_output_ring *job_output_rings = NULL;
+size_t job_output_ring_count = 0;
+
+size_t job_output_mapping_size(size_t page_size) {
+    return page_size + 2 * JOB_OUTPUT_RING_SIZE;
+}
+
+/*
+ * Returns a new mapping of a ring, or NULL on failure
+ */
+char *map_job_output_ring(size_t page_size) {
+    int fd = memfd_create("jsh-job-output", MFD_CLOEXEC);
+    if (fd == -1) {
+        return NULL;
+    }
+    char *mapping = MAP_FAILED;
+    // The whole range is reserved first, so that the two mappings of the ring follow each other
+    if (ftruncate(fd, page_size + JOB_OUTPUT_RING_SIZE) == 0) {
+        mapping = mmap(NULL, job_output_mapping_size(page_size), PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    if (mapping != MAP_FAILED &&
+        (mmap(mapping, page_size + JOB_OUTPUT_RING_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) ==
+             MAP_FAILED ||
+         mmap(mapping + page_size + JOB_OUTPUT_RING_SIZE, JOB_OUTPUT_RING_SIZE, PROT_READ | PROT_WRITE,
+              MAP_SHARED | MAP_FIXED, fd, page_size) == MAP_FAILED)) {
+        munmap(mapping, job_output_mapping_size(page_size));
+        mapping = MAP_FAILED;
+    }
+    close(fd);
+    return mapping == MAP_FAILED ? NULL : mapping;
+}
+
+job_output_ring *find_job_output_ring(unsigned id) {
+    for (size_t i = 0; i < job_output_ring_count; i++) {
+        if (job_output_rings[i].id == id) {
+            return &job_output_rings[i];
+        }
+    }
+    return NULL;
+}
+
+/* Keeps the ring as the one of the job id, the output of a former job of the same id being forgotten */
+void keep_job_output_ring(unsigned id, char *mapping, size_t page_size) {
+    job_output_ring *ring = find_job_output_ring(id);
+    if (ring != NULL) {
+        munmap(ring->mapping, job_output_mapping_size(ring->page_size));
+    } else {
+        job_output_rings = realloc(job_output_rings, sizeof(job_output_ring) * (job_output_ring_count + 1));
+        assert(job_output_rings != NULL);
+        ring = &job_output_rings[job_output_ring_count++];
+    }
+    ring->id = id;
+    ring->mapping = mapping;
+    ring->page_size = page_size;
+}
+
+void append_to_job_output_ring(char *mapping, size_t page_size, const char *data, size_t len) {
+    job_output_header *header = (job_output_header *)mapping;
+    char *ring = mapping + page_size;
+    uint64_t written = header->written;
+    // Only the end of what does not fit in the ring is kept
+    size_t skipped = len > JOB_OUTPUT_RING_SIZE ? len - JOB_OUTPUT_RING_SIZE : 0;
+    memcpy(ring + (written + skipped) % JOB_OUTPUT_RING_SIZE, data + skipped, len - skipped);
+    __atomic_store_n(&header->written, written + len, __ATOMIC_RELEASE);
+}
+
+void flush_job_output_stream(job_output_stream *stream) {
+    write_all(stream->target, stream->out, stream->out_len);
+    stream->out_len = 0;
+}
+
+/*
+ * Adds the prefix, the beginning of the line kept by the stream and the rest of the line to the lines to write,
+ * which are written first if the line does not fit with them, so that it is written at once
+ */
+void add_job_output_line(job_output_stream *stream, const char *prefix, const char *rest, size_t rest_len) {
+    size_t prefix_len = strlen(prefix);
+    size_t len = prefix_len + stream->line_len + rest_len;
+    if (stream->out_len + len > JOB_OUTPUT_CHUNK_SIZE) {
+        flush_job_output_stream(stream);
+    }
+    if (len > JOB_OUTPUT_CHUNK_SIZE) {
+        write_all(stream->target, prefix, prefix_len);
+        write_all(stream->target, stream->line, stream->line_len);
+        write_all(stream->target, rest, rest_len);
+    } else {
+        memcpy(stream->out + stream->out_len, prefix, prefix_len);
+        memcpy(stream->out + stream->out_len + prefix_len, stream->line, stream->line_len);
+        memcpy(stream->out + stream->out_len + prefix_len + stream->line_len, rest, rest_len);
+        stream->out_len += len;
+    }
+    stream->line_len = 0;
+}
+
+/*
+ * Writes the whole lines read from the stream, the last one being kept until its end is read
+ */
+void write_job_output_lines(job_output_stream *stream, const char *prefix, const char *data, size_t len) {
+    while (len > 0) {
+        const char *end = memchr(data, '\n', len);
+        if (end != NULL) {
+            size_t line_len = end - data + 1;
+            add_job_output_line(stream, prefix, data, line_len);
+            data += line_len;
+            len -= line_len;
+            continue;
+        }
+        size_t kept = JOB_OUTPUT_LINE_SIZE - stream->line_len;
+        kept = len < kept ? len : kept;
+        memcpy(stream->line + stream->line_len, data, kept);
+        stream->line_len += kept;
+        data += kept;
+        len -= kept;
+        if (stream->line_len == JOB_OUTPUT_LINE_SIZE) {
+            add_job_output_line(stream, prefix, "\n", 1);
+        }
+    }
+    flush_job_output_stream(stream);
+}
+
+/*
+ * Relays the output of a job read from its two pipes until both are closed
+ */
+void relay_job_output(job_output_stream *streams, const char *prefix, char *mapping, size_t page_size) {
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    assert(epoll_fd != -1);
+    char *buffer = malloc(JOB_OUTPUT_CHUNK_SIZE);
+    assert(buffer != NULL);
+
+    size_t open_count = 0;
+    for (size_t i = 0; i < 2; i++) {
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = &streams[i];
+        assert(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, streams[i].fd, &event) == 0);
+        open_count++;
+    }
+
+    while (open_count > 0) {
+        struct epoll_event events[2];
+        int event_count = epoll_wait(epoll_fd, events, 2, -1);
+        if (event_count == -1 && errno == EINTR) {
+            continue;
+        }
+        assert(event_count != -1);
+
+        for (int i = 0; i < event_count; i++) {
+            job_output_stream *stream = events[i].data.ptr;
+            ssize_t nread = read(stream->fd, buffer, JOB_OUTPUT_CHUNK_SIZE);
+            if (nread < 0 && errno == EINTR) {
+                continue;
+            }
+            if (nread <= 0) {
+                // The last line is written even without its end
+                if (stream->line_len > 0) {
+                    add_job_output_line(stream, prefix, "\n", 1);
+                    flush_job_output_stream(stream);
+                }
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, stream->fd, NULL);
+                close(stream->fd);
+                open_count--;
+                continue;
+            }
+            append_to_job_output_ring(mapping, page_size, buffer, nread);
+            write_job_output_lines(stream, prefix, buffer, nread);
+        }
+    }
+
+    free(buffer);
+    close(epoll_fd);
+}
+
+pid_t start_job_output(unsigned id, int *stdout_fd, int *stderr_fd) {
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    char *mapping = map_job_output_ring(page_size);
+    if (mapping == NULL) {
+        return -1;
+    }
+    int stdout_tube[2];
+    int stderr_tube[2];
+    if (pipe2(stdout_tube, O_CLOEXEC) == -1) {
+        munmap(mapping, job_output_mapping_size(page_size));
+        return -1;
+    }
+    if (pipe2(stderr_tube, O_CLOEXEC) == -1) {
+        close(stdout_tube[0]);
+        close(stdout_tube[1]);
+        munmap(mapping, job_output_mapping_size(page_size));
+        return -1;
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    assert(pid != -1);
+
+    if (pid == 0) {
+        close(stdout_tube[1]);
+        close(stderr_tube[1]);
+        // A terminal or a reader gone must not kill the relay, whose job would then block
+        signal(SIGPIPE, SIG_IGN);
+
+        job_output_stream *streams = malloc(sizeof(job_output_stream) * 2);
+        assert(streams != NULL);
+        streams[0].fd = stdout_tube[0];
+        streams[0].target = STDOUT_FILENO;
+        streams[1].fd = stderr_tube[0];
+        streams[1].target = STDERR_FILENO;
+        for (size_t i = 0; i < 2; i++) {
+            streams[i].line_len = 0;
+            streams[i].out_len = 0;
+        }
+        char prefix[16];
+        snprintf(prefix, sizeof(prefix), "[%u] ", id);
+
+        relay_job_output(streams, prefix, mapping, page_size);
+        free(streams);
+        exit(EXIT_SUCCESS);
+    }
+
+    close(stdout_tube[0]);
+    close(stderr_tube[0]);
+    keep_job_output_ring(id, mapping, page_size);
+    *stdout_fd = stdout_tube[1];
+    *stderr_fd = stderr_tube[1];
+    return pid;
+}
+
+bool replay_job_output(unsigned id, int fd) {
+    job_output_ring *ring = find_job_output_ring(id);
+    if (ring == NULL) {
+        return false;
+    }
+    job_output_header *header = (job_output_header *)ring->mapping;
+    const char *data = ring->mapping + ring->page_size;
+
+    uint64_t written = __atomic_load_n(&header->written, __ATOMIC_ACQUIRE);
+    uint64_t start = written > JOB_OUTPUT_RING_SIZE ? written - JOB_OUTPUT_RING_SIZE : 0;
+    size_t len = written - start;
+    char *copy = malloc(JOB_OUTPUT_RING_SIZE);
+    assert(copy != NULL);
+    memcpy(copy, data + start % JOB_OUTPUT_RING_SIZE, len);
+
+    // The relay of a running job may have overwritten the oldest bytes while they were copied
+    uint64_t rewritten = __atomic_load_n(&header->written, __ATOMIC_ACQUIRE);
+    size_t skipped = 0;
+    if (rewritten - start > JOB_OUTPUT_RING_SIZE) {
+        skipped = rewritten - start - JOB_OUTPUT_RING_SIZE;
+        skipped = skipped < len ? skipped : len;
+    }
+    if (start + skipped > 0) {
+        const char *end = memchr(copy + skipped, '\n', len - skipped);
+        skipped = end == NULL ? len : (size_t)(end - copy) + 1;
+    }
+
+    write_all(fd, copy + skipped, len - skipped);
+    free(copy);
+    return true;
+}
+
+void free_job_outputs() {
+    for (size_t i = 0; i < job_output_ring_count; i++) {
+        munmap(job_output_rings[i].mapping, job_output_mapping_size(job_output_rings[i].page_size));
+    }
+    free(job_output_rings);
+    job_output_rings = NULL;
+    job_output_ring_count = 0;
+}
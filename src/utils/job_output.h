@@ -0,0 +1,35 @@
+#ifndef JOB_OUTPUT_H
+#define JOB_OUTPUT_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+#define JOB_OUTPUT_RING_SIZE (1 << 16)
+/* Number of bytes of the last output of each job kept for `jobs -o`, a multiple of the size of a page */
+
+#define JOB_OUTPUT_LINE_SIZE 4096
+/* Length after which a line without its end is written anyway, so that a relay never holds it back for too long */
+
+#define JOB_OUTPUT_CHUNK_SIZE (1 << 16)
+/* Maximal number of bytes read by the relay from a pipe at once */
+
+pid_t start_job_output(unsigned id, int *stdout_fd, int *stderr_fd);
+/*
+ * Forks the relay of the output of the job id, and sets stdout_fd and stderr_fd to the write ends of its pipes.
+ * The relay waits for both pipes at once with epoll, and writes each line read from them to the standard output or
+ * error of jsh as a whole, prefixed with `[id] `, so that the lines of jobs run in parallel never interleave. It also
+ * copies the output to a ring of JOB_OUTPUT_RING_SIZE bytes shared with jsh, which replaces the former one of the id,
+ * and ends once every writer of the pipes is closed.
+ * Returns the pid of the relay, or -1 if the output cannot be captured.
+ */
+
+bool replay_job_output(unsigned id, int fd);
+/*
+ * Writes the output of the job id kept in its ring to the descriptor, from the first whole line if the beginning has
+ * been overwritten. Returns false if no output of the job was captured.
+ */
+
+void free_job_outputs();
+/* Unmaps the rings of the outputs of the jobs */
+
+#endif
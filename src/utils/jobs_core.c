@@ -1,7 +1,10 @@
 #include "jobs_core.h"
 #include "constants.h"
 #include "core.h"
+#include "event_log.h"
+#include "flight_recorder.h"
 #include "int_utils.h"
+#include "timer_wheel.h"
 #include <assert.h>
 #include <errno.h>
 #include <stdbool.h>
@@ -19,6 +22,9 @@ void free_job(job *j) {
     if (j == NULL) {
         return;
     }
+    if (j->deadline != 0) {
+        cancel_deadline(j->deadline);
+    }
     if (j->pipeline != NULL) {
         free_pipeline(j->pipeline);
     }
@@ -56,6 +62,9 @@ char *state_to_string(Status status) {
     if (status == KILLED) {
         return strdup("Killed");
     }
+    if (status == TIMED_OUT) {
+        return strdup("Timed out");
+    }
     return strdup("Done");
 }
 
@@ -125,6 +134,7 @@ job *init_job_to_add(pid_t pgid, pid_t pid, pipeline *pip, Status s) {
     new_job->pipeline = pip;
     new_job->process_number = 0;
     new_job->job_process = NULL;
+    new_job->deadline = 0;
 
     return new_job;
 }
@@ -137,6 +147,8 @@ process *init_process_to_add(pid_t pid, command *cmd, command_without_substituti
     p->cmd = cmd;
     p->cmd_without_subst = cmd_without_subst;
     p->status = s;
+    p->exit_status = 0;
+    p->start_time = event_log_time();
 
     return p;
 }
@@ -153,6 +165,7 @@ int get_jobs_placement_with_id(unsigned id) {
 }
 
 int add_job_to_jobs(job *j) {
+    log_job_event(j);
     if (jobs == NULL) {
         jobs = malloc(sizeof(job *));
         assert(jobs != NULL);
@@ -185,6 +198,9 @@ int add_process_to_job(job *j, pid_t pid, command *cmd, command_without_substitu
     j->job_process = new_process;
     new_process[j->process_number] = init_process_to_add(pid, cmd, cmd_without_subst, s);
     j->process_number++;
+    log_spawn_event(j, new_process[j->process_number - 1]);
+    record_flight_event(FLIGHT_FORK, pid, j->pgid,
+                        cmd_without_subst == NULL ? "(relay)" : cmd_without_subst->name);
 
     return SUCCESS;
 }
@@ -219,29 +235,47 @@ int remove_job_from_jobs(unsigned id) {
     return SUCCESS;
 }
 
+void set_status_of_process(process *p, int status) {
+    if (WIFEXITED(status)) {
+        p->status = DONE;
+        p->exit_status = WEXITSTATUS(status);
+    } else if (WIFSIGNALED(status)) {
+        p->status = KILLED;
+        p->exit_status = 128 + WTERMSIG(status);
+    } else if (WIFSTOPPED(status)) {
+        p->status = STOPPED;
+    } else if (WIFCONTINUED(status)) {
+        p->status = RUNNING;
+    }
+}
+
 int update_status_of_process(process *p) {
+    // A process already reaped is not a child any more, waiting for it again would make it detached
+    if (p->status != RUNNING && p->status != STOPPED) {
+        return SUCCESS;
+    }
     int status;
     int res = waitpid(p->pid, &status, WNOHANG | WUNTRACED | WCONTINUED);
+    // The processes whose status did not change are polled too often to be recorded
+    if (res != 0) {
+        record_flight_event(FLIGHT_WAITPID, p->pid, res < 0 ? -errno : status, NULL);
+    }
 
     if (res < 0) {
         assert(errno == ECHILD);
         p->status = DETACHED;
     } else if (res > 0) {
-        if (WIFEXITED(status)) {
-            p->status = DONE;
-        } else if (WIFSIGNALED(status)) {
-            p->status = KILLED;
-        } else if (WIFSTOPPED(status)) {
-            p->status = STOPPED;
-        } else if (WIFCONTINUED(status)) {
-            p->status = RUNNING;
-        }
+        set_status_of_process(p, status);
     }
     return SUCCESS;
 }
 
 int update_status_of_job(job *j) {
     Status st = j->status;
+    // A terminated job keeps its status until it is removed, such as between the rounds of `jobs -t -w`
+    if (st == DONE || st == KILLED || st == DETACHED || st == TIMED_OUT) {
+        return SUCCESS;
+    }
     unsigned pre_nkilled = 0;
 
     for (unsigned i = 0; i < j->process_number; i++) {
@@ -251,7 +285,9 @@ int update_status_of_job(job *j) {
     }
 
     for (unsigned i = 0; i < j->process_number; i++) {
+        Status previous = j->job_process[i]->status;
         update_status_of_process(j->job_process[i]);
+        log_status_event(j, j->job_process[i], previous);
     }
     unsigned ndone = 0;
     unsigned nkilled = 0;
@@ -283,11 +319,16 @@ int update_status_of_job(job *j) {
         }
     } else if (ndetached == j->process_number) {
         j->status = DETACHED;
+    } else if (has_job_timed_out(j)) {
+        j->status = TIMED_OUT;
     } else if (pre_nkilled < nkilled) {
         j->status = KILLED;
     } else {
         j->status = DONE;
     }
+    if (j->status != st) {
+        record_flight_event(FLIGHT_JOB_STATUS, j->pgid, j->status, NULL);
+    }
     return SUCCESS;
 }
 
@@ -296,7 +337,7 @@ void remove_terminated_jobs(bool print) {
     for (int i = 0; i < job_number; i++) {
         job *j = jobs[i];
 
-        if (j->status == DONE || j->status == KILLED || j->status == DETACHED) {
+        if (j->status == DONE || j->status == KILLED || j->status == DETACHED || j->status == TIMED_OUT) {
             if (print) {
                 print_job(j, false);
             }
@@ -310,8 +351,31 @@ void remove_terminated_jobs(bool print) {
     }
 }
 
+bool has_job_timed_out(const job *j) {
+    return j->deadline != 0 && has_deadline_expired(j->deadline);
+}
+
 void update_status_of_jobs() {
     for (size_t i = 0; i < job_number; i++) {
         update_status_of_job(jobs[i]);
     }
 }
+
+bool jobs_have_status_changes() {
+    for (size_t i = 0; i < job_number; i++) {
+        for (size_t k = 0; k < jobs[i]->process_number; k++) {
+            process *p = jobs[i]->job_process[k];
+            if (p->status != RUNNING && p->status != STOPPED) {
+                continue;
+            }
+
+            siginfo_t info;
+            info.si_pid = 0;
+            int res = waitid(P_PID, p->pid, &info, WEXITED | WSTOPPED | WCONTINUED | WNOHANG | WNOWAIT);
+            if ((res == -1 && errno == ECHILD) || (res == 0 && info.si_pid != 0)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
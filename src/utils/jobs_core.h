@@ -5,16 +5,19 @@
 
 /* ENUM */
 
-typedef enum { RUNNING, STOPPED, DETACHED, KILLED, DONE } Status;
+typedef enum { RUNNING, STOPPED, DETACHED, KILLED, DONE, TIMED_OUT } Status;
 
 /* STRUCTURES */
 
 typedef struct process {
     pid_t pid;
     Status status;
+    int exit_status;
     command *cmd;
     command_without_substitution *cmd_without_subst;
+    unsigned long long start_time;
 } process;
+/* The start time is the one of CLOCK_MONOTONIC in nanoseconds at which the process was added to its job */
 
 typedef struct job {
     unsigned id;
@@ -24,7 +27,9 @@ typedef struct job {
     pipeline *pipeline;
     process **job_process;
     size_t process_number;
+    unsigned long deadline;
 } job;
+/* The deadline is the one of the timer wheel after which a job run with `timeout` is killed, 0 if it has none */
 
 /* VARIABLES */
 
@@ -77,6 +82,17 @@ int remove_job_from_jobs(unsigned);
 void remove_terminated_jobs(bool);
 /* Removes jobs from list if done, detached or killed and print it if true is given */
 
+void set_status_of_process(process *, int);
+/* Sets the status of the process from the status returned by waitpid, its exit status being
+ * 128 plus the number of the signal which killed it if it was killed */
+
+bool has_job_timed_out(const job *);
+/* Returns true if the job was killed because its deadline had passed */
+
 void update_status_of_jobs();
-/* Updates job status according to waitpid */
+/* Updates job status according to waitpid, a terminated job keeping its status until it is removed */
+
+bool jobs_have_status_changes();
+/* Returns true if a running or stopped process of a job has changed status since the last update,
+ * without collecting its status */
 #endif
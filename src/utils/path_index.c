@@ -0,0 +1,342 @@
+#define _GNU_SOURCE
+#include "path_index.h"
+#include "directory_cache.h"
+#include "string_utils.h"
+#include <assert.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct {
+    char *path;
+    int watch;
+    bool exists;
+    struct timespec mtime;
+    bool stale;
+    char **names;
+    size_t name_count;
+} path_directory;
+/* A directory of PATH with its executables, watched with the inotify descriptor watch,
+ * or through its modification time if watch is -1 */
+
+typedef struct {
+    const char *name;
+    size_t directory;
+} path_entry;
+/* An executable of the index, found first in the directory of PATH at the given position */
+
+char *path_index_variable = NULL;
+path_directory *path_directories = NULL;
+size_t path_directory_count = 0;
+bool path_index_has_relative_directories = false;
+int path_index_inotify_fd = -1;
+pid_t path_index_owner = -1;
+
+path_entry *path_entries = NULL;
+size_t path_entry_count = 0;
+
+const unsigned int PATH_INDEX_WATCHED_EVENTS =
+    IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF;
+
+void free_path_directory_names(path_directory *directory) {
+    for (size_t i = 0; i < directory->name_count; i++) {
+        free(directory->names[i]);
+    }
+    free(directory->names);
+    directory->names = NULL;
+    directory->name_count = 0;
+}
+
+bool is_executable_entry(int dirfd, const directory_entry *entry) {
+    if (entry->type != DT_REG) {
+        struct stat st;
+        if (entry->type != DT_LNK && entry->type != DT_UNKNOWN) {
+            return false;
+        }
+        if (fstatat(dirfd, entry->name, &st, 0) == -1 || !S_ISREG(st.st_mode)) {
+            return false;
+        }
+    }
+    return faccessat(dirfd, entry->name, X_OK, AT_EACCESS) == 0;
+}
+
+/*
+ * Reads the executables of the directory again, watching it first so that no change can be missed in between
+ */
+void read_path_directory(path_directory *directory) {
+    free_path_directory_names(directory);
+    directory->stale = false;
+
+    if (directory->watch == -1 && path_index_inotify_fd != -1) {
+        directory->watch =
+            inotify_add_watch(path_index_inotify_fd, directory->path, PATH_INDEX_WATCHED_EVENTS | IN_ONLYDIR);
+    }
+    struct stat st;
+    directory->exists = stat(directory->path, &st) == 0;
+    if (directory->exists) {
+        directory->mtime = st.st_mtim;
+    }
+
+    int dirfd = open(directory->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirfd == -1) {
+        return;
+    }
+    directory_listing *listing = get_directory_listing(dirfd, ".");
+    if (listing == NULL) {
+        close(dirfd);
+        return;
+    }
+
+    directory->names = malloc(sizeof(char *) * (listing->entry_count + 1));
+    assert(directory->names != NULL);
+    for (size_t i = 0; i < listing->entry_count; i++) {
+        if (is_executable_entry(dirfd, &listing->entries[i])) {
+            directory->names[directory->name_count] = strdup(listing->entries[i].name);
+            assert(directory->names[directory->name_count] != NULL);
+            directory->name_count++;
+        }
+    }
+    release_directory_listing(listing);
+    close(dirfd);
+}
+
+int compare_path_entries(const void *a, const void *b) {
+    const path_entry *entry_a = a;
+    const path_entry *entry_b = b;
+    int comparison = strcmp(entry_a->name, entry_b->name);
+    if (comparison != 0) {
+        return comparison;
+    }
+    return (entry_a->directory > entry_b->directory) - (entry_a->directory < entry_b->directory);
+}
+
+/*
+ * Merges the names of all the directories, keeping for each name the first directory of PATH which has it
+ */
+void merge_path_directories() {
+    size_t total = 0;
+    for (size_t i = 0; i < path_directory_count; i++) {
+        total += path_directories[i].name_count;
+    }
+    free(path_entries);
+    path_entries = malloc(sizeof(path_entry) * (total + 1));
+    assert(path_entries != NULL);
+
+    size_t count = 0;
+    for (size_t i = 0; i < path_directory_count; i++) {
+        for (size_t k = 0; k < path_directories[i].name_count; k++) {
+            path_entries[count++] = (path_entry){path_directories[i].names[k], i};
+        }
+    }
+    qsort(path_entries, count, sizeof(path_entry), compare_path_entries);
+
+    path_entry_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (path_entry_count == 0 || strcmp(path_entries[path_entry_count - 1].name, path_entries[i].name) != 0) {
+            path_entries[path_entry_count++] = path_entries[i];
+        }
+    }
+}
+
+void free_path_directories() {
+    for (size_t i = 0; i < path_directory_count; i++) {
+        if (path_directories[i].watch != -1 && path_index_inotify_fd != -1) {
+            inotify_rm_watch(path_index_inotify_fd, path_directories[i].watch);
+        }
+        free_path_directory_names(&path_directories[i]);
+        free(path_directories[i].path);
+    }
+    free(path_directories);
+    path_directories = NULL;
+    path_directory_count = 0;
+    free(path_entries);
+    path_entries = NULL;
+    path_entry_count = 0;
+}
+
+/*
+ * Splits PATH into its directories, all stale, ignoring the repeated ones
+ */
+void split_path_variable(const char *path_variable) {
+    free_path_directories();
+    free(path_index_variable);
+    path_index_variable = strdup(path_variable);
+    assert(path_index_variable != NULL);
+    path_index_has_relative_directories = false;
+
+    size_t capacity = 1;
+    for (const char *p = path_variable; *p != '\0'; p++) {
+        capacity += *p == ':';
+    }
+    path_directories = malloc(sizeof(path_directory) * capacity);
+    assert(path_directories != NULL);
+
+    char *copy = strdup(path_variable);
+    assert(copy != NULL);
+    char *rest = copy;
+    char *directory;
+    while ((directory = strsep(&rest, ":")) != NULL) {
+        // An empty directory stands for the current one
+        if (directory[0] != '/') {
+            path_index_has_relative_directories = true;
+            continue;
+        }
+        bool repeated = false;
+        for (size_t i = 0; i < path_directory_count && !repeated; i++) {
+            repeated = strcmp(path_directories[i].path, directory) == 0;
+        }
+        if (repeated) {
+            continue;
+        }
+        path_directory *entry = &path_directories[path_directory_count++];
+        entry->path = strdup(directory);
+        assert(entry->path != NULL);
+        entry->watch = -1;
+        entry->exists = false;
+        entry->stale = true;
+        entry->names = NULL;
+        entry->name_count = 0;
+    }
+    free(copy);
+}
+
+/*
+ * Marks stale the directories whose inotify watch reported a change
+ */
+void read_path_index_events() {
+    char buffer[PATH_INDEX_EVENTS_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t nread;
+    while ((nread = read(path_index_inotify_fd, buffer, sizeof(buffer))) > 0) {
+        for (char *p = buffer; p < buffer + nread;) {
+            const struct inotify_event *event = (const struct inotify_event *)p;
+            p += sizeof(struct inotify_event) + event->len;
+
+            for (size_t i = 0; i < path_directory_count; i++) {
+                path_directory *directory = &path_directories[i];
+                // Events were lost, every directory may have changed
+                if (event->mask & IN_Q_OVERFLOW) {
+                    directory->stale = true;
+                } else if (directory->watch == event->wd) {
+                    directory->stale = true;
+                    if (event->mask & IN_IGNORED) {
+                        directory->watch = -1;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Marks stale the directories which are not watched and whose modification time changed
+ */
+void check_unwatched_path_directories() {
+    for (size_t i = 0; i < path_directory_count; i++) {
+        path_directory *directory = &path_directories[i];
+        if (directory->watch != -1 || directory->stale) {
+            continue;
+        }
+        struct stat st;
+        bool exists = stat(directory->path, &st) == 0;
+        directory->stale = exists != directory->exists ||
+                           (exists && (st.st_mtim.tv_sec != directory->mtime.tv_sec ||
+                                       st.st_mtim.tv_nsec != directory->mtime.tv_nsec));
+    }
+}
+
+void refresh_path_index() {
+    pid_t pid = getpid();
+    if (path_index_owner != -1 && path_index_owner != pid) {
+        return;
+    }
+    if (path_index_owner == -1) {
+        path_index_owner = pid;
+        path_index_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    }
+
+    const char *path_variable = getenv("PATH");
+    if (path_variable == NULL) {
+        path_variable = "";
+    }
+    if (path_index_variable == NULL || strcmp(path_index_variable, path_variable) != 0) {
+        split_path_variable(path_variable);
+    } else if (path_index_inotify_fd != -1) {
+        read_path_index_events();
+    }
+    check_unwatched_path_directories();
+
+    bool changed = path_entries == NULL;
+    for (size_t i = 0; i < path_directory_count; i++) {
+        if (path_directories[i].stale) {
+            read_path_directory(&path_directories[i]);
+            changed = true;
+        }
+    }
+    if (changed) {
+        merge_path_directories();
+    }
+}
+
+/*
+ * Returns the position of the first name not lower than the given one
+ */
+size_t lower_bound_in_path_index(const char *name) {
+    size_t low = 0;
+    size_t high = path_entry_count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (strcmp(path_entries[middle].name, name) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+char *find_in_path_index(const char *name) {
+    if (path_entries == NULL || path_index_has_relative_directories) {
+        return NULL;
+    }
+    size_t position = lower_bound_in_path_index(name);
+    if (position == path_entry_count || strcmp(path_entries[position].name, name) != 0) {
+        return NULL;
+    }
+    return concat_with_delimiter(path_directories[path_entries[position].directory].path, name, '/');
+}
+
+bool path_index_prefix_range(const char *prefix, size_t *first, size_t *last) {
+    if (path_entries == NULL) {
+        return false;
+    }
+    size_t prefix_len = strlen(prefix);
+    *first = lower_bound_in_path_index(prefix);
+    *last = *first;
+    while (*last < path_entry_count && strncmp(path_entries[*last].name, prefix, prefix_len) == 0) {
+        (*last)++;
+    }
+    return *last > *first;
+}
+
+const char *path_index_name(size_t index) {
+    assert(index < path_entry_count);
+    return path_entries[index].name;
+}
+
+void free_path_index() {
+    if (path_index_owner != getpid()) {
+        return;
+    }
+    free_path_directories();
+    free(path_index_variable);
+    path_index_variable = NULL;
+    if (path_index_inotify_fd != -1) {
+        close(path_index_inotify_fd);
+        path_index_inotify_fd = -1;
+    }
+    path_index_owner = -1;
+}
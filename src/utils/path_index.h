@@ -0,0 +1,35 @@
+#ifndef PATH_INDEX_H
+#define PATH_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define PATH_INDEX_EVENTS_SIZE 4096
+/* Size of the buffer of the inotify events read at once */
+
+void refresh_path_index();
+/*
+ * Builds the index of the executables of the directories of PATH at the first call, then reads again the
+ * directories changed since the last call, which are watched with inotify, or through their modification time
+ * if they cannot be. The whole index is built again if PATH changed.
+ * Only jsh refreshes the index, the calls in its children do nothing, so that they cannot take the inotify events.
+ */
+
+char *find_in_path_index(const char *name);
+/*
+ * Returns the path of the executable of the first directory of PATH with the given name as of the last refresh,
+ * or NULL if there is none, if the index was not built, or if PATH has relative directories, which depend on the
+ * current directory. The path must be freed by the caller.
+ */
+
+bool path_index_prefix_range(const char *prefix, size_t *first, size_t *last);
+/* Sets first and last to the range of the names of executables starting with the prefix, in byte order,
+ * each name appearing once even if it is in several directories. Returns false if there is none */
+
+const char *path_index_name(size_t index);
+/* Returns the name of the executable at the given index of the range */
+
+void free_path_index();
+/* Frees the index and stops watching the directories */
+
+#endif
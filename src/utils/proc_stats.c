@@ -0,0 +1,137 @@
+#define _GNU_SOURCE
+#include "proc_stats.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Reads the file of the directory of a process in the buffer with a single read, returns false if it cannot be read
+ */
+bool read_proc_file(int dir_fd, const char *name, char *buffer) {
+    int fd = openat(dir_fd, name, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+    ssize_t len = read(fd, buffer, PROC_STATS_BUFFER_SIZE - 1);
+    close(fd);
+    if (len <= 0) {
+        return false;
+    }
+    buffer[len] = '\0';
+    return true;
+}
+
+/*
+ * Parses the fields of /proc/<pid>/stat following the name of the command, which may contain spaces and parentheses
+ */
+bool parse_proc_stat(const char *stat, process_stats *stats) {
+    const char *fields = strrchr(stat, ')');
+    if (fields == NULL || fields[1] != ' ') {
+        return false;
+    }
+    fields += 2;
+    stats->state = fields[0];
+
+    // The state is the third field, utime and stime the 14th and 15th, starttime the 22nd
+    unsigned long long utime = 0, stime = 0;
+    char *end;
+    const char *field = fields;
+    for (int index = 3; index <= 22 && field != NULL; index++) {
+        if (index == 14) {
+            utime = strtoull(field, &end, 10);
+        } else if (index == 15) {
+            stime = strtoull(field, &end, 10);
+        } else if (index == 22) {
+            stats->start_ticks = strtoull(field, &end, 10);
+            stats->cpu_ticks = utime + stime;
+            return true;
+        }
+        field = strchr(field, ' ');
+        field = field == NULL ? NULL : field + 1;
+    }
+    return false;
+}
+
+/* Returns the value of the line `key: value` of /proc/<pid>/io, 0 if there is none */
+unsigned long long proc_io_value(const char *io, const char *key) {
+    const char *line = strstr(io, key);
+    return line == NULL ? 0 : strtoull(line + strlen(key), NULL, 10);
+}
+
+/*
+ * Returns the number of bytes waiting in the pipe of the descriptor of the process, -1 if it is not a pipe, and sets
+ * size to its capacity
+ */
+long pipe_fill_of_process_fd(int dir_fd, const char *fd_name, long *size) {
+    char target[64];
+    ssize_t len = readlinkat(dir_fd, fd_name, target, sizeof(target) - 1);
+    if (len <= 0) {
+        return -1;
+    }
+    target[len] = '\0';
+    if (strncmp(target, "pipe:", 5) != 0) {
+        return -1;
+    }
+    // Opening the pipe anew does not need a writer, and reads nothing from it
+    int fd = openat(dir_fd, fd_name, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd == -1) {
+        return -1;
+    }
+    int fill;
+    long result = ioctl(fd, FIONREAD, &fill) == -1 ? -1 : fill;
+    if (size != NULL) {
+        *size = fcntl(fd, F_GETPIPE_SZ);
+    }
+    close(fd);
+    return result;
+}
+
+bool read_process_stats(pid_t pid, process_stats *stats) {
+    char path[32];
+    snprintf(path, sizeof(path), "/proc/%d", pid);
+    int dir_fd = open(path, O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd == -1) {
+        return false;
+    }
+
+    char buffer[PROC_STATS_BUFFER_SIZE];
+    stats->pid = pid;
+    if (!read_proc_file(dir_fd, "stat", buffer) || !parse_proc_stat(buffer, stats)) {
+        close(dir_fd);
+        return false;
+    }
+    stats->has_io = read_proc_file(dir_fd, "io", buffer);
+    stats->read_bytes = stats->has_io ? proc_io_value(buffer, "rchar:") : 0;
+    stats->written_bytes = stats->has_io ? proc_io_value(buffer, "wchar:") : 0;
+
+    stats->output_pipe_size = 0;
+    stats->input_pipe_fill = pipe_fill_of_process_fd(dir_fd, "fd/0", NULL);
+    stats->output_pipe_fill = pipe_fill_of_process_fd(dir_fd, "fd/1", &stats->output_pipe_size);
+    close(dir_fd);
+    return true;
+}
+
+double process_cpu_percent(const process_stats *previous, const process_stats *current, double elapsed_seconds) {
+    long ticks_per_second = sysconf(_SC_CLK_TCK);
+    double ticks;
+    if (previous != NULL) {
+        ticks = current->cpu_ticks - previous->cpu_ticks;
+    } else {
+        ticks = current->cpu_ticks;
+        elapsed_seconds = seconds_since_boot() - (double)current->start_ticks / ticks_per_second;
+    }
+    if (elapsed_seconds <= 0) {
+        return 0;
+    }
+    return 100 * ticks / ticks_per_second / elapsed_seconds;
+}
+
+double seconds_since_boot() {
+    struct timespec now;
+    clock_gettime(CLOCK_BOOTTIME, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
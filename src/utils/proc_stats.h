@@ -0,0 +1,45 @@
+#ifndef PROC_STATS_H
+#define PROC_STATS_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+#define PROC_STATS_BUFFER_SIZE 1024
+/* Size of the buffer in which a file of /proc/<pid> is read at once, enough for stat and io */
+
+typedef struct {
+    pid_t pid;
+    char state;
+    unsigned long long cpu_ticks;
+    unsigned long long start_ticks;
+    bool has_io;
+    unsigned long long read_bytes;
+    unsigned long long written_bytes;
+    long input_pipe_fill;
+    long output_pipe_fill;
+    long output_pipe_size;
+} process_stats;
+/*
+ * What /proc tells about a process: its state (`R`, `S`, `D`, `T`, `Z`...), the clock ticks it has run for in user
+ * and kernel mode and the one it started at after the boot, the bytes it has read and written with any system call
+ * if /proc/<pid>/io can be read, and the number of bytes waiting in the pipes of its standard input and output, -1 if
+ * they are not pipes, with the capacity of the one of its output.
+ */
+
+bool read_process_stats(pid_t pid, process_stats *stats);
+/*
+ * Reads the statistics of the process from /proc/<pid>, each file with a single read, and returns false if it does
+ * not exist anymore. The pipes are opened through /proc/<pid>/fd, as jsh no longer has them once the processes are
+ * started, and measured with FIONREAD without reading anything.
+ */
+
+double process_cpu_percent(const process_stats *previous, const process_stats *current, double elapsed_seconds);
+/*
+ * Returns the share of a CPU used by the process between the two samples, elapsed_seconds apart, or since it started
+ * if previous is NULL, in percent
+ */
+
+double seconds_since_boot();
+/* Returns the time elapsed since the boot, the clock of the start of the processes */
+
+#endif
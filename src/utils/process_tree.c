@@ -0,0 +1,246 @@
+#define _GNU_SOURCE
+#include "process_tree.h"
+#include <assert.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define PROCESS_TREE_STAT_SIZE 256
+/* Number of bytes read from each stat file, enough for the fields up to the parent even with a long name */
+
+typedef struct {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+} process_tree_dirent;
+/* An entry returned by getdents64, which glibc does not always declare */
+
+/*
+ * Returns the pid named by the entry of /proc, or 0 if it is not the directory of a process
+ */
+pid_t pid_of_proc_entry(const char *name) {
+    pid_t pid = 0;
+    for (; *name != '\0'; name++) {
+        if (*name < '0' || *name > '9') {
+            return 0;
+        }
+        pid = pid * 10 + (*name - '0');
+    }
+    return pid;
+}
+
+/*
+ * Reads the name, the state and the parent of the process from its stat file, returns false if it is gone
+ */
+bool read_tree_process(int proc_fd, const char *entry, tree_process *process) {
+    char path[32];
+    snprintf(path, sizeof(path), "%s/stat", entry);
+    int fd = openat(proc_fd, path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+    char stat[PROCESS_TREE_STAT_SIZE];
+    ssize_t len = read(fd, stat, sizeof(stat) - 1);
+    close(fd);
+    if (len <= 0) {
+        return false;
+    }
+    stat[len] = '\0';
+
+    // The name is between the first `(` and the last `)`, as it may contain both
+    char *name = strchr(stat, '(');
+    char *name_end = strrchr(stat, ')');
+    if (name == NULL || name_end == NULL || name_end < name || name_end[1] != ' ' || name_end[2] == '\0') {
+        return false;
+    }
+    size_t name_len = name_end - name - 1;
+    name_len = name_len < PROCESS_TREE_NAME_SIZE - 1 ? name_len : PROCESS_TREE_NAME_SIZE - 1;
+    memcpy(process->name, name + 1, name_len);
+    process->name[name_len] = '\0';
+    process->state = name_end[2];
+    process->ppid = strtol(name_end + 3, NULL, 10);
+    process->is_current = true;
+    return true;
+}
+
+int compare_tree_processes(const void *a, const void *b) {
+    pid_t pid_a = ((const tree_process *)a)->pid;
+    pid_t pid_b = ((const tree_process *)b)->pid;
+    return (pid_a > pid_b) - (pid_a < pid_b);
+}
+
+/*
+ * Builds the index of the children: they are counted for each parent, and then put in place in the order of the
+ * processes, so that the children of each of them are sorted by pid
+ */
+void index_process_tree_children(process_tree *tree) {
+    size_t *parents = malloc(sizeof(size_t) * (tree->count + 1));
+    tree->child_starts = calloc(tree->count + 2, sizeof(size_t));
+    tree->children = malloc(sizeof(size_t) * (tree->count + 1));
+    assert(parents != NULL && tree->child_starts != NULL && tree->children != NULL);
+
+    for (size_t i = 0; i < tree->count; i++) {
+        parents[i] = process_tree_index(tree, tree->processes[i].ppid);
+        if (parents[i] != tree->count) {
+            tree->child_starts[parents[i] + 2]++;
+        }
+    }
+    // Once the counts are summed, child_starts[i + 1] is where the next child of i goes
+    for (size_t i = 2; i < tree->count + 2; i++) {
+        tree->child_starts[i] += tree->child_starts[i - 1];
+    }
+    for (size_t i = 0; i < tree->count; i++) {
+        if (parents[i] != tree->count) {
+            tree->children[tree->child_starts[parents[i] + 1]++] = i;
+        }
+    }
+    free(parents);
+}
+
+/*
+ * Reads again the roots and their descendants which were taken from the previous tree. Returns true if one of them
+ * has ended or has another parent, the ended ones being removed and the index of the children built again.
+ */
+bool refresh_process_tree_descendants(process_tree *tree, int proc_fd, const pid_t *roots, size_t root_count) {
+    size_t *stack = malloc(sizeof(size_t) * (tree->count + 1));
+    bool *ended = calloc(tree->count + 1, sizeof(bool));
+    assert(stack != NULL && ended != NULL);
+    size_t stack_size = 0;
+    bool changed = false;
+    for (size_t i = 0; i < root_count; i++) {
+        size_t index = process_tree_index(tree, roots[i]);
+        if (index != tree->count) {
+            stack[stack_size++] = index;
+        }
+    }
+    // The tree has no cycle, each process is reached at most once, from its parent
+    while (stack_size > 0) {
+        size_t index = stack[--stack_size];
+        tree_process *process = &tree->processes[index];
+        if (!process->is_current) {
+            char entry[16];
+            snprintf(entry, sizeof(entry), "%d", process->pid);
+            pid_t ppid = process->ppid;
+            if (!read_tree_process(proc_fd, entry, process)) {
+                ended[index] = true;
+                changed = true;
+                continue;
+            }
+            changed = changed || process->ppid != ppid;
+        }
+        const size_t *children;
+        size_t count = process_tree_children(tree, index, &children);
+        for (size_t i = 0; i < count && stack_size < tree->count; i++) {
+            stack[stack_size++] = children[i];
+        }
+    }
+
+    if (changed) {
+        size_t count = 0;
+        for (size_t i = 0; i < tree->count; i++) {
+            if (!ended[i]) {
+                tree->processes[count++] = tree->processes[i];
+            }
+        }
+        tree->count = count;
+        free(tree->child_starts);
+        free(tree->children);
+        index_process_tree_children(tree);
+    }
+    free(stack);
+    free(ended);
+    return changed;
+}
+
+bool read_process_tree(process_tree *tree, const process_tree *previous, const pid_t *roots, size_t root_count) {
+    tree->processes = NULL;
+    tree->count = 0;
+    tree->child_starts = NULL;
+    tree->children = NULL;
+
+    int proc_fd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (proc_fd == -1) {
+        return false;
+    }
+    char *dirents = malloc(PROCESS_TREE_DIRENTS_SIZE);
+    assert(dirents != NULL);
+    size_t capacity = 0;
+    bool sorted = true;
+
+    long len;
+    while ((len = syscall(SYS_getdents64, proc_fd, dirents, PROCESS_TREE_DIRENTS_SIZE)) > 0) {
+        for (long offset = 0; offset < len;) {
+            process_tree_dirent *entry = (process_tree_dirent *)(dirents + offset);
+            offset += entry->d_reclen;
+            pid_t pid = pid_of_proc_entry(entry->d_name);
+            if (pid == 0) {
+                continue;
+            }
+            if (tree->count == capacity) {
+                capacity = capacity == 0 ? 1024 : capacity * 2;
+                tree->processes = realloc(tree->processes, sizeof(tree_process) * capacity);
+                assert(tree->processes != NULL);
+            }
+            tree_process *process = &tree->processes[tree->count];
+            process->pid = pid;
+            size_t cached = previous == NULL ? 0 : process_tree_index(previous, pid);
+            bool is_cached = previous != NULL && cached != previous->count;
+            if (is_cached) {
+                *process = previous->processes[cached];
+                process->is_current = false;
+            }
+            // A process which ended since the directory was listed is left out
+            if (is_cached || read_tree_process(proc_fd, entry->d_name, process)) {
+                sorted = sorted && (tree->count == 0 || tree->processes[tree->count - 1].pid < pid);
+                tree->count++;
+            }
+        }
+    }
+    free(dirents);
+
+    // The kernel lists the processes by increasing pid, they are only sorted if it did not
+    if (!sorted) {
+        qsort(tree->processes, tree->count, sizeof(tree_process), compare_tree_processes);
+    }
+    index_process_tree_children(tree);
+    // A process which gets another parent may bring descendants which were not read again yet
+    while (refresh_process_tree_descendants(tree, proc_fd, roots, root_count)) {
+    }
+    close(proc_fd);
+    return true;
+}
+
+size_t process_tree_index(const process_tree *tree, pid_t pid) {
+    size_t low = 0;
+    size_t high = tree->count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (tree->processes[middle].pid < pid) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low < tree->count && tree->processes[low].pid == pid ? low : tree->count;
+}
+
+size_t process_tree_children(const process_tree *tree, size_t index, const size_t **children) {
+    *children = tree->children + tree->child_starts[index];
+    return tree->child_starts[index + 1] - tree->child_starts[index];
+}
+
+void free_process_tree(process_tree *tree) {
+    free(tree->processes);
+    free(tree->child_starts);
+    free(tree->children);
+    tree->processes = NULL;
+    tree->child_starts = NULL;
+    tree->children = NULL;
+    tree->count = 0;
+}
@@ -0,0 +1,57 @@
+#ifndef PROCESS_TREE_H
+#define PROCESS_TREE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#define PROCESS_TREE_NAME_SIZE 16
+/* Size of the name of a command kept by the kernel, with its null byte */
+
+#define PROCESS_TREE_DIRENTS_SIZE (1 << 16)
+/* Size of the buffer of the entries of /proc read by each getdents64 */
+
+typedef struct {
+    pid_t pid;
+    pid_t ppid;
+    char state;
+    char name[PROCESS_TREE_NAME_SIZE];
+    bool is_current;
+} tree_process;
+/*
+ * A process of the tree with its parent, its state and the name of its command, as in /proc/<pid>/stat, read by the
+ * scan of the tree if is_current is true, and taken from the previous tree otherwise
+ */
+
+typedef struct {
+    tree_process *processes;
+    size_t count;
+    size_t *child_starts;
+    size_t *children;
+} process_tree;
+/*
+ * All the processes of the system at the time it was read, sorted by pid, with the index of their children: the
+ * children of processes[i] are the processes whose indexes are children[child_starts[i]] to
+ * children[child_starts[i + 1] - 1], sorted by pid.
+ */
+
+bool read_process_tree(process_tree *tree, const process_tree *previous, const pid_t *roots, size_t root_count);
+/*
+ * Reads the processes of the system with a single scan of /proc, by getdents64, reading only the beginning of the
+ * stat file of each of them, and builds the index of their children in linear time after sorting them.
+ * The processes already in the previous tree, if it is not NULL, are not read again, except the roots and their
+ * descendants, so that the ones shown are current: a process keeps its parent until it ends, and its pid is only
+ * given to another one once the pids have wrapped around.
+ * Returns false if /proc cannot be read.
+ */
+
+size_t process_tree_index(const process_tree *tree, pid_t pid);
+/* Returns the index of the process in the tree, found by a binary search, or the count of the tree if it is not in */
+
+size_t process_tree_children(const process_tree *tree, size_t index, const size_t **children);
+/* Sets children to the indexes of the children of the process of the index, and returns their number */
+
+void free_process_tree(process_tree *tree);
+/* Frees the processes of the tree and their index */
+
+#endif
@@ -0,0 +1,440 @@
+#define _GNU_SOURCE
+#include "prompt_segments.h"
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+typedef struct {
+    char *folder;
+    char *watched_path;
+    struct timespec watched_mtime;
+    unsigned long line_epoch;
+} prompt_segment_key;
+/* What a value of a segment depends on */
+
+typedef struct {
+    const prompt_segment_definition *definition;
+    prompt_segment_key requested;
+    bool pending;
+    char *value;
+} prompt_segment;
+/* The last key requested to the worker, whether the worker still has to compute it,
+ * and the value computed for it, which is kept while the worker computes the next one */
+
+prompt_segment prompt_segments[PROMPT_SEGMENTS_MAX];
+size_t prompt_segment_count = 0;
+unsigned long prompt_segments_line_epoch = 0;
+
+pthread_mutex_t prompt_segments_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t prompt_segments_requested = PTHREAD_COND_INITIALIZER;
+pthread_t prompt_segments_worker;
+bool prompt_segments_worker_started = false;
+bool prompt_segments_stopping = false;
+bool prompt_segments_values_changed = false;
+pid_t prompt_segments_child = -1;
+int prompt_segments_event_fd = -1;
+
+// Only used by the main thread
+char prompt_segments_buffer[PROMPT_SEGMENTS_TEXT_SIZE] = "";
+unsigned long prompt_segments_text_generation = 0;
+
+char *git_branch_segment(const char *folder, const char *head_path);
+char *git_status_segment(const char *folder, const char *head_path);
+
+const prompt_segment_definition git_branch_definition = {".git/HEAD", false, git_branch_segment};
+const prompt_segment_definition git_status_definition = {".git/HEAD", true, git_status_segment};
+
+void free_prompt_segment_key(prompt_segment_key *key) {
+    free(key->folder);
+    free(key->watched_path);
+    key->folder = NULL;
+    key->watched_path = NULL;
+}
+
+bool same_optional_string(const char *a, const char *b) {
+    return (a == NULL && b == NULL) || (a != NULL && b != NULL && strcmp(a, b) == 0);
+}
+
+bool same_prompt_segment_key(const prompt_segment_key *a, const prompt_segment_key *b) {
+    return same_optional_string(a->folder, b->folder) && same_optional_string(a->watched_path, b->watched_path) &&
+           a->watched_mtime.tv_sec == b->watched_mtime.tv_sec &&
+           a->watched_mtime.tv_nsec == b->watched_mtime.tv_nsec && a->line_epoch == b->line_epoch;
+}
+
+/*
+ * Looks up the watched file from the folder to the root, returns its path or NULL if it is nowhere
+ */
+char *find_watched_file(const char *folder, const char *watched_file, struct timespec *mtime) {
+    size_t folder_len = strlen(folder);
+    size_t watched_len = strlen(watched_file);
+    char *path = malloc(folder_len + watched_len + 2);
+    assert(path != NULL);
+    memcpy(path, folder, folder_len);
+
+    while (1) {
+        path[folder_len] = '/';
+        memcpy(path + folder_len + 1, watched_file, watched_len + 1);
+        struct stat st;
+        if (stat(path, &st) == 0) {
+            *mtime = st.st_mtim;
+            return path;
+        }
+
+        while (folder_len > 0 && path[folder_len - 1] != '/') {
+            folder_len--;
+        }
+        if (folder_len == 0) {
+            free(path);
+            return NULL;
+        }
+        folder_len--; // The '/' before the last component
+    }
+}
+
+/*
+ * Rebuilds the text of the segments from their values, the lock must be held
+ */
+void render_prompt_segments_locked() {
+    size_t len = 0;
+    for (size_t i = 0; i < prompt_segment_count; i++) {
+        const char *value = prompt_segments[i].value;
+        if (value == NULL) {
+            continue;
+        }
+        size_t value_len = strlen(value);
+        if (len + value_len >= PROMPT_SEGMENTS_TEXT_SIZE) {
+            break;
+        }
+        memcpy(prompt_segments_buffer + len, value, value_len);
+        len += value_len;
+    }
+    prompt_segments_buffer[len] = '\0';
+    prompt_segments_text_generation++;
+    prompt_segments_values_changed = false;
+}
+
+/*
+ * Forgets the segments in the children of jsh, since the worker is not there and may have held the lock
+ */
+void disable_prompt_segments_in_child() {
+    prompt_segment_count = 0;
+    prompt_segments_worker_started = false;
+}
+
+/*
+ * Computes the requested values one after the other, only keeping the ones whose key is still the last requested
+ */
+void *run_prompt_segments_worker(void *arg) {
+    pthread_mutex_lock(&prompt_segments_lock);
+    while (!prompt_segments_stopping) {
+        size_t index = prompt_segment_count;
+        for (size_t i = 0; i < prompt_segment_count; i++) {
+            if (prompt_segments[i].pending) {
+                index = i;
+                break;
+            }
+        }
+        if (index == prompt_segment_count) {
+            pthread_cond_wait(&prompt_segments_requested, &prompt_segments_lock);
+            continue;
+        }
+
+        prompt_segment *segment = &prompt_segments[index];
+        segment->pending = false;
+        prompt_segment_key key = segment->requested;
+        key.folder = strdup(key.folder);
+        key.watched_path = key.watched_path == NULL ? NULL : strdup(key.watched_path);
+        assert(key.folder != NULL);
+        pthread_mutex_unlock(&prompt_segments_lock);
+
+        char *value = segment->definition->compute(key.folder, key.watched_path);
+
+        pthread_mutex_lock(&prompt_segments_lock);
+        if (same_prompt_segment_key(&key, &segment->requested) && !same_optional_string(value, segment->value)) {
+            free(segment->value);
+            segment->value = value;
+            value = NULL;
+            prompt_segments_values_changed = true;
+            uint64_t one = 1;
+            write(prompt_segments_event_fd, &one, sizeof(one));
+        }
+        free(value);
+        free_prompt_segment_key(&key);
+    }
+    pthread_mutex_unlock(&prompt_segments_lock);
+    return NULL;
+}
+
+int add_prompt_segment(const prompt_segment_definition *definition) {
+    if (prompt_segment_count == PROMPT_SEGMENTS_MAX) {
+        return -1;
+    }
+    prompt_segment *segment = &prompt_segments[prompt_segment_count];
+    segment->definition = definition;
+    segment->requested = (prompt_segment_key){NULL, NULL, {0, 0}, 0};
+    segment->pending = false;
+    segment->value = NULL;
+    return prompt_segment_count++;
+}
+
+void init_prompt_segments() {
+    const char *vcs = getenv("JSH_PROMPT_VCS");
+    if (vcs != NULL && vcs[0] != '\0') {
+        add_prompt_segment(strcmp(vcs, "branch") == 0 ? &git_branch_definition : &git_status_definition);
+    }
+    if (prompt_segment_count == 0) {
+        return;
+    }
+
+    prompt_segments_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (prompt_segments_event_fd == -1) {
+        prompt_segment_count = 0;
+        return;
+    }
+
+    // A worker stopped by free_prompt_segments may be started again
+    prompt_segments_stopping = false;
+    // The worker must not take the signals meant for the main thread, such as SIGCHLD
+    sigset_t all, previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &previous);
+    prompt_segments_worker_started =
+        pthread_create(&prompt_segments_worker, NULL, run_prompt_segments_worker, NULL) == 0;
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+    if (!prompt_segments_worker_started) {
+        close(prompt_segments_event_fd);
+        prompt_segments_event_fd = -1;
+        prompt_segment_count = 0;
+        return;
+    }
+    pthread_atfork(NULL, NULL, disable_prompt_segments_in_child);
+}
+
+bool refresh_prompt_segments(const char *folder) {
+    if (prompt_segment_count == 0) {
+        return false;
+    }
+
+    pthread_mutex_lock(&prompt_segments_lock);
+    bool requested = false;
+    for (size_t i = 0; i < prompt_segment_count; i++) {
+        prompt_segment *segment = &prompt_segments[i];
+        const prompt_segment_definition *definition = segment->definition;
+
+        prompt_segment_key key = {NULL, NULL, {0, 0}, 0};
+        key.folder = strdup(folder);
+        assert(key.folder != NULL);
+        if (definition->watched_file != NULL) {
+            key.watched_path = find_watched_file(folder, definition->watched_file, &key.watched_mtime);
+        }
+        if (definition->refresh_after_each_line) {
+            key.line_epoch = prompt_segments_line_epoch;
+        }
+
+        if (same_prompt_segment_key(&key, &segment->requested)) {
+            free_prompt_segment_key(&key);
+            continue;
+        }
+
+        // The value of another folder would be misleading, unlike a stale value of the same one
+        if (!same_optional_string(key.folder, segment->requested.folder) && segment->value != NULL) {
+            free(segment->value);
+            segment->value = NULL;
+            prompt_segments_values_changed = true;
+        }
+        free_prompt_segment_key(&segment->requested);
+        segment->requested = key;
+        segment->pending = true;
+        requested = true;
+    }
+    if (requested) {
+        pthread_cond_signal(&prompt_segments_requested);
+    }
+    pthread_mutex_unlock(&prompt_segments_lock);
+    return requested;
+}
+
+void invalidate_prompt_segments() {
+    prompt_segments_line_epoch++;
+}
+
+unsigned long prompt_segments_generation() {
+    if (prompt_segment_count == 0) {
+        return 0;
+    }
+    pthread_mutex_lock(&prompt_segments_lock);
+    if (prompt_segments_values_changed) {
+        render_prompt_segments_locked();
+    }
+    pthread_mutex_unlock(&prompt_segments_lock);
+    return prompt_segments_text_generation;
+}
+
+const char *prompt_segments_text() {
+    prompt_segments_generation();
+    return prompt_segments_buffer;
+}
+
+int prompt_segments_fd() {
+    return prompt_segments_event_fd;
+}
+
+void acknowledge_prompt_segments() {
+    uint64_t count;
+    read(prompt_segments_event_fd, &count, sizeof(count));
+}
+
+void free_prompt_segments() {
+    if (prompt_segments_worker_started) {
+        pthread_mutex_lock(&prompt_segments_lock);
+        prompt_segments_stopping = true;
+        if (prompt_segments_child != -1) {
+            kill(prompt_segments_child, SIGTERM);
+        }
+        pthread_cond_signal(&prompt_segments_requested);
+        pthread_mutex_unlock(&prompt_segments_lock);
+        pthread_join(prompt_segments_worker, NULL);
+        prompt_segments_worker_started = false;
+    }
+
+    for (size_t i = 0; i < prompt_segment_count; i++) {
+        free_prompt_segment_key(&prompt_segments[i].requested);
+        free(prompt_segments[i].value);
+    }
+    prompt_segment_count = 0;
+    if (prompt_segments_event_fd != -1) {
+        close(prompt_segments_event_fd);
+        prompt_segments_event_fd = -1;
+    }
+}
+
+/*
+ * Runs the command in its own process group, without the terminal and with the default signal handling,
+ * and returns true if it succeeds and writes something. Its output is not kept
+ */
+bool command_has_output(char *const argv[]) {
+    int output[2];
+    if (pipe2(output, O_CLOEXEC) == -1) {
+        return false;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_adddup2(&actions, output[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+    // The signals ignored by jsh would stay ignored after exec(3), and the worker blocks them all
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    sigset_t signals;
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attributes, &signals);
+    sigfillset(&signals);
+    posix_spawnattr_setsigdefault(&attributes, &signals);
+    posix_spawnattr_setpgroup(&attributes, 0);
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETPGROUP);
+
+    pid_t pid;
+    pthread_mutex_lock(&prompt_segments_lock);
+    bool spawned = !prompt_segments_stopping &&
+                   posix_spawnp(&pid, argv[0], &actions, &attributes, argv, environ) == 0;
+    if (spawned) {
+        prompt_segments_child = pid;
+    }
+    pthread_mutex_unlock(&prompt_segments_lock);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attributes);
+    close(output[1]);
+
+    bool has_output = false;
+    if (spawned) {
+        char buffer[4096];
+        ssize_t nread;
+        while ((nread = read(output[0], buffer, sizeof(buffer))) > 0) {
+            has_output = true;
+        }
+
+        int status;
+        while (waitpid(pid, &status, 0) == -1 && errno == EINTR) {
+        }
+        pthread_mutex_lock(&prompt_segments_lock);
+        prompt_segments_child = -1;
+        pthread_mutex_unlock(&prompt_segments_lock);
+        has_output = has_output && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    close(output[0]);
+    return has_output;
+}
+
+/*
+ * Returns the name of the branch of the HEAD file of a repository, or its abbreviated commit if it is detached
+ */
+char *read_git_branch(const char *head_path) {
+    int fd = open(head_path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return NULL;
+    }
+    char buffer[256];
+    ssize_t nread = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    if (nread <= 0) {
+        return NULL;
+    }
+    buffer[nread] = '\0';
+    buffer[strcspn(buffer, "\n")] = '\0';
+
+    const char *ref_prefix = "ref: refs/heads/";
+    if (strncmp(buffer, ref_prefix, strlen(ref_prefix)) == 0) {
+        return strdup(buffer + strlen(ref_prefix));
+    }
+    if (strncmp(buffer, "ref: ", 5) == 0) {
+        return strdup(buffer + 5);
+    }
+    buffer[7] = '\0';
+    return strdup(buffer);
+}
+
+char *git_segment(const char *head_path, bool dirty) {
+    char *branch = read_git_branch(head_path);
+    if (branch == NULL) {
+        return NULL;
+    }
+    size_t len = strlen(branch) + 4;
+    char *segment = malloc(len);
+    assert(segment != NULL);
+    snprintf(segment, len, "(%s%s)", branch, dirty ? "*" : "");
+    free(branch);
+    return segment;
+}
+
+char *git_branch_segment(const char *folder, const char *head_path) {
+    if (head_path == NULL) {
+        return NULL;
+    }
+    return git_segment(head_path, false);
+}
+
+char *git_status_segment(const char *folder, const char *head_path) {
+    if (head_path == NULL) {
+        return NULL;
+    }
+    // Only the tracked files, which is much faster than looking for the untracked ones in a large tree
+    char *argv[] = {"git", "--no-optional-locks", "-C", (char *)folder, "status", "--porcelain",
+                    "--untracked-files=no", NULL};
+    return git_segment(head_path, command_has_output(argv));
+}
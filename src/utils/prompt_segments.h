@@ -0,0 +1,58 @@
+#ifndef PROMPT_SEGMENTS_H
+#define PROMPT_SEGMENTS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define PROMPT_SEGMENTS_MAX 4
+/* Maximal number of segments of the prompt */
+
+#define PROMPT_SEGMENTS_TEXT_SIZE 128
+/* Size of the buffer of the text of all the segments */
+
+typedef struct {
+    const char *watched_file;
+    bool refresh_after_each_line;
+    char *(*compute)(const char *folder, const char *watched_path);
+} prompt_segment_definition;
+/*
+ * A segment of the prompt computed by a background worker, which may take a long time.
+ * Its value is cached with a key made of the current folder and the modification time of watched_file,
+ * looked up from the current folder to the root (NULL if the segment watches no file).
+ * If refresh_after_each_line is true, the value is also computed again after each command line.
+ * compute is called by the worker with the folder and the path where watched_file was found
+ * (NULL if it was not found), and returns the text of the segment allocated on the heap, or NULL
+ * if the segment has nothing to show.
+ */
+
+void init_prompt_segments();
+/* Registers the segments enabled by the environment (JSH_PROMPT_VCS for the branch and the state
+ * of the git repository), and starts the worker if there is one */
+
+int add_prompt_segment(const prompt_segment_definition *definition);
+/* Registers a segment, returns -1 if there are already PROMPT_SEGMENTS_MAX of them */
+
+bool refresh_prompt_segments(const char *folder);
+/* Asks the worker for the segments whose cache key changed, without waiting for them.
+ * Returns true if one of them was asked for */
+
+void invalidate_prompt_segments();
+/* Marks the segments refreshed after each command line as out of date */
+
+const char *prompt_segments_text();
+/* Returns the text of the segments, which may be stale while the worker computes the fresh values */
+
+unsigned long prompt_segments_generation();
+/* Returns a number which changes each time the text of the segments changes */
+
+int prompt_segments_fd();
+/* Returns a descriptor which is readable when fresh values arrive, -1 if there is no segment.
+ * It is emptied by acknowledge_prompt_segments */
+
+void acknowledge_prompt_segments();
+/* Empties the descriptor of prompt_segments_fd */
+
+void free_prompt_segments();
+/* Stops the worker and frees the segments */
+
+#endif
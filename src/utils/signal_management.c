@@ -1,7 +1,26 @@
 #include "signal_management.h"
+#include "flight_recorder.h"
 #include <assert.h>
+#include <pthread.h>
 #include <signal.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/signalfd.h>
+
+volatile sig_atomic_t interrupted = 0;
+
+typedef struct {
+    const char *name;
+    int number;
+} signal_name;
+
+const signal_name signal_names[] = {
+    {"HUP", SIGHUP},       {"INT", SIGINT},   {"QUIT", SIGQUIT}, {"ILL", SIGILL},   {"TRAP", SIGTRAP},
+    {"ABRT", SIGABRT},     {"BUS", SIGBUS},   {"FPE", SIGFPE},   {"KILL", SIGKILL}, {"USR1", SIGUSR1},
+    {"SEGV", SIGSEGV},     {"USR2", SIGUSR2}, {"PIPE", SIGPIPE}, {"ALRM", SIGALRM}, {"TERM", SIGTERM},
+    {"CHLD", SIGCHLD},     {"CONT", SIGCONT}, {"STOP", SIGSTOP}, {"TSTP", SIGTSTP}, {"TTIN", SIGTTIN},
+    {"TTOU", SIGTTOU},     {"URG", SIGURG},   {"XCPU", SIGXCPU}, {"XFSZ", SIGXFSZ}, {"VTALRM", SIGVTALRM},
+    {"PROF", SIGPROF},     {"WINCH", SIGWINCH}, {"IO", SIGIO},   {"SYS", SIGSYS},   {NULL, 0}};
 
 void use_jsh_signal_management() {
     struct sigaction sigac_ignore;
@@ -32,3 +51,73 @@ void reset_signal_management() {
     assert(sigaction(SIGTTOU, &sigac_reset, NULL) >= 0);
     assert(sigaction(SIGTSTP, &sigac_reset, NULL) >= 0);
 }
+
+void set_interrupted(int signal) {
+    interrupted = 1;
+    record_flight_event(FLIGHT_SIGNAL_RECEIVED, 0, signal, NULL);
+}
+
+void catch_interrupts() {
+    struct sigaction sigac_interrupt;
+    sigac_interrupt.sa_handler = set_interrupted;
+    sigac_interrupt.sa_flags = SA_RESTART;
+
+    assert(sigemptyset(&sigac_interrupt.sa_mask) >= 0);
+    assert(sigaction(SIGINT, &sigac_interrupt, NULL) >= 0);
+    interrupted = 0;
+}
+
+void ignore_interrupts() {
+    struct sigaction sigac_ignore;
+    sigac_ignore.sa_handler = SIG_IGN;
+    sigac_ignore.sa_flags = 0;
+
+    assert(sigemptyset(&sigac_ignore.sa_mask) >= 0);
+    assert(sigaction(SIGINT, &sigac_ignore, NULL) >= 0);
+    interrupted = 0;
+}
+
+int signal_of_name(const char *name) {
+    if (name[0] >= '0' && name[0] <= '9') {
+        char *end;
+        long number = strtol(name, &end, 10);
+        return *end == '\0' && number > 0 && number < NSIG ? number : -1;
+    }
+    if (strncmp(name, "SIG", 3) == 0) {
+        name += 3;
+    }
+    for (size_t i = 0; signal_names[i].name != NULL; i++) {
+        if (strcmp(signal_names[i].name, name) == 0) {
+            return signal_names[i].number;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Unblocks SIGCHLD in a child, since the signal mask is kept by execvp
+ */
+void unblock_child_signal() {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigprocmask(SIG_UNBLOCK, &mask, NULL);
+}
+
+int open_child_signal_fd() {
+    sigset_t mask;
+    assert(sigemptyset(&mask) >= 0);
+    assert(sigaddset(&mask, SIGCHLD) >= 0);
+
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) == -1) {
+        return -1;
+    }
+    int fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd == -1) {
+        sigprocmask(SIG_UNBLOCK, &mask, NULL);
+        return -1;
+    }
+
+    pthread_atfork(NULL, NULL, unblock_child_signal);
+    return fd;
+}
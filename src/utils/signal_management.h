@@ -1,6 +1,10 @@
 #ifndef SIGNAL_MANAGEMENT_H
 #define SIGNAL_MANAGEMENT_H
 
+#include <signal.h>
+
+extern volatile sig_atomic_t interrupted; // set by SIGINT while interrupts are caught
+
 void use_jsh_signal_management();
 /* jsh ignores SIGINT, SIGTERM, SIGTTIN, SIGQUIT,
 SIGTTOU and SIGTSTP signals */
@@ -9,4 +13,18 @@ void reset_signal_management();
 /* Reset SIGINT, SIGTERM, SIGTTIN, SIGQUIT,
 SIGTTOU and SIGTSTP signals, which were previously ignored */
 
+void catch_interrupts();
+/* Sets interrupted on SIGINT instead of ignoring it, so that a loop run by jsh itself can be interrupted */
+
+void ignore_interrupts();
+/* Ignores SIGINT again and clears interrupted */
+
+int signal_of_name(const char *name);
+/* Returns the number of the signal named with or without its `SIG` prefix, such as `TERM` or `SIGKILL`, or given
+ * by its number, or -1 if there is no such signal */
+
+int open_child_signal_fd();
+/* Blocks SIGCHLD and returns a non-blocking signalfd from which it can be read instead,
+ * or -1 on failure. The processes forked afterwards get SIGCHLD unblocked again */
+
 #endif
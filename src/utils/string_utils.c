@@ -1,6 +1,7 @@
 #include <assert.h>
 #include <ctype.h>
 #include <errno.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -158,4 +159,210 @@ bool has_sequence_of_with_exception(const char *str, char c, char c_exception) {
     }
 
     return false;
-}
\ No newline at end of file
+}
+
+bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\n';
+}
+
+size_t strip_trailing_newlines(const char *buffer, size_t len) {
+    while (len > 0 && buffer[len - 1] == '\n') {
+        len--;
+    }
+    return len;
+}
+
+size_t count_fields(const char *buffer, size_t len) {
+    size_t count = 0;
+    bool in_field = false;
+
+    for (size_t i = 0; i < len; i++) {
+        if (is_blank(buffer[i])) {
+            in_field = false;
+        } else if (!in_field) {
+            in_field = true;
+            count++;
+        }
+    }
+    return count;
+}
+
+size_t split_fields(char *buffer, size_t len, char **fields, size_t max_fields) {
+    size_t count = 0;
+    bool in_field = false;
+
+    for (size_t i = 0; i < len; i++) {
+        if (is_blank(buffer[i])) {
+            buffer[i] = '\0';
+            in_field = false;
+        } else if (!in_field) {
+            in_field = true;
+            if (count == max_fields) {
+                break;
+            }
+            fields[count++] = buffer + i;
+        }
+    }
+    buffer[len] = '\0';
+    return count;
+}
+/*
+ * Sorts the strings sharing their first depth bytes with an insertion sort
+ */
+void insertion_sort_strings(char **strings, size_t count, size_t depth) {
+    for (size_t i = 1; i < count; i++) {
+        char *current = strings[i];
+        size_t j = i;
+        while (j > 0 && strcmp(strings[j - 1] + depth, current + depth) > 0) {
+            strings[j] = strings[j - 1];
+            j--;
+        }
+        strings[j] = current;
+    }
+}
+
+/*
+ * Sorts the strings sharing their first depth bytes by distributing them on their byte at depth,
+ * then sorting each bucket on the following bytes. tmp has room for count strings.
+ */
+void msd_radix_sort_strings(char **strings, size_t count, size_t depth, char **tmp) {
+    while (count >= RADIX_SORT_THRESHOLD) {
+        size_t counts[UCHAR_MAX + 1] = {0};
+        for (size_t i = 0; i < count; i++) {
+            counts[(unsigned char)strings[i][depth]]++;
+        }
+
+        // Strings ending at depth are equal, and a single bucket needs no distribution
+        if (counts[0] == count) {
+            return;
+        }
+        if (counts[(unsigned char)strings[0][depth]] == count) {
+            depth++;
+            continue;
+        }
+
+        size_t starts[UCHAR_MAX + 1];
+        size_t position = 0;
+        for (size_t b = 0; b <= UCHAR_MAX; b++) {
+            starts[b] = position;
+            position += counts[b];
+        }
+        for (size_t i = 0; i < count; i++) {
+            tmp[starts[(unsigned char)strings[i][depth]]++] = strings[i];
+        }
+        memcpy(strings, tmp, sizeof(char *) * count);
+
+        position = counts[0];
+        for (size_t b = 1; b <= UCHAR_MAX; b++) {
+            if (counts[b] > 1) {
+                msd_radix_sort_strings(strings + position, counts[b], depth + 1, tmp);
+            }
+            position += counts[b];
+        }
+        return;
+    }
+    insertion_sort_strings(strings, count, depth);
+}
+
+void radix_sort_strings(char **strings, size_t count) {
+    if (count < 2) {
+        return;
+    }
+    char **tmp = malloc(sizeof(char *) * count);
+    assert(tmp != NULL);
+    msd_radix_sort_strings(strings, count, 0, tmp);
+    free(tmp);
+}
+
+/*
+ * Decodes the UTF-8 character of the given length, returns false if it is not a valid encoding
+ */
+bool decode_utf8_character(const char *str, size_t len, uint32_t *codepoint) {
+    unsigned char lead = str[0];
+    size_t expected_len = 0;
+    if (lead < 0x80) {
+        expected_len = 1;
+    } else if ((lead & 0xE0) == 0xC0) {
+        expected_len = 2;
+    } else if ((lead & 0xF0) == 0xE0) {
+        expected_len = 3;
+    } else if ((lead & 0xF8) == 0xF0) {
+        expected_len = 4;
+    }
+    if (expected_len != len) {
+        return false;
+    }
+
+    *codepoint = len == 1 ? lead : lead & (0x7F >> len);
+    for (size_t i = 1; i < len; i++) {
+        if (((unsigned char)str[i] & 0xC0) != 0x80) {
+            return false;
+        }
+        *codepoint = (*codepoint << 6) | ((unsigned char)str[i] & 0x3F);
+    }
+    return true;
+}
+
+int codepoint_display_width(uint32_t codepoint) {
+    // Combining marks and zero width characters
+    if ((codepoint >= 0x0300 && codepoint <= 0x036F) || (codepoint >= 0x200B && codepoint <= 0x200F) ||
+        (codepoint >= 0x20D0 && codepoint <= 0x20FF) || (codepoint >= 0xFE00 && codepoint <= 0xFE0F) ||
+        (codepoint >= 0xFE20 && codepoint <= 0xFE2F)) {
+        return 0;
+    }
+    // East Asian wide and fullwidth characters, and emojis
+    if ((codepoint >= 0x1100 && codepoint <= 0x115F) || (codepoint >= 0x2E80 && codepoint <= 0x303E) ||
+        (codepoint >= 0x3041 && codepoint <= 0xA4CF) || (codepoint >= 0xAC00 && codepoint <= 0xD7A3) ||
+        (codepoint >= 0xF900 && codepoint <= 0xFAFF) || (codepoint >= 0xFE30 && codepoint <= 0xFE4F) ||
+        (codepoint >= 0xFF00 && codepoint <= 0xFF60) || (codepoint >= 0xFFE0 && codepoint <= 0xFFE6) ||
+        (codepoint >= 0x1F300 && codepoint <= 0x1F64F) || (codepoint >= 0x1F900 && codepoint <= 0x1F9FF) ||
+        (codepoint >= 0x20000 && codepoint <= 0x3FFFD)) {
+        return 2;
+    }
+    return 1;
+}
+
+/*
+ * Returns the position of the character ending at end and its display width,
+ * an invalid byte being a character of its own displayed on one column
+ */
+size_t previous_utf8_character(const char *str, size_t end, int *width) {
+    size_t start = end - 1;
+    while (start > 0 && end - start < 4 && ((unsigned char)str[start] & 0xC0) == 0x80) {
+        start--;
+    }
+
+    uint32_t codepoint;
+    if (!decode_utf8_character(str + start, end - start, &codepoint)) {
+        *width = 1;
+        return end - 1;
+    }
+    *width = codepoint_display_width(codepoint);
+    return start;
+}
+
+size_t utf8_display_width(const char *str) {
+    size_t width = 0;
+    size_t position = strlen(str);
+    while (position > 0) {
+        int character_width;
+        position = previous_utf8_character(str, position, &character_width);
+        width += character_width;
+    }
+    return width;
+}
+
+const char *suffix_of_display_width(const char *str, size_t len, size_t max_width) {
+    size_t width = 0;
+    size_t position = len;
+    while (position > 0) {
+        int character_width;
+        size_t start = previous_utf8_character(str, position, &character_width);
+        if (width + character_width > max_width) {
+            break;
+        }
+        width += character_width;
+        position = start;
+    }
+    return str + position;
+}
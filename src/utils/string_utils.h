@@ -2,6 +2,8 @@
 #define STRING_UTILS_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 bool start_with(const char *, const char *);
 /* Returns true if the first string begins with
@@ -24,6 +26,35 @@ bool is_integer(const char *);
 bool has_sequence_of(const char *, char);
 /* Returns true if the char * argument contains a sequence of the given char */
 
+size_t strip_trailing_newlines(const char *, size_t);
+/* Returns the length of the buffer of the given length once its trailing newlines are removed */
+
+size_t count_fields(const char *, size_t);
+/* Returns the number of fields separated by blanks (spaces, tabs and newlines) in the buffer of the given length */
+
+size_t split_fields(char *, size_t, char **, size_t);
+/* Splits the buffer of the given length in place on blanks, storing at most the given number of fields in the array
+ * (pointers inside the buffer, terminated by '\0'), and returns the number of fields stored.
+ * The buffer must have room for one more byte than its length. */
+
+#define RADIX_SORT_THRESHOLD 32
+/* Number of strings under which radix_sort_strings switches to an insertion sort */
+
+void radix_sort_strings(char **, size_t);
+/* Sorts the array of the given number of strings in byte order (the order of strcmp),
+ * with a most significant digit radix sort */
+
+int codepoint_display_width(uint32_t);
+/* Returns the number of columns a character is displayed on in a terminal:
+ * 0 for combining marks, 2 for wide characters (CJK, emojis) and 1 otherwise */
+
+size_t utf8_display_width(const char *);
+/* Returns the number of columns the UTF-8 string is displayed on, an invalid byte taking one column */
+
+const char *suffix_of_display_width(const char *, size_t, size_t);
+/* Returns the start of the longest suffix of the UTF-8 string of the given length which is displayed on
+ * at most the given number of columns, without cutting a character */
+
 bool has_sequence_of_with_exception(const char *, char, char);
 /* Returns true if the char * argument contains a sequence of the given char, not
  * including the character exception */
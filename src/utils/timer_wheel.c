@@ -0,0 +1,283 @@
+#include "timer_wheel.h"
+#include "flight_recorder.h"
+#include <assert.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NO_DEADLINE SIZE_MAX
+
+typedef struct {
+    unsigned long id;
+    pid_t target;
+    bool is_group;
+    int signal;
+    bool expired;
+    size_t slot;
+    size_t rounds;
+    size_t next;
+} deadline;
+/*
+ * A deadline of the wheel, free if its id is 0. Until it expires, it is in the list of its slot, which the wheel
+ * passes rounds more times before it expires.
+ */
+
+deadline *deadlines = NULL;
+size_t deadline_capacity = 0;
+size_t pending_deadline_count = 0;
+unsigned long last_deadline_id = 0;
+
+size_t timer_wheel_slots[TIMER_WHEEL_SLOTS];
+uint64_t timer_wheel_tick = 0;
+/* First deadline of the list of each slot, and last tick whose slot was passed */
+
+int timer_wheel_fd = -1;
+bool timer_wheel_started = false;
+bool timer_wheel_stopping = false;
+bool timer_wheel_fork_handlers_added = false;
+pthread_t timer_wheel_thread;
+pthread_mutex_t timer_wheel_lock = PTHREAD_MUTEX_INITIALIZER;
+
+uint64_t current_timer_wheel_time_ms() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/*
+ * Arms the timer for the next tick whose slot has a deadline expiring, one turn of the wheel later at most so that
+ * the rounds of the others are counted, or disarms it if there is no deadline
+ */
+void arm_timer_wheel() {
+    struct itimerspec timer;
+    memset(&timer, 0, sizeof(timer));
+    if (pending_deadline_count > 0) {
+        uint64_t next_tick = timer_wheel_tick + TIMER_WHEEL_SLOTS;
+        for (uint64_t tick = timer_wheel_tick + 1; tick < timer_wheel_tick + TIMER_WHEEL_SLOTS; tick++) {
+            size_t i = timer_wheel_slots[tick % TIMER_WHEEL_SLOTS];
+            while (i != NO_DEADLINE && deadlines[i].rounds > 0) {
+                i = deadlines[i].next;
+            }
+            if (i != NO_DEADLINE) {
+                next_tick = tick;
+                break;
+            }
+        }
+        uint64_t next_ms = next_tick * TIMER_WHEEL_TICK_MS;
+        timer.it_value.tv_sec = next_ms / 1000;
+        timer.it_value.tv_nsec = (next_ms % 1000) * 1000000;
+    }
+    timerfd_settime(timer_wheel_fd, TFD_TIMER_ABSTIME, &timer, NULL);
+}
+
+void expire_deadline(deadline *d) {
+    d->expired = true;
+    pending_deadline_count--;
+    record_flight_event(FLIGHT_SIGNAL_SENT, d->is_group ? -d->target : d->target, d->signal, "timeout");
+    // A process which ran its command before jsh put it in its group is alone in the group of jsh
+    if (d->is_group && killpg(d->target, d->signal) == 0) {
+        killpg(d->target, SIGCONT);
+    } else {
+        kill(d->target, d->signal);
+        kill(d->target, SIGCONT);
+    }
+}
+
+/* Passes the slots of the ticks up to the given one, expiring their deadlines whose last round it is */
+void turn_timer_wheel(uint64_t tick) {
+    for (; timer_wheel_tick < tick && pending_deadline_count > 0; timer_wheel_tick++) {
+        size_t *link = &timer_wheel_slots[(timer_wheel_tick + 1) % TIMER_WHEEL_SLOTS];
+        while (*link != NO_DEADLINE) {
+            deadline *d = &deadlines[*link];
+            if (d->rounds > 0) {
+                d->rounds--;
+                link = &d->next;
+            } else {
+                *link = d->next;
+                expire_deadline(d);
+            }
+        }
+    }
+    // The wheel does not need to turn while it has no deadline
+    timer_wheel_tick = tick;
+}
+
+void *run_timer_wheel(void *arg) {
+    while (true) {
+        uint64_t expirations;
+        read(timer_wheel_fd, &expirations, sizeof(expirations));
+
+        pthread_mutex_lock(&timer_wheel_lock);
+        if (timer_wheel_stopping) {
+            pthread_mutex_unlock(&timer_wheel_lock);
+            return NULL;
+        }
+        turn_timer_wheel(current_timer_wheel_time_ms() / TIMER_WHEEL_TICK_MS);
+        arm_timer_wheel();
+        pthread_mutex_unlock(&timer_wheel_lock);
+    }
+}
+
+/* The lock is held across a fork, so that a child never gets it held by the thread of the wheel */
+void lock_timer_wheel_before_fork() {
+    pthread_mutex_lock(&timer_wheel_lock);
+}
+
+void unlock_timer_wheel_after_fork() {
+    pthread_mutex_unlock(&timer_wheel_lock);
+}
+
+/*
+ * Forgets the deadlines in the children of jsh, since the thread is not there and the timer is shared with jsh
+ */
+void reset_timer_wheel_in_child() {
+    if (timer_wheel_fd != -1) {
+        close(timer_wheel_fd);
+        timer_wheel_fd = -1;
+    }
+    timer_wheel_started = false;
+    pending_deadline_count = 0;
+    for (size_t i = 0; i < deadline_capacity; i++) {
+        deadlines[i].id = 0;
+    }
+    pthread_mutex_unlock(&timer_wheel_lock);
+}
+
+bool start_timer_wheel() {
+    timer_wheel_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (timer_wheel_fd == -1) {
+        return false;
+    }
+    for (size_t i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+        timer_wheel_slots[i] = NO_DEADLINE;
+    }
+    timer_wheel_stopping = false;
+
+    // The thread must not take the signals meant for the main thread, such as SIGCHLD
+    sigset_t all, previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &previous);
+    timer_wheel_started = pthread_create(&timer_wheel_thread, NULL, run_timer_wheel, NULL) == 0;
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+    if (!timer_wheel_started) {
+        close(timer_wheel_fd);
+        timer_wheel_fd = -1;
+        return false;
+    }
+    if (!timer_wheel_fork_handlers_added) {
+        pthread_atfork(lock_timer_wheel_before_fork, unlock_timer_wheel_after_fork, reset_timer_wheel_in_child);
+        timer_wheel_fork_handlers_added = true;
+    }
+    return true;
+}
+
+deadline *find_deadline(unsigned long id) {
+    for (size_t i = 0; i < deadline_capacity && id != 0; i++) {
+        if (deadlines[i].id == id) {
+            return &deadlines[i];
+        }
+    }
+    return NULL;
+}
+
+unsigned long add_deadline(unsigned long delay_ms, pid_t target, bool is_group, int signal) {
+    pthread_mutex_lock(&timer_wheel_lock);
+    if (!timer_wheel_started && !start_timer_wheel()) {
+        pthread_mutex_unlock(&timer_wheel_lock);
+        return 0;
+    }
+
+    size_t index = 0;
+    while (index < deadline_capacity && deadlines[index].id != 0) {
+        index++;
+    }
+    if (index == deadline_capacity) {
+        deadline_capacity = deadline_capacity == 0 ? 8 : deadline_capacity * 2;
+        deadlines = realloc(deadlines, sizeof(deadline) * deadline_capacity);
+        assert(deadlines != NULL);
+        for (size_t i = index; i < deadline_capacity; i++) {
+            deadlines[i].id = 0;
+        }
+    }
+
+    uint64_t now_ms = current_timer_wheel_time_ms();
+    if (pending_deadline_count == 0) {
+        timer_wheel_tick = now_ms / TIMER_WHEEL_TICK_MS;
+    }
+    // The deadline expires at the first tick after it, never before
+    uint64_t expiry_tick = (now_ms + delay_ms + TIMER_WHEEL_TICK_MS - 1) / TIMER_WHEEL_TICK_MS;
+    if (expiry_tick <= timer_wheel_tick) {
+        expiry_tick = timer_wheel_tick + 1;
+    }
+
+    deadline *d = &deadlines[index];
+    d->id = ++last_deadline_id;
+    d->target = target;
+    d->is_group = is_group;
+    d->signal = signal;
+    d->expired = false;
+    d->slot = expiry_tick % TIMER_WHEEL_SLOTS;
+    d->rounds = (expiry_tick - timer_wheel_tick - 1) / TIMER_WHEEL_SLOTS;
+    d->next = timer_wheel_slots[d->slot];
+    timer_wheel_slots[d->slot] = index;
+    pending_deadline_count++;
+
+    arm_timer_wheel();
+    unsigned long id = d->id;
+    pthread_mutex_unlock(&timer_wheel_lock);
+    return id;
+}
+
+bool has_deadline_expired(unsigned long id) {
+    pthread_mutex_lock(&timer_wheel_lock);
+    deadline *d = find_deadline(id);
+    bool expired = d != NULL && d->expired;
+    pthread_mutex_unlock(&timer_wheel_lock);
+    return expired;
+}
+
+void cancel_deadline(unsigned long id) {
+    pthread_mutex_lock(&timer_wheel_lock);
+    deadline *d = find_deadline(id);
+    if (d != NULL) {
+        if (!d->expired) {
+            size_t *link = &timer_wheel_slots[d->slot];
+            while (&deadlines[*link] != d) {
+                link = &deadlines[*link].next;
+            }
+            *link = d->next;
+            pending_deadline_count--;
+            arm_timer_wheel();
+        }
+        d->id = 0;
+    }
+    pthread_mutex_unlock(&timer_wheel_lock);
+}
+
+void free_timer_wheel() {
+    if (timer_wheel_started) {
+        // The timer wakes the thread up at once to let it see that it stops
+        pthread_mutex_lock(&timer_wheel_lock);
+        timer_wheel_stopping = true;
+        struct itimerspec timer;
+        memset(&timer, 0, sizeof(timer));
+        timer.it_value.tv_nsec = 1;
+        timerfd_settime(timer_wheel_fd, 0, &timer, NULL);
+        pthread_mutex_unlock(&timer_wheel_lock);
+        pthread_join(timer_wheel_thread, NULL);
+
+        close(timer_wheel_fd);
+        timer_wheel_fd = -1;
+        timer_wheel_started = false;
+    }
+    free(deadlines);
+    deadlines = NULL;
+    deadline_capacity = 0;
+    pending_deadline_count = 0;
+}
@@ -0,0 +1,29 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+#define TIMER_WHEEL_SLOTS 512
+#define TIMER_WHEEL_TICK_MS 10
+/* Number of slots of the wheel of the deadlines and time each of them stands for, the wheel turning every 5.12s */
+
+unsigned long add_deadline(unsigned long delay_ms, pid_t target, bool is_group, int signal);
+/*
+ * Sends the signal to the process group target, or to the process target if is_group is false, once the delay has
+ * elapsed, followed by SIGCONT so that a stopped job gets it too. Returns the identifier of the deadline, or 0 if
+ * it cannot be enforced.
+ * The deadlines are kept in the slots of a hashed timing wheel turned by a thread of its own, blocked on a timerfd
+ * armed for the next slot where a deadline expires, or one turn later at most: nothing runs while none is near.
+ */
+
+bool has_deadline_expired(unsigned long id);
+/* Returns true if the signal of the deadline has been sent */
+
+void cancel_deadline(unsigned long id);
+/* Forgets the deadline, whose signal is no longer sent if it has not expired yet */
+
+void free_timer_wheel();
+/* Stops the thread of the wheel and frees the deadlines */
+
+#endif
@@ -0,0 +1,311 @@
+#include "variables.h"
+#include "arithmetic.h"
+#include "core.h"
+#include <assert.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    char *name;
+    char *value;
+} variable;
+
+// Open addressing table with linear probing, variables are never removed
+variable *variables = NULL;
+size_t variable_capacity = 0;
+size_t variable_count = 0;
+
+typedef struct positional_parameters {
+    size_t count;
+    char *const *values;
+    struct positional_parameters *caller;
+} positional_parameters;
+
+// The parameters of the function being run, on the stack of the call
+positional_parameters *current_parameters = NULL;
+
+bool expansion_failed = false;
+int substitution_exit_value = -1;
+
+uint64_t hash_of_name(const char *name, size_t len) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+/*
+ * Returns the slot of the variable in the table, or the empty slot where it would be inserted
+ */
+variable *slot_of_variable(const char *name, size_t len) {
+    size_t i = hash_of_name(name, len) & (variable_capacity - 1);
+    while (variables[i].name != NULL &&
+           (strncmp(variables[i].name, name, len) != 0 || variables[i].name[len] != '\0')) {
+        i = (i + 1) & (variable_capacity - 1);
+    }
+    return &variables[i];
+}
+
+void grow_variables() {
+    variable *old = variables;
+    size_t old_capacity = variable_capacity;
+    variable_capacity = old_capacity == 0 ? VARIABLES_INITIAL_CAPACITY : old_capacity * 2;
+    variables = calloc(variable_capacity, sizeof(variable));
+    assert(variables != NULL);
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old[i].name != NULL) {
+            *slot_of_variable(old[i].name, strlen(old[i].name)) = old[i];
+        }
+    }
+    free(old);
+}
+
+bool is_variable_name(const char *name, size_t len) {
+    if (len == 0 || !(isalpha((unsigned char)name[0]) || name[0] == '_')) {
+        return false;
+    }
+    for (size_t i = 1; i < len; i++) {
+        if (!(isalnum((unsigned char)name[i]) || name[i] == '_')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool is_assignment(const char *word) {
+    const char *equal = strchr(word, '=');
+    return equal != NULL && is_variable_name(word, equal - word);
+}
+
+const char *get_variable(const char *name, size_t len) {
+    if (variable_count > 0) {
+        variable *slot = slot_of_variable(name, len);
+        if (slot->name != NULL) {
+            return slot->value;
+        }
+    }
+
+    char buffer[VARIABLE_NAME_SIZE];
+    char *copy = len < VARIABLE_NAME_SIZE ? buffer : malloc(len + 1);
+    assert(copy != NULL);
+    memcpy(copy, name, len);
+    copy[len] = '\0';
+    const char *value = getenv(copy);
+    if (copy != buffer) {
+        free(copy);
+    }
+    return value;
+}
+
+void set_variable(const char *name, const char *value) {
+    size_t len = strlen(name);
+    if (variable_capacity == 0) {
+        grow_variables();
+    }
+    variable *slot = slot_of_variable(name, len);
+    if (slot->name == NULL && getenv(name) != NULL) {
+        setenv(name, value, 1);
+        return;
+    }
+
+    char *copy = strdup(value);
+    assert(copy != NULL);
+    if (slot->name != NULL) {
+        free(slot->value);
+        slot->value = copy;
+        return;
+    }
+    slot->name = strdup(name);
+    assert(slot->name != NULL);
+    slot->value = copy;
+    variable_count++;
+    if (variable_count * 2 > variable_capacity) {
+        grow_variables();
+    }
+}
+
+void push_positional_parameters(size_t count, char *const *parameters) {
+    positional_parameters *frame = malloc(sizeof(positional_parameters));
+    assert(frame != NULL);
+    frame->count = count;
+    frame->values = parameters;
+    frame->caller = current_parameters;
+    current_parameters = frame;
+}
+
+void pop_positional_parameters() {
+    assert(current_parameters != NULL);
+    positional_parameters *frame = current_parameters;
+    current_parameters = frame->caller;
+    free(frame);
+}
+
+size_t positional_parameter_count() {
+    return current_parameters == NULL ? 0 : current_parameters->count;
+}
+
+const char *positional_parameter(size_t i) {
+    return i == 0 || i > positional_parameter_count() ? NULL : current_parameters->values[i - 1];
+}
+
+/*
+ * Appends len characters to the buffer of the given capacity, which grows as needed
+ */
+void append_to_expansion(char **buffer, size_t *size, size_t *capacity, const char *s, size_t len) {
+    if (*size + len + 1 > *capacity) {
+        while (*size + len + 1 > *capacity) {
+            *capacity *= 2;
+        }
+        *buffer = realloc(*buffer, *capacity);
+        assert(*buffer != NULL);
+    }
+    memcpy(*buffer + *size, s, len);
+    *size += len;
+}
+
+/*
+ * Returns the length of the expression of the arithmetic expansion whose `$((` ends before start, up to its `))`,
+ * or -1 if its parentheses do not end with `))`
+ */
+ptrdiff_t arithmetic_expression_length(const char *start) {
+    size_t depth = 0;
+    for (const char *p = start; *p != '\0'; p++) {
+        if (*p == '(') {
+            depth++;
+        } else if (*p == ')' && depth > 0) {
+            depth--;
+        } else if (*p == ')') {
+            return p[1] == ')' ? p - start : -1;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Appends the value of the arithmetic expression of the given length, whose variables `$name` are expanded first
+ */
+void append_arithmetic_expansion(char **buffer, size_t *size, size_t *capacity, const char *expression, size_t len) {
+    char *expanded = NULL;
+    if (memchr(expression, '$', len) != NULL) {
+        char *copy = strndup(expression, len);
+        assert(copy != NULL);
+        expanded = expand_variables(copy);
+        free(copy);
+        expression = expanded;
+        len = strlen(expanded);
+    }
+    long long value;
+    if (evaluate_arithmetic(expression, len, &value)) {
+        char digits[ARITHMETIC_RESULT_SIZE];
+        int digits_len = snprintf(digits, sizeof(digits), "%lld", value);
+        append_to_expansion(buffer, size, capacity, digits, digits_len);
+    } else {
+        expansion_failed = true;
+    }
+    free(expanded);
+}
+
+char *expand_variables(const char *word) {
+    size_t capacity = strlen(word) + 1;
+    size_t size = 0;
+    char *result = malloc(capacity);
+    assert(result != NULL);
+
+    for (const char *p = word; *p != '\0';) {
+        const char *dollar = strchr(p, '$');
+        if (dollar == NULL) {
+            append_to_expansion(&result, &size, &capacity, p, strlen(p));
+            break;
+        }
+        append_to_expansion(&result, &size, &capacity, p, dollar - p);
+
+        const char *name = dollar + 1;
+        size_t len = 0;
+        const char *next = name;
+        if (*name == '?') {
+            char status[16];
+            int status_len = snprintf(status, sizeof(status), "%d", last_command_exit_value);
+            append_to_expansion(&result, &size, &capacity, status, status_len);
+            p = name + 1;
+            continue;
+        }
+        if (name[0] == '(' && name[1] == '(') {
+            ptrdiff_t len = arithmetic_expression_length(name + 2);
+            if (len >= 0) {
+                append_arithmetic_expansion(&result, &size, &capacity, name + 2, len);
+                p = name + 2 + len + 2;
+                continue;
+            }
+        }
+        if (*name == '#') {
+            char count[24];
+            int count_len = snprintf(count, sizeof(count), "%zu", positional_parameter_count());
+            append_to_expansion(&result, &size, &capacity, count, count_len);
+            p = name + 1;
+            continue;
+        }
+        if (*name == '@' || *name == '*') {
+            for (size_t i = 1; i <= positional_parameter_count(); i++) {
+                if (i > 1) {
+                    append_to_expansion(&result, &size, &capacity, " ", 1);
+                }
+                append_to_expansion(&result, &size, &capacity, positional_parameter(i), strlen(positional_parameter(i)));
+            }
+            p = name + 1;
+            continue;
+        }
+        if (isdigit((unsigned char)*name) && *name != '0') {
+            const char *parameter = positional_parameter(*name - '0');
+            if (parameter != NULL) {
+                append_to_expansion(&result, &size, &capacity, parameter, strlen(parameter));
+            }
+            p = name + 1;
+            continue;
+        }
+        if (*name == '{') {
+            const char *closing = strchr(name, '}');
+            if (closing != NULL && is_variable_name(name + 1, closing - name - 1)) {
+                len = closing - name - 1;
+                next = closing + 1;
+                name++;
+            }
+        } else {
+            while (isalnum((unsigned char)name[len]) || name[len] == '_') {
+                len++;
+            }
+            if (!is_variable_name(name, len)) {
+                len = 0;
+            }
+            next = name + len;
+        }
+
+        if (len == 0) {
+            append_to_expansion(&result, &size, &capacity, "$", 1);
+            p = dollar + 1;
+            continue;
+        }
+        const char *value = get_variable(name, len);
+        if (value != NULL) {
+            append_to_expansion(&result, &size, &capacity, value, strlen(value));
+        }
+        p = next;
+    }
+
+    result[size] = '\0';
+    return result;
+}
+
+void free_variables() {
+    for (size_t i = 0; i < variable_capacity; i++) {
+        free(variables[i].name);
+        free(variables[i].value);
+    }
+    free(variables);
+    variables = NULL;
+    variable_capacity = 0;
+    variable_count = 0;
+}
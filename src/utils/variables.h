@@ -0,0 +1,60 @@
+#ifndef VARIABLES_H
+#define VARIABLES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define VARIABLES_INITIAL_CAPACITY 64
+/* Number of slots of the table of the variables at first, doubled once it is half full */
+
+extern bool expansion_failed; // set when an expansion is invalid, such as a division by zero
+extern int substitution_exit_value; // status of the last command substitution of a command, -1 if it has none
+
+#define VARIABLE_NAME_SIZE 256
+/* Size of the buffer a name is copied to when it is looked up in the environment, longer names being allocated */
+
+uint64_t hash_of_name(const char *name, size_t len);
+/* Returns the FNV-1a hash of the first len characters of the name, for the tables of names of jsh */
+
+bool is_variable_name(const char *name, size_t len);
+/* Returns true if the first len characters are a name of variable: a letter or `_` followed by letters, digits
+ * and `_` */
+
+bool is_assignment(const char *word);
+/* Returns true if the word is an assignment `name=value` */
+
+const char *get_variable(const char *name, size_t len);
+/*
+ * Returns the value of the variable named by the first len characters of name, the variables of jsh being looked
+ * up before the environment, or NULL if it is not set. The value stays valid until the variable is set again.
+ */
+
+void set_variable(const char *name, const char *value);
+/* Sets the variable to a copy of the value. A variable of the environment is changed in the environment, so that
+ * the commands run see its new value, such as PATH */
+
+void push_positional_parameters(size_t count, char *const *parameters);
+/* Makes the arguments of a function call the positional parameters until they are popped. They are borrowed */
+
+void pop_positional_parameters();
+/* Restores the positional parameters of the caller */
+
+size_t positional_parameter_count();
+/* Returns the number of positional parameters, 0 outside of a function */
+
+const char *positional_parameter(size_t i);
+/* Returns the positional parameter i, starting from 1, or NULL if there are fewer */
+
+char *expand_variables(const char *word);
+/*
+ * Returns a copy of the word where `$name`, `${name}`, `$?`, the positional parameters `$1` to `$9`, `$#` and `$@`
+ * (joined by spaces) are replaced by their values, an unset variable by nothing, and the arithmetic expansions
+ * `$(( expression ))` by the value of their expression, or by nothing and setting expansion_failed if it is invalid.
+ * A `$` which starts none of them is kept. The copy must be freed by the caller.
+ */
+
+void free_variables();
+/* Frees the variables of jsh */
+
+#endif
@@ -0,0 +1,66 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/run/run.h"
+#include "../../src/utils/variables.h"
+#include "test_assignment.h"
+
+void test_assignment_status();
+void test_assignment_with_substitutions();
+
+void test_assignment() {
+    printf("Test function assignment_status\n");
+    test_assignment_status();
+    printf("Test assignment_status passed\n");
+
+    printf("Test function assignment_with_substitutions\n");
+    test_assignment_with_substitutions();
+    printf("Test assignment_with_substitutions passed\n");
+}
+
+int status_of_line(const char *line) {
+    pipeline_list *pips = parse_pipeline_list(line);
+    assert(pips != NULL);
+    int status = run_pipeline_list(pips);
+    free_pipeline_list(pips);
+    return status;
+}
+
+void test_assignment_status() {
+    // A command made only of assignments has the status of its last command substitution
+    assert(status_of_line("jsh_test_status=$(false)") == 1);
+    assert(status_of_line("jsh_test_status=a$(exit 3)") == 3);
+    assert(status_of_line("jsh_test_status=$(false) jsh_test_other=$(true)") == 0);
+    assert(status_of_line("jsh_test_status=$(true)") == 0);
+
+    // Without substitution, it succeeds whatever the status of the command before it
+    assert(status_of_line("jsh_test_status=$(false)") == 1);
+    assert(status_of_line("jsh_test_status=a") == 0);
+    assert(strcmp(get_variable("jsh_test_status", strlen("jsh_test_status")), "a") == 0);
+}
+
+/* Returns true if the variable has the value */
+bool variable_is(const char *name, const char *value) {
+    const char *current = get_variable(name, strlen(name));
+    return current != NULL && strcmp(current, value) == 0;
+}
+
+void test_assignment_with_substitutions() {
+    // The output of a substitution is the value as is, a single field without its trailing newlines
+    assert(status_of_line("jsh_test_value=$(echo hi)") == 0);
+    assert(variable_is("jsh_test_value", "hi"));
+    assert(status_of_line("jsh_test_value=$(seq 3)") == 0);
+    assert(variable_is("jsh_test_value", "1\n2\n3"));
+
+    // The text around it and the other expansions are kept
+    assert(status_of_line("jsh_test_index=2") == 0);
+    assert(status_of_line("jsh_test_value=-$(echo a b)-$jsh_test_index$((jsh_test_index+1))") == 0);
+    assert(variable_is("jsh_test_value", "-a b-23"));
+
+    // Each assignment of a command gets its own value
+    assert(status_of_line("jsh_test_value=$(echo a) jsh_test_other=$(echo b c)") == 0);
+    assert(variable_is("jsh_test_value", "a") && variable_is("jsh_test_other", "b c"));
+}
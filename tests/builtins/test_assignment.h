@@ -0,0 +1,9 @@
+#ifndef TEST_ASSIGNMENT_H
+#define TEST_ASSIGNMENT_H
+
+void test_assignment();
+
+int status_of_line(const char *line);
+/* Returns the status of the line run by jsh */
+
+#endif
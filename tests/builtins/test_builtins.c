@@ -0,0 +1,29 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../../src/builtins/builtins.h"
+#include "test_builtins.h"
+
+void test_find_builtin();
+
+void test_builtins() {
+    printf("Test function find_builtin\n");
+    test_find_builtin();
+    printf("Test find_builtin passed\n");
+}
+
+void test_find_builtin() {
+    // The table is sorted, so that each builtin is found by its name
+    for (size_t i = 0; i < builtin_count; i++) {
+        assert(i == 0 || strcmp(builtins[i - 1].name, builtins[i].name) < 0);
+        assert(find_builtin(builtins[i].name) == &builtins[i]);
+    }
+
+    assert(find_builtin("cd")->updates_prompt);
+    assert(find_builtin("chunked")->is_forked);
+    assert(find_builtin("pwd")->is_contained && !find_builtin("cd")->is_contained);
+    assert(find_builtin("ls") == NULL);
+    assert(find_builtin("") == NULL);
+    assert(find_builtin("x=1") == NULL);
+}
@@ -0,0 +1,6 @@
+#ifndef TEST_BUILTINS_H
+#define TEST_BUILTINS_H
+
+void test_builtins();
+
+#endif
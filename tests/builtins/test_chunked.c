@@ -0,0 +1,89 @@
+#include <assert.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+
+#include "../../src/builtins/chunked.h"
+#include "../../src/utils/constants.h"
+#include "test_chunked.h"
+
+void test_combine_batch_status();
+void test_pack_batch();
+
+void test_chunked() {
+    printf("Test function combine_batch_status\n");
+    test_combine_batch_status();
+    printf("Test combine_batch_status passed\n");
+
+    printf("Test function pack_batch\n");
+    test_pack_batch();
+    printf("Test pack_batch passed\n");
+}
+
+void test_combine_batch_status() {
+    // A batch which succeeds keeps the code of the previous ones
+    assert(combine_batch_status(0, W_EXITCODE(0, 0)) == 0);
+    assert(combine_batch_status(CHUNKED_BATCH_FAILED, W_EXITCODE(0, 0)) == CHUNKED_BATCH_FAILED);
+
+    // A batch which fails gives 123, whatever its own code
+    assert(combine_batch_status(0, W_EXITCODE(1, 0)) == CHUNKED_BATCH_FAILED);
+    assert(combine_batch_status(0, W_EXITCODE(2, 0)) == CHUNKED_BATCH_FAILED);
+
+    // A command which could not be run is more severe than a failed batch, before or after it
+    assert(combine_batch_status(0, W_EXITCODE(COMMAND_NOT_FOUND, 0)) == COMMAND_NOT_FOUND);
+    assert(combine_batch_status(CHUNKED_BATCH_FAILED, W_EXITCODE(COMMAND_NOT_FOUND, 0)) == COMMAND_NOT_FOUND);
+    assert(combine_batch_status(COMMAND_NOT_FOUND, W_EXITCODE(1, 0)) == COMMAND_NOT_FOUND);
+    assert(combine_batch_status(CHUNKED_BATCH_FAILED, W_EXITCODE(CHUNKED_CANNOT_RUN, 0)) == CHUNKED_CANNOT_RUN);
+
+    // A batch killed by a signal gives 125
+    assert(combine_batch_status(0, W_EXITCODE(0, SIGKILL)) == CHUNKED_BATCH_KILLED);
+    assert(combine_batch_status(CHUNKED_BATCH_FAILED, W_EXITCODE(0, SIGTERM)) == CHUNKED_BATCH_KILLED);
+}
+
+/* Packs the arguments in batches after the command, in a space of the given size, and returns the number of them */
+size_t count_batches(char **arguments, size_t argument_count, size_t space, size_t *batch_sizes) {
+    char *argv[8];
+    argv[0] = "echo";
+    size_t initial_size = argument_size(argv[0]);
+    size_t batch_count = 0;
+    size_t next = 0;
+    while (next < argument_count) {
+        size_t taken = pack_batch(argv, 1, initial_size, arguments + next, argument_count - next, space);
+        assert(argv[1 + taken] == NULL);
+        for (size_t i = 0; i < taken; i++) {
+            assert(argv[1 + i] == arguments[next + i]);
+        }
+        batch_sizes[batch_count++] = taken;
+        next += taken;
+    }
+    return batch_count;
+}
+
+void test_pack_batch() {
+    char *arguments[] = {"a", "bb", "ccc", "d", "eeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeee", "f"};
+    size_t sizes[8];
+    size_t per_argument = sizeof(char *) + 1;
+
+    // Everything fits in a single batch
+    assert(count_batches(arguments, 6, 4096, sizes) == 1);
+    assert(sizes[0] == 6);
+
+    // The command and two short arguments fit, the long one does not fit with anything and goes alone
+    size_t space = argument_size("echo") + 2 * per_argument + 4;
+    assert(count_batches(arguments, 6, space, sizes) == 4);
+    assert(sizes[0] == 2);
+    assert(sizes[1] == 2);
+    assert(sizes[2] == 1);
+    assert(sizes[3] == 1);
+
+    // An argument is always taken, even if the command alone does not fit
+    assert(count_batches(arguments, 3, 1, sizes) == 3);
+    assert(sizes[0] == 1 && sizes[1] == 1 && sizes[2] == 1);
+
+    // Without arguments, nothing is taken and the batch is only the command
+    char *argv[2] = {"echo", "x"};
+    assert(pack_batch(argv, 1, argument_size("echo"), arguments, 0, 4096) == 0);
+    assert(argv[1] == NULL);
+    assert(strcmp(argv[0], "echo") == 0);
+}
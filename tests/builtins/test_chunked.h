@@ -0,0 +1,6 @@
+#ifndef TEST_CHUNKED_H
+#define TEST_CHUNKED_H
+
+void test_chunked();
+
+#endif
@@ -0,0 +1,37 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../../src/builtins/extern_command.h"
+#include "../../src/utils/constants.h"
+#include "test_extern_command.h"
+
+void test_extern_command_failures();
+
+void test_extern_command() {
+    printf("Test function extern_command_failures\n");
+    test_extern_command_failures();
+    printf("Test extern_command_failures passed\n");
+}
+
+/* Returns the status of the command of a single argument, which must not be executable */
+int status_of_failed_command(char *name) {
+    char *argv[] = {name, NULL};
+    command_without_substitution cmd = {.name = name, .argc = 1, .argv = argv};
+    return extern_command(&cmd);
+}
+
+void test_extern_command_failures() {
+    // A command which does not exist is not found
+    assert(status_of_failed_command("jsh_test_no_such_command") == COMMAND_NOT_FOUND);
+    assert(status_of_failed_command("/tmp/jsh_test_no_such_directory/command") == COMMAND_NOT_FOUND);
+
+    // A file without the permission to execute it is found but not executable
+    char path[] = "/tmp/jsh_test_extern_command_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd != -1);
+    close(fd);
+    assert(status_of_failed_command(path) == COMMAND_NOT_EXECUTABLE);
+    unlink(path);
+}
@@ -0,0 +1,6 @@
+#ifndef TEST_EXTERN_COMMAND_H
+#define TEST_EXTERN_COMMAND_H
+
+void test_extern_command();
+
+#endif
@@ -0,0 +1,137 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../../src/builtins/wait.h"
+#include "../../src/utils/jobs_core.h"
+#include "test_assignment.h"
+#include "test_wait.h"
+
+void test_wait_for_several_jobs();
+void test_wait_for_next_job();
+void test_wait_for_job_given_twice();
+void test_wait_for_unknown_job();
+void test_wait_for_ended_job();
+
+char wait_script[] = "/tmp/jsh_test_wait_XXXXXX";
+/* A script sleeping for its first argument in seconds, then exiting with its second one */
+
+void test_wait() {
+    int fd = mkstemp(wait_script);
+    assert(fd != -1);
+    const char *script = "#!/bin/sh\nsleep $1\nexit $2\n";
+    assert(write(fd, script, strlen(script)) == (ssize_t)strlen(script));
+    close(fd);
+    assert(chmod(wait_script, 0700) == 0);
+
+    printf("Test function wait_for_several_jobs\n");
+    test_wait_for_several_jobs();
+    printf("Test wait_for_several_jobs passed\n");
+
+    printf("Test function wait_for_next_job\n");
+    test_wait_for_next_job();
+    printf("Test wait_for_next_job passed\n");
+
+    printf("Test function wait_for_job_given_twice\n");
+    test_wait_for_job_given_twice();
+    printf("Test wait_for_job_given_twice passed\n");
+
+    printf("Test function wait_for_unknown_job\n");
+    test_wait_for_unknown_job();
+    printf("Test wait_for_unknown_job passed\n");
+
+    printf("Test function wait_for_ended_job\n");
+    test_wait_for_ended_job();
+    printf("Test wait_for_ended_job passed\n");
+
+    unlink(wait_script);
+}
+
+/* Runs the script in the background and returns the id of its job */
+unsigned start_waited_job(const char *seconds, int exit_status) {
+    char line[128];
+    snprintf(line, sizeof(line), "%s %s %d &", wait_script, seconds, exit_status);
+    assert(status_of_line(line) == 0);
+    assert(job_number > 0);
+    return jobs[job_number - 1]->id;
+}
+
+void test_wait_for_several_jobs() {
+    unsigned slow = start_waited_job("0.3", 3);
+    unsigned fast = start_waited_job("0.1", 5);
+    char line[64];
+
+    // All the jobs are waited for, the status is the one of the last argument
+    snprintf(line, sizeof(line), "wait %%%u %%%u", slow, fast);
+    assert(status_of_line(line) == 5);
+    assert(job_number == 0);
+
+    slow = start_waited_job("0.3", 3);
+    fast = start_waited_job("0.1", 5);
+    snprintf(line, sizeof(line), "wait %%%u %%%u", fast, slow);
+    assert(status_of_line(line) == 3);
+    assert(job_number == 0);
+}
+
+void test_wait_for_next_job() {
+    unsigned slow = start_waited_job("0.5", 3);
+    unsigned fast = start_waited_job("0.1", 5);
+    char line[64];
+
+    // Only the first job to end is waited for, whatever the order of the arguments
+    snprintf(line, sizeof(line), "wait -n %%%u %%%u", slow, fast);
+    assert(status_of_line(line) == 5);
+    assert(job_number == 1);
+    assert(get_jobs_placement_with_id(slow) != -1);
+    assert(get_jobs_placement_with_id(fast) == -1);
+
+    snprintf(line, sizeof(line), "wait -n %%%u", slow);
+    assert(status_of_line(line) == 3);
+    assert(job_number == 0);
+
+    // Without any job, there is nothing to wait for
+    assert(status_of_line("wait -n") == WAIT_NOT_FOUND);
+}
+
+void test_wait_for_job_given_twice() {
+    unsigned id = start_waited_job("0.1", 4);
+    char line[64];
+    snprintf(line, sizeof(line), "wait %%%u %%%u", id, id);
+    assert(status_of_line(line) == 4);
+    assert(job_number == 0);
+}
+
+void test_wait_for_unknown_job() {
+    assert(status_of_line("wait %99") == WAIT_NOT_FOUND);
+
+    // The other jobs are still waited for, the status being the one of the last argument
+    unsigned id = start_waited_job("0.1", 4);
+    char line[64];
+    snprintf(line, sizeof(line), "wait %%%u %%99", id);
+    assert(status_of_line(line) == WAIT_NOT_FOUND);
+    assert(job_number == 0);
+}
+
+void test_wait_for_ended_job() {
+    char line[64];
+
+    // A job which ended without being reaped yet
+    unsigned id = start_waited_job("0", 6);
+    usleep(300000);
+    snprintf(line, sizeof(line), "wait %%%u", id);
+    assert(status_of_line(line) == 6);
+    assert(job_number == 0);
+
+    // And one whose end was already collected, before the poll
+    id = start_waited_job("0", 7);
+    while (jobs[get_jobs_placement_with_id(id)]->status == RUNNING) {
+        usleep(10000);
+        update_status_of_jobs();
+    }
+    snprintf(line, sizeof(line), "wait %%%u", id);
+    assert(status_of_line(line) == 7);
+    assert(job_number == 0);
+}
@@ -0,0 +1,6 @@
+#ifndef TEST_WAIT_H
+#define TEST_WAIT_H
+
+void test_wait();
+
+#endif
@@ -1,8 +1,11 @@
 #include <assert.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "../../src/parser/bytecode.h"
+#include "../../src/utils/functions.h"
 #include "test_parser.h"
 
 void test_tokenize();
@@ -28,6 +31,15 @@ void test_parse_pipeline_list_with_only_spaces();
 void test_parse_pipeline_list_with_only_spaces_and_ampersand();
 void test_parse_pipeline_list_with_start_ampersand();
 void test_parse_pipeline_list_with_middle_ampersands();
+void test_parse_pipeline_list_with_list_operators();
+void test_parse_pipeline_list_with_groups();
+void test_parse_pipeline_list_with_compound_commands();
+void test_compile_compound_command();
+void test_continuation_lines();
+void test_parse_pipeline_list_with_function_definitions();
+void test_expand_aliases();
+void test_parse_pipeline_list_with_timeouts();
+void test_parse_pipeline_list_with_captured_jobs();
 void test_parse_pipeline_list_with_only_ampersand();
 void test_parse_pipeline_list_with_middle_ampersands_and_spaces();
 void test_parse_pipeline_list_with_middle_ampersands_and_spaces2();
@@ -71,6 +83,13 @@ void test_invalid_pipe_substitution2();
 void test_invalid_pipe_substitution3();
 void test_invalid_pipe_substitution4();
 void test_invalid_pipe_substitution5();
+void test_parse_pipeline_with_command_substitution();
+void test_str_of_pipeline_with_command_substitution();
+void test_invalid_command_substitution();
+void test_parse_pipeline_with_command_substitutions_in_words();
+void test_parse_pipeline_with_output_substitution_targets();
+void test_parse_pipeline_with_here_string();
+void test_read_here_documents();
 
 void test_parser_utils() {
     printf("Test function test_tokenize\n");
@@ -165,6 +184,42 @@ void test_parser_utils() {
     test_parse_pipeline_list_with_middle_ampersands();
     printf("Test test_parse_pipeline_list_with_middle_ampersands passed\n");
 
+    printf("Test function test_parse_pipeline_list_with_list_operators\n");
+    test_parse_pipeline_list_with_list_operators();
+    printf("Test test_parse_pipeline_list_with_list_operators passed\n");
+
+    printf("Test function test_parse_pipeline_list_with_groups\n");
+    test_parse_pipeline_list_with_groups();
+    printf("Test test_parse_pipeline_list_with_groups passed\n");
+
+    printf("Test function test_parse_pipeline_list_with_compound_commands\n");
+    test_parse_pipeline_list_with_compound_commands();
+    printf("Test test_parse_pipeline_list_with_compound_commands passed\n");
+
+    printf("Test function test_compile_compound_command\n");
+    test_compile_compound_command();
+    printf("Test test_compile_compound_command passed\n");
+
+    printf("Test function test_continuation_lines\n");
+    test_continuation_lines();
+    printf("Test test_continuation_lines passed\n");
+
+    printf("Test function test_parse_pipeline_list_with_function_definitions\n");
+    test_parse_pipeline_list_with_function_definitions();
+    printf("Test test_parse_pipeline_list_with_function_definitions passed\n");
+
+    printf("Test function test_expand_aliases\n");
+    test_expand_aliases();
+    printf("Test test_expand_aliases passed\n");
+
+    printf("Test function test_parse_pipeline_list_with_timeouts\n");
+    test_parse_pipeline_list_with_timeouts();
+    printf("Test test_parse_pipeline_list_with_timeouts passed\n");
+
+    printf("Test function test_parse_pipeline_list_with_captured_jobs\n");
+    test_parse_pipeline_list_with_captured_jobs();
+    printf("Test test_parse_pipeline_list_with_captured_jobs passed\n");
+
     printf("Test function test_parse_pipeline_list_with_middle_ampersands_and_spaces\n");
     test_parse_pipeline_list_with_middle_ampersands_and_spaces();
     printf("Test test_parse_pipeline_list_with_middle_ampersands_and_spaces passed\n");
@@ -331,7 +386,35 @@ void test_parser_utils() {
 
     printf("Test function test_invalid_pipe_substitution5\n");
     test_invalid_pipe_substitution5();
-    printf("Test test_invalid_pipe_substitution5 passed\n");    
+    printf("Test test_invalid_pipe_substitution5 passed\n");
+
+    printf("Test function test_parse_pipeline_with_command_substitution\n");
+    test_parse_pipeline_with_command_substitution();
+    printf("Test test_parse_pipeline_with_command_substitution passed\n");
+
+    printf("Test function test_str_of_pipeline_with_command_substitution\n");
+    test_str_of_pipeline_with_command_substitution();
+    printf("Test test_str_of_pipeline_with_command_substitution passed\n");
+
+    printf("Test function test_invalid_command_substitution\n");
+    test_invalid_command_substitution();
+    printf("Test test_invalid_command_substitution passed\n");
+
+    printf("Test function test_parse_pipeline_with_command_substitutions_in_words\n");
+    test_parse_pipeline_with_command_substitutions_in_words();
+    printf("Test test_parse_pipeline_with_command_substitutions_in_words passed\n");
+
+    printf("Test function test_parse_pipeline_with_output_substitution_targets\n");
+    test_parse_pipeline_with_output_substitution_targets();
+    printf("Test test_parse_pipeline_with_output_substitution_targets passed\n");
+
+    printf("Test function test_parse_pipeline_with_here_string\n");
+    test_parse_pipeline_with_here_string();
+    printf("Test test_parse_pipeline_with_here_string passed\n");
+
+    printf("Test function test_read_here_documents\n");
+    test_read_here_documents();
+    printf("Test test_read_here_documents passed\n");
 }
 
 void test_tokenize() {
@@ -1005,8 +1088,190 @@ void test_parse_pipeline_list_with_middle_ampersands() {
     // Call the function to test
     pipeline_list *pips = parse_pipeline_list(input);
 
-    // Check if the pipeline_list is NULL
-    assert(pips == NULL);
+    // Check the correct number of pipelines and their operator
+    assert(pips != NULL);
+    assert(pips->pipeline_count == 2);
+    assert(pips->operators[0] == LIST_AND);
+    assert(!pips->pipelines[0]->to_job);
+    assert(!pips->pipelines[1]->to_job);
+    assert(strcmp(pips->pipelines[1]->commands[0]->name, "./test") == 0);
+
+    // Cleanup
+    free_pipeline_list(pips);
+}
+
+void test_parse_pipeline_list_with_list_operators() {
+    char *input = "cd x && make | tee log || echo failed ; sleep 1 & ls;";
+
+    // Call the function to test
+    pipeline_list *pips = parse_pipeline_list(input);
+
+    // Check the pipelines and the operators between them
+    assert(pips != NULL);
+    assert(pips->pipeline_count == 5);
+    assert(pips->operators[0] == LIST_AND);
+    assert(pips->operators[1] == LIST_OR);
+    assert(pips->operators[2] == LIST_SEQUENCE);
+    assert(pips->operators[3] == LIST_SEQUENCE);
+    assert(pips->pipelines[1]->command_count == 2);
+    assert(strcmp(pips->pipelines[2]->commands[0]->name, "echo") == 0);
+    assert(pips->pipelines[3]->to_job);
+    assert(!pips->pipelines[4]->to_job);
+    assert(strcmp(pips->pipelines[4]->commands[0]->name, "ls") == 0);
+    free_pipeline_list(pips);
+
+    // The operators inside a substitution belong to its pipeline
+    pips = parse_pipeline_list("cat <(ls; ls) && ls");
+    assert(pips != NULL);
+    assert(pips->pipeline_count == 2);
+    free_pipeline_list(pips);
+
+    // An operator cannot follow an empty pipeline, nor `&&` and `||` end the list
+    assert(parse_pipeline_list("; ls") == NULL);
+    assert(parse_pipeline_list("ls ;; ls") == NULL);
+    assert(parse_pipeline_list("ls &&") == NULL);
+    assert(parse_pipeline_list("ls ||  ") == NULL);
+    assert(parse_pipeline_list("|| ls") == NULL);
+    assert(parse_pipeline_list("ls &&& ls") == NULL);
+}
+
+void test_parse_pipeline_list_with_groups() {
+    pipeline_list *pips = parse_pipeline_list("{ ls; pwd; } > out && echo done");
+
+    // The group is a command of its own, its redirections applying to the whole list
+    assert(pips != NULL);
+    assert(pips->pipeline_count == 2);
+    command *cmd = pips->pipelines[0]->commands[0];
+    assert(cmd->group_type == GROUP_BRACES);
+    assert(cmd->group->pipeline_count == 2);
+    assert(strcmp(cmd->group->pipelines[1]->commands[0]->name, "pwd") == 0);
+    assert(cmd->redirection_count == 1);
+    assert(strcmp(cmd->redirections[0].filename, "out") == 0);
+    assert(pips->operators[0] == LIST_AND);
+    free_pipeline_list(pips);
+
+    // A subshell may be a stage of a pipeline and contain lists and other groups
+    pips = parse_pipeline_list("( cd x && { ls | wc; } ) | cat");
+    assert(pips != NULL);
+    assert(pips->pipeline_count == 1);
+    assert(pips->pipelines[0]->command_count == 2);
+    cmd = pips->pipelines[0]->commands[0];
+    assert(cmd->group_type == GROUP_SUBSHELL);
+    assert(cmd->group->pipeline_count == 2);
+    assert(cmd->group->operators[0] == LIST_AND);
+    assert(cmd->group->pipelines[1]->commands[0]->group_type == GROUP_BRACES);
+    char *str = str_of_pipeline(pips->pipelines[0]);
+    assert(strcmp(str, "( cd x && { ls | wc; } ) | cat") == 0);
+    free(str);
+    free_pipeline_list(pips);
+
+    // A brace is only a keyword at the start of a command
+    pips = parse_pipeline_list("echo { }");
+    assert(pips != NULL);
+    assert(pips->pipelines[0]->commands[0]->group_type == GROUP_NONE);
+    assert(pips->pipelines[0]->commands[0]->argc == 3);
+    free_pipeline_list(pips);
+
+    assert(parse_pipeline_list("{ ls }") == NULL);
+    assert(parse_pipeline_list("( )") == NULL);
+    assert(parse_pipeline_list("}") == NULL);
+    assert(parse_pipeline_list("( ls ) foo") == NULL);
+    assert(parse_pipeline_list("( ls") == NULL);
+}
+
+void test_parse_pipeline_list_with_compound_commands() {
+    pipeline_list *pips = parse_pipeline_list("if test -d x; then cd x; elif true; then ls; else pwd; fi > out");
+
+    // Each `if` and `elif` is a clause, the `else` body being apart
+    assert(pips != NULL);
+    assert(pips->pipeline_count == 1);
+    command *cmd = pips->pipelines[0]->commands[0];
+    assert(cmd->group_type == GROUP_IF);
+    assert(cmd->compound->clause_count == 2);
+    assert(strcmp(cmd->compound->conditions[0]->pipelines[0]->commands[0]->name, "test") == 0);
+    assert(strcmp(cmd->compound->bodies[1]->pipelines[0]->commands[0]->name, "ls") == 0);
+    assert(strcmp(cmd->compound->else_body->pipelines[0]->commands[0]->name, "pwd") == 0);
+    assert(cmd->redirection_count == 1);
+    char *str = str_of_pipeline(pips->pipelines[0]);
+    assert(strcmp(str, "if test -d x; then cd x; elif true; then ls; else pwd; fi > out") == 0);
+    free(str);
+    free_pipeline_list(pips);
+
+    // The words of a `for` loop are parsed as the command `name in words...`, loops nesting in others
+    pips = parse_pipeline_list("for x in a b; do while false; do ls; done; done | cat");
+    assert(pips != NULL);
+    assert(pips->pipelines[0]->command_count == 2);
+    cmd = pips->pipelines[0]->commands[0];
+    assert(cmd->group_type == GROUP_FOR);
+    assert(cmd->compound->clause_count == 1);
+    assert(cmd->compound->conditions[0] == NULL);
+    assert(cmd->compound->words->argc == 4);
+    assert(strcmp(cmd->compound->words->name, "x") == 0);
+    assert(cmd->compound->bodies[0]->pipelines[0]->commands[0]->group_type == GROUP_WHILE);
+    free_pipeline_list(pips);
+
+    // An arithmetic expansion is a word, not a command substitution
+    pips = parse_pipeline_list("echo $(( (1 + 2) * 3 )) && x=$((x+1))");
+    assert(pips != NULL);
+    assert(pips->pipeline_count == 2);
+    assert(pips->pipelines[0]->commands[0]->argc == 2);
+    assert(pips->pipelines[0]->commands[0]->argv[1]->type == ARG_SIMPLE);
+    assert(strcmp(pips->pipelines[0]->commands[0]->argv[1]->value.simple, "$(( (1 + 2) * 3 ))") == 0);
+    free_pipeline_list(pips);
+
+    // A reserved word is only one in command position
+    pips = parse_pipeline_list("echo if then fi");
+    assert(pips != NULL);
+    assert(pips->pipelines[0]->commands[0]->group_type == GROUP_NONE);
+    assert(pips->pipelines[0]->commands[0]->argc == 4);
+    free_pipeline_list(pips);
+
+    assert(parse_pipeline_list("if true; fi") == NULL);
+    assert(parse_pipeline_list("if true; then ls") == NULL);
+    assert(parse_pipeline_list("while true; do ls; done foo") == NULL);
+    assert(parse_pipeline_list("for 1x in a; do ls; done") == NULL);
+    assert(parse_pipeline_list("done") == NULL);
+    assert(parse_pipeline_list("then ls") == NULL);
+}
+
+void test_compile_compound_command() {
+    pipeline_list *pips = parse_pipeline_list("while test -f x; do ls || pwd; done");
+    assert(pips != NULL);
+    command *cmd = pips->pipelines[0]->commands[0];
+    program *prog = compile_compound_command(cmd->group_type, cmd->compound);
+
+    // The condition and the body are flattened into jumps around the three pipelines
+    assert(prog->pipeline_count == 3);
+    assert(prog->loop_count == 1);
+    assert(prog->instructions[0].op == OP_LOOP_START);
+    assert(prog->instructions[prog->instruction_count - 1].op == OP_LOOP_END);
+    size_t runs = 0;
+    for (size_t i = 0; i < prog->instruction_count; i++) {
+        if (prog->instructions[i].op == OP_RUN) {
+            runs++;
+        } else if (prog->instructions[i].op <= OP_JUMP_IF_SUCCESS) {
+            assert(prog->instructions[i].arg < prog->instruction_count);
+        }
+    }
+    assert(runs == 3);
+    free_program(prog);
+    free_pipeline_list(pips);
+}
+
+void test_continuation_lines() {
+    assert(is_incomplete_input("for x in a b"));
+    assert(is_incomplete_input("if true; then { ls"));
+    assert(!is_incomplete_input("while true; do ls; done"));
+    assert(!is_incomplete_input("echo for while"));
+
+    // The lines are joined by `;`, unless the previous one ends with a word a command follows
+    char *input = strdup("for x in a b");
+    input = join_continuation_line(input, "do echo $x");
+    input = join_continuation_line(input, "");
+    input = join_continuation_line(input, "done");
+    assert(strcmp(input, "for x in a b; do echo $x; done") == 0);
+    assert(!is_incomplete_input(input));
+    free(input);
 }
 
 void test_parse_pipeline_list_with_middle_ampersands_and_spaces() {
@@ -2214,3 +2479,292 @@ void test_invalid_pipe_substitution5() {
     // Check if the pipeline is NULL
     assert(pip == NULL);
 }
+
+
+void test_parse_pipeline_with_command_substitution() {
+    // Set up
+    char *input = "echo $( cat foo | grep $(echo bar) ) baz";
+    pipeline *pip = parse_pipeline(input, false);
+
+    // Check if the pipeline is correct
+    assert(pip != NULL);
+    assert(pip->command_count == 1);
+
+    command *cmd = pip->commands[0];
+    assert(strcmp(cmd->name, "echo") == 0);
+    assert(cmd->argc == 3);
+
+    assert(cmd->argv[1]->type == ARG_COMMAND_SUBSTITUTION);
+    pipeline *subpip = cmd->argv[1]->value.substitution;
+    assert(subpip->command_count == 2);
+    assert(strcmp(subpip->commands[0]->name, "cat") == 0);
+    assert(strcmp(subpip->commands[1]->name, "grep") == 0);
+    assert(subpip->commands[1]->argc == 2);
+    assert(subpip->commands[1]->argv[1]->type == ARG_COMMAND_SUBSTITUTION);
+
+    assert(cmd->argv[2]->type == ARG_SIMPLE);
+    assert(strcmp(cmd->argv[2]->value.simple, "baz") == 0);
+
+    // Clean up
+    free_pipeline(pip);
+}
+
+void test_str_of_pipeline_with_command_substitution() {
+    // Set up
+    char *input = "ls $(cat dirs) <(echo a) > out";
+    pipeline *pip = parse_pipeline(input, false);
+    char *strpip = str_of_pipeline(pip);
+
+    // Check if the string is correct
+    assert(strcmp(strpip, "ls $( cat dirs ) <( echo a ) > out") == 0);
+
+    // Clean up
+    free_pipeline(pip);
+    free(strpip);
+}
+
+void test_invalid_command_substitution() {
+    assert(parse_pipeline("echo $(", false) == NULL);
+    assert(parse_pipeline("echo $()", false) == NULL);
+    assert(parse_pipeline("echo $( )", false) == NULL);
+    assert(parse_pipeline("echo a )", false) == NULL);
+}
+void test_parse_pipeline_with_command_substitutions_in_words() {
+    // Set up
+    pipeline *pip = parse_pipeline("echo x$(echo a)y $(echo a)$(echo b) {1..3}$(echo z) $((1+2))", false);
+    assert(pip != NULL);
+    command *cmd = pip->commands[0];
+    assert(cmd->argc == 5);
+
+    // Check the text around a substitution is kept in its parts
+    assert(cmd->argv[1]->type == ARG_WORD);
+    assert(cmd->argv[1]->value.word.part_count == 3);
+    assert(cmd->argv[1]->value.word.parts[0]->type == ARG_SIMPLE);
+    assert(strcmp(cmd->argv[1]->value.word.parts[0]->value.simple, "x") == 0);
+    assert(cmd->argv[1]->value.word.parts[1]->type == ARG_COMMAND_SUBSTITUTION);
+    assert(strcmp(cmd->argv[1]->value.word.parts[2]->value.simple, "y") == 0);
+
+    // Check two substitutions next to each other are a single word
+    assert(cmd->argv[2]->type == ARG_WORD);
+    assert(cmd->argv[2]->value.word.part_count == 2);
+    assert(cmd->argv[2]->value.word.parts[0]->type == ARG_COMMAND_SUBSTITUTION);
+    assert(cmd->argv[2]->value.word.parts[1]->type == ARG_COMMAND_SUBSTITUTION);
+
+    assert(cmd->argv[3]->type == ARG_WORD);
+    assert(strcmp(cmd->argv[3]->value.word.parts[0]->value.simple, "{1..3}") == 0);
+
+    // Check an arithmetic expansion is no substitution
+    assert(cmd->argv[4]->type == ARG_SIMPLE);
+
+    char *strpip = str_of_pipeline(pip);
+    assert(strcmp(strpip, "echo x$( echo a )y $( echo a )$( echo b ) {1..3}$( echo z ) $((1+2))") == 0);
+    free(strpip);
+
+    // Check an invalid substitution in a word is a parse error
+    free_pipeline(pip);
+    assert(parse_pipeline("echo x$()", false) == NULL);
+    assert(parse_pipeline("echo x$( )y", false) == NULL);
+}
+
+void test_parse_pipeline_with_output_substitution_targets() {
+    // Set up
+    char *input = "seq 10 > a >> b >(gzip > c.gz)";
+    pipeline *pip = parse_pipeline(input, false);
+    assert(pip != NULL);
+    command *cmd = pip->commands[0];
+
+    // Check the output substitution is an additional stdout target
+    assert(cmd->argc == 2);
+    assert(cmd->redirection_count == 3);
+    assert(cmd->redirections[2].type == REDIRECT_STDOUT);
+    assert(is_output_substitution(cmd->redirections[2].filename));
+
+    // Check an output substitution before the redirections is still an argument
+    free_pipeline(pip);
+    pip = parse_pipeline("tee >(wc -l) > a", false);
+    assert(pip != NULL);
+    cmd = pip->commands[0];
+    assert(cmd->argc == 2);
+    assert(cmd->argv[1]->type == ARG_OUTPUT_SUBSTITUTION);
+    assert(cmd->redirection_count == 1);
+
+    // Clean up
+    free_pipeline(pip);
+}
+
+void test_parse_pipeline_with_here_string() {
+    // Set up
+    pipeline *pip = parse_pipeline("wc -c <<< word > out", false);
+    assert(pip != NULL);
+    command *cmd = pip->commands[0];
+
+    // Check the here-string and its content
+    assert(cmd->argc == 2);
+    assert(cmd->redirection_count == 2);
+    assert(cmd->redirections[0].type == REDIRECT_STDIN);
+    assert(cmd->redirections[0].mode == REDIRECT_HERE_STRING);
+    assert(strcmp(cmd->redirections[0].content, "word\n") == 0);
+    assert(cmd->redirections[1].content == NULL);
+
+    char *strpip = str_of_pipeline(pip);
+    assert(strcmp(strpip, "wc -c <<< word > out") == 0);
+
+    // Clean up
+    free(strpip);
+    free_pipeline(pip);
+
+    assert(parse_pipeline("cat <<", false) == NULL);
+}
+
+char *here_document_lines[] = {"first line", "", "EOF", "second", "END", "unterminated"};
+size_t here_document_line_index = 0;
+
+char *read_test_here_document_line() {
+    if (here_document_line_index >= sizeof(here_document_lines) / sizeof(char *)) {
+        return NULL;
+    }
+    return strdup(here_document_lines[here_document_line_index++]);
+}
+
+void test_read_here_documents() {
+    // Set up
+    pipeline_list *pips = parse_pipeline_list("cat << EOF | cat <( cat << END ) & cat << STOP");
+    assert(pips != NULL);
+    assert(pips->pipeline_count == 2);
+    assert(strcmp(pips->pipelines[0]->commands[0]->redirections[0].filename, "EOF") == 0);
+    assert(pips->pipelines[0]->commands[0]->redirections[0].content == NULL);
+
+    read_here_documents(pips, read_test_here_document_line);
+
+    // Check the bodies are read in order, the last one until the end of the input
+    assert(strcmp(pips->pipelines[0]->commands[0]->redirections[0].content, "first line\n\n") == 0);
+    pipeline *substitution = pips->pipelines[0]->commands[1]->argv[1]->value.substitution;
+    assert(strcmp(substitution->commands[0]->redirections[0].content, "second\n") == 0);
+    assert(strcmp(pips->pipelines[1]->commands[0]->redirections[0].content, "unterminated\n") == 0);
+
+    char *strpip = str_of_pipeline(pips->pipelines[0]);
+    assert(strcmp(strpip, "cat << EOF | cat <( cat << END )") == 0);
+
+    // Clean up
+    free(strpip);
+    free_pipeline_list(pips);
+}
+
+void test_parse_pipeline_list_with_function_definitions() {
+    pipeline_list *pips = parse_pipeline_list("greet() { echo hello $1; } > out; greet you");
+
+    // The body is a list made of the compound command, which keeps its redirections
+    assert(pips != NULL);
+    assert(pips->pipeline_count == 2);
+    command *cmd = pips->pipelines[0]->commands[0];
+    assert(cmd->group_type == GROUP_FUNCTION);
+    assert(strcmp(cmd->name, "greet") == 0);
+    assert(cmd->argc == 1);
+    assert(cmd->redirection_count == 0);
+    assert(cmd->group->pipeline_count == 1);
+    command *body = cmd->group->pipelines[0]->commands[0];
+    assert(body->group_type == GROUP_BRACES);
+    assert(body->redirection_count == 1);
+    char *str = str_of_pipeline(pips->pipelines[0]);
+    assert(strcmp(str, "greet() { echo hello $1; } > out") == 0);
+    free(str);
+    assert(pips->pipelines[1]->commands[0]->group_type == GROUP_NONE);
+    free_pipeline_list(pips);
+
+    pips = parse_pipeline_list("in-dir ( ) ( cd x && ls )");
+    assert(pips != NULL);
+    assert(strcmp(pips->pipelines[0]->commands[0]->name, "in-dir") == 0);
+    assert(pips->pipelines[0]->commands[0]->group->pipelines[0]->commands[0]->group_type == GROUP_SUBSHELL);
+    free_pipeline_list(pips);
+
+    // The body is a compound command, possibly on the next line
+    assert(parse_pipeline_list("f() ls") == NULL);
+    assert(parse_pipeline_list("f()") == NULL);
+    assert(parse_pipeline_list("f() g() { ls; }") == NULL);
+    assert(is_incomplete_input("f() "));
+    assert(!is_incomplete_input("echo $(ls)"));
+    char *input = strdup("f()");
+    input = join_continuation_line(input, "{ ls; }");
+    assert(strcmp(input, "f() { ls; }") == 0);
+    free(input);
+}
+
+bool aliases_expand_to(const char *input, const char *expected) {
+    char *expanded = expand_aliases(input);
+    bool same = expanded != NULL && strcmp(expanded, expected) == 0;
+    free(expanded);
+    return same;
+}
+
+void test_expand_aliases() {
+    assert(expand_aliases("ll") == NULL);
+    set_alias("ll", "ls -l");
+    set_alias("ls", "ls -F");
+    set_alias("run", "nice ");
+
+    // Only the words starting a command are expanded, an alias not in its own value
+    assert(aliases_expand_to("ll x; echo ll | ll>out", "ls -F -l x; echo ll | ls -F -l>out"));
+    assert(aliases_expand_to("if ll; then { ls; }; fi", "if ls -F -l; then { ls -F; }; fi"));
+    assert(aliases_expand_to("echo $(ll)", "echo $(ls -F -l)"));
+    assert(expand_aliases("echo ll lls") == NULL);
+
+    // A value ending with a blank makes the next word start a command
+    assert(aliases_expand_to("run ll", "nice  ls -F -l"));
+
+    pipeline_list *pips = parse_pipeline_list("ll dir");
+    assert(pips != NULL);
+    assert(pips->pipelines[0]->commands[0]->argc == 4);
+    free_pipeline_list(pips);
+
+    assert(unset_alias("ls"));
+    assert(!unset_alias("ls"));
+    assert(aliases_expand_to("ll", "ls -l"));
+    unset_aliases();
+    assert(expand_aliases("ll") == NULL);
+    free_functions();
+}
+
+void test_parse_pipeline_list_with_timeouts() {
+    unsigned long timeout_ms;
+    int timeout_signal;
+    assert(timeout_prefix_length("timeout 1.5 sleep 3", &timeout_ms, &timeout_signal) == 12);
+    assert(timeout_ms == 1500);
+    assert(timeout_signal == SIGTERM);
+    assert(timeout_prefix_length("timeout -s KILL 2m make", &timeout_ms, &timeout_signal) == 19);
+    assert(timeout_ms == 120000);
+    assert(timeout_signal == SIGKILL);
+    assert(timeout_prefix_length("timeout 1 -s SIGINT cmd", &timeout_ms, &timeout_signal) == 20);
+    assert(timeout_signal == SIGINT);
+    assert(timeout_prefix_length("timeout 1x cmd", &timeout_ms, &timeout_signal) == 0);
+    assert(timeout_prefix_length("timeout -s NOPE 1 cmd", &timeout_ms, &timeout_signal) == 0);
+    assert(timeout_prefix_length("timeouts 1 cmd", &timeout_ms, &timeout_signal) == 0);
+
+    // The prefix applies to the whole pipeline, and is left as a command when nothing follows it
+    pipeline_list *pips = parse_pipeline_list("timeout 0.25 { make; } | tee log; timeout 5");
+    assert(pips != NULL);
+    assert(pips->pipeline_count == 2);
+    assert(pips->pipelines[0]->timeout_ms == 250);
+    assert(pips->pipelines[0]->command_count == 2);
+    assert(pips->pipelines[0]->commands[0]->group_type == GROUP_BRACES);
+    char *str = str_of_pipeline(pips->pipelines[0]);
+    assert(strcmp(str, "timeout 0.250 { make; } | tee log") == 0);
+    free(str);
+    assert(pips->pipelines[1]->timeout_ms == 0);
+    assert(strcmp(pips->pipelines[1]->commands[0]->name, "timeout") == 0);
+    free_pipeline_list(pips);
+}
+
+void test_parse_pipeline_list_with_captured_jobs() {
+    pipeline_list *pips = parse_pipeline_list("make | tee log &! sleep 1 & ls &!");
+    assert(pips != NULL);
+    assert(pips->pipeline_count == 3);
+    assert(pips->pipelines[0]->to_job && pips->pipelines[0]->capture_output);
+    assert(pips->pipelines[0]->command_count == 2);
+    assert(pips->pipelines[1]->to_job && !pips->pipelines[1]->capture_output);
+    assert(pips->pipelines[2]->to_job && pips->pipelines[2]->capture_output);
+    assert(pips->pipelines[2]->commands[0]->argc == 1);
+    char *str = str_of_pipeline_list(pips);
+    assert(strcmp(str, "make | tee log &! sleep 1 & ls &!") == 0);
+    free(str);
+    free_pipeline_list(pips);
+}
@@ -0,0 +1,206 @@
+#define _GNU_SOURCE
+#include <assert.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../../src/run/fanout.h"
+#include "../../src/utils/fd_utils.h"
+#include "test_fanout.h"
+
+#define FANOUT_TEST_MAX_TARGETS 3
+
+void test_fanout_to_pipes();
+void test_fanout_with_target_closed_early();
+void test_fanout_to_regular_file();
+
+void test_fanout() {
+    printf("Test function fanout_to_pipes\n");
+    test_fanout_to_pipes();
+    printf("Test fanout_to_pipes passed\n");
+
+    printf("Test function fanout_with_target_closed_early\n");
+    test_fanout_with_target_closed_early();
+    printf("Test fanout_with_target_closed_early passed\n");
+
+    printf("Test function fanout_to_regular_file\n");
+    test_fanout_to_regular_file();
+    printf("Test fanout_to_regular_file passed\n");
+}
+
+/* Returns the number of bytes sent through the relay, several times the size of a pipe and not a multiple of it */
+size_t fanout_test_size() {
+    int tube[2];
+    assert(pipe(tube) == 0);
+    int pipe_size = fcntl(tube[0], F_GETPIPE_SZ);
+    close(tube[0]);
+    close(tube[1]);
+    assert(pipe_size > 0);
+    return 4 * (size_t)pipe_size + 12345;
+}
+
+/* Returns the bytes sent through the relay, which differ from one offset to the next */
+char *fanout_test_data(size_t len) {
+    char *data = malloc(len);
+    assert(data != NULL);
+    for (size_t i = 0; i < len; i++) {
+        data[i] = (char)(i * 31 + i / 251);
+    }
+    return data;
+}
+
+typedef struct {
+    int file;
+    pid_t reader;
+    bool is_pipe;
+} fanout_test_target;
+/* A target of the relay: a pipe read by a child which copies it to the file, or the file itself */
+
+/*
+ * Starts a child copying a new pipe to the file up to limit bytes, then closing the pipe, and returns the write end
+ * of the pipe. Only the child keeps its read end, so that closing it is seen by the relay.
+ */
+int start_fanout_test_reader(fanout_test_target *target, size_t limit) {
+    char path[] = "/tmp/jsh_test_fanout_XXXXXX";
+    target->file = mkstemp(path);
+    assert(target->file != -1);
+    unlink(path);
+    target->is_pipe = true;
+
+    int tube[2];
+    assert(pipe(tube) == 0);
+    target->reader = fork();
+    assert(target->reader != -1);
+    if (target->reader == 0) {
+        close(tube[1]);
+        char buffer[4096];
+        size_t total = 0;
+        while (total < limit) {
+            size_t to_read = limit - total < sizeof(buffer) ? limit - total : sizeof(buffer);
+            ssize_t nread = read(tube[0], buffer, to_read);
+            if (nread <= 0) {
+                break;
+            }
+            assert(write_all(target->file, buffer, nread));
+            total += nread;
+        }
+        close(tube[0]);
+        _exit(EXIT_SUCCESS);
+    }
+    close(tube[0]);
+    return tube[1];
+}
+
+/* Sends the data through a relay to the targets, whose descriptors are given, and waits for all of them */
+void send_through_fanout(const char *data, size_t len, fanout_test_target *targets, int *fds, size_t target_count) {
+    int input_fd;
+    // The relay exits with exit(3), the output buffered so far must not be written twice
+    fflush(stdout);
+    pid_t relay_pid = start_fanout_relay(fds, target_count, &input_fd);
+    for (size_t i = 0; i < target_count; i++) {
+        if (targets[i].is_pipe) {
+            close(fds[i]);
+        }
+    }
+    // The relay does not stop for a target closed early, the write never fails
+    assert(write_all(input_fd, data, len));
+    close(input_fd);
+
+    int status;
+    assert(waitpid(relay_pid, &status, 0) == relay_pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+    for (size_t i = 0; i < target_count; i++) {
+        if (targets[i].is_pipe) {
+            assert(waitpid(targets[i].reader, &status, 0) == targets[i].reader);
+        }
+    }
+}
+
+/* Returns true if the file of the target holds exactly the len first bytes of the data, and closes it */
+bool target_received(fanout_test_target *target, const char *data, size_t len) {
+    struct stat st;
+    assert(fstat(target->file, &st) == 0);
+    bool same = (size_t)st.st_size == len;
+    if (same) {
+        char *content = malloc(len);
+        assert(content != NULL);
+        assert(pread(target->file, content, len, 0) == (ssize_t)len);
+        same = memcmp(content, data, len) == 0;
+        free(content);
+    }
+    close(target->file);
+    return same;
+}
+
+void test_fanout_to_pipes() {
+    size_t len = fanout_test_size();
+    char *data = fanout_test_data(len);
+
+    for (size_t target_count = 2; target_count <= FANOUT_TEST_MAX_TARGETS; target_count++) {
+        fanout_test_target targets[FANOUT_TEST_MAX_TARGETS];
+        int fds[FANOUT_TEST_MAX_TARGETS];
+        for (size_t i = 0; i < target_count; i++) {
+            fds[i] = start_fanout_test_reader(&targets[i], len);
+        }
+        send_through_fanout(data, len, targets, fds, target_count);
+        for (size_t i = 0; i < target_count; i++) {
+            assert(target_received(&targets[i], data, len));
+        }
+    }
+    free(data);
+}
+
+void test_fanout_with_target_closed_early() {
+    size_t len = fanout_test_size();
+    char *data = fanout_test_data(len);
+
+    // Each target in turn stops reading, at once or after a part of the data, the others get everything
+    size_t limits[] = {0, len / 3};
+    for (size_t l = 0; l < sizeof(limits) / sizeof(limits[0]); l++) {
+        for (size_t closed = 0; closed < FANOUT_TEST_MAX_TARGETS; closed++) {
+            fanout_test_target targets[FANOUT_TEST_MAX_TARGETS];
+            int fds[FANOUT_TEST_MAX_TARGETS];
+            for (size_t i = 0; i < FANOUT_TEST_MAX_TARGETS; i++) {
+                fds[i] = start_fanout_test_reader(&targets[i], i == closed ? limits[l] : len);
+            }
+            send_through_fanout(data, len, targets, fds, FANOUT_TEST_MAX_TARGETS);
+            for (size_t i = 0; i < FANOUT_TEST_MAX_TARGETS; i++) {
+                assert(target_received(&targets[i], data, i == closed ? limits[l] : len));
+            }
+        }
+    }
+    free(data);
+}
+
+void test_fanout_to_regular_file() {
+    size_t len = fanout_test_size();
+    char *data = fanout_test_data(len);
+
+    // splice(2) refuses a file opened in append mode, the bytes are copied with read and write instead
+    char path[] = "/tmp/jsh_test_fanout_file_XXXXXX";
+    int file = mkstemp(path);
+    assert(file != -1);
+    close(file);
+    for (size_t position = 0; position < 2; position++) {
+        fanout_test_target targets[2];
+        int fds[2];
+        fds[1 - position] = start_fanout_test_reader(&targets[1 - position], len);
+        fds[position] = open(path, O_WRONLY | O_TRUNC | O_APPEND);
+        assert(fds[position] != -1);
+        targets[position].file = open(path, O_RDONLY);
+        assert(targets[position].file != -1);
+        targets[position].is_pipe = false;
+
+        send_through_fanout(data, len, targets, fds, 2);
+        close(fds[position]);
+        assert(target_received(&targets[0], data, len));
+        assert(target_received(&targets[1], data, len));
+    }
+    unlink(path);
+    free(data);
+}
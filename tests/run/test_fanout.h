@@ -0,0 +1,6 @@
+#ifndef TEST_FANOUT_H
+#define TEST_FANOUT_H
+
+void test_fanout();
+
+#endif
@@ -0,0 +1,87 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../../src/utils/core.h"
+#include "../../src/utils/event_log.h"
+#include "../../src/utils/variables.h"
+#include "../builtins/test_assignment.h"
+#include "test_groups.h"
+
+void test_contained_subshells();
+void test_forked_subshells();
+
+void test_groups() {
+    printf("Test function contained_subshells\n");
+    test_contained_subshells();
+    printf("Test contained_subshells passed\n");
+
+    printf("Test function forked_subshells\n");
+    test_forked_subshells();
+    printf("Test forked_subshells passed\n");
+}
+
+/*
+ * Runs the line with the events logged, sets status to its status and returns the number of processes it started
+ */
+size_t spawns_of_line(const char *line, int *status) {
+    char path[] = "/tmp/jsh_test_groups_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd != -1);
+    close(fd);
+    assert(open_event_log(path));
+    *status = status_of_line(line);
+    close_event_log();
+
+    FILE *log = fopen(path, "r");
+    assert(log != NULL);
+    size_t spawns = 0;
+    char event[EVENT_LOG_LINE_SIZE + 1];
+    while (fgets(event, sizeof(event), log) != NULL) {
+        spawns += strstr(event, "\"event\":\"spawn\"") != NULL;
+    }
+    fclose(log);
+    unlink(path);
+    return spawns;
+}
+
+void test_contained_subshells() {
+    int status;
+
+    // A subshell of builtins which only read the state of jsh is run by jsh itself
+    assert(spawns_of_line("( pwd )", &status) == 0);
+    assert(status == 0);
+    assert(spawns_of_line("( pwd; { pwd; } )", &status) == 0);
+    assert(status == 0);
+
+    // As soon as one of its commands is not such a builtin, it is forked
+    assert(spawns_of_line("( pwd; /bin/true )", &status) > 0);
+}
+
+void test_forked_subshells() {
+    int status;
+    char *folder = strdup(current_folder);
+    char *cwd = getcwd(NULL, 0);
+    assert(folder != NULL && cwd != NULL);
+
+    // A subshell changing the state of jsh is forked, its changes being lost with it
+    assert(spawns_of_line("( cd / )", &status) > 0);
+    assert(status == 0);
+    assert(strcmp(current_folder, folder) == 0);
+    char *cwd_after = getcwd(NULL, 0);
+    assert(cwd_after != NULL && strcmp(cwd_after, cwd) == 0);
+    free(cwd_after);
+
+    assert(spawns_of_line("( jsh_test_subshell=1 )", &status) > 0);
+    assert(status == 0);
+    assert(get_variable("jsh_test_subshell", strlen("jsh_test_subshell")) == NULL);
+
+    // Exiting leaves the subshell only, with its status
+    assert(spawns_of_line("( exit 3 )", &status) > 0);
+    assert(status == 3);
+
+    free(folder);
+    free(cwd);
+}
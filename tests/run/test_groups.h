@@ -0,0 +1,6 @@
+#ifndef TEST_GROUPS_H
+#define TEST_GROUPS_H
+
+void test_groups();
+
+#endif
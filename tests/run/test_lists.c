@@ -0,0 +1,53 @@
+#include <assert.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../../src/utils/variables.h"
+#include "../builtins/test_assignment.h"
+#include "test_lists.h"
+
+void test_lists_with_signalled_commands();
+
+void test_lists() {
+    printf("Test function lists_with_signalled_commands\n");
+    test_lists_with_signalled_commands();
+    printf("Test lists_with_signalled_commands passed\n");
+}
+
+/* Returns true if the variable is set */
+bool is_variable_set(const char *name) {
+    return get_variable(name, strlen(name)) != NULL;
+}
+
+void test_lists_with_signalled_commands() {
+    char path[] = "/tmp/jsh_test_selfkill_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd != -1);
+    const char *script = "#!/bin/sh\nkill -TERM $$\n";
+    assert(write(fd, script, strlen(script)) == (ssize_t)strlen(script));
+    close(fd);
+    assert(chmod(path, 0700) == 0);
+    char line[128];
+
+    // A command killed by a signal fails with 128 plus the signal
+    assert(status_of_line(path) == 128 + SIGTERM);
+
+    // `&&` stops after it, and `||` goes on
+    snprintf(line, sizeof(line), "%s && jsh_test_and_ran=1", path);
+    assert(status_of_line(line) == 128 + SIGTERM);
+    assert(!is_variable_set("jsh_test_and_ran"));
+    snprintf(line, sizeof(line), "%s || jsh_test_or_ran=1", path);
+    assert(status_of_line(line) == 0);
+    assert(is_variable_set("jsh_test_or_ran"));
+
+    // The condition of an if fails with it too
+    snprintf(line, sizeof(line), "if %s; then jsh_test_then_ran=1; fi", path);
+    status_of_line(line);
+    assert(!is_variable_set("jsh_test_then_ran"));
+
+    unlink(path);
+}
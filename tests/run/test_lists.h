@@ -0,0 +1,6 @@
+#ifndef TEST_LISTS_H
+#define TEST_LISTS_H
+
+void test_lists();
+
+#endif
@@ -1,10 +1,35 @@
+#include "builtins/test_assignment.h"
+#include "builtins/test_builtins.h"
+#include "builtins/test_chunked.h"
+#include "builtins/test_extern_command.h"
+#include "builtins/test_wait.h"
 #include "parser/test_parser.h"
+#include "run/test_fanout.h"
+#include "run/test_groups.h"
+#include "run/test_lists.h"
 #include <assert.h>
 #include <stdio.h>
 
+#include "utils/test_arithmetic.h"
+#include "utils/test_brace_expansion.h"
+#include "utils/test_directory_fds.h"
+#include "utils/test_event_log.h"
+#include "utils/test_event_loop.h"
+#include "utils/test_flight_recorder.h"
+#include "utils/test_frecency.h"
+#include "utils/test_functions.h"
+#include "utils/test_glob_expansion.h"
+#include "utils/test_history_file.h"
+#include "utils/test_job_output.h"
 #include "utils/test_jobs_core.h"
 #include "utils/test_int_utils.h"
+#include "utils/test_path_index.h"
+#include "utils/test_proc_stats.h"
+#include "utils/test_process_tree.h"
+#include "utils/test_prompt_segments.h"
 #include "utils/test_string_utils.h"
+#include "utils/test_timer_wheel.h"
+#include "utils/test_variables.h"
 int main() {
     printf("Running tests...\n");
 
@@ -25,6 +50,106 @@ int main() {
     test_jobs_core();
     printf("Test jobs_core passed\n");
 
+    printf("Running test glob_expansion\n");
+    test_glob_expansion();
+    printf("Test glob_expansion passed\n");
+
+    printf("Running test history_file\n");
+    test_history_file();
+    printf("Test history_file passed\n");
+
+    printf("Running test path_index\n");
+    test_path_index();
+    printf("Test path_index passed\n");
+
+    printf("Running test frecency\n");
+    test_frecency();
+    printf("Test frecency passed\n");
+
+    printf("Running test directory_fds\n");
+    test_directory_fds();
+    printf("Test directory_fds passed\n");
+
+    printf("Running test variables\n");
+    test_variables();
+    printf("Test variables passed\n");
+
+    printf("Running test functions\n");
+    test_functions();
+    printf("Test functions passed\n");
+
+    printf("Running test arithmetic\n");
+    test_arithmetic();
+    printf("Test arithmetic passed\n");
+
+    printf("Running test brace_expansion\n");
+    test_brace_expansion();
+    printf("Test brace_expansion passed\n");
+
+    printf("Running test timer_wheel\n");
+    test_timer_wheel();
+    printf("Test timer_wheel passed\n");
+
+    printf("Running test job_output\n");
+    test_job_output();
+    printf("Test job_output passed\n");
+
+    printf("Running test proc_stats\n");
+    test_proc_stats();
+    printf("Test proc_stats passed\n");
+
+    printf("Running test process_tree\n");
+    test_process_tree();
+    printf("Test process_tree passed\n");
+
+    printf("Running test event_log\n");
+    test_event_log();
+    printf("Test event_log passed\n");
+
+    printf("Running test prompt_segments\n");
+    test_prompt_segments();
+    printf("Test prompt_segments passed\n");
+
+    printf("Running test event_loop\n");
+    test_event_loop();
+    printf("Test event_loop passed\n");
+
+    printf("Running test flight_recorder\n");
+    test_flight_recorder();
+    printf("Test flight_recorder passed\n");
+
+    printf("Running test builtins\n");
+    test_builtins();
+    printf("Test builtins passed\n");
+
+    printf("Running test assignment\n");
+    test_assignment();
+    printf("Test assignment passed\n");
+
+    printf("Running test extern_command\n");
+    test_extern_command();
+    printf("Test extern_command passed\n");
+
+    printf("Running test chunked\n");
+    test_chunked();
+    printf("Test chunked passed\n");
+
+    printf("Running test wait\n");
+    test_wait();
+    printf("Test wait passed\n");
+
+    printf("Running test lists\n");
+    test_lists();
+    printf("Test lists passed\n");
+
+    printf("Running test fanout\n");
+    test_fanout();
+    printf("Test fanout passed\n");
+
+    printf("Running test groups\n");
+    test_groups();
+    printf("Test groups passed\n");
+
     printf("All test cases passed!\n");
 
     return 0;
@@ -0,0 +1,96 @@
+#include <assert.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../../src/utils/arithmetic.h"
+#include "../../src/utils/variables.h"
+#include "test_arithmetic.h"
+
+void test_arithmetic_operators();
+void test_arithmetic_variables();
+void test_arithmetic_errors();
+
+void test_arithmetic() {
+    printf("Test function arithmetic_operators\n");
+    test_arithmetic_operators();
+    printf("Test arithmetic_operators passed\n");
+
+    printf("Test function arithmetic_variables\n");
+    test_arithmetic_variables();
+    printf("Test arithmetic_variables passed\n");
+
+    printf("Test function arithmetic_errors\n");
+    test_arithmetic_errors();
+    printf("Test arithmetic_errors passed\n");
+
+    free_variables();
+}
+
+bool evaluates_to(const char *expression, long long expected) {
+    long long result;
+    return evaluate_arithmetic(expression, strlen(expression), &result) && result == expected;
+}
+
+void test_arithmetic_operators() {
+    assert(evaluates_to("", 0));
+    assert(evaluates_to("1 + 2 * 3", 7));
+    assert(evaluates_to("(1 + 2) * 3", 9));
+    assert(evaluates_to("10 - 4 - 3", 3));
+    assert(evaluates_to("-7 / 2", -3));
+    assert(evaluates_to("-7 % 3", -1));
+    assert(evaluates_to("2 ** 3 ** 2", 512));
+    assert(evaluates_to("-2 ** 2", 4));
+    assert(evaluates_to("1 << 4 | 3 & 1 ^ 2", 19));
+    assert(evaluates_to("~0 == -1 && !0", 1));
+    assert(evaluates_to("3 > 2 > 1", 0));
+    assert(evaluates_to("0x1f + 010", 39));
+    assert(evaluates_to("1 ? 2 : 0 ? 3 : 4", 2));
+    assert(evaluates_to("1, 2, 3", 3));
+
+    // The arithmetic wraps around instead of being undefined
+    assert(evaluates_to("9223372036854775807 + 1", LLONG_MIN));
+    assert(evaluates_to("(-9223372036854775807 - 1) / -1", LLONG_MIN));
+    assert(evaluates_to("1 << 64", 1));
+}
+
+void test_arithmetic_variables() {
+    assert(evaluates_to("unset_variable + 1", 1));
+    set_variable("i", "5");
+    assert(evaluates_to("i * 2", 10));
+    assert(evaluates_to("i += 3", 8));
+    assert(strcmp(get_variable("i", 1), "8") == 0);
+    assert(evaluates_to("i++ + ++i", 18));
+    assert(evaluates_to("i--", 10));
+    assert(evaluates_to("a = b = 4", 4));
+    assert(strcmp(get_variable("a", 1), "4") == 0);
+
+    // A value which is not a number is evaluated as an expression
+    set_variable("e", "b * 2");
+    assert(evaluates_to("e + 1", 9));
+
+    // The operand not evaluated assigns nothing
+    assert(evaluates_to("0 && (i = 1), 1 || (i = 2), 0 ? i = 3 : i", 9));
+    assert(strcmp(get_variable("i", 1), "9") == 0);
+}
+
+void test_arithmetic_errors() {
+    long long result;
+    assert(!evaluate_arithmetic("1 / 0", 5, &result));
+    assert(!evaluate_arithmetic("2 % (1 - 1)", 11, &result));
+    assert(!evaluate_arithmetic("2 ** -1", 7, &result));
+    assert(!evaluate_arithmetic("1 +", 3, &result));
+    assert(!evaluate_arithmetic("(1", 2, &result));
+    assert(!evaluate_arithmetic("1 = 2", 5, &result));
+    assert(!evaluate_arithmetic("1 ? 2", 5, &result));
+    assert(!evaluate_arithmetic("09", 2, &result));
+    assert(!evaluate_arithmetic("2 # 3", 5, &result));
+
+    // A variable whose value refers to itself is not evaluated forever
+    set_variable("loop", "loop + 1");
+    assert(!evaluate_arithmetic("loop", 4, &result));
+
+    // Only the given length is read
+    assert(evaluate_arithmetic("1 + 2))", 5, &result) && result == 3);
+}
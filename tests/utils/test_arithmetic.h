@@ -0,0 +1,6 @@
+#ifndef TEST_ARITHMETIC_H
+#define TEST_ARITHMETIC_H
+
+void test_arithmetic();
+
+#endif
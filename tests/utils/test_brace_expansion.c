@@ -0,0 +1,94 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/utils/brace_expansion.h"
+#include "test_brace_expansion.h"
+
+void test_brace_lists();
+void test_brace_ranges();
+void test_words_without_brace_expansion();
+
+void test_brace_expansion() {
+    printf("Test function brace_lists\n");
+    test_brace_lists();
+    printf("Test brace_lists passed\n");
+
+    printf("Test function brace_ranges\n");
+    test_brace_ranges();
+    printf("Test brace_ranges passed\n");
+
+    printf("Test function words_without_brace_expansion\n");
+    test_words_without_brace_expansion();
+    printf("Test words_without_brace_expansion passed\n");
+}
+
+/* Returns true if the words of the expansion of the word, joined by spaces, are the expected ones */
+bool brace_expands_to(const char *word, const char *expected) {
+    brace_expansion expansion;
+    if (!start_brace_expansion(word, &expansion)) {
+        return false;
+    }
+    char *joined = malloc(expansion.count * (expansion.max_len + 1) + 1);
+    assert(joined != NULL);
+    joined[0] = '\0';
+    for (size_t i = 0; i < expansion.count; i++) {
+        const char *generated = brace_expansion_word(&expansion, i);
+        assert(strlen(generated) <= expansion.max_len);
+        if (i > 0) {
+            strcat(joined, " ");
+        }
+        strcat(joined, generated);
+    }
+    bool matches = strcmp(joined, expected) == 0;
+    free(joined);
+    end_brace_expansion(&expansion);
+    return matches;
+}
+
+void test_brace_lists() {
+    assert(brace_expands_to("{a,b,c}", "a b c"));
+    assert(brace_expands_to("x{a,b}y", "xay xby"));
+    assert(brace_expands_to("{a,b}{1,2}", "a1 a2 b1 b2"));
+    assert(brace_expands_to("{a,b{1,2},c}", "a b1 b2 c"));
+    assert(brace_expands_to("x{,a}", "x xa"));
+    assert(brace_expands_to("{a,{b},c}", "a {b} c"));
+    assert(brace_expands_to("{a{b,c}}", "{ab} {ac}"));
+    assert(brace_expands_to("{a,{b,c}", "{a,b {a,c"));
+    assert(brace_expands_to("{$x,${y}}", "$x ${y}"));
+}
+
+void test_brace_ranges() {
+    assert(brace_expands_to("{1..5}", "1 2 3 4 5"));
+    assert(brace_expands_to("{3..-1}", "3 2 1 0 -1"));
+    assert(brace_expands_to("{0..10..4}", "0 4 8"));
+    assert(brace_expands_to("{10..1..-3}", "10 7 4 1"));
+    assert(brace_expands_to("{1..3..0}", "1 2 3"));
+    assert(brace_expands_to("{08..11}", "08 09 10 11"));
+    assert(brace_expands_to("{-02..1}", "-02 -01 000 001"));
+    assert(brace_expands_to("{a..e..2}", "a c e"));
+    assert(brace_expands_to("{C..A}{1..2}", "C1 C2 B1 B2 A1 A2"));
+    assert(brace_expands_to("f{1..2}.{c,h}", "f1.c f1.h f2.c f2.h"));
+
+    brace_expansion expansion;
+    assert(start_brace_expansion("{1..100000}", &expansion));
+    assert(expansion.count == 100000);
+    assert(expansion.max_len == 6);
+    assert(strcmp(brace_expansion_word(&expansion, 99999), "100000") == 0);
+    end_brace_expansion(&expansion);
+
+    // A word which would be too long is an error
+    assert(start_brace_expansion("{1..100000}{1..1000}", &expansion));
+    assert(expansion.count == 0);
+    end_brace_expansion(&expansion);
+}
+
+void test_words_without_brace_expansion() {
+    brace_expansion expansion;
+    const char *words[] = {"word", "{}", "{a}", "{a,b", "a,b}", "{1..a}", "{1..5..x}", "{a..9}", "${a,b}"};
+    for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+        assert(!start_brace_expansion(words[i], &expansion));
+    }
+}
@@ -0,0 +1,6 @@
+#ifndef TEST_BRACE_EXPANSION_H
+#define TEST_BRACE_EXPANSION_H
+
+void test_brace_expansion();
+
+#endif
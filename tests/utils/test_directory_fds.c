@@ -0,0 +1,136 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../../src/utils/core.h"
+#include "../../src/utils/directory_fds.h"
+#include "../builtins/test_assignment.h"
+#include "test_directory_fds.h"
+
+void test_logical_path();
+void test_directory_fd();
+void test_redirection_in_moved_directory();
+
+void test_directory_fds() {
+    printf("Test function logical_path\n");
+    test_logical_path();
+    printf("Test logical_path passed\n");
+
+    printf("Test function directory_fd\n");
+    test_directory_fd();
+    printf("Test directory_fd passed\n");
+
+    printf("Test function redirection_in_moved_directory\n");
+    test_redirection_in_moved_directory();
+    printf("Test redirection_in_moved_directory passed\n");
+}
+
+bool logical_path_is(const char *current, const char *path, const char *expected) {
+    char *result = logical_path(current, path);
+    bool same = strcmp(result, expected) == 0;
+    free(result);
+    return same;
+}
+
+void test_logical_path() {
+    assert(logical_path_is("/home/user", "src", "/home/user/src"));
+    assert(logical_path_is("/home/user", "./src/../doc/", "/home/user/doc"));
+    assert(logical_path_is("/home/user", "..", "/home"));
+    assert(logical_path_is("/home/user", "../..", "/"));
+    assert(logical_path_is("/home/user", "../../../..", "/"));
+    assert(logical_path_is("/home/user", "/usr//local/./bin", "/usr/local/bin"));
+    assert(logical_path_is("/", ".", "/"));
+    assert(logical_path_is("/", "tmp", "/tmp"));
+}
+
+void test_directory_fd() {
+    char directory[] = "/tmp/jsh_test_directory_fds_XXXXXX";
+    assert(mkdtemp(directory) != NULL);
+
+    int fd = directory_fd(directory);
+    assert(fd != -1);
+    assert(directory_fd(directory) == fd);
+
+    // The descriptor of a removed directory is not used again
+    assert(rmdir(directory) == 0);
+    assert(directory_fd(directory) == -1);
+    assert(mkdir(directory, 0700) == 0);
+    fd = directory_fd(directory);
+    assert(fd != -1);
+    struct stat fd_st, path_st;
+    assert(fstat(fd, &fd_st) == 0 && stat(directory, &path_st) == 0);
+    assert(fd_st.st_ino == path_st.st_ino);
+
+    // Nor the one of a directory moved, or of a symbolic link retargeted, the path leading to another one
+    char moved[64], link[64], target[64];
+    snprintf(moved, sizeof(moved), "%s/moved", directory);
+    snprintf(link, sizeof(link), "%s/link", directory);
+    snprintf(target, sizeof(target), "%s/target", directory);
+    assert(mkdir(moved, 0700) == 0 && mkdir(target, 0700) == 0);
+    assert(symlink(moved, link) == 0);
+    int moved_fd = directory_fd(moved);
+    assert(moved_fd != -1);
+    assert(directory_fd(link) != -1);
+    char renamed[64];
+    snprintf(renamed, sizeof(renamed), "%s/renamed", directory);
+    assert(rename(moved, renamed) == 0 && mkdir(moved, 0700) == 0);
+    assert(stat(moved, &path_st) == 0);
+    assert(fstat(directory_fd(moved), &fd_st) == 0 && fd_st.st_ino == path_st.st_ino);
+    assert(unlink(link) == 0 && symlink(target, link) == 0);
+    assert(stat(target, &path_st) == 0);
+    assert(fstat(directory_fd(link), &fd_st) == 0 && fd_st.st_ino == path_st.st_ino);
+    close_directory_fds();
+    unlink(link);
+    rmdir(moved);
+    rmdir(renamed);
+    rmdir(target);
+    fd = directory_fd(directory);
+
+    // The retained descriptors are not evicted by the others
+    retain_directory_fd(directory);
+    for (int i = 0; i < DIRECTORY_FDS_SIZE; i++) {
+        char other[64];
+        snprintf(other, sizeof(other), "%s/%d", directory, i);
+        assert(mkdir(other, 0700) == 0);
+        assert(directory_fd(other) != -1);
+    }
+    assert(directory_fd(directory) == fd);
+    release_directory_fd(directory);
+
+    close_directory_fds();
+    for (int i = 0; i < DIRECTORY_FDS_SIZE; i++) {
+        char other[64];
+        snprintf(other, sizeof(other), "%s/%d", directory, i);
+        rmdir(other);
+    }
+    rmdir(directory);
+}
+
+void test_redirection_in_moved_directory() {
+    char *previous = getcwd(NULL, 0);
+    assert(previous != NULL);
+    char directory[] = "/tmp/jsh_test_moved_directory_XXXXXX";
+    assert(mkdtemp(directory) != NULL);
+    char moved[64], file[80];
+    snprintf(moved, sizeof(moved), "%s_moved", directory);
+    snprintf(file, sizeof(file), "%s/file", moved);
+
+    // A relative redirection is opened in the current directory, even once its path names another one
+    assert(change_pwd(directory) == 0);
+    update_current_folder();
+    assert(rename(directory, moved) == 0 && mkdir(directory, 0700) == 0);
+    assert(status_of_line("true >| file") == 0);
+    struct stat st;
+    assert(stat(file, &st) == 0);
+    assert(rmdir(directory) == 0);
+
+    assert(change_pwd(previous) == 0);
+    update_current_folder();
+    unlink(file);
+    rmdir(moved);
+    free(previous);
+}
@@ -0,0 +1,6 @@
+#ifndef TEST_DIRECTORY_FDS_H
+#define TEST_DIRECTORY_FDS_H
+
+void test_directory_fds();
+
+#endif
@@ -0,0 +1,154 @@
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../../src/utils/event_log.h"
+#include "test_event_log.h"
+
+void test_events_written_in_batches();
+void test_event_strings_escaped();
+void test_status_events();
+
+void test_event_log() {
+    printf("Test function events_written_in_batches\n");
+    test_events_written_in_batches();
+    printf("Test events_written_in_batches passed\n");
+
+    printf("Test function event_strings_escaped\n");
+    test_event_strings_escaped();
+    printf("Test event_strings_escaped passed\n");
+
+    printf("Test function status_events\n");
+    test_status_events();
+    printf("Test status_events passed\n");
+}
+
+/* Opens the log in a new temporary file, whose path is set */
+void open_test_event_log(char *path) {
+    strcpy(path, "/tmp/jsh_test_event_log_XXXXXX");
+    int fd = mkstemp(path);
+    assert(fd != -1);
+    close(fd);
+    assert(open_event_log(path));
+    assert(is_event_log_open());
+}
+
+/* Returns the content of the log, to be freed */
+char *read_test_event_log(const char *path) {
+    int fd = open(path, O_RDONLY);
+    assert(fd != -1);
+    struct stat st;
+    assert(fstat(fd, &st) == 0);
+    char *content = malloc(st.st_size + 1);
+    assert(content != NULL);
+    assert(read(fd, content, st.st_size) == st.st_size);
+    content[st.st_size] = '\0';
+    close(fd);
+    return content;
+}
+
+size_t count_lines(const char *content) {
+    size_t count = 0;
+    for (const char *c = content; *c != '\0'; c++) {
+        count += *c == '\n';
+    }
+    return count;
+}
+
+void test_events_written_in_batches() {
+    char path[64];
+    open_test_event_log(path);
+    char *argv[] = {"cd", "/tmp", NULL};
+    command_without_substitution cmd = {0};
+    cmd.name = argv[0];
+    cmd.argc = 2;
+    cmd.argv = argv;
+
+    // Nothing is written until the batch is full
+    for (size_t i = 0; i < EVENT_LOG_BATCH_SIZE - 1; i++) {
+        log_builtin_event(&cmd, 0, event_log_time());
+    }
+    char *content = read_test_event_log(path);
+    assert(content[0] == '\0');
+    free(content);
+
+    log_builtin_event(&cmd, 1, event_log_time());
+    content = read_test_event_log(path);
+    assert(count_lines(content) == EVENT_LOG_BATCH_SIZE);
+    assert(strncmp(content, "{\"time_ns\":", 11) == 0);
+    assert(strstr(content, "\"event\":\"builtin\",\"status\":0,\"duration_ns\":") != NULL);
+    assert(strstr(content, "\"command\":\"cd /tmp\"}\n") != NULL);
+    assert(strstr(content, "\"status\":1,") != NULL);
+    free(content);
+
+    // The rest is written when the log is closed
+    log_builtin_event(&cmd, 0, event_log_time());
+    close_event_log();
+    assert(!is_event_log_open());
+    log_builtin_event(&cmd, 0, event_log_time());
+    content = read_test_event_log(path);
+    assert(count_lines(content) == EVENT_LOG_BATCH_SIZE + 1);
+    free(content);
+    unlink(path);
+}
+
+void test_event_strings_escaped() {
+    char path[64];
+    open_test_event_log(path);
+    log_parse_event("echo \"a\\b\"\tc\n", 1, event_log_time());
+
+    // A line too long is cut, the event staying a whole object
+    char long_line[3 * EVENT_LOG_LINE_SIZE];
+    memset(long_line, 'x', sizeof(long_line) - 1);
+    long_line[sizeof(long_line) - 1] = '\0';
+    log_parse_event(long_line, 1, event_log_time());
+    flush_event_log();
+
+    char *content = read_test_event_log(path);
+    assert(count_lines(content) == 2);
+    assert(strstr(content, "\"event\":\"parse\",\"pipelines\":1,") != NULL);
+    assert(strstr(content, "\"line\":\"echo \\\"a\\\\b\\\"\\tc\\n\"}\n") != NULL);
+    char *second = strchr(content, '\n') + 1;
+    size_t len = strlen(second);
+    assert(len <= EVENT_LOG_LINE_SIZE);
+    assert(strcmp(second + len - 5, "xx\"}\n") == 0);
+    free(content);
+    close_event_log();
+    unlink(path);
+}
+
+void test_status_events() {
+    char path[64];
+    open_test_event_log(path);
+    job *j = init_job_to_add(1234, 1234, NULL, RUNNING);
+    add_process_to_job(j, 1234, NULL, NULL, RUNNING);
+    process *p = j->job_process[0];
+
+    log_status_event(j, p, RUNNING);
+    p->status = STOPPED;
+    log_status_event(j, p, RUNNING);
+    p->status = RUNNING;
+    log_status_event(j, p, STOPPED);
+    p->status = DONE;
+    p->exit_status = 3;
+    log_status_event(j, p, RUNNING);
+    flush_event_log();
+
+    char *content = read_test_event_log(path);
+    // The spawn is recorded by the addition of the process, an unchanged status is not
+    assert(count_lines(content) == 4);
+    assert(strstr(content, "\"event\":\"spawn\",\"job\":") != NULL);
+    assert(strstr(content, "\"pid\":1234,\"pgid\":1234,\"command\":\"(relay)\"}\n") != NULL);
+    assert(strstr(content, "\"event\":\"stop\"") < strstr(content, "\"event\":\"continue\""));
+    assert(strstr(content, "\"event\":\"continue\"") < strstr(content, "\"event\":\"reap\""));
+    assert(strstr(content, "\"status\":\"done\",\"exit_status\":3,\"duration_ns\":") != NULL);
+    free(content);
+
+    free_job(j);
+    close_event_log();
+    unlink(path);
+}
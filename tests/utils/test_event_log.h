@@ -0,0 +1,6 @@
+#ifndef TEST_EVENT_LOG_H
+#define TEST_EVENT_LOG_H
+
+void test_event_log();
+
+#endif
@@ -0,0 +1,109 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../../src/utils/event_loop.h"
+#include "test_event_loop.h"
+
+void test_watch_fd();
+void test_stop_event_loop();
+
+void test_event_loop() {
+    printf("Test function watch_fd\n");
+    test_watch_fd();
+    printf("Test watch_fd passed\n");
+
+    printf("Test function stop_event_loop\n");
+    test_stop_event_loop();
+    printf("Test stop_event_loop passed\n");
+}
+
+typedef struct {
+    int calls;
+    int stop_after;
+    char last;
+} handler_state;
+/* What a handler of the tests has read, the loop being stopped once it has been called stop_after times */
+
+void read_byte_handler(int fd, void *data) {
+    handler_state *state = data;
+    assert(read(fd, &state->last, 1) == 1);
+    if (++state->calls == state->stop_after) {
+        stop_event_loop();
+    }
+}
+
+/*
+ * Writes a byte to the pipe from a child once the loop waits, so that the loop is woken up by it
+ */
+void write_byte_later(int fd, char byte) {
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        usleep(20000);
+        assert(write(fd, &byte, 1) == 1);
+        _exit(0);
+    }
+}
+
+void test_watch_fd() {
+    assert(init_event_loop());
+    int first[2], second[2];
+    assert(pipe(first) == 0 && pipe(second) == 0);
+
+    // Each handler gets its descriptor and its data
+    handler_state first_state = {0, 2, 0};
+    handler_state second_state = {0, 0, 0};
+    assert(watch_fd(first[0], read_byte_handler, &first_state));
+    assert(watch_fd(second[0], read_byte_handler, &second_state));
+    assert(write(second[1], "b", 1) == 1);
+    assert(write(first[1], "a", 1) == 1);
+    write_byte_later(first[1], 'c');
+    run_event_loop();
+    assert(first_state.calls == 2 && first_state.last == 'c');
+    assert(second_state.calls == 1 && second_state.last == 'b');
+
+    // A regular file cannot be watched
+    char path[] = "/tmp/jsh_test_event_loop_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd != -1);
+    assert(!watch_fd(fd, read_byte_handler, &first_state));
+    close(fd);
+    unlink(path);
+
+    while (wait(NULL) > 0) {
+    }
+    close(first[0]);
+    close(first[1]);
+    close(second[0]);
+    close(second[1]);
+    free_event_loop();
+}
+
+void test_stop_event_loop() {
+    assert(init_event_loop());
+    int first[2], second[2];
+    assert(pipe(first) == 0 && pipe(second) == 0);
+
+    // The events of the same wait after the one which stopped the loop are not handled
+    handler_state state = {0, 1, 0};
+    assert(watch_fd(first[0], read_byte_handler, &state));
+    assert(watch_fd(second[0], read_byte_handler, &state));
+    assert(write(first[1], "a", 1) == 1);
+    assert(write(second[1], "b", 1) == 1);
+    run_event_loop();
+    assert(state.calls == 1);
+
+    // The loop can be run again, handling the event left
+    state.stop_after = 2;
+    run_event_loop();
+    assert(state.calls == 2);
+
+    close(first[0]);
+    close(first[1]);
+    close(second[0]);
+    close(second[1]);
+    free_event_loop();
+}
@@ -0,0 +1,6 @@
+#ifndef TEST_EVENT_LOOP_H
+#define TEST_EVENT_LOOP_H
+
+void test_event_loop();
+
+#endif
@@ -0,0 +1,116 @@
+#include <assert.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../../src/utils/flight_recorder.h"
+#include "test_flight_recorder.h"
+
+void test_dump_of_recorded_events();
+void test_ring_keeps_last_events();
+void test_dump_on_abort();
+
+void test_flight_recorder() {
+    printf("Test function dump_of_recorded_events\n");
+    test_dump_of_recorded_events();
+    printf("Test dump_of_recorded_events passed\n");
+
+    printf("Test function ring_keeps_last_events\n");
+    test_ring_keeps_last_events();
+    printf("Test ring_keeps_last_events passed\n");
+
+    printf("Test function dump_on_abort\n");
+    test_dump_on_abort();
+    printf("Test dump_on_abort passed\n");
+}
+
+/* Returns what the descriptor holds from its beginning, to be freed */
+char *read_dump(int fd) {
+    off_t size = lseek(fd, 0, SEEK_END);
+    char *dump = malloc(size + 1);
+    assert(dump != NULL);
+    assert(pread(fd, dump, size, 0) == size);
+    dump[size] = '\0';
+    return dump;
+}
+
+/* Returns a copy of the dump of the recorder, to be freed */
+char *dump_to_string() {
+    FILE *file = tmpfile();
+    assert(file != NULL);
+    dump_flight_recorder(fileno(file));
+    char *dump = read_dump(fileno(file));
+    fclose(file);
+    return dump;
+}
+
+void test_dump_of_recorded_events() {
+    record_flight_event(FLIGHT_PARSE, 100, 2, "sleep 1 | cat\n");
+    record_flight_event(FLIGHT_FORK, 101, 101, "sleep");
+    record_flight_event(FLIGHT_WAITPID, 101, 0x7f << 8 | 0x7f, NULL);
+    record_flight_event(FLIGHT_WAITPID, 102, 9, NULL);
+    record_flight_event(FLIGHT_WAITPID, 103, -10, NULL);
+    record_flight_event(FLIGHT_SIGNAL_SENT, -101, SIGCONT, "a text longer than the size of the text of an event");
+    char *dump = dump_to_string();
+
+    assert(strncmp(dump, "jsh ", 4) == 0);
+    const char *parse = strstr(dump, "parse           pid     100  pipelines 2  sleep 1 | cat \n");
+    const char *fork = strstr(dump, "fork            pid     101  pgid 101  sleep\n");
+    const char *stopped = strstr(dump, "waitpid         pid     101  stopped by 127\n");
+    const char *killed = strstr(dump, "waitpid         pid     102  killed by 9\n");
+    const char *failed = strstr(dump, "waitpid         pid     103  errno 10\n");
+    const char *sent = strstr(dump, "signal sent     pid    -101  signal 18  a text longer than the size of \n");
+    assert(parse != NULL && fork != NULL && stopped != NULL && killed != NULL && failed != NULL && sent != NULL);
+    // The events are written from the oldest one, with their age
+    assert(parse < fork && fork < stopped && stopped < killed && killed < failed && failed < sent);
+    assert(strstr(dump, "s ago  parse") != NULL);
+    free(dump);
+}
+
+void test_ring_keeps_last_events() {
+    for (int i = 0; i < FLIGHT_RECORDER_SIZE + 10; i++) {
+        record_flight_event(FLIGHT_TCSETPGRP, 1, i, NULL);
+    }
+    char *dump = dump_to_string();
+    char expected[64];
+    snprintf(expected, sizeof(expected), ": last %d of ", FLIGHT_RECORDER_SIZE);
+    assert(strstr(dump, expected) != NULL);
+
+    // The oldest events have been overwritten by the last ones
+    size_t lines = 0;
+    for (const char *c = dump; *c != '\0'; c++) {
+        lines += *c == '\n';
+    }
+    assert(lines == FLIGHT_RECORDER_SIZE + 1);
+    assert(strstr(dump, "result 9\n") == NULL);
+    const char *first = strstr(dump, "result 10\n");
+    snprintf(expected, sizeof(expected), "result %d\n", FLIGHT_RECORDER_SIZE + 9);
+    const char *last = strstr(dump, expected);
+    assert(first != NULL && last != NULL && first < last);
+    free(dump);
+}
+
+void test_dump_on_abort() {
+    FILE *file = tmpfile();
+    assert(file != NULL);
+    fflush(stdout);
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        install_flight_recorder_handlers();
+        record_flight_event(FLIGHT_JOB_STATUS, 4242, 1, "before the abort");
+        dup2(fileno(file), STDERR_FILENO);
+        abort();
+    }
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    // The signal still kills the process once the ring is dumped
+    assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+    char *dump = read_dump(fileno(file));
+    assert(strstr(dump, "job status      pid    4242  Stopped  before the abort\n") != NULL);
+    free(dump);
+    fclose(file);
+}
@@ -0,0 +1,6 @@
+#ifndef TEST_FLIGHT_RECORDER_H
+#define TEST_FLIGHT_RECORDER_H
+
+void test_flight_recorder();
+
+#endif
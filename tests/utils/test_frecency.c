@@ -0,0 +1,83 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../../src/utils/frecency.h"
+#include "test_frecency.h"
+
+void test_find_frecent_directory();
+
+void test_frecency() {
+    printf("Test function find_frecent_directory and flush_frecency_database\n");
+    test_find_frecent_directory();
+    printf("Test find_frecent_directory and flush_frecency_database passed\n");
+}
+
+bool is_directory(char *found, const char *expected) {
+    bool same = found != NULL && strcmp(found, expected) == 0;
+    free(found);
+    return same;
+}
+
+size_t listed_directory_count = 0;
+
+void count_listed_directory(const char *directory, double score) {
+    (void)directory;
+    assert(score > 0);
+    listed_directory_count++;
+}
+
+void test_find_frecent_directory() {
+    char root[] = "/tmp/jsh_test_frecency_XXXXXX";
+    assert(mkdtemp(root) != NULL);
+    char database[128], billing[128], server[128], server_src[128], removed[128];
+    snprintf(database, sizeof(database), "%s/jumps", root);
+    snprintf(billing, sizeof(billing), "%s/billing", root);
+    snprintf(server, sizeof(server), "%s/server", root);
+    snprintf(server_src, sizeof(server_src), "%s/server/src", root);
+    snprintf(removed, sizeof(removed), "%s/billing_old", root);
+    assert(mkdir(billing, 0755) == 0 && mkdir(server, 0755) == 0 && mkdir(server_src, 0755) == 0);
+
+    assert(open_frecency_database(database));
+    record_directory_visit(billing);
+    record_directory_visit(server_src);
+    record_directory_visit(server_src);
+    for (int i = 0; i < 3; i++) {
+        record_directory_visit(removed);
+    }
+
+    // The visits not flushed yet are found too
+    char *bill[] = {"bill"};
+    char *server_and_src[] = {"serv", "src"};
+    char *src[] = {"src"};
+    assert(is_directory(find_frecent_directory(bill, 1, NULL), billing));
+    assert(is_directory(find_frecent_directory(server_and_src, 2, NULL), server_src));
+    assert(find_frecent_directory(server_and_src, 2, server_src) == NULL);
+    assert(flush_frecency_database());
+    assert(is_directory(find_frecent_directory(src, 1, NULL), server_src));
+    close_frecency_database();
+
+    // The database is read again from the file, the removed directory being skipped
+    assert(open_frecency_database(database));
+    assert(is_directory(find_frecent_directory(bill, 1, NULL), billing));
+    // The last fragment must be in the last component
+    char *server_only[] = {"server"};
+    assert(find_frecent_directory(server_only, 1, NULL) == NULL);
+    listed_directory_count = 0;
+    list_frecent_directories(NULL, 0, count_listed_directory);
+    assert(listed_directory_count == 3);
+    close_frecency_database();
+
+    char lock[160];
+    snprintf(lock, sizeof(lock), "%s.lock", database);
+    unlink(lock);
+    unlink(database);
+    rmdir(server_src);
+    rmdir(server);
+    rmdir(billing);
+    rmdir(root);
+}
@@ -0,0 +1,6 @@
+#ifndef TEST_FRECENCY_H
+#define TEST_FRECENCY_H
+
+void test_frecency();
+
+#endif
@@ -0,0 +1,69 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/utils/functions.h"
+#include "test_functions.h"
+
+void test_define_function();
+void test_aliases();
+
+void test_functions() {
+    printf("Test function define_function\n");
+    test_define_function();
+    printf("Test define_function passed\n");
+
+    printf("Test function aliases\n");
+    test_aliases();
+    printf("Test aliases passed\n");
+
+    free_functions();
+}
+
+void test_define_function() {
+    assert(find_function("f") == NULL);
+
+    // The table grows beyond its initial capacity without losing a function
+    char name[32];
+    for (int i = 0; i < NAME_TABLE_INITIAL_CAPACITY * 2; i++) {
+        sprintf(name, "f%d", i);
+        define_function(name, parse_pipeline_list("{ ls; }"));
+    }
+    for (int i = 0; i < NAME_TABLE_INITIAL_CAPACITY * 2; i++) {
+        sprintf(name, "f%d", i);
+        assert(find_function(name) != NULL);
+        assert(find_function(name)->body->pipeline_count == 1);
+    }
+
+    // A body being run stays alive when its function is defined again
+    function_definition *running = find_function("f0");
+    retain_function(running);
+    define_function("f0", parse_pipeline_list("( pwd )"));
+    assert(find_function("f0") != running);
+    assert(running->references == 1);
+    assert(strcmp(running->body->pipelines[0]->commands[0]->group->pipelines[0]->commands[0]->name, "ls") == 0);
+    release_function(running);
+    assert(find_function("f0")->body->pipelines[0]->commands[0]->group_type == GROUP_SUBSHELL);
+}
+
+void test_aliases() {
+    assert(get_alias("ll", 2) == NULL);
+    set_alias("ll", "ls -l");
+    set_alias("la", "ls -a");
+    set_alias("ll", "ls -lh");
+    assert(strcmp(get_alias("ll x", 2), "ls -lh") == 0);
+
+    const char **names;
+    assert(alias_names(&names) == 2);
+    assert(strcmp(names[0], "la") == 0 && strcmp(names[1], "ll") == 0);
+    free(names);
+
+    // A removed alias can be defined again
+    assert(unset_alias("la"));
+    assert(get_alias("la", 2) == NULL);
+    assert(alias_names(&names) == 1);
+    free(names);
+    set_alias("la", "ls -A");
+    assert(strcmp(get_alias("la", 2), "ls -A") == 0);
+}
@@ -0,0 +1,6 @@
+#ifndef TEST_FUNCTIONS_H
+#define TEST_FUNCTIONS_H
+
+void test_functions();
+
+#endif
@@ -0,0 +1,130 @@
+#include <assert.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../../src/utils/glob_expansion.h"
+#include "test_glob_expansion.h"
+
+void test_has_glob_characters();
+void test_match_glob();
+void test_expand_glob();
+
+void test_glob_expansion() {
+    printf("Test function has_glob_characters\n");
+    test_has_glob_characters();
+    printf("Test has_glob_characters passed\n");
+
+    printf("Test function match_glob\n");
+    test_match_glob();
+    printf("Test match_glob passed\n");
+
+    printf("Test function expand_glob\n");
+    test_expand_glob();
+    printf("Test expand_glob passed\n");
+}
+
+void test_has_glob_characters() {
+    assert(has_glob_characters("*.log"));
+    assert(has_glob_characters("file?"));
+    assert(has_glob_characters("[ab]c"));
+    assert(!has_glob_characters("["));
+    assert(!has_glob_characters("a[b"));
+    assert(!has_glob_characters("plain/path"));
+}
+
+void test_match_glob() {
+    assert(match_glob("*", "anything"));
+    assert(match_glob("*.log", "jsh.log"));
+    assert(!match_glob("*.log", "jsh.log.gz"));
+    assert(match_glob("a*b*c", "aXXbYYbc"));
+    assert(match_glob("?at", "cat"));
+    assert(!match_glob("?at", "at"));
+    assert(match_glob("[a-c]x", "bx"));
+    assert(!match_glob("[!a-c]x", "bx"));
+    assert(match_glob("[^a-c]x", "dx"));
+    assert(match_glob("[]]", "]"));
+    assert(match_glob("a[b", "a[b"));
+    assert(match_glob("**", ""));
+    assert(!match_glob("a", ""));
+}
+
+void create_file(const char *root, const char *path) {
+    char full_path[256];
+    snprintf(full_path, sizeof(full_path), "%s/%s", root, path);
+    size_t len = strlen(full_path);
+    if (full_path[len - 1] == '/') {
+        assert(mkdir(full_path, 0755) == 0);
+    } else {
+        int fd = open(full_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        assert(fd != -1);
+        close(fd);
+    }
+}
+
+void assert_expansion(const char *root, const char *pattern, const char **expected, size_t expected_count) {
+    char full_pattern[256];
+    snprintf(full_pattern, sizeof(full_pattern), "%s/%s", root, pattern);
+
+    size_t count;
+    char **paths = expand_glob(full_pattern, &count);
+    if (expected_count == 0) {
+        assert(paths == NULL);
+        return;
+    }
+
+    assert(paths != NULL);
+    assert(count == expected_count);
+    for (size_t i = 0; i < count; i++) {
+        char expected_path[256];
+        snprintf(expected_path, sizeof(expected_path), "%s/%s", root, expected[i]);
+        assert(strcmp(paths[i], expected_path) == 0);
+        free(paths[i]);
+    }
+    free(paths);
+}
+
+void test_expand_glob() {
+    // Set up
+    char root[] = "/tmp/jsh_glob_XXXXXX";
+    assert(mkdtemp(root) != NULL);
+    const char *files[] = {"b.log", "a.log", "a.txt", ".hidden.log", "src/", "src/main.c",
+                           "src/run/", "src/run/run.c", "src/run/run.h", "src/.git/", "src/.git/x.c"};
+    size_t file_count = sizeof(files) / sizeof(char *);
+    for (size_t i = 0; i < file_count; i++) {
+        create_file(root, files[i]);
+    }
+
+    const char *logs[] = {"a.log", "b.log"};
+    assert_expansion(root, "*.log", logs, 2);
+    const char *hidden[] = {".hidden.log"};
+    assert_expansion(root, ".*.log", hidden, 1);
+    const char *sources[] = {"src/main.c", "src/run/run.c"};
+    assert_expansion(root, "**/*.c", sources, 2);
+    const char *run_files[] = {"src/run/run.c", "src/run/run.h"};
+    assert_expansion(root, "src/*/run.?", run_files, 2);
+    const char *directories[] = {"src/", "src/run/"};
+    assert_expansion(root, "**/", directories, 2);
+    const char *all[] = {"src/main.c", "src/run", "src/run/run.c", "src/run/run.h"};
+    assert_expansion(root, "src/**", all, 4);
+    assert_expansion(root, "*.none", NULL, 0);
+
+    // A new file is seen even though the listing of the directory was cached
+    create_file(root, "c.log");
+    const char *new_logs[] = {"a.log", "b.log", "c.log"};
+    assert_expansion(root, "*.log", new_logs, 3);
+
+    // Clean up
+    char path[256];
+    snprintf(path, sizeof(path), "%s/c.log", root);
+    assert(remove(path) == 0);
+    for (size_t i = file_count; i > 0; i--) {
+        snprintf(path, sizeof(path), "%s/%s", root, files[i - 1]);
+        assert(remove(path) == 0);
+    }
+    assert(rmdir(root) == 0);
+}
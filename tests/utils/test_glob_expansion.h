@@ -0,0 +1,6 @@
+#ifndef TEST_GLOB_EXPANSION_H
+#define TEST_GLOB_EXPANSION_H
+
+void test_glob_expansion();
+
+#endif
@@ -0,0 +1,130 @@
+#include <assert.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../../src/utils/history_file.h"
+#include "test_history_file.h"
+
+void test_append_and_search_history_file();
+void test_history_file_skips_broken_records();
+void test_load_recent_history();
+
+void test_history_file() {
+    printf("Test function append_to_history_file and search_history_file\n");
+    test_append_and_search_history_file();
+    printf("Test append_to_history_file and search_history_file passed\n");
+
+    printf("Test function history_file_record_count with broken records\n");
+    test_history_file_skips_broken_records();
+    printf("Test history_file_record_count with broken records passed\n");
+
+    printf("Test function load_recent_history\n");
+    test_load_recent_history();
+    printf("Test load_recent_history passed\n");
+}
+
+bool record_is(size_t index, const char *expected) {
+    size_t len;
+    const char *line = history_file_record(index, &len);
+    return len == strlen(expected) && strncmp(line, expected, len) == 0;
+}
+
+void test_append_and_search_history_file() {
+    char path[] = "/tmp/jsh_test_history_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd != -1);
+    close(fd);
+
+    assert(open_history_file(path));
+    assert(append_to_history_file("git status"));
+    assert(!append_to_history_file(""));
+    assert(append_to_history_file("make test"));
+    assert(append_to_history_file("git commit"));
+    assert(history_file_record_count() == 3);
+    assert(record_is(1, "make test"));
+
+    assert(search_history_file("git", 3) == 2);
+    assert(search_history_file("git", 2) == 0);
+    assert(search_history_file("git", 0) == -1);
+    assert(search_history_file("ma", 3) == 1);
+    assert(search_history_file("absent", 3) == -1);
+
+    // Enough records for the index to be built in the background, the searches going on meanwhile
+    char line[64];
+    for (int i = 0; i < HISTORY_UNINDEXED_MAX + 10; i++) {
+        snprintf(line, sizeof(line), "echo %d", i);
+        assert(append_to_history_file(line));
+    }
+    size_t count = history_file_record_count();
+    assert(count == 3 + HISTORY_UNINDEXED_MAX + 10);
+
+    // The results are the same before and after the index is ready
+    for (int k = 0; k < 2; k++) {
+        assert(search_history_file("git status", count) == 0);
+        assert(search_history_file("git commit", count) == 2);
+        assert(search_history_file("echo 42", count) == 3 + 429);
+        assert(search_history_file("echo 42", 3 + 429) == 3 + 428);
+        assert(search_history_file("echo 42", 3 + 42) == -1);
+        assert(search_history_file("absent", count) == -1);
+        usleep(200000);
+    }
+
+    close_history_file();
+    unlink(path);
+}
+
+void test_history_file_skips_broken_records() {
+    char path[] = "/tmp/jsh_test_history_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd != -1);
+    // A record cut by a crash, then a whole one
+    const unsigned char broken[] = {HISTORY_RECORD_MARK, 20, 0, 0, 0, 'l', 's'};
+    assert(write(fd, broken, sizeof(broken)) == sizeof(broken));
+    close(fd);
+
+    assert(open_history_file(path));
+    assert(append_to_history_file("pwd"));
+    assert(append_to_history_file("cd /tmp"));
+    assert(history_file_record_count() == 2);
+    assert(record_is(0, "pwd"));
+    assert(record_is(1, "cd /tmp"));
+
+    close_history_file();
+    unlink(path);
+}
+
+char *loaded_lines[4];
+size_t loaded_count = 0;
+
+void add_loaded_line(const char *line) {
+    assert(loaded_count < 4);
+    loaded_lines[loaded_count++] = strdup(line);
+}
+
+void test_load_recent_history() {
+    char path[] = "/tmp/jsh_test_history_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd != -1);
+    close(fd);
+
+    assert(open_history_file(path));
+    assert(append_to_history_file("first"));
+    assert(append_to_history_file("second"));
+    assert(append_to_history_file("third"));
+    close_history_file();
+
+    assert(open_history_file(path));
+    load_recent_history(add_loaded_line, 2);
+    assert(loaded_count == 2);
+    assert(strcmp(loaded_lines[0], "second") == 0);
+    assert(strcmp(loaded_lines[1], "third") == 0);
+    for (size_t i = 0; i < loaded_count; i++) {
+        free(loaded_lines[i]);
+    }
+    close_history_file();
+    unlink(path);
+}
@@ -0,0 +1,6 @@
+#ifndef TEST_HISTORY_FILE_H
+#define TEST_HISTORY_FILE_H
+
+void test_history_file();
+
+#endif
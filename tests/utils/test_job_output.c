@@ -0,0 +1,131 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../../src/utils/fd_utils.h"
+#include "../../src/utils/job_output.h"
+#include "test_job_output.h"
+
+void test_prefixed_lines_of_job_output();
+void test_replay_of_overwritten_job_output();
+
+void test_job_output() {
+    printf("Test function prefixed_lines_of_job_output\n");
+    test_prefixed_lines_of_job_output();
+    printf("Test prefixed_lines_of_job_output passed\n");
+
+    printf("Test function replay_of_overwritten_job_output\n");
+    test_replay_of_overwritten_job_output();
+    printf("Test replay_of_overwritten_job_output passed\n");
+
+    free_job_outputs();
+}
+
+/*
+ * Relays what the function writes as the job id, with the standard output and error of the relay being the given
+ * files, and waits for the end of the relay
+ */
+void relay_job_writes(unsigned id, FILE *out, FILE *err, void (*writes)(int, int)) {
+    int stdout_copy = dup(STDOUT_FILENO);
+    int stderr_copy = dup(STDERR_FILENO);
+    fflush(stdout);
+    dup2(fileno(out), STDOUT_FILENO);
+    dup2(fileno(err), STDERR_FILENO);
+
+    int stdout_fd, stderr_fd;
+    pid_t relay_pid = start_job_output(id, &stdout_fd, &stderr_fd);
+
+    dup2(stdout_copy, STDOUT_FILENO);
+    dup2(stderr_copy, STDERR_FILENO);
+    close(stdout_copy);
+    close(stderr_copy);
+    assert(relay_pid != -1);
+
+    writes(stdout_fd, stderr_fd);
+    close(stdout_fd);
+    close(stderr_fd);
+    assert(waitpid(relay_pid, NULL, 0) == relay_pid);
+}
+
+/* Returns the content of the file, which is freed by the caller */
+char *content_of_file(FILE *file) {
+    long len = ftell(file);
+    char *content = malloc(len + 1);
+    assert(content != NULL);
+    rewind(file);
+    assert(fread(content, 1, len, file) == (size_t)len);
+    content[len] = '\0';
+    return content;
+}
+
+void write_lines_in_pieces(int stdout_fd, int stderr_fd) {
+    assert(write_all(stdout_fd, "first li", 8));
+    assert(write_all(stderr_fd, "oops\n", 5));
+    assert(write_all(stdout_fd, "ne\nsecond line\nno end", 21));
+}
+
+void test_prefixed_lines_of_job_output() {
+    FILE *out = tmpfile();
+    FILE *err = tmpfile();
+    assert(out != NULL && err != NULL);
+    relay_job_writes(7, out, err, write_lines_in_pieces);
+
+    // A line is written once it is whole, the last one even without its end
+    fseek(out, 0, SEEK_END);
+    fseek(err, 0, SEEK_END);
+    char *relayed_out = content_of_file(out);
+    char *relayed_err = content_of_file(err);
+    assert(strcmp(relayed_out, "[7] first line\n[7] second line\n[7] no end\n") == 0);
+    assert(strcmp(relayed_err, "[7] oops\n") == 0);
+    free(relayed_out);
+    free(relayed_err);
+
+    FILE *replayed = tmpfile();
+    assert(replayed != NULL);
+    assert(replay_job_output(7, fileno(replayed)));
+    assert(!replay_job_output(8, fileno(replayed)));
+    char *replayed_output = content_of_file(replayed);
+    // Both pipes are kept in the order they are read, which only keeps the order of the writes of each of them
+    assert(strlen(replayed_output) == 34);
+    assert(strstr(replayed_output, "oops\n") != NULL);
+    assert(strstr(replayed_output, "second line\nno end") != NULL);
+    free(replayed_output);
+
+    fclose(out);
+    fclose(err);
+    fclose(replayed);
+}
+
+void write_many_lines(int stdout_fd, int stderr_fd) {
+    char line[32];
+    for (int i = 0; i < 20000; i++) {
+        int len = sprintf(line, "line %d\n", i);
+        assert(write_all(stdout_fd, line, len));
+    }
+}
+
+void test_replay_of_overwritten_job_output() {
+    FILE *out = tmpfile();
+    FILE *err = tmpfile();
+    assert(out != NULL && err != NULL);
+    relay_job_writes(3, out, err, write_many_lines);
+
+    // Only the last bytes are kept, from the first whole line among them
+    FILE *replayed = tmpfile();
+    assert(replayed != NULL);
+    assert(replay_job_output(3, fileno(replayed)));
+    char *replayed_output = content_of_file(replayed);
+    size_t len = strlen(replayed_output);
+    assert(len <= JOB_OUTPUT_RING_SIZE && len > JOB_OUTPUT_RING_SIZE - 16);
+    assert(strncmp(replayed_output, "line ", 5) == 0);
+    assert(strcmp(replayed_output + len - 11, "line 19999\n") == 0);
+    free(replayed_output);
+
+    fclose(out);
+    fclose(err);
+    fclose(replayed);
+}
@@ -0,0 +1,6 @@
+#ifndef TEST_JOB_OUTPUT_H
+#define TEST_JOB_OUTPUT_H
+
+void test_job_output();
+
+#endif
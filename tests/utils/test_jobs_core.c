@@ -3,6 +3,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "../../src/utils/core.h"
 #include "../../src/utils/jobs_core.h"
@@ -21,6 +24,8 @@ void test_simple_str_of_job_old_job_stopped_with_pipe();
 void test_simple_str_of_job_old_job_running_with_pipe();
 void test_simple_str_of_job_old_job_killed_with_pipe();
 void test_simple_str_of_job_old_job_done_with_pipe();
+void test_set_status_of_process();
+void test_update_status_of_terminated_jobs();
 
 void test_jobs_core() {
     printf("Test function add_job_to_jobs\n");
@@ -78,6 +83,14 @@ void test_jobs_core() {
     printf("Test function test_simple_str_of_job_old_job_done_with_pipe\n");
     test_simple_str_of_job_old_job_done_with_pipe();
     printf("Test test_simple_str_of_job_old_job_done_with_pipe passed\n");
+
+    printf("Test function set_status_of_process\n");
+    test_set_status_of_process();
+    printf("Test set_status_of_process passed\n");
+
+    printf("Test function update_status_of_terminated_jobs\n");
+    test_update_status_of_terminated_jobs();
+    printf("Test update_status_of_terminated_jobs passed\n");
 }
 
 void test_add_job_to_jobs() {
@@ -481,3 +494,60 @@ void test_simple_str_of_job_old_job_done_with_pipe() {
     remove_job_from_jobs(jb->id);
     free(strjob);
 }
+
+/* Returns the status of a child which exits with the given status, or is killed by the given signal if it is not 0 */
+int status_of_child(int exit_status, int signal) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (signal != 0) {
+            raise(signal);
+        }
+        _exit(exit_status);
+    }
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    return status;
+}
+
+void test_set_status_of_process() {
+    job *jb = init_job_to_add(-1, -1, NULL, RUNNING);
+    add_process_to_job(jb, 1, NULL, NULL, RUNNING);
+    process *p = jb->job_process[0];
+    assert(p->exit_status == 0);
+
+    set_status_of_process(p, status_of_child(7, 0));
+    assert(p->status == DONE);
+    assert(p->exit_status == 7);
+
+    set_status_of_process(p, status_of_child(0, SIGKILL));
+    assert(p->status == KILLED);
+    assert(p->exit_status == 128 + SIGKILL);
+
+    free_job(jb);
+}
+
+void test_update_status_of_terminated_jobs() {
+    pid_t pid = fork();
+    if (pid == 0) {
+        raise(SIGKILL);
+        _exit(0);
+    }
+    job *jb = init_job_to_add(pid, pid, NULL, RUNNING);
+    add_process_to_job(jb, pid, NULL, NULL, RUNNING);
+    add_job_to_jobs(jb);
+    while (jb->status == RUNNING) {
+        usleep(1000);
+        update_status_of_jobs();
+    }
+    assert(jb->status == KILLED);
+    assert(jb->job_process[0]->exit_status == 128 + SIGKILL);
+
+    // A job not removed yet keeps its status and the one of its processes, which are not waited for again
+    update_status_of_jobs();
+    update_status_of_jobs();
+    assert(jb->status == KILLED);
+    assert(jb->job_process[0]->status == KILLED);
+    assert(jb->job_process[0]->exit_status == 128 + SIGKILL);
+
+    remove_job_from_jobs(jb->id);
+}
@@ -0,0 +1,89 @@
+#include <assert.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../../src/utils/path_index.h"
+#include "test_path_index.h"
+
+void test_find_in_path_index();
+
+void test_path_index() {
+    printf("Test function find_in_path_index and path_index_prefix_range\n");
+    test_find_in_path_index();
+    printf("Test find_in_path_index and path_index_prefix_range passed\n");
+}
+
+void create_program(const char *directory, const char *name, mode_t mode) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", directory, name);
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, mode);
+    assert(fd != -1);
+    close(fd);
+    chmod(path, mode);
+}
+
+void remove_program(const char *directory, const char *name) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", directory, name);
+    unlink(path);
+}
+
+bool path_is(char *path, const char *directory, const char *name) {
+    char expected[256];
+    snprintf(expected, sizeof(expected), "%s/%s", directory, name);
+    bool same = path != NULL && strcmp(path, expected) == 0;
+    free(path);
+    return same;
+}
+
+void test_find_in_path_index() {
+    char first[] = "/tmp/jsh_test_path_XXXXXX";
+    char second[] = "/tmp/jsh_test_path_XXXXXX";
+    assert(mkdtemp(first) != NULL && mkdtemp(second) != NULL);
+    create_program(first, "tool", 0755);
+    create_program(first, "notes", 0644);
+    create_program(second, "tool", 0755);
+    create_program(second, "toolbox", 0755);
+
+    char *saved_path = getenv("PATH") == NULL ? NULL : strdup(getenv("PATH"));
+    char path_variable[128];
+    snprintf(path_variable, sizeof(path_variable), "%s:%s", first, second);
+    setenv("PATH", path_variable, 1);
+
+    assert(find_in_path_index("tool") == NULL);
+    refresh_path_index();
+    assert(path_is(find_in_path_index("tool"), first, "tool"));
+    assert(path_is(find_in_path_index("toolbox"), second, "toolbox"));
+    assert(find_in_path_index("notes") == NULL);
+
+    size_t first_index, last_index;
+    assert(path_index_prefix_range("to", &first_index, &last_index));
+    assert(last_index - first_index == 2);
+    assert(strcmp(path_index_name(first_index), "tool") == 0);
+    assert(strcmp(path_index_name(first_index + 1), "toolbox") == 0);
+    assert(!path_index_prefix_range("x", &first_index, &last_index));
+
+    // The changes of the directories are seen at the next refresh
+    remove_program(first, "tool");
+    create_program(second, "xtool", 0755);
+    refresh_path_index();
+    assert(path_is(find_in_path_index("tool"), second, "tool"));
+    assert(path_is(find_in_path_index("xtool"), second, "xtool"));
+
+    free_path_index();
+    if (saved_path != NULL) {
+        setenv("PATH", saved_path, 1);
+        free(saved_path);
+    }
+    remove_program(first, "notes");
+    remove_program(second, "tool");
+    remove_program(second, "toolbox");
+    remove_program(second, "xtool");
+    rmdir(first);
+    rmdir(second);
+}
@@ -0,0 +1,6 @@
+#ifndef TEST_PATH_INDEX_H
+#define TEST_PATH_INDEX_H
+
+void test_path_index();
+
+#endif
@@ -0,0 +1,85 @@
+#include <assert.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../../src/utils/proc_stats.h"
+#include "test_proc_stats.h"
+
+void test_stats_of_current_process();
+void test_pipe_fill_of_process();
+
+void test_proc_stats() {
+    printf("Test function stats_of_current_process\n");
+    test_stats_of_current_process();
+    printf("Test stats_of_current_process passed\n");
+
+    printf("Test function pipe_fill_of_process\n");
+    test_pipe_fill_of_process();
+    printf("Test pipe_fill_of_process passed\n");
+}
+
+void test_stats_of_current_process() {
+    process_stats stats;
+    assert(read_process_stats(getpid(), &stats));
+    assert(stats.pid == getpid());
+    assert(stats.state == 'R');
+    assert(stats.start_ticks / (double)sysconf(_SC_CLK_TCK) <= seconds_since_boot());
+    double cpu = process_cpu_percent(NULL, &stats, 0);
+    assert(cpu >= 0);
+
+    process_stats later = stats;
+    later.cpu_ticks += sysconf(_SC_CLK_TCK) / 2;
+    double half = process_cpu_percent(&stats, &later, 1);
+    assert(half > 49.9 && half < 50.1);
+}
+
+void test_pipe_fill_of_process() {
+    int output[2];
+    int input[2];
+    assert(pipe(output) == 0 && pipe(input) == 0);
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        // The child fills its output with 1000 bytes nobody reads, reads a byte of its input and waits
+        dup2(output[1], STDOUT_FILENO);
+        dup2(input[0], STDIN_FILENO);
+        close(output[0]);
+        close(output[1]);
+        close(input[0]);
+        close(input[1]);
+        char bytes[1000];
+        memset(bytes, 'x', sizeof(bytes));
+        write(STDOUT_FILENO, bytes, sizeof(bytes));
+        read(STDIN_FILENO, bytes, 1);
+        pause();
+        _exit(0);
+    }
+    close(output[1]);
+    close(input[0]);
+    assert(write(input[1], "abc", 3) == 3);
+
+    process_stats stats;
+    for (int tries = 0; tries < 1000; tries++) {
+        assert(read_process_stats(pid, &stats));
+        if (stats.output_pipe_fill == 1000 && stats.input_pipe_fill == 2) {
+            break;
+        }
+        usleep(1000);
+    }
+    assert(stats.output_pipe_fill == 1000);
+    assert(stats.output_pipe_size >= 4096);
+    assert(stats.input_pipe_fill == 2);
+
+    // Measuring a pipe takes nothing from it
+    char bytes[1001];
+    assert(read(output[0], bytes, sizeof(bytes)) == 1000);
+    kill(pid, SIGKILL);
+    close(input[1]);
+    close(output[0]);
+    assert(waitpid(pid, NULL, 0) == pid);
+    assert(!read_process_stats(pid, &stats));
+}
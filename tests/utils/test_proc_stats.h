@@ -0,0 +1,6 @@
+#ifndef TEST_PROC_STATS_H
+#define TEST_PROC_STATS_H
+
+void test_proc_stats();
+
+#endif
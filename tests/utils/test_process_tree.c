@@ -0,0 +1,175 @@
+#include <assert.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../../src/utils/process_tree.h"
+#include "test_process_tree.h"
+
+void test_tree_of_current_process();
+void test_descendants_in_tree();
+void test_tree_read_again();
+
+void test_process_tree() {
+    printf("Test function tree_of_current_process\n");
+    test_tree_of_current_process();
+    printf("Test tree_of_current_process passed\n");
+
+    printf("Test function descendants_in_tree\n");
+    test_descendants_in_tree();
+    printf("Test descendants_in_tree passed\n");
+
+    printf("Test function tree_read_again\n");
+    test_tree_read_again();
+    printf("Test tree_read_again passed\n");
+}
+
+void test_tree_of_current_process() {
+    process_tree tree;
+    assert(read_process_tree(&tree, NULL, NULL, 0));
+    assert(tree.count > 0);
+    for (size_t i = 1; i < tree.count; i++) {
+        assert(tree.processes[i - 1].pid < tree.processes[i].pid);
+    }
+
+    size_t index = process_tree_index(&tree, getpid());
+    assert(index != tree.count);
+    assert(tree.processes[index].pid == getpid());
+    assert(tree.processes[index].ppid == getppid());
+    assert(tree.processes[index].state == 'R');
+
+    // The current process is among the children of its parent
+    size_t parent = process_tree_index(&tree, getppid());
+    if (parent != tree.count) {
+        const size_t *children;
+        size_t count = process_tree_children(&tree, parent, &children);
+        bool found = false;
+        for (size_t i = 0; i < count; i++) {
+            found = found || children[i] == index;
+        }
+        assert(found);
+    }
+    assert(process_tree_index(&tree, 0) == tree.count);
+    free_process_tree(&tree);
+    assert(tree.processes == NULL && tree.count == 0);
+}
+
+void test_descendants_in_tree() {
+    int ready[2];
+    assert(pipe(ready) == 0);
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        // The child starts a grandchild, tells its pid and waits, both being killed at the end
+        close(ready[0]);
+        pid_t grandchild = fork();
+        if (grandchild == 0) {
+            pause();
+            _exit(0);
+        }
+        write(ready[1], &grandchild, sizeof(grandchild));
+        pause();
+        _exit(0);
+    }
+    close(ready[1]);
+    pid_t grandchild;
+    assert(read(ready[0], &grandchild, sizeof(grandchild)) == sizeof(grandchild));
+    close(ready[0]);
+
+    process_tree tree;
+    assert(read_process_tree(&tree, NULL, NULL, 0));
+    size_t index = process_tree_index(&tree, getpid());
+    size_t child_index = process_tree_index(&tree, pid);
+    size_t grandchild_index = process_tree_index(&tree, grandchild);
+    assert(index != tree.count && child_index != tree.count && grandchild_index != tree.count);
+    assert(tree.processes[child_index].ppid == getpid());
+    assert(tree.processes[grandchild_index].ppid == pid);
+
+    const size_t *children;
+    size_t count = process_tree_children(&tree, index, &children);
+    bool found = false;
+    for (size_t i = 0; i < count; i++) {
+        assert(tree.processes[children[i]].ppid == getpid());
+        assert(i == 0 || children[i - 1] < children[i]);
+        found = found || children[i] == child_index;
+    }
+    assert(found);
+    assert(process_tree_children(&tree, child_index, &children) == 1);
+    assert(children[0] == grandchild_index);
+    assert(process_tree_children(&tree, grandchild_index, &children) == 0);
+    free_process_tree(&tree);
+
+    kill(grandchild, SIGKILL);
+    kill(pid, SIGKILL);
+    assert(waitpid(pid, NULL, 0) == pid);
+}
+
+void test_tree_read_again() {
+    int ready[2];
+    assert(pipe(ready) == 0);
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        // The child starts a grandchild, tells its pid and waits, the grandchild outliving it
+        close(ready[0]);
+        pid_t grandchild = fork();
+        if (grandchild == 0) {
+            pause();
+            _exit(0);
+        }
+        write(ready[1], &grandchild, sizeof(grandchild));
+        pause();
+        _exit(0);
+    }
+    close(ready[1]);
+    pid_t grandchild;
+    assert(read(ready[0], &grandchild, sizeof(grandchild)) == sizeof(grandchild));
+    close(ready[0]);
+
+    process_tree first;
+    assert(read_process_tree(&first, NULL, NULL, 0));
+    size_t index = process_tree_index(&first, pid);
+    assert(index != first.count && first.processes[index].state != 'T' && first.processes[index].is_current);
+
+    // The roots are read again, the other processes known are taken from the previous tree, the new ones are read
+    assert(kill(pid, SIGSTOP) == 0);
+    assert(waitpid(pid, NULL, WUNTRACED) == pid);
+    pid_t other = fork();
+    assert(other != -1);
+    if (other == 0) {
+        pause();
+        _exit(0);
+    }
+    process_tree second;
+    assert(read_process_tree(&second, &first, &pid, 1));
+    index = process_tree_index(&second, pid);
+    assert(index != second.count && second.processes[index].state == 'T' && second.processes[index].is_current);
+    index = process_tree_index(&second, grandchild);
+    assert(index != second.count && second.processes[index].is_current);
+    index = process_tree_index(&second, other);
+    assert(index != second.count && second.processes[index].is_current);
+    assert(second.processes[index].ppid == getpid());
+    index = process_tree_index(&second, getpid());
+    assert(index != second.count && !second.processes[index].is_current);
+    free_process_tree(&first);
+
+    // A descendant whose parent has ended is read again, and is no longer under it, nor is the ended process
+    kill(other, SIGKILL);
+    assert(waitpid(other, NULL, 0) == other);
+    kill(pid, SIGKILL);
+    assert(waitpid(pid, NULL, 0) == pid);
+    process_tree third;
+    assert(read_process_tree(&third, &second, &grandchild, 1));
+    assert(process_tree_index(&third, pid) == third.count);
+    assert(process_tree_index(&third, other) == third.count);
+    index = process_tree_index(&third, grandchild);
+    assert(index != third.count && third.processes[index].is_current);
+    assert(third.processes[index].ppid != pid);
+    free_process_tree(&second);
+    free_process_tree(&third);
+
+    kill(grandchild, SIGKILL);
+}
@@ -0,0 +1,6 @@
+#ifndef TEST_PROCESS_TREE_H
+#define TEST_PROCESS_TREE_H
+
+void test_process_tree();
+
+#endif
@@ -0,0 +1,96 @@
+#include <assert.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../../src/utils/prompt_segments.h"
+#include "test_prompt_segments.h"
+
+void test_prompt_segment_values();
+
+void test_prompt_segments() {
+    printf("Test function prompt_segment_values\n");
+    test_prompt_segment_values();
+    printf("Test prompt_segment_values passed\n");
+}
+
+int folder_segment_calls = 0;
+bool folder_segment_blocks = false;
+int folder_segment_gate[2];
+/* The number of values computed, and whether the worker waits for a byte of the gate before giving each one */
+
+/*
+ * Returns the last component of the folder between parentheses
+ */
+char *folder_segment(const char *folder, const char *watched_path) {
+    __atomic_add_fetch(&folder_segment_calls, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&folder_segment_blocks, __ATOMIC_SEQ_CST)) {
+        char byte;
+        assert(read(folder_segment_gate[0], &byte, 1) == 1);
+    }
+    const char *name = strrchr(folder, '/') + 1;
+    char *value = malloc(strlen(name) + 3);
+    assert(value != NULL);
+    sprintf(value, "(%s)", name);
+    return value;
+}
+
+const prompt_segment_definition folder_definition = {NULL, true, folder_segment};
+
+/*
+ * Waits for the values from the worker, and returns the text of the segments then
+ */
+const char *wait_for_prompt_segments() {
+    struct pollfd fd = {prompt_segments_fd(), POLLIN, 0};
+    assert(poll(&fd, 1, 5000) == 1);
+    acknowledge_prompt_segments();
+    return prompt_segments_text();
+}
+
+/* Lets the worker give the value it computes */
+void release_folder_segment() {
+    assert(write(folder_segment_gate[1], "x", 1) == 1);
+}
+
+void test_prompt_segment_values() {
+    unsetenv("JSH_PROMPT_VCS");
+    assert(pipe(folder_segment_gate) == 0);
+    assert(add_prompt_segment(&folder_definition) == 0);
+    init_prompt_segments();
+    assert(prompt_segments_fd() != -1);
+    assert(strcmp(prompt_segments_text(), "") == 0);
+
+    // The value arrives from the worker, and changes the generation of the text
+    unsigned long generation = prompt_segments_generation();
+    assert(refresh_prompt_segments("/tmp/first"));
+    assert(strcmp(wait_for_prompt_segments(), "(first)") == 0);
+    assert(prompt_segments_generation() != generation);
+    assert(__atomic_load_n(&folder_segment_calls, __ATOMIC_SEQ_CST) == 1);
+
+    // The same key is not asked for again
+    assert(!refresh_prompt_segments("/tmp/first"));
+    assert(__atomic_load_n(&folder_segment_calls, __ATOMIC_SEQ_CST) == 1);
+
+    // The value of another folder is dropped at once, before the worker gives the new one
+    __atomic_store_n(&folder_segment_blocks, true, __ATOMIC_SEQ_CST);
+    assert(refresh_prompt_segments("/tmp/second"));
+    assert(strcmp(prompt_segments_text(), "") == 0);
+    release_folder_segment();
+    assert(strcmp(wait_for_prompt_segments(), "(second)") == 0);
+
+    // Whereas the stale value of the same folder is shown until the fresh one arrives
+    invalidate_prompt_segments();
+    assert(refresh_prompt_segments("/tmp/second"));
+    assert(strcmp(prompt_segments_text(), "(second)") == 0);
+    __atomic_store_n(&folder_segment_blocks, false, __ATOMIC_SEQ_CST);
+    release_folder_segment();
+
+    free_prompt_segments();
+    assert(__atomic_load_n(&folder_segment_calls, __ATOMIC_SEQ_CST) <= 3);
+    assert(refresh_prompt_segments("/tmp/third") == false);
+    close(folder_segment_gate[0]);
+    close(folder_segment_gate[1]);
+}
@@ -0,0 +1,6 @@
+#ifndef TEST_PROMPT_SEGMENTS_H
+#define TEST_PROMPT_SEGMENTS_H
+
+void test_prompt_segments();
+
+#endif
@@ -14,6 +14,10 @@ void test_concat_with_delimiter();
 void test_is_integer();
 void test_has_sequence_of();
 void test_has_sequence_of_with_exception();
+void test_strip_trailing_newlines();
+void test_split_fields();
+void test_radix_sort_strings();
+void test_utf8_display_width();
 
 void test_string_utils() {
     printf("Test function start_with\n");
@@ -43,6 +47,22 @@ void test_string_utils() {
     printf("Test function has_sequence_of_with_exception\n");
     test_has_sequence_of_with_exception();
     printf("Test has_sequence_of_with_exception passed\n");
+
+    printf("Test function strip_trailing_newlines\n");
+    test_strip_trailing_newlines();
+    printf("Test strip_trailing_newlines passed\n");
+
+    printf("Test function split_fields\n");
+    test_split_fields();
+    printf("Test split_fields passed\n");
+
+    printf("Test function radix_sort_strings\n");
+    test_radix_sort_strings();
+    printf("Test radix_sort_strings passed\n");
+
+    printf("Test function utf8_display_width\n");
+    test_utf8_display_width();
+    printf("Test utf8_display_width passed\n");
 }
 
 void test_start_with() {
@@ -139,3 +159,83 @@ void test_has_sequence_of_with_exception(){
     assert(has_sequence_of_with_exception("dss ddc  cfs dcdsd", 'c', ' '));
     assert(has_sequence_of_with_exception("dss ddc  cfs dcdsccd", 'c', ' '));
 }
+
+
+void test_strip_trailing_newlines() {
+    assert(strip_trailing_newlines("", 0) == 0);
+    assert(strip_trailing_newlines("\n\n", 2) == 0);
+    assert(strip_trailing_newlines("abc\n", 4) == 3);
+    assert(strip_trailing_newlines("a\nb\n\n\n", 6) == 3);
+    assert(strip_trailing_newlines("abc ", 4) == 4);
+}
+
+void test_split_fields() {
+    char buffer[] = "  foo\tbar\n\nbaz  ";
+    size_t len = strlen(buffer);
+    char *fields[3];
+
+    assert(count_fields(buffer, len) == 3);
+    assert(split_fields(buffer, len, fields, 3) == 3);
+    assert(strcmp(fields[0], "foo") == 0);
+    assert(strcmp(fields[1], "bar") == 0);
+    assert(strcmp(fields[2], "baz") == 0);
+
+    char blanks[] = " \n\t ";
+    assert(count_fields(blanks, strlen(blanks)) == 0);
+    assert(split_fields(blanks, strlen(blanks), fields, 3) == 0);
+}
+int compare_strings(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+void test_radix_sort_strings() {
+    char *few[] = {"b", "a/c", "a", "", "a/b"};
+    radix_sort_strings(few, 5);
+    assert(strcmp(few[0], "") == 0);
+    assert(strcmp(few[1], "a") == 0);
+    assert(strcmp(few[2], "a/b") == 0);
+    assert(strcmp(few[3], "a/c") == 0);
+    assert(strcmp(few[4], "b") == 0);
+
+    // Enough strings with common prefixes to be distributed in buckets
+    size_t count = 1000;
+    char **strings = malloc(sizeof(char *) * count);
+    char **expected = malloc(sizeof(char *) * count);
+    assert(strings != NULL && expected != NULL);
+    for (size_t i = 0; i < count; i++) {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "dir/%zu/\xe9%zu", (i * 7919) % 97, i % 13);
+        strings[i] = strdup(buffer);
+        expected[i] = strings[i];
+    }
+
+    radix_sort_strings(strings, count);
+    qsort(expected, count, sizeof(char *), compare_strings);
+    for (size_t i = 0; i < count; i++) {
+        assert(strcmp(strings[i], expected[i]) == 0);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        free(strings[i]);
+    }
+    free(strings);
+    free(expected);
+}
+
+void test_utf8_display_width() {
+    assert(utf8_display_width("") == 0);
+    assert(utf8_display_width("/home/jsh") == 9);
+    assert(utf8_display_width("/home/\xc3\xa9t\xc3\xa9") == 9);        // "/home/été"
+    assert(utf8_display_width("/\xe6\x97\xa5\xe6\x9c\xac") == 5);        // "/日本"
+    assert(utf8_display_width("e\xcc\x81") == 1);                       // "e" and a combining accent
+    assert(utf8_display_width("\xff\xfe") == 2);                        // Invalid bytes
+
+    const char *path = "/home/\xe6\x97\xa5\xe6\x9c\xac/src";        // "/home/日本/src"
+    size_t len = strlen(path);
+    assert(suffix_of_display_width(path, len, 100) == path);
+    assert(strcmp(suffix_of_display_width(path, len, 4), "/src") == 0);
+    // A wide character is never cut
+    assert(strcmp(suffix_of_display_width(path, len, 7), "\xe6\x9c\xac/src") == 0);
+    assert(strcmp(suffix_of_display_width(path, len, 8), "\xe6\x97\xa5\xe6\x9c\xac/src") == 0);
+    assert(strcmp(suffix_of_display_width(path, len, 0), "") == 0);
+}
@@ -0,0 +1,73 @@
+#include <assert.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../../src/utils/timer_wheel.h"
+#include "test_timer_wheel.h"
+
+void test_deadlines_expire();
+void test_cancelled_deadlines();
+
+void test_timer_wheel() {
+    printf("Test function deadlines_expire\n");
+    test_deadlines_expire();
+    printf("Test deadlines_expire passed\n");
+
+    printf("Test function cancelled_deadlines\n");
+    test_cancelled_deadlines();
+    printf("Test cancelled_deadlines passed\n");
+
+    free_timer_wheel();
+}
+
+/* Returns a child sleeping for the given number of seconds, in a process group of its own */
+pid_t sleeping_child(unsigned int seconds) {
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        setpgid(0, 0);
+        sleep(seconds);
+        _exit(0);
+    }
+    setpgid(pid, pid);
+    return pid;
+}
+
+void test_deadlines_expire() {
+    // A deadline beyond a turn of the wheel expires after the nearer one
+    pid_t near = sleeping_child(5);
+    pid_t far = sleeping_child(10);
+    unsigned long near_deadline = add_deadline(50, near, true, SIGKILL);
+    unsigned long far_deadline = add_deadline(TIMER_WHEEL_SLOTS * TIMER_WHEEL_TICK_MS + 100, far, false, SIGTERM);
+    assert(near_deadline != 0 && far_deadline != 0);
+
+    int status;
+    assert(waitpid(near, &status, 0) == near);
+    assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL);
+    assert(has_deadline_expired(near_deadline));
+    assert(!has_deadline_expired(far_deadline));
+
+    assert(waitpid(far, &status, 0) == far);
+    assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGTERM);
+    assert(has_deadline_expired(far_deadline));
+    cancel_deadline(near_deadline);
+    cancel_deadline(far_deadline);
+    assert(!has_deadline_expired(near_deadline));
+}
+
+void test_cancelled_deadlines() {
+    pid_t pid = sleeping_child(1);
+    unsigned long cancelled = add_deadline(20, pid, true, SIGKILL);
+    unsigned long kept = add_deadline(30, pid, true, SIGCONT);
+    cancel_deadline(cancelled);
+
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    assert(!has_deadline_expired(cancelled));
+    assert(has_deadline_expired(kept));
+    cancel_deadline(kept);
+}
@@ -0,0 +1,6 @@
+#ifndef TEST_TIMER_WHEEL_H
+#define TEST_TIMER_WHEEL_H
+
+void test_timer_wheel();
+
+#endif
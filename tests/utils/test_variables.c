@@ -0,0 +1,102 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/utils/variables.h"
+#include "test_variables.h"
+
+void test_is_assignment();
+void test_set_variable();
+void test_expand_variables();
+
+void test_variables() {
+    printf("Test function is_assignment\n");
+    test_is_assignment();
+    printf("Test is_assignment passed\n");
+
+    printf("Test function set_variable\n");
+    test_set_variable();
+    printf("Test set_variable passed\n");
+
+    printf("Test function expand_variables\n");
+    test_expand_variables();
+    printf("Test expand_variables passed\n");
+
+    free_variables();
+}
+
+void test_is_assignment() {
+    assert(is_assignment("x=1"));
+    assert(is_assignment("_name2="));
+    assert(!is_assignment("=1"));
+    assert(!is_assignment("2x=1"));
+    assert(!is_assignment("a-b=1"));
+    assert(!is_assignment("ls"));
+}
+
+void test_set_variable() {
+    assert(get_variable("jsh_test_unset", 14) == NULL);
+
+    // The table grows beyond its initial capacity without losing a variable
+    char name[32];
+    char value[32];
+    for (int i = 0; i < VARIABLES_INITIAL_CAPACITY * 2; i++) {
+        sprintf(name, "jsh_test_%d", i);
+        sprintf(value, "%d", i * 2);
+        set_variable(name, value);
+    }
+    for (int i = 0; i < VARIABLES_INITIAL_CAPACITY * 2; i++) {
+        sprintf(name, "jsh_test_%d", i);
+        sprintf(value, "%d", i * 2);
+        assert(strcmp(get_variable(name, strlen(name)), value) == 0);
+    }
+    set_variable("jsh_test_0", "again");
+    assert(strcmp(get_variable("jsh_test_0=", 10), "again") == 0);
+
+    // A variable of the environment is changed in the environment
+    setenv("JSH_TEST_ENV", "before", 1);
+    assert(strcmp(get_variable("JSH_TEST_ENV", 12), "before") == 0);
+    set_variable("JSH_TEST_ENV", "after");
+    assert(strcmp(getenv("JSH_TEST_ENV"), "after") == 0);
+    unsetenv("JSH_TEST_ENV");
+}
+
+int expands_to(const char *word, const char *expected) {
+    char *result = expand_variables(word);
+    int same = strcmp(result, expected) == 0;
+    free(result);
+    return same;
+}
+
+void test_expand_variables() {
+    set_variable("jsh_x", "value");
+    assert(expands_to("$jsh_x", "value"));
+    assert(expands_to("a${jsh_x}b", "avalueb"));
+    assert(expands_to("$jsh_x.txt", "value.txt"));
+    assert(expands_to("$jsh_xb", ""));
+    assert(expands_to("$ and $0 and ${", "$ and $0 and ${"));
+
+    // The positional parameters are those of the innermost function call
+    assert(expands_to("$1$#", "0"));
+    char *outer[] = {"a", "b c"};
+    char *inner[] = {"d"};
+    push_positional_parameters(2, outer);
+    assert(expands_to("$2-$1-$3-$#", "b c-a--2"));
+    push_positional_parameters(1, inner);
+    assert(expands_to("[$@]", "[d]"));
+    pop_positional_parameters();
+    assert(expands_to("[$@]", "[a b c]"));
+    pop_positional_parameters();
+    assert(expands_to("no variable", "no variable"));
+
+    // An arithmetic expansion expands the variables of its expression, an invalid one expands to nothing
+    set_variable("jsh_n", "4");
+    assert(expands_to("[$((jsh_n * (2 + 1)))]", "[12]"));
+    assert(expands_to("$(( $jsh_n + 1 ))$((jsh_n))", "54"));
+    expansion_failed = false;
+    assert(expands_to("x$((1 / 0))", "x"));
+    assert(expansion_failed);
+    expansion_failed = false;
+    assert(expands_to("$((1)+(2)", "$((1)+(2)"));
+}
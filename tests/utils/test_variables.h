@@ -0,0 +1,6 @@
+#ifndef TEST_VARIABLES_H
+#define TEST_VARIABLES_H
+
+void test_variables();
+
+#endif